@@ -0,0 +1,131 @@
+#version 450 core
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_GOOGLE_include_directive    : enable
+#include "Nyx.h"
+
+#define BLOCK_SIZE_X 64 
+#define BLOCK_SIZE_Y 1 
+#define BLOCK_SIZE_Z 1 
+
+layout( local_size_x = BLOCK_SIZE_X, local_size_y = BLOCK_SIZE_Y, local_size_z = BLOCK_SIZE_Z ) in ; 
+
+// Cluster of neighbouring triangles, see NyxMeshlets.h.
+struct Meshlet
+{
+  vec4 sphere      ;
+  vec4 cone        ;
+  uint first_index ;
+  uint index_count ;
+  uint padding0    ;
+  uint padding1    ;
+};
+
+// One drawn instance of a clustered mesh. Dispatched along y, with it's meshlets along x.
+struct Job
+{
+  mat4 model         ;
+  uint first_meshlet ;
+  uint meshlet_count ;
+  uint first_index   ;
+  uint output        ;
+};
+
+// Matches VkDrawIndexedIndirectCommand. The index count is reset to zero by the host before every dispatch.
+struct Command
+{
+  uint index_count    ;
+  uint instance_count ;
+  uint first_index    ;
+  int  vertex_offset  ;
+  uint first_instance ;
+};
+
+NyxPushConstant push
+{
+  vec4 eye ;
+};
+
+layout( binding = 0 ) uniform projection
+{
+  mat4 viewproj ;
+};
+
+layout( binding = 1 ) restrict readonly buffer meshlets
+{
+  Meshlet clusters[] ;
+};
+
+layout( binding = 2 ) restrict readonly buffer jobs
+{
+  Job cull_jobs[] ;
+};
+
+layout( binding = 3 ) restrict readonly buffer indices
+{
+  uint in_indices[] ;
+};
+
+layout( binding = 4 ) restrict writeonly buffer culled
+{
+  uint out_indices[] ;
+};
+
+layout( binding = 5 ) restrict coherent buffer commands
+{
+  Command draws[] ;
+};
+
+bool outsideFrustum( vec3 center, float radius )
+{
+  const vec4 row0 = vec4( viewproj[ 0 ][ 0 ], viewproj[ 1 ][ 0 ], viewproj[ 2 ][ 0 ], viewproj[ 3 ][ 0 ] ) ;
+  const vec4 row1 = vec4( viewproj[ 0 ][ 1 ], viewproj[ 1 ][ 1 ], viewproj[ 2 ][ 1 ], viewproj[ 3 ][ 1 ] ) ;
+  const vec4 row2 = vec4( viewproj[ 0 ][ 2 ], viewproj[ 1 ][ 2 ], viewproj[ 2 ][ 2 ], viewproj[ 3 ][ 2 ] ) ;
+  const vec4 row3 = vec4( viewproj[ 0 ][ 3 ], viewproj[ 1 ][ 3 ], viewproj[ 2 ][ 3 ], viewproj[ 3 ][ 3 ] ) ;
+  vec4       planes[ 6 ] ;
+  
+  planes[ 0 ] = row3 + row0 ;
+  planes[ 1 ] = row3 - row0 ;
+  planes[ 2 ] = row3 + row1 ;
+  planes[ 3 ] = row3 - row1 ;
+  planes[ 4 ] = row2        ; // Vulkan depth starts at zero.
+  planes[ 5 ] = row3 - row2 ;
+  
+  for( uint index = 0; index < 6; index++ )
+  {
+    if( dot( planes[ index ].xyz, center ) + planes[ index ].w < -radius * length( planes[ index ].xyz ) ) return true ;
+  }
+  
+  return false ;
+}
+
+void main()
+{
+  const Job  job   = cull_jobs[ gl_GlobalInvocationID.y ] ;
+  const uint index = gl_GlobalInvocationID.x              ;
+  Meshlet    meshlet ;
+  vec3       center  ;
+  vec3       axis    ;
+  float      radius  ;
+  float      scale   ;
+  uint       offset  ;
+  
+  if( index >= job.meshlet_count ) return ;
+  
+  meshlet = clusters[ job.first_meshlet + index ] ;
+  scale   = max( max( length( job.model[ 0 ].xyz ), length( job.model[ 1 ].xyz ) ), length( job.model[ 2 ].xyz ) ) ;
+  center  = ( job.model * vec4( meshlet.sphere.xyz, 1.0 ) ).xyz ;
+  radius  = meshlet.sphere.w * scale ;
+  axis    = normalize( mat3( job.model ) * meshlet.cone.xyz ) ;
+  
+  if( outsideFrustum( center, radius ) ) return ;
+  
+  // Every triangle's normal lies inside the cone, so if the whole cone faces away from the eye so does the meshlet.
+  if( meshlet.cone.w < 1.0 && dot( center - eye.xyz, axis ) >= meshlet.cone.w * length( center - eye.xyz ) + radius ) return ;
+  
+  offset = atomicAdd( draws[ gl_GlobalInvocationID.y ].index_count, meshlet.index_count ) ;
+  
+  for( uint corner = 0; corner < meshlet.index_count; corner++ )
+  {
+    out_indices[ job.output + offset + corner ] = in_indices[ job.first_index + meshlet.first_index + corner ] ;
+  }
+}
@@ -0,0 +1,157 @@
+#version 450 core
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_GOOGLE_include_directive    : enable
+#include "Nyx.h"
+
+#define BLOCK_SIZE_X 64 
+#define BLOCK_SIZE_Y 1 
+#define BLOCK_SIZE_Z 1 
+
+layout( local_size_x = BLOCK_SIZE_X, local_size_y = BLOCK_SIZE_Y, local_size_z = BLOCK_SIZE_Z ) in ; 
+
+// A single particle of the pool, see NyxParticles.cpp.
+struct Particle
+{
+  vec4 position ; // xyz position, w age in seconds.
+  vec4 velocity ; // xyz velocity, w lifetime in seconds.
+  uint emitter  ;
+  uint padding0 ;
+  uint padding1 ;
+  uint padding2 ;
+};
+
+// An emitter & the range of this frame's spawns it owns.
+struct Emitter
+{
+  vec4  position          ; // xyz position, w spread of the cone particles leave in, in radians.
+  vec4  direction         ; // xyz direction, w speed.
+  vec4  gravity           ; // xyz acceleration, w drag.
+  vec4  color_start       ;
+  vec4  color_end         ;
+  float lifetime          ;
+  float lifetime_variance ;
+  float size_start        ;
+  float size_end          ;
+  uint  texture           ;
+  uint  first_spawn       ;
+  uint  spawn_count       ;
+  uint  padding           ;
+};
+
+// Matches VkDrawIndexedIndirectCommand, followed by the pool's bookkeeping.
+struct Counters
+{
+  uint index_count      ;
+  uint instance_count   ; // The particles that survived the last simulation.
+  uint first_index      ;
+  int  vertex_offset    ;
+  uint first_instance   ; // Where the surviving list starts, so the draw reads it without being re-recorded.
+  int  dead_count       ;
+  uint alive_count[ 2 ] ;
+};
+
+NyxPushConstant push
+{
+  float delta         ;
+  uint  seed          ;
+  uint  current       ;
+  uint  spawn_count   ;
+  uint  capacity      ;
+  uint  emitter_count ;
+};
+
+layout( binding = 0 ) restrict buffer particles
+{
+  Particle pool[] ;
+};
+
+layout( binding = 1 ) restrict readonly buffer emitters
+{
+  Emitter sources[] ;
+};
+
+layout( binding = 2 ) restrict coherent buffer counters
+{
+  Counters counter ;
+};
+
+layout( binding = 3 ) restrict buffer dead
+{
+  uint dead_list[] ;
+};
+
+layout( binding = 4 ) restrict writeonly buffer alive
+{
+  uint alive_list[] ;
+};
+
+uint hash( uint value )
+{
+  value ^= value >> 16 ; value *= 0x7feb352du ;
+  value ^= value >> 15 ; value *= 0x846ca68bu ;
+  value ^= value >> 16 ;
+  
+  return value ;
+}
+
+float random( inout uint state )
+{
+  state = hash( state ) ;
+  return float( state >> 8 ) / 16777216.0 ;
+}
+
+void main()
+{
+  const uint index = gl_GlobalInvocationID.x ;
+  uint       state = hash( index ^ push.seed ) ;
+  uint       owner = 0                       ;
+  Particle   particle ;
+  Emitter    source   ;
+  vec3       axis     ;
+  vec3       side     ;
+  vec3       up       ;
+  float      angle    ;
+  float      turn     ;
+  int        slot     ;
+  
+  // The list simulated next frame starts empty, nothing else touches it during this pass.
+  if( index == 0 )
+  {
+    counter.instance_count                  = 0 ;
+    counter.alive_count[ 1 - push.current ] = 0 ;
+  }
+  
+  if( index >= push.spawn_count ) return ;
+  
+  // Pop a dead particle. Once none are left the spawn is dropped, and the count restored for the ones still popping.
+  slot = atomicAdd( counter.dead_count, -1 ) - 1 ;
+  if( slot < 0 )
+  {
+    atomicAdd( counter.dead_count, 1 ) ;
+    return ;
+  }
+  
+  while( owner + 1 < push.emitter_count && index >= sources[ owner ].first_spawn + sources[ owner ].spawn_count ) owner++ ;
+  
+  source = sources[ owner ] ;
+  
+  // A random direction inside the emitter's cone.
+  axis  = normalize( source.direction.xyz ) ;
+  side  = normalize( abs( axis.y ) < 0.99 ? cross( axis, vec3( 0.0, 1.0, 0.0 ) ) : cross( axis, vec3( 1.0, 0.0, 0.0 ) ) ) ;
+  up    = cross( side, axis ) ;
+  angle = acos( mix( 1.0, cos( source.position.w ), random( state ) ) ) ;
+  turn  = random( state ) * 6.28318530718 ;
+  axis  = cos( angle ) * axis + sin( angle ) * ( cos( turn ) * side + sin( turn ) * up ) ;
+  
+  particle.position = vec4( source.position.xyz, 0.0 ) ;
+  particle.velocity = vec4( axis * source.direction.w, max( source.lifetime + ( random( state ) * 2.0 - 1.0 ) * source.lifetime_variance, 0.001 ) ) ;
+  particle.emitter  = owner ;
+  particle.padding0 = 0     ;
+  particle.padding1 = 0     ;
+  particle.padding2 = 0     ;
+  
+  pool[ dead_list[ slot ] ] = particle ;
+  
+  // Spawned particles join the list simulated this frame, so they move & draw right away.
+  alive_list[ push.current * push.capacity + atomicAdd( counter.alive_count[ push.current ], 1 ) ] = dead_list[ slot ] ;
+}
@@ -0,0 +1,151 @@
+#version 450 core
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_GOOGLE_include_directive    : enable
+#include "Nyx.h"
+
+#define BLOCK_SIZE_X 64 
+#define BLOCK_SIZE_Y 1 
+#define BLOCK_SIZE_Z 1 
+
+layout( local_size_x = BLOCK_SIZE_X, local_size_y = BLOCK_SIZE_Y, local_size_z = BLOCK_SIZE_Z ) in ; 
+
+// A single particle of the pool, see NyxParticles.cpp.
+struct Particle
+{
+  vec4 position ; // xyz position, w age in seconds.
+  vec4 velocity ; // xyz velocity, w lifetime in seconds.
+  uint emitter  ;
+  uint padding0 ;
+  uint padding1 ;
+  uint padding2 ;
+};
+
+// An emitter & the range of this frame's spawns it owns.
+struct Emitter
+{
+  vec4  position          ; // xyz position, w spread of the cone particles leave in, in radians.
+  vec4  direction         ; // xyz direction, w speed.
+  vec4  gravity           ; // xyz acceleration, w drag.
+  vec4  color_start       ;
+  vec4  color_end         ;
+  float lifetime          ;
+  float lifetime_variance ;
+  float size_start        ;
+  float size_end          ;
+  uint  texture           ;
+  uint  first_spawn       ;
+  uint  spawn_count       ;
+  uint  padding           ;
+};
+
+// Matches VkDrawIndexedIndirectCommand, followed by the pool's bookkeeping.
+struct Counters
+{
+  uint index_count      ;
+  uint instance_count   ;
+  uint first_index      ;
+  int  vertex_offset    ;
+  uint first_instance   ;
+  int  dead_count       ;
+  uint alive_count[ 2 ] ;
+};
+
+NyxPushConstant push
+{
+  float delta         ;
+  uint  seed          ;
+  uint  current       ;
+  uint  spawn_count   ;
+  uint  capacity      ;
+  uint  emitter_count ;
+};
+
+layout( binding = 0 ) restrict buffer particles
+{
+  Particle pool[] ;
+};
+
+layout( binding = 1 ) restrict readonly buffer emitters
+{
+  Emitter sources[] ;
+};
+
+layout( binding = 2 ) restrict coherent buffer counters
+{
+  Counters counter ;
+};
+
+layout( binding = 3 ) restrict buffer dead
+{
+  uint dead_list[] ;
+};
+
+layout( binding = 4 ) restrict buffer alive
+{
+  uint alive_list[] ;
+};
+
+shared uint group_alive ;
+shared uint group_dead  ;
+shared uint alive_base  ;
+shared uint dead_base   ;
+
+void main()
+{
+  const uint index    = gl_GlobalInvocationID.x ;
+  const uint next     = 1 - push.current        ;
+  bool       active   = false                   ;
+  bool       living   = false                   ;
+  uint       id       = 0                       ;
+  uint       offset   = 0                       ;
+  Particle   particle ;
+  vec4       gravity  ;
+  
+  if( gl_LocalInvocationIndex == 0 )
+  {
+    group_alive = 0 ;
+    group_dead  = 0 ;
+  }
+  
+  // Every group agrees on where the surviving list starts, so the recorded draw always reads the right half.
+  if( index == 0 ) counter.first_instance = next * push.capacity ;
+  
+  barrier() ;
+  
+  if( index < counter.alive_count[ push.current ] )
+  {
+    id       = alive_list[ push.current * push.capacity + index ] ;
+    particle = pool[ id ]                                        ;
+    gravity  = sources[ particle.emitter ].gravity               ;
+    active   = true                                              ;
+    
+    particle.velocity.xyz += gravity.xyz * push.delta                 ;
+    particle.velocity.xyz *= 1.0 / ( 1.0 + gravity.w * push.delta ) ;
+    particle.position.xyz += particle.velocity.xyz * push.delta       ;
+    particle.position.w   += push.delta                               ;
+    living                 = particle.position.w < particle.velocity.w ;
+    
+    pool[ id ].position = particle.position ;
+    pool[ id ].velocity = particle.velocity ;
+    
+    // Compaction is counted per group first, so the global counters see one atomic per group instead of per particle.
+    offset = living ? atomicAdd( group_alive, 1 ) : atomicAdd( group_dead, 1 ) ;
+  }
+  
+  barrier() ;
+  
+  if( gl_LocalInvocationIndex == 0 )
+  {
+    alive_base = group_alive != 0 ? atomicAdd( counter.alive_count[ next ], group_alive )         : 0 ;
+    dead_base  = group_dead  != 0 ? uint( atomicAdd( counter.dead_count, int( group_dead ) ) ) : 0 ;
+    
+    if( group_alive != 0 ) atomicAdd( counter.instance_count, group_alive ) ;
+  }
+  
+  barrier() ;
+  
+  if( !active ) return ;
+  
+  if( living ) alive_list[ next * push.capacity + alive_base + offset ] = id ;
+  else         dead_list [ dead_base + offset                          ] = id ;
+}
@@ -0,0 +1,89 @@
+#version 450 core
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_GOOGLE_include_directive    : enable
+#include "Nyx.h"
+
+// Matches RESAMPLE_BLOCK, RESAMPLE_LINES & RESAMPLE_TILE in NyxResample.h.
+#define BLOCK_SIZE_X 64
+#define BLOCK_SIZE_Y 2
+#define BLOCK_SIZE_Z 1
+#define TILE_SIZE    384
+
+layout( local_size_x = BLOCK_SIZE_X, local_size_y = BLOCK_SIZE_Y, local_size_z = BLOCK_SIZE_Z ) in ;
+
+// The input pixels of one output pixel, see NyxResample.h.
+struct Span
+{
+  int first ;
+  int count ;
+};
+
+// One separable pass. x of the workgroup walks the output along the axis, y the lines across it.
+NyxPushConstant push
+{
+  uint axis   ;
+  uint offset ;
+  uint taps   ;
+  uint size   ;
+};
+
+layout( binding = 0, rgba32f ) restrict readonly  uniform image2D input_tex  ;
+layout( binding = 1, rgba32f ) restrict writeonly uniform image2D output_tex ;
+
+layout( binding = 2 ) restrict readonly buffer spans
+{
+  Span span[] ;
+};
+
+layout( binding = 3 ) restrict readonly buffer weights
+{
+  float weight[] ;
+};
+
+shared vec4 tile[ BLOCK_SIZE_Y ][ TILE_SIZE ] ;
+
+ivec2 texel( int along, uint line )
+{
+  return axis == 0 ? ivec2( along, line ) : ivec2( line, along ) ;
+}
+
+void main()
+{
+  const ivec2 in_size   = imageSize( input_tex )                                           ;
+  const uint  lines     = uint( axis == 0 ? in_size.y : in_size.x )                        ;
+  const uint  line      = gl_WorkGroupID.y * BLOCK_SIZE_Y + gl_LocalInvocationID.y          ;
+  const uint  block     = gl_WorkGroupID.x * BLOCK_SIZE_X                                  ;
+  const uint  out_index = block + gl_LocalInvocationID.x                                   ;
+  const Span  low       = span[ offset + block                                         ]    ;
+  const Span  high      = span[ offset + min( block + BLOCK_SIZE_X, size ) - 1         ]    ;
+  const int   width     = high.first + high.count - low.first                              ;
+  const bool  tiled     = width <= TILE_SIZE                                               ;
+
+  // Neighbouring outputs share most of their inputs, so the block reads each input of it's lines once into shared memory.
+  if( tiled && line < lines )
+  {
+    for( int index = int( gl_LocalInvocationID.x ); index < width; index += BLOCK_SIZE_X )
+    {
+      tile[ gl_LocalInvocationID.y ][ index ] = imageLoad( input_tex, texel( low.first + index, line ) ) ;
+    }
+  }
+
+  barrier() ;
+
+  if( out_index >= size || line >= lines ) return ;
+
+  const Span own   = span[ offset + out_index ] ;
+  const uint first = ( offset + out_index ) * taps ;
+  vec4       color = vec4( 0.0 )                  ;
+
+  if( tiled )
+  {
+    for( int tap = 0; tap < own.count; tap++ ) color += weight[ first + tap ] * tile[ gl_LocalInvocationID.y ][ own.first - low.first + tap ] ;
+  }
+  else
+  {
+    for( int tap = 0; tap < own.count; tap++ ) color += weight[ first + tap ] * imageLoad( input_tex, texel( own.first + tap, line ) ) ;
+  }
+
+  imageStore( output_tex, texel( int( out_index ), line ), color ) ;
+}
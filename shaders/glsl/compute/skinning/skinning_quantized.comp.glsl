@@ -0,0 +1,92 @@
+#version 450 core
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_GOOGLE_include_directive    : enable
+#include "Nyx.h"
+#include "NyxQuantized.h"
+
+#define BLOCK_SIZE_X 64 
+#define BLOCK_SIZE_Y 1 
+#define BLOCK_SIZE_Z 1 
+
+layout( local_size_x = BLOCK_SIZE_X, local_size_y = BLOCK_SIZE_Y, local_size_z = BLOCK_SIZE_Z ) in ; 
+
+// Standard Ngg model vertex layout, written out after skinning.
+struct Vertex
+{
+  vec4  vertex     ;
+  vec4  normals    ;
+  vec4  weights    ;
+  uvec4 ids        ;
+  vec2  tex_coords ;
+};
+
+// One mesh of one skinned drawable. Dispatched along y, with it's vertices along x.
+struct Job
+{
+  uint first_vertex   ;
+  uint vertex_count   ;
+  uint first_bone     ;
+  uint output         ;
+  uint dequantization ; // Only used by the quantized variant.
+};
+
+layout( binding = 0, scalar ) restrict readonly buffer vertices
+{
+  NyxQuantizedVertex in_vertices[] ;
+};
+
+layout( binding = 1 ) restrict readonly buffer bones
+{
+  mat4 palette[] ;
+};
+
+layout( binding = 2 ) restrict readonly buffer jobs
+{
+  Job skin_jobs[] ;
+};
+
+layout( binding = 3, scalar ) restrict writeonly buffer skinned
+{
+  Vertex out_vertices[] ;
+};
+
+layout( binding = 4 ) restrict readonly buffer dequantization
+{
+  NyxDequantization dequant[] ;
+};
+
+void main()
+{
+  const Job          job   = skin_jobs[ gl_GlobalInvocationID.y ] ;
+  const uint         index = gl_GlobalInvocationID.x              ;
+  NyxQuantizedVertex quantized ;
+  Vertex             vert      ;
+  mat4               skin      ;
+  float              total     ;
+  
+  if( index >= job.vertex_count ) return ;
+  
+  // Decode into the full layout, since deformed positions no longer fit the mesh's bounds.
+  quantized       = in_vertices[ job.first_vertex + index ]                        ;
+  vert.vertex     = nyxDecodePosition ( quantized, dequant[ job.dequantization ] ) ;
+  vert.normals    = nyxDecodeNormal   ( quantized                              ) ;
+  vert.weights    = nyxDecodeWeights  ( quantized                              ) ;
+  vert.ids        = nyxDecodeIds      ( quantized                              ) ;
+  vert.tex_coords = nyxDecodeTexCoords( quantized                              ) ;
+  
+  total = vert.weights.x + vert.weights.y + vert.weights.z + vert.weights.w ;
+  
+  // Unweighted vertices are left where they are, so static meshes can share a skinned drawable.
+  if( total > 0.0 )
+  {
+    skin = vert.weights.x * palette[ job.first_bone + vert.ids.x ] +
+           vert.weights.y * palette[ job.first_bone + vert.ids.y ] +
+           vert.weights.z * palette[ job.first_bone + vert.ids.z ] +
+           vert.weights.w * palette[ job.first_bone + vert.ids.w ] ;
+    
+    vert.vertex  = skin * vec4( vert.vertex.xyz, 1.0 ) ;
+    vert.normals = vec4( normalize( mat3( skin ) * vert.normals.xyz ), vert.normals.w ) ;
+  }
+  
+  out_vertices[ job.output + index ] = vert ;
+}
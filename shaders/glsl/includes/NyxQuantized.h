@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2021 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* 
+ * File:   NyxQuantized.h
+ * Author: Jordan Hendl
+ *
+ * Created on May 4, 2021, 8:02 PM
+ */
+
+#ifndef NYXQUANTIZED_H
+#define NYXQUANTIZED_H
+
+// Quantized Ngg model vertex layout. Matches nyx::QuantizedVertex.
+struct NyxQuantizedVertex
+{
+  uint position_xy ; // Snorm16 x & y inside the mesh's bounds.
+  uint position_zw ; // Snorm16 z, w is padding.
+  uint normal      ; // Octahedral-encoded normal, as two snorm16 values.
+  uint weights     ; // Four unorm8 bone weights.
+  uint ids         ; // Four uint8 bone ids.
+  uint tex_coords  ; // Two half-float texture coordinates.
+};
+
+// position = offset + scale * snorm. Matches nyx::Dequantization.
+struct NyxDequantization
+{
+  vec4 offset ;
+  vec4 scale  ;
+};
+
+vec3 nyxOctDecode( vec2 encoded )
+{
+  vec3  n = vec3( encoded.x, encoded.y, 1.0 - abs( encoded.x ) - abs( encoded.y ) ) ;
+  float t = max( -n.z, 0.0 ) ;
+  
+  n.x += n.x >= 0.0 ? -t : t ;
+  n.y += n.y >= 0.0 ? -t : t ;
+  
+  return normalize( n ) ;
+}
+
+vec4 nyxDecodePosition( NyxQuantizedVertex vert, NyxDequantization dequant )
+{
+  vec3 snorm = vec3( unpackSnorm2x16( vert.position_xy ), unpackSnorm2x16( vert.position_zw ).x ) ;
+  
+  return vec4( dequant.offset.xyz + dequant.scale.xyz * snorm, 1.0 ) ;
+}
+
+vec4 nyxDecodeNormal( NyxQuantizedVertex vert )
+{
+  return vec4( nyxOctDecode( unpackSnorm2x16( vert.normal ) ), 0.0 ) ;
+}
+
+vec4 nyxDecodeWeights( NyxQuantizedVertex vert )
+{
+  return unpackUnorm4x8( vert.weights ) ;
+}
+
+uvec4 nyxDecodeIds( NyxQuantizedVertex vert )
+{
+  return uvec4( vert.ids & 0xFF, ( vert.ids >> 8 ) & 0xFF, ( vert.ids >> 16 ) & 0xFF, ( vert.ids >> 24 ) & 0xFF ) ;
+}
+
+vec2 nyxDecodeTexCoords( NyxQuantizedVertex vert )
+{
+  return unpackHalf2x16( vert.tex_coords ) ;
+}
+
+#endif
@@ -0,0 +1,42 @@
+#version 450 core
+#extension GL_GOOGLE_include_directive    : enable
+#extension GL_ARB_separate_shader_objects : enable
+#include "Nyx.h"
+
+     layout( location = 0 ) in vec2 frag_coords ;
+     layout( location = 1 ) in vec4 frag_color  ;
+flat layout( location = 2 ) in uint frag_page   ;
+flat layout( location = 3 ) in uint frag_mode   ;
+
+layout( location = 0 ) out vec4 out_color ;
+
+// Modes of an instance, matching nyx::InstanceMode.
+const uint MODE_GLYPH = 0 ;
+const uint MODE_IMAGE = 1 ;
+
+// The shared atlas every sprite & quad is packed into.
+layout( binding = 0 ) uniform sampler2DArray images ;
+
+// Signed distance fields of every glyph in the alpha, one half at the glyph's edge.
+layout( binding = 4 ) uniform sampler2DArray glyphs ;
+
+void main()
+{
+  vec4 color = frag_color ;
+
+  // The mode is the same for a whole quad, so neighbouring fragments never diverge here.
+  if( frag_mode == MODE_IMAGE )
+  {
+    color *= texture( images, vec3( frag_coords, float( frag_page ) ) ) ;
+  }
+  else
+  {
+    float distance = texture( glyphs, vec3( frag_coords, float( frag_page ) ) ).a                ;
+    float width    = max( 0.7 * length( vec2( dFdx( distance ), dFdy( distance ) ) ), 0.0001 ) ;
+
+    color.a *= smoothstep( 0.5 - width, 0.5 + width, distance ) ;
+  }
+
+  if( color.a < 0.01 ) discard ;
+  out_color = color ;
+}
@@ -0,0 +1,53 @@
+#version 450 core
+#extension GL_GOOGLE_include_directive    : enable
+#extension GL_ARB_separate_shader_objects : enable
+#include "Nyx.h"
+
+// The unit quad every sprite, quad & glyph is drawn with.
+layout ( location = 0 ) in vec4 vertex ;
+
+     layout( location = 0 ) out vec2 frag_coords ;
+     layout( location = 1 ) out vec4 frag_color  ;
+flat layout( location = 2 ) out uint frag_page   ;
+flat layout( location = 3 ) out uint frag_mode   ;
+
+// A single sprite, quad or glyph to draw, see GlyphInstance in NyxText.h.
+struct Instance
+{
+  vec4 rect      ; // The quad in the space of it's transform, xy offset & zw size.
+  vec4 region    ; // The rectangle sampled on it's atlas page, xy offset & zw size.
+  vec4 color     ;
+  uint page      ;
+  uint transform ;
+  uint mode      ; // Which atlas the instance samples, see draw_2d.frag.glsl.
+  uint padding   ;
+};
+
+layout( binding = 1 ) uniform projection
+{
+  mat4 viewproj ;
+};
+
+layout( binding = 2 ) restrict readonly buffer transforms
+{
+  mat4 transform_list[] ;
+};
+
+// Every instance of every layer, in the order they are drawn.
+layout( binding = 3 ) restrict readonly buffer instances
+{
+  Instance instance_list[] ;
+};
+
+void main()
+{
+  Instance instance = instance_list[ gl_InstanceIndex ]                 ;
+  vec2     position = instance.rect.xy + vertex.xy * instance.rect.zw ;
+
+  frag_coords = instance.region.xy + vertex.xy * instance.region.zw ;
+  frag_color  = instance.color                                      ;
+  frag_page   = instance.page                                       ;
+  frag_mode   = instance.mode                                       ;
+
+  gl_Position = viewproj * transform_list[ instance.transform ] * vec4( position, 0.0, 1.0 ) ;
+}
@@ -14,12 +14,17 @@ layout ( location = 4 ) in vec2  tex_coords ;
      layout( location = 0 ) out vec2  frag_coords    ;
 flat layout( location = 1 ) out uvec2 texture_index  ;
 
-NyxPushConstant push
+struct Instance
 {
-  uint index     ;
+  uint transform ;
   uint tex_index ;
 };
 
+NyxPushConstant push
+{
+  uint instance_offset ;
+};
+
 layout( binding = 1 ) uniform projection
 {
   mat4 viewproj ;
@@ -30,22 +35,29 @@ layout( binding = 2 ) buffer transform
   mat4 transforms[] ;
 }; 
 
+layout( binding = 3 ) buffer instance
+{
+  Instance instances[] ;
+};
+
 void main()
 {
-  mat4  model     ;
-  vec4  position  ;
-  vec4  normal    ;
-  float weight    ;
-  uint  id        ;
+  Instance inst     ;
+  mat4     model    ;
+  vec4     position ;
+  vec4     normal   ;
+  float    weight   ;
+  uint     id       ;
 
   normal         = normals      ;
   weight         = weights[ 0 ] ;
   id             = ids    [ 0 ] ;
   position       = vertex       ;
 
-  model           = transforms[ index ] ;
-  frag_coords     = tex_coords          ;
-  texture_index.x = tex_index           ;
+  inst            = instances[ instance_offset + gl_InstanceIndex ] ;
+  model           = transforms[ inst.transform ]                   ;
+  frag_coords     = tex_coords                                     ;
+  texture_index.x = inst.tex_index                                 ;
 
   gl_Position = viewproj * model * position ;
 }
\ No newline at end of file
@@ -0,0 +1,88 @@
+#version 450 core
+#extension GL_GOOGLE_include_directive    : enable
+#extension GL_ARB_separate_shader_objects : enable
+#include "Nyx.h"
+#include "NyxQuantized.h"
+
+// Quantized Ngg model vertex layout, pulled from the geometry arena instead of vertex inputs.
+struct Vertex
+{
+  vec4  vertex     ;
+  vec4  normals    ;
+  vec4  weights    ;
+  uvec4 ids        ;
+  vec2  tex_coords ;
+};
+
+     layout( location = 0 ) out vec2  frag_coords    ;
+flat layout( location = 1 ) out uvec2 texture_index  ;
+
+struct Instance
+{
+  uint transform ;
+  uint tex_index ;
+};
+
+NyxPushConstant push
+{
+  uint instance_offset ;
+  uint dequantization  ; // The mesh's dequantization, or 0xFFFFFFFF for draws of skinned vertices.
+};
+
+layout( binding = 1 ) uniform projection
+{
+  mat4 viewproj ;
+};
+
+layout( binding = 2 ) buffer transform
+{
+  mat4 transforms[] ;
+}; 
+
+layout( binding = 3 ) buffer instance
+{
+  Instance instances[] ;
+};
+
+layout( binding = 4, scalar ) restrict readonly buffer vertices
+{
+  NyxQuantizedVertex quantized[] ;
+};
+
+// Skinning writes full float vertices, since deformed positions no longer fit the mesh's bounds.
+layout( binding = 5, scalar ) restrict readonly buffer skinned
+{
+  Vertex skinned_vertices[] ;
+};
+
+layout( binding = 6 ) restrict readonly buffer dequantization
+{
+  NyxDequantization dequant[] ;
+};
+
+void main()
+{
+  Instance inst     ;
+  mat4     model    ;
+  vec4     position ;
+  vec2     coords   ;
+
+  // gl_VertexIndex already includes the draw's base vertex.
+  if( dequantization == 0xFFFFFFFF )
+  {
+    position = skinned_vertices[ gl_VertexIndex ].vertex     ;
+    coords   = skinned_vertices[ gl_VertexIndex ].tex_coords ;
+  }
+  else
+  {
+    position = nyxDecodePosition ( quantized[ gl_VertexIndex ], dequant[ dequantization ] ) ;
+    coords   = nyxDecodeTexCoords( quantized[ gl_VertexIndex ]                            ) ;
+  }
+
+  inst            = instances[ instance_offset + gl_InstanceIndex ] ;
+  model           = transforms[ inst.transform ]                   ;
+  frag_coords     = coords                                         ;
+  texture_index.x = inst.tex_index                                 ;
+
+  gl_Position = viewproj * model * position ;
+}
@@ -0,0 +1,26 @@
+#version 450 core
+#extension GL_GOOGLE_include_directive    : enable
+#extension GL_ARB_separate_shader_objects : enable
+#include "Nyx.h"
+
+     layout( location = 0 ) in vec2 frag_coords   ;
+     layout( location = 1 ) in vec4 frag_color    ;
+flat layout( location = 2 ) in uint texture_index ;
+
+layout( location = 0 ) out vec4 out_color ;
+
+layout( binding = 0 ) uniform sampler2D textures[ 1024 ] ; 
+
+const uint NO_TEXTURE = 0xFFFFFFFFu ;
+
+void main()
+{
+  vec4 color = frag_color ;
+  
+  // Emitters without a texture draw soft round dots.
+  if( texture_index != NO_TEXTURE ) color *= texture( textures[ texture_index ], frag_coords ) ;
+  else                              color.a *= 1.0 - smoothstep( 0.6, 1.0, length( frag_coords * 2.0 - 1.0 ) ) ;
+  
+  if( color.a < 0.01 ) discard ;
+  out_color = color ;
+}
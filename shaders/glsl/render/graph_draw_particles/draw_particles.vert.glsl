@@ -0,0 +1,80 @@
+#version 450 core
+#extension GL_GOOGLE_include_directive    : enable
+#extension GL_ARB_separate_shader_objects : enable
+#include "Nyx.h"
+
+// The same unit quad sprites are drawn with.
+layout ( location = 0 ) in vec4 vertex ;
+
+     layout( location = 0 ) out vec2 frag_coords   ;
+     layout( location = 1 ) out vec4 frag_color    ;
+flat layout( location = 2 ) out uint texture_index ;
+
+// A single particle of the pool, see NyxParticles.cpp.
+struct Particle
+{
+  vec4 position ; // xyz position, w age in seconds.
+  vec4 velocity ; // xyz velocity, w lifetime in seconds.
+  uint emitter  ;
+  uint padding0 ;
+  uint padding1 ;
+  uint padding2 ;
+};
+
+// An emitter & the range of this frame's spawns it owns.
+struct Emitter
+{
+  vec4  position          ;
+  vec4  direction         ;
+  vec4  gravity           ;
+  vec4  color_start       ;
+  vec4  color_end         ;
+  float lifetime          ;
+  float lifetime_variance ;
+  float size_start        ;
+  float size_end          ;
+  uint  texture           ;
+  uint  first_spawn       ;
+  uint  spawn_count       ;
+  uint  padding           ;
+};
+
+layout( binding = 1 ) uniform projection
+{
+  mat4 view ;
+  mat4 proj ;
+};
+
+layout( binding = 2 ) restrict readonly buffer particles
+{
+  Particle pool[] ;
+};
+
+layout( binding = 3 ) restrict readonly buffer emitters
+{
+  Emitter sources[] ;
+};
+
+// Both halves of the alive lists. The indirect draw's first instance points at the half the simulation just wrote.
+layout( binding = 4 ) restrict readonly buffer alive
+{
+  uint alive_list[] ;
+};
+
+void main()
+{
+  Particle particle = pool[ alive_list[ gl_InstanceIndex ] ]                      ;
+  Emitter  source   = sources[ particle.emitter ]                                 ;
+  float    age      = clamp( particle.position.w / particle.velocity.w, 0.0, 1.0 ) ;
+  float    size     = mix( source.size_start, source.size_end, age )               ;
+  vec4     center   = view * vec4( particle.position.xyz, 1.0 )                    ;
+
+  // Billboarded in view space, so every particle faces the camera.
+  center.xy += ( vertex.xy - 0.5 ) * size ;
+
+  frag_coords   = vertex.xy                                          ;
+  frag_color    = mix( source.color_start, source.color_end, age ) ;
+  texture_index = source.texture                                     ;
+
+  gl_Position = proj * center ;
+}
@@ -6,16 +6,21 @@
 
      layout( location = 0 ) in  vec2 frag_coords ;
 flat layout( location = 1 ) in  uint index       ;
+flat layout( location = 2 ) in  uint atlas_page  ;
 
 layout( location = 0 ) out vec4  out_color ;
 
-layout( binding = 0 ) uniform sampler2D textures[ 1024 ] ; 
+layout( binding = 0 ) uniform sampler2D      textures[ 1024 ] ; 
+layout( binding = 4 ) uniform sampler2DArray atlas            ;
+
+const uint NO_ATLAS = 0xFFFFFFFFu ;
 
 void main()
 {  
   vec4 color ;
   
-  color = texture( textures[ index ], frag_coords ) ;
+  if( atlas_page != NO_ATLAS ) color = texture( atlas, vec3( frag_coords, float( atlas_page ) ) ) ;
+  else                         color = texture( textures[ index ], frag_coords )                    ;
   //if( color.a < 0.1 ) discard ;
   out_color = color ;
 }
\ No newline at end of file
@@ -10,90 +10,95 @@ layout ( location = 0 ) in vec4 vertex ;
 
      layout( location = 0 ) out vec2 frag_coords    ;
 flat layout( location = 1 ) out uint texture_index  ;
+flat layout( location = 2 ) out uint atlas_page     ;
 
-NyxBuffer PositionData 
-{
-  mat4 model ; 
-};
+// Loop modes of an animation, matching nyx::SpriteLoop.
+const uint LOOP_ONCE     = 0 ;
+const uint LOOP_REPEAT   = 1 ;
+const uint LOOP_PINGPONG = 2 ;
 
+// The frame's uv is computed on the host whenever it changes, so every vertex is a single multiply-add.
+// Animated sprites carry their sheet's first cell instead, and step whole cells from it by the clock.
 struct Sprite
 {
-  uint sprite_index  ;
-  uint tex_index     ;
-  uint sprite_width  ;
-  uint sprite_height ;
-  uint image_width   ;
-  uint image_height  ;
+  vec4  uv          ; // The current frame in the sprite's texture or atlas page, xy offset & zw size.
+  uint  tex_index   ;
+  uint  atlas_page  ; // The atlas page to sample, or NO_ATLAS to sample textures[ tex_index ].
+  uint  columns     ; // Cells in a row of the sheet.
+  uint  first_frame ;
+  uint  frame_count ; // One or less when the sprite isn't animated.
+  float fps         ;
+  uint  loop        ;
+  float start_time  ;
 };
 
-NyxPushConstant push 
+layout( binding = 1 ) uniform projection
 {
-  PositionData transform_device_ptr     ;
-  NyxIterator  const_transform_iterator ;
+  mat4 proj ; 
 };
 
-layout( binding = 1 ) uniform projection
+// Sprite records & transforms are storage buffers, so the sprite count is only limited by what the module allocates.
+layout( binding = 2 ) restrict readonly buffer sprite
 {
-  mat4 proj ; 
+  Sprite sprites[] ;
+}; 
+
+layout( binding = 3 ) restrict readonly buffer transform
+{
+  mat4 transforms[] ;
 };
 
-layout( binding = 2 ) uniform sprite
+// Written once per frame, so animations advance without touching any sprite record.
+layout( binding = 5 ) uniform clock
 {
-  Sprite sprites[ 1024 ] ;
-} ; 
+  float time ;
+};
 
-vec2 calculateCoordinates( uint sprite_width, uint sprite_height, uint image_width, uint image_height, uint sprite_index, uint coord_index )
+/** Function to compute the cell an animated sprite shows right now. Mirrors nyx::animationFrame on the host.
+ */
+uint animationFrame( Sprite sprite )
 {
-  uint idx                = uint( coord_index )                              ;
-  uint sprite             = sprite_index                                     ;
-  uint num_sprites_in_row = image_width  / sprite_width                      ; 
-  uint sprite_y_index     = sprite / num_sprites_in_row                      ;
-  uint sprite_x_index     = sprite - ( sprite_y_index * num_sprites_in_row ) ;
-  uint sprite_ypixel      = sprite_y_index * sprite_height                   ;
-  uint sprite_xpixel      = sprite_x_index * sprite_width                    ;
-  
-  vec2 texarray[ 4 ] ;
-
-  texarray[ 0 ].x = float( sprite_xpixel                 ) / float( image_width  ) ;
-  texarray[ 0 ].y = float( sprite_ypixel + sprite_height ) / float( image_height ) ;
-  texarray[ 1 ].x = float( sprite_xpixel + sprite_width  ) / float( image_width  ) ;
-  texarray[ 1 ].y = float( sprite_ypixel                 ) / float( image_height ) ;
-  texarray[ 2 ].x = float( sprite_xpixel                 ) / float( image_width  ) ;
-  texarray[ 2 ].y = float( sprite_ypixel                 ) / float( image_height ) ;
-  texarray[ 3 ].x = float( sprite_xpixel + sprite_width  ) / float( image_width  ) ;
-  texarray[ 3 ].y = float( sprite_ypixel + sprite_height ) / float( image_height ) ;
-
-  return texarray[ idx ] ;
+  uint count = max( sprite.frame_count, 1u )                                 ;
+  uint frame = uint( max( ( time - sprite.start_time ) * sprite.fps, 0.0 ) ) ;
+
+  if( sprite.loop == LOOP_ONCE )
+  {
+    frame = min( frame, count - 1 ) ;
+  }
+  else if( sprite.loop == LOOP_PINGPONG && count > 1 )
+  {
+    frame = frame % ( 2 * count - 2 ) ;
+    if( frame >= count ) frame = 2 * count - 2 - frame ;
+  }
+  else if( sprite.loop == LOOP_PINGPONG )
+  {
+    frame = 0 ;
+  }
+  else
+  {
+    frame = frame % count ;
+  }
+
+  return sprite.first_frame + frame ;
 }
 
 void main()
 {
-  NyxIterator model_iterator  ;
-  mat4        model           ;
-  mat4        projection      ;
-  vec4        position        ;
-  vec2        tex             ;
-  uint        sprite_index    ;
-  uint        sprite_width    ;
-  uint        sprite_height   ;
-  uint        image_width     ;
-  uint        image_height    ;
-
-  model_iterator  = const_transform_iterator ;
-  position = vec4( vertex.x, vertex.y, 0.0, 1.0 ) ;
-
-  nyx_seek( model_iterator , gl_InstanceIndex ) ;
-
-  model         = nyx_get( transform_device_ptr, model_iterator  ).model ;
-  texture_index = sprites[ gl_InstanceIndex ].tex_index                  ;
-  sprite_index  = sprites[ gl_InstanceIndex ].sprite_index               ;
-  sprite_width  = sprites[ gl_InstanceIndex ].sprite_width               ;
-  sprite_height = sprites[ gl_InstanceIndex ].sprite_height              ;
-  image_width   = sprites[ gl_InstanceIndex ].image_width                ;
-  image_height  = sprites[ gl_InstanceIndex ].image_height               ;
-  projection    = proj                                                   ;
-
-  frag_coords = calculateCoordinates( sprite_width, sprite_height, image_width, image_height, sprite_index, uint( vertex.z ) ) ;
-
-  gl_Position = projection * model * position ;  
+  Sprite sprite   = sprites[ gl_InstanceIndex ]            ;
+  vec4   position = vec4( vertex.x, vertex.y, 0.0, 1.0 ) ;
+  vec4   uv       = sprite.uv                            ;
+
+  if( sprite.frame_count > 1 )
+  {
+    uint frame = animationFrame( sprite ) ;
+    uint row   = frame / sprite.columns   ;
+
+    uv.xy += vec2( frame - row * sprite.columns, row ) * uv.zw ;
+  }
+
+  texture_index = sprite.tex_index  ;
+  atlas_page    = sprite.atlas_page ;
+  frag_coords   = uv.xy + vertex.xy * uv.zw              ;
+
+  gl_Position = proj * transforms[ gl_InstanceIndex ] * position ;  
 }
\ No newline at end of file
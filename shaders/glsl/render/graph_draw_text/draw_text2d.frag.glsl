@@ -0,0 +1,27 @@
+#version 450 core
+#extension GL_GOOGLE_include_directive    : enable
+#extension GL_ARB_separate_shader_objects : enable
+#include "Nyx.h"
+
+     layout( location = 0 ) in vec2 frag_coords ;
+     layout( location = 1 ) in vec4 frag_color  ;
+flat layout( location = 2 ) in uint frag_page   ;
+
+layout( location = 0 ) out vec4 out_color ;
+
+// Signed distance fields of every glyph in the alpha, one half at the glyph's edge.
+layout( binding = 0 ) uniform sampler2DArray atlas ;
+
+void main()
+{
+  float distance = texture( atlas, vec3( frag_coords, float( frag_page ) ) ).a ;
+
+  // Smoothed over about a pixel on screen, however far the glyph is scaled.
+  float width = max( 0.7 * length( vec2( dFdx( distance ), dFdy( distance ) ) ), 0.0001 ) ;
+  vec4  color = frag_color                                                                ;
+
+  color.a *= smoothstep( 0.5 - width, 0.5 + width, distance ) ;
+
+  if( color.a < 0.01 ) discard ;
+  out_color = color ;
+}
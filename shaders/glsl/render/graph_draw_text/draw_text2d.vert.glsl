@@ -0,0 +1,50 @@
+#version 450 core
+#extension GL_GOOGLE_include_directive    : enable
+#extension GL_ARB_separate_shader_objects : enable
+#include "Nyx.h"
+
+// The unit quad every glyph is drawn with.
+layout ( location = 0 ) in vec4 vertex ;
+
+     layout( location = 0 ) out vec2 frag_coords ;
+     layout( location = 1 ) out vec4 frag_color  ;
+flat layout( location = 2 ) out uint frag_page   ;
+
+// A single glyph to draw, see GlyphInstance in NyxText.h.
+struct Glyph
+{
+  vec4 rect      ; // The glyph's quad in the space of it's string, xy offset & zw size.
+  vec4 region    ; // The glyph's rectangle on it's atlas page, xy offset & zw size.
+  vec4 color     ;
+  uint page      ;
+  uint transform ;
+  uint mode      ; // Always a glyph here, see InstanceMode.
+  uint padding   ;
+};
+
+layout( binding = 1 ) uniform projection
+{
+  mat4 viewproj ;
+};
+
+layout( binding = 2 ) restrict readonly buffer transforms
+{
+  mat4 transform_list[] ;
+};
+
+layout( binding = 3 ) restrict readonly buffer glyphs
+{
+  Glyph glyph_list[] ;
+};
+
+void main()
+{
+  Glyph glyph    = glyph_list[ gl_InstanceIndex ]            ;
+  vec2  position = glyph.rect.xy + vertex.xy * glyph.rect.zw ;
+
+  frag_coords = glyph.region.xy + vertex.xy * glyph.region.zw ;
+  frag_color  = glyph.color                                   ;
+  frag_page   = glyph.page                                    ;
+
+  gl_Position = viewproj * transform_list[ glyph.transform ] * vec4( position, 0.0, 1.0 ) ;
+}
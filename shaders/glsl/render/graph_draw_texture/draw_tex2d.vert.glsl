@@ -8,6 +8,9 @@ layout ( location = 0 ) in vec4  vertex ;
 
      layout( location = 0 ) out vec2 frag_coords    ;
 flat layout( location = 1 ) out uint texture_index  ;
+flat layout( location = 2 ) out uint atlas_page     ;
+
+const uint NO_ATLAS = 0xFFFFFFFFu ;
 
 layout( binding = 1 ) uniform projection
 {
@@ -24,18 +27,40 @@ layout( binding = 3 ) buffer texture_id
   uint texture_ids[] ;
 };
 
+// The quad each instance draws. Quads are recorded with one instanced draw, so ids don't have to be contiguous.
+layout( binding = 6 ) buffer instance_id
+{
+  uint instance_ids[] ;
+};
+
+// Where each quad's image sits on it's atlas page, xy offset & zw size. Zero size for quads drawing a whole texture.
+layout( binding = 4 ) buffer atlas_region
+{
+  vec4 regions[] ;
+};
+
 void main()
 {
   mat4 model          ;
   mat4 projection     ;
   vec4 position       ;
   vec2 tex            ;
+  uint id             ;
 
+  id            = instance_ids[ gl_InstanceIndex ]     ;
   position      = vec4( vertex.x, vertex.y, 0.0, 1.0 ) ;
-  model         = transforms [ gl_InstanceIndex ]      ;
-  texture_index = texture_ids[ gl_InstanceIndex ]      ;
+  model         = transforms [ id ]                    ;
+  texture_index = texture_ids[ id ]                    ;
   projection    = proj                                 ;
   frag_coords   = vec2( vertex.z, vertex.w )           ;
+  atlas_page    = NO_ATLAS                             ;
+
+  // Quads in the atlas carry their page as texture id.
+  if( regions[ id ].z > 0.0 )
+  {
+    frag_coords = regions[ id ].xy + frag_coords * regions[ id ].zw ;
+    atlas_page  = texture_index                                     ;
+  }
 
   gl_Position = projection * model * position ;  
 }
\ No newline at end of file
@@ -0,0 +1,44 @@
+#version 450 core
+#extension GL_GOOGLE_include_directive    : enable
+#extension GL_ARB_separate_shader_objects : enable
+#include "Nyx.h"
+
+     layout( location = 0 ) in vec2 frag_tile      ;
+flat layout( location = 1 ) in uint frag_layer     ;
+flat layout( location = 2 ) in uint frag_tileset   ;
+flat layout( location = 3 ) in uint frag_tile_size ;
+
+layout( location = 0 ) out vec4 out_color ;
+
+layout( binding = 0 ) uniform sampler2D textures[ 1024 ] ; 
+
+// Every resident chunk, CHUNK * CHUNK tiles each. A tile is one past the tileset cell it shows, zero is empty.
+layout( binding = 3 ) restrict readonly buffer tiles
+{
+  uint cache[] ;
+};
+
+const uint CHUNK = 64 ; // Matches TILEMAP_CHUNK in NyxTilemap.h.
+
+void main()
+{
+  ivec2 tile  = clamp( ivec2( floor( frag_tile ) ), ivec2( 0 ), ivec2( CHUNK - 1 ) ) ;
+  uint  index = cache[ frag_layer * CHUNK * CHUNK + uint( tile.y ) * CHUNK + uint( tile.x ) ] ;
+  
+  if( index == 0 ) discard ;
+  index -= 1 ;
+  
+  vec2  size    = vec2( textureSize( textures[ frag_tileset ], 0 ) ) ;
+  float cell    = float( frag_tile_size )                            ;
+  uint  columns = max( 1u, uint( size.x ) / frag_tile_size )         ;
+  vec2  corner  = vec2( index % columns, index / columns ) * cell    ;
+  
+  // Half a texel stays inside the cell, so filtering never bleeds the neighbouring tile in.
+  vec2 inside = clamp( fract( frag_tile ) * cell, vec2( 0.5 ), vec2( cell - 0.5 ) ) ;
+  
+  // Gradients come from the continuous coordinate, fract() would have every tile edge pick the smallest mip.
+  vec2 dx = dFdx( frag_tile ) * cell / size ;
+  vec2 dy = dFdy( frag_tile ) * cell / size ;
+  
+  out_color = textureGrad( textures[ frag_tileset ], ( corner + inside ) / size, dx, dy ) ;
+}
@@ -0,0 +1,52 @@
+#version 450 core
+#extension GL_GOOGLE_include_directive    : enable
+#extension GL_ARB_separate_shader_objects : enable
+#include "Nyx.h"
+
+// The same unit quad sprites are drawn with.
+layout ( location = 0 ) in vec4 vertex ;
+
+     layout( location = 0 ) out vec2 frag_tile      ;
+flat layout( location = 1 ) out uint frag_layer     ;
+flat layout( location = 2 ) out uint frag_tileset   ;
+flat layout( location = 3 ) out uint frag_tile_size ;
+
+// A chunk drawn this frame, see TileChunk in NyxTilemap.h.
+struct Chunk
+{
+  vec4 rect     ; // xy first tile of the chunk, zw the tiles it spans.
+  uint layer    ;
+  uint padding0 ;
+  uint padding1 ;
+  uint padding2 ;
+};
+
+layout( binding = 1 ) uniform map
+{
+  mat4 viewproj  ;
+  uint tileset   ;
+  uint tile_size ;
+  uint padding0  ;
+  uint padding1  ;
+};
+
+layout( binding = 2 ) restrict readonly buffer chunks
+{
+  Chunk visible[] ;
+};
+
+const uint NO_CHUNK = 0xFFFFFFFFu ;
+
+void main()
+{
+  Chunk chunk = visible[ gl_InstanceIndex ] ;
+
+  frag_tile      = vertex.xy * chunk.rect.zw ;
+  frag_layer     = chunk.layer               ;
+  frag_tileset   = tileset                   ;
+  frag_tile_size = tile_size                 ;
+
+  // Slots without a chunk, or whose chunk hasn't streamed in yet, are moved out of the view volume & clipped.
+  if( chunk.layer == NO_CHUNK ) gl_Position = vec4( 2.0, 2.0, 2.0, 1.0 )                            ;
+  else                          gl_Position = viewproj * vec4( chunk.rect.xy + frag_tile, 0.0, 1.0 ) ;
+}
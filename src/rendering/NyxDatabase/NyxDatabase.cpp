@@ -25,8 +25,11 @@
 #include <Mars/Model.h>
 #include <Mars/Texture.h>
 #include <Mars/TextureArray.h>
+#include <templates/NyxLodChain.h>
+#include <templates/NyxAtlas.h>
 #include <NyxGPU/vkg/Vulkan.h>
 #include <NyxGPU/library/Image.h>
+#include <NyxGPU/library/Chain.h>
 #include <string>
 
 static const unsigned VERSION = 1 ;
@@ -36,6 +39,9 @@ namespace nyx
   using ModelManager   = mars::Manager<unsigned, mars::Model<Framework>>    ;
   using TextureManager = mars::Manager<unsigned, mars::Texture<Framework>>  ;
   using TextureArray   = mars::TextureArray<Framework>                      ;
+  using LodChain       = nyx::LodChain<Framework>                           ;
+  using Atlas          = nyx::Atlas<Framework>                              ;
+  using Token          = iris::config::json::Token                          ;
   using Log            = iris::log::Log                                     ;
   
   struct DatabaseData
@@ -51,6 +57,10 @@ namespace nyx
     TextureRequests             texture_request ;
     iris::config::Configuration database        ;
     unsigned                    device          ;
+    Atlas                       atlas           ;
+    nyx::Chain<Framework>       atlas_chain     ;
+    iris::Bus                   atlas_bus       ;
+    unsigned                    atlas_pages     ;
     
     /** Default constructor.
      */
@@ -63,12 +73,31 @@ namespace nyx
     void requestModel( unsigned model_id, ModelManager::Callback* cb ) ;
     void requestTexture( unsigned texture_id, TextureManager::Callback* cb ) ;
     void loadModels() ;
+    bool applyMaterials( const Token& model, mars::Reference<mars::Model<Framework>>& ref, const std::string& path ) ;
+    bool loadLods( const Token& model, mars::Reference<mars::Model<Framework>>& ref, const Token& models ) ;
     void loadTextures() ;
     bool loadTexture( unsigned id ) ;
     void setInputNames( unsigned idx, const char* name ) ;
     void setOutputName( const char* name ) ;
     void setDatabaseJSON( const char* name ) ;
     void setDevice( unsigned id ) ;
+    
+    /** Method to pack an image into the atlas. Safe to call from any thread, it is uploaded on the next execution.
+     * @param image The image to pack.
+     */
+    void addAtlasImage( const nyx::AtlasImage& image ) ;
+    
+    /** Method to upload the atlas pages changed since the last execution, & let every module using the atlas know.
+     */
+    void uploadAtlas() ;
+    
+    /** Method to retrieve the atlas shared by every module drawing 2D images.
+     * @return Const-reference to the atlas.
+     */
+    const Atlas& atlasRef() ;
+    void setAtlasInputName( const char* name ) ;
+    void setAtlasOutputName( const char* name ) ;
+    void setAtlasPages( unsigned count ) ;
   };
   
   bool DatabaseData::loadTexture( unsigned tex_id ) 
@@ -100,12 +129,96 @@ namespace nyx
     return false ;
   }
 
+  bool DatabaseData::applyMaterials( const Token& model, mars::Reference<mars::Model<Framework>>& ref, const std::string& path )
+  {
+    auto        materials = model[ "materials" ] ;
+    std::string mesh_name ;
+    bool        tex_dirty ;
+    
+    tex_dirty = false ;
+    for( unsigned material_index = 0; material_index < materials.size(); material_index++ )
+    {
+      unsigned index      = 0                                 ;
+      unsigned mesh_index = UINT32_MAX                        ;
+      auto&    meshes     = ref->meshes()                     ;
+      auto     mat        = materials.token( material_index ) ;
+      auto     diffuse    = mat[ "diffuse" ]                  ;
+       
+      mesh_name = mat[ "mesh" ].string() ;
+      index = 0 ;
+      for( auto& mesh : meshes )
+      {
+        if( mesh->name == mesh_name )
+        {
+          mesh_index = index ;
+        }
+        
+        index++ ;
+      }
+      
+      if( mesh_index != UINT32_MAX )
+      {
+        if( diffuse )
+        {
+          ref->setTexture( mesh_index, "diffuse", diffuse.number() ) ;
+          tex_dirty = tex_dirty || this->loadTexture( diffuse.number() ) ;
+          Log::output( "Module ", this->name.c_str(), " assigning diffuse texture ", diffuse.number(), " for model ", path.c_str(), " to mesh ", mesh_name.c_str() ) ;
+        }
+      }
+    }
+    
+    return tex_dirty ;
+  }
+  
+  bool DatabaseData::loadLods( const Token& model, mars::Reference<mars::Model<Framework>>& ref, const Token& models )
+  {
+    auto lods      = model[ "lods"   ] ;
+    auto radius    = model[ "radius" ] ;
+    bool tex_dirty = false             ;
+    
+    if( radius ) LodChain::setRadius( *ref, radius.decimal() ) ;
+    
+    for( unsigned lod_index = 0; lod_index < lods.size(); lod_index++ )
+    {
+      auto     lod  = lods.token( lod_index ) ;
+      unsigned id   = lod[ "ID"   ].number()  ;
+      float    size = lod[ "size" ].decimal() ;
+      
+      for( unsigned index = 0; index < models.size(); index++ )
+      {
+        auto        entry = models.token( index )    ;
+        std::string path  = entry[ "Path" ].string() ;
+        
+        if( entry[ "ID" ].number() != id ) continue ;
+        
+        if( ModelManager::has( id ) )
+        {
+          LodChain::add( *ref, ModelManager::reference( id ), size ) ;
+        }
+        else
+        {
+          Log::output( "Module ", this->name.c_str(), " loading level of detail ", lod_index + 1, " at ", path.c_str() ) ;
+          auto lod_ref = ModelManager::create( id, path.c_str(), this->device ) ;
+          if( !lod_ref )
+          {
+            Log::output( Log::Level::Warning, "Level of detail model ", path.c_str(), " failed to load!" ) ;
+            continue ;
+          }
+          
+          tex_dirty = this->applyMaterials( entry, lod_ref, path ) || tex_dirty ;
+          LodChain::add( *ref, lod_ref, size ) ;
+        }
+      }
+    }
+    
+    return tex_dirty ;
+  }
+
   void DatabaseData::loadModels()
   {
     const auto token = this->database.begin()[ "models" ] ;
     unsigned    id        ;
     std::string path      ;
-    std::string mesh_name ;
     bool        tex_dirty ;
     
     tex_dirty = false ;
@@ -115,8 +228,7 @@ namespace nyx
       {
         for( unsigned index = 0; index < token.size(); index++ )
         {
-          auto model     = token.token( index ) ;
-          auto materials = model[ "materials" ] ;
+          auto model = token.token( index ) ;
           id   = model[ "ID"   ].number() ;
           path = model[ "Path" ].string() ;
           
@@ -132,36 +244,8 @@ namespace nyx
             }
             else
             {
-              for( unsigned material_index = 0; material_index < materials.size(); material_index++ )
-              {
-                unsigned index      = 0                                 ;
-                unsigned mesh_index = UINT32_MAX                        ;
-                auto&    meshes     = ref->meshes()                     ;
-                auto     mat        = materials.token( material_index ) ;
-                auto     diffuse    = mat[ "diffuse" ]                  ;
-                 
-                mesh_name = mat[ "mesh" ].string() ;
-                index = 0 ;
-                for( auto& mesh : meshes )
-                {
-                  if( mesh->name == mesh_name )
-                  {
-                    mesh_index = index ;
-                  }
-                  
-                  index++ ;
-                }
-                
-                if( mesh_index != UINT32_MAX )
-                {
-                  if( diffuse )
-                  {
-                    ref->setTexture( mesh_index, "diffuse", diffuse.number() ) ;
-                    tex_dirty = tex_dirty || this->loadTexture( diffuse.number() ) ;
-                    Log::output( "Module ", this->name.c_str(), " assigning diffuse texture ", diffuse.number(), " for model ", path.c_str(), " to mesh ", mesh_name.c_str() ) ;
-                  }
-                }
-              }
+              tex_dirty = this->applyMaterials( model, ref, path ) || tex_dirty ;
+              tex_dirty = this->loadLods      ( model, ref, token ) || tex_dirty ;
               model_id.second->callback( id, ref ) ;
               delete model_id.second ;
               model_id.second = nullptr ;
@@ -242,6 +326,47 @@ namespace nyx
     }
   }
 
+  void DatabaseData::addAtlasImage( const nyx::AtlasImage& image )
+  {
+    if( !this->atlas.add( image ) )
+    {
+      Log::output( Log::Level::Warning, "Module ", this->name.c_str(), " has no atlas space left for image ", image.id, " of size ", image.width, "x", image.height ) ;
+    }
+  }
+  
+  void DatabaseData::uploadAtlas()
+  {
+    if( this->atlas_chain.initialized() && this->atlas.upload( this->atlas_chain ) )
+    {
+      this->atlas_chain.submit     () ;
+      this->atlas_chain.synchronize() ;
+      this->atlas_bus.emit() ;
+    }
+  }
+  
+  const Atlas& DatabaseData::atlasRef()
+  {
+    return this->atlas ;
+  }
+  
+  void DatabaseData::setAtlasInputName( const char* name )
+  {
+    Log::output( "Module ", this->name.c_str(), " set atlas image input signal as \"", name, "\"" ) ;
+    this->bus.enroll( this, &DatabaseData::addAtlasImage, iris::OPTIONAL, name ) ;
+  }
+  
+  void DatabaseData::setAtlasOutputName( const char* name )
+  {
+    Log::output( "Module ", this->name.c_str(), " set atlas output as \"", name, "\"" ) ;
+    this->atlas_bus.publish( this, &DatabaseData::atlasRef, name ) ;
+  }
+  
+  void DatabaseData::setAtlasPages( unsigned count )
+  {
+    Log::output( "Module ", this->name.c_str(), " set atlas page count as ", count ) ;
+    this->atlas_pages = count ;
+  }
+
   void DatabaseData::setDatabaseJSON( const char* name )
   {
     Log::output( "Module ", this->name.c_str(), " set database JSON file as \"", name, "\"" ) ;
@@ -282,9 +407,10 @@ namespace nyx
     ModelManager  ::addFulfiller( this, &DatabaseData::requestModel  , 0 ) ;
     TextureManager::addFulfiller( this, &DatabaseData::requestTexture, 0 ) ;
     
-    this->device    = 0  ;
-    this->name      = "" ;
-    this->json_path = "" ;
+    this->device      = 0           ;
+    this->name        = ""          ;
+    this->json_path   = ""          ;
+    this->atlas_pages = ATLAS_PAGES ;
   }
 
   Database::Database()
@@ -311,21 +437,30 @@ namespace nyx
     {
       mars::TextureArray<Framework>::set( index, data().default_tex ) ;
     }
+    
+    data().atlas_chain.initialize( data().device, nyx::ChainType::Compute             ) ;
+    data().atlas      .initialize( data().device, ATLAS_PAGE_SIZE, data().atlas_pages ) ;
   }
 
   void Database::subscribe( unsigned id )
   {
     
-    data().bus.setChannel( id ) ;
+    data().bus      .setChannel( id ) ;
+    data().atlas_bus.setChannel( id ) ;
     data().name = this->name() ;
     data().bus.enroll( this->module_data, &DatabaseData::setInputNames  , iris::OPTIONAL, this->name(), "::inputs"         ) ;
     data().bus.enroll( this->module_data, &DatabaseData::setOutputName  , iris::OPTIONAL, this->name(), "::output"         ) ;
     data().bus.enroll( this->module_data, &DatabaseData::setDatabaseJSON, iris::OPTIONAL, this->name(), "::path"           ) ;
     data().bus.enroll( this->module_data, &DatabaseData::setDevice      , iris::OPTIONAL, this->name(), "::device"         ) ;
+    data().bus.enroll( this->module_data, &DatabaseData::setAtlasInputName , iris::OPTIONAL, this->name(), "::atlas_input" ) ;
+    data().bus.enroll( this->module_data, &DatabaseData::setAtlasOutputName, iris::OPTIONAL, this->name(), "::atlas"       ) ;
+    data().bus.enroll( this->module_data, &DatabaseData::setAtlasPages     , iris::OPTIONAL, this->name(), "::atlas_pages" ) ;
   }
 
   void Database::shutdown()
   {
+    data().atlas.reset() ;
+    if( data().atlas_chain.initialized() ) data().atlas_chain.reset() ;
   }
 
   void Database::execute()
@@ -333,6 +468,7 @@ namespace nyx
     data().bus.wait() ;
     data().loadTextures() ;
     data().loadModels  () ;
+    data().uploadAtlas () ;
 //    data().bus.emit() ;
   }
 
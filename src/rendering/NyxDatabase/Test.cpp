@@ -23,10 +23,120 @@
  */
 
 #include "NyxDatabase.h"
+#include <templates/NyxAtlas.h>
 #include <Iris/data/Bus.h>
 #include <iostream>
+#include <random>
+#include <vector>
+#include <chrono>
+
+/** Function to pack random rectangles until the packer is full, then check none overlap or leave the page.
+ */
+static bool testPacker()
+{
+  constexpr unsigned SIZE = 1024 ;
+
+  nyx::SkylinePacker                      packer ( SIZE, SIZE        ) ;
+  std::vector<unsigned char>              covered( SIZE * SIZE, 0    ) ;
+  std::mt19937                            rng    ( 1337              ) ;
+  std::uniform_int_distribution<unsigned> side   ( 8, 64             ) ;
+  unsigned                                x                            ;
+  unsigned                                y                            ;
+  unsigned                                count = 0                    ;
+
+  const auto start = std::chrono::steady_clock::now() ;
+
+  for( ;; )
+  {
+    const unsigned width  = side( rng ) ;
+    const unsigned height = side( rng ) ;
+
+    if( !packer.pack( width, height, x, y ) ) break ;
+    if( x + width > SIZE || y + height > SIZE ) return false ;
+
+    for( unsigned row = y; row < y + height; row++ )
+    {
+      for( unsigned column = x; column < x + width; column++ )
+      {
+        if( covered[ row * SIZE + column ]++ ) return false ;
+      }
+    }
+
+    count++ ;
+  }
+
+  const auto end = std::chrono::steady_clock::now() ;
+
+  std::cout << "Skyline packer: " << "\n"
+            << "-- Rectangles : " << count                                                            << "\n"
+            << "-- Occupancy  : " << packer.occupancy()                                               << "\n"
+            << "-- Time       : " << std::chrono::duration<double, std::milli>( end - start ).count() << "ms" << std::endl ;
+
+  // Random sizes up to 64 pixels should still fill most of the page before the first miss.
+  return packer.occupancy() > 0.75f ;
+}
+
+/** Function to check images are copied to where they were packed, with their edges bled into the padding.
+ */
+static bool testAtlas()
+{
+  constexpr unsigned SIZE    = 256 ;
+  constexpr unsigned PADDING = 2   ;
+
+  nyx::AtlasPages            atlas                 ;
+  nyx::AtlasRect             rect                  ;
+  std::vector<unsigned char> image( 4 * 3 * 4 ) ;
+
+  atlas.initialize( SIZE, 2, PADDING ) ;
+
+  for( unsigned index = 0; index < image.size(); index++ ) image[ index ] = static_cast<unsigned char>( index ) ;
+
+  if( !atlas.add( { 0, image.data(), 4, 3 } ) || !atlas.find( 0, rect ) ) return false ;
+  if( rect.x < PADDING || rect.y < PADDING || rect.width != 4 || rect.height != 3 ) return false ;
+
+  for( int row = -static_cast<int>( PADDING ); row < 3 + static_cast<int>( PADDING ); row++ )
+  {
+    for( int column = -static_cast<int>( PADDING ); column < 4 + static_cast<int>( PADDING ); column++ )
+    {
+      const unsigned       source_row    = std::min( std::max( row   , 0 ), 2 )                                      ;
+      const unsigned       source_column = std::min( std::max( column, 0 ), 3 )                                      ;
+      const unsigned char* pixel         = atlas.pixels( rect.page ) + ( ( rect.y + row ) * SIZE + rect.x + column ) * 4 ;
+
+      for( unsigned channel = 0; channel < 4; channel++ )
+      {
+        if( pixel[ channel ] != image[ ( source_row * 4 + source_column ) * 4 + channel ] ) return false ;
+      }
+    }
+  }
+
+  // Fill both pages with 28x28 padded images, the next one has to be turned down.
+  std::vector<unsigned char> tile( 24 * 24 * 4, 255 ) ;
+  unsigned                   added = 0                ;
+
+  while( atlas.add( { added + 1, tile.data(), 24, 24 } ) ) added++ ;
+
+  if( !atlas.find( added, rect ) || rect.page != 1 || atlas.find( added + 1, rect ) ) return false ;
+
+  std::cout << "Atlas: " << "\n"
+            << "-- Images    : " << atlas.count()        << "\n"
+            << "-- Occupancy : " << atlas.occupancy( 0 ) << ", " << atlas.occupancy( 1 ) << std::endl ;
+
+  return atlas.count() == added + 1 ;
+}
 
 int main()
 {
+  if( !testPacker() )
+  {
+    std::cout << "Skyline packer test failed." << std::endl ;
+    return 1 ;
+  }
+
+  if( !testAtlas() )
+  {
+    std::cout << "Atlas test failed." << std::endl ;
+    return 1 ;
+  }
+
   return 0 ;
 }
\ No newline at end of file
@@ -0,0 +1,323 @@
+/*
+ * Copyright (C) 2020 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   NyxDraw2D.cpp
+ * Author: Jordan Hendl
+ *
+ * Created on April 14, 2021, 6:58 PM
+ */
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+
+#include "NyxDraw2D.h"
+#include "draw_2d.h"
+#include <NyxGPU/library/Array.h>
+#include <NyxGPU/library/Image.h>
+#include <NyxGPU/library/Chain.h>
+#include <NyxGPU/vkg/Vulkan.h>
+
+static const unsigned VERSION = 1 ;
+namespace nyx
+{
+  constexpr unsigned TRANSFORM_SIZE = 4096 ;
+
+  /** The unit quad every sprite, quad & glyph is drawn with.
+   */
+  const static glm::vec4 vertices[] =
+  {
+    glm::vec4( 0.0f, 1.0f, 0.0f, 0.0f ),
+    glm::vec4( 1.0f, 0.0f, 0.0f, 0.0f ),
+    glm::vec4( 0.0f, 0.0f, 0.0f, 0.0f ),
+    glm::vec4( 1.0f, 1.0f, 0.0f, 0.0f ),
+  };
+
+  const static unsigned indices[] = { 0, 1, 2, 0, 3, 1 } ;
+
+  NyxDraw2D::NyxDraw2DData::NyxDraw2DData()
+  {
+    this->command     = { 6, 0, 0, 0, 0 } ;
+    this->atlas       = nullptr           ;
+    this->source      = &this->builtin    ;
+    this->projection  = nullptr           ;
+    this->camera      = nullptr           ;
+    this->batch_dirty = true              ;
+    this->view_dirty  = true              ;
+    this->truncated   = false             ;
+  }
+
+  void NyxDraw2D::NyxDraw2DData::setText( unsigned id, const char* text )
+  {
+    this->batch.setText( id, text ) ;
+    this->batch_dirty = true ;
+  }
+
+  void NyxDraw2D::NyxDraw2DData::setColor( unsigned id, const glm::vec4& color )
+  {
+    this->batch.setColor( id, color ) ;
+    this->batch_dirty = true ;
+  }
+
+  void NyxDraw2D::NyxDraw2DData::setFrame( unsigned id, unsigned frame )
+  {
+    this->batch.setFrame( id, frame ) ;
+    this->batch_dirty = true ;
+  }
+
+  void NyxDraw2D::NyxDraw2DData::record( const nyx::DrawItem* items, unsigned count, nyx::Chain<Framework>& chain, nyx::Pipeline<Framework>& pipeline )
+  {
+    this->order.clear() ;
+
+    for( unsigned index = 0; index < count; index++ )
+    {
+      if( items[ index ].id < TRANSFORM_SIZE ) this->order.push_back( items[ index ].id ) ;
+    }
+
+    // Layers are the order of instances in the buffer, so however many there are this stays one draw.
+    chain.drawIndexedIndirect( pipeline, this->d_indices, this->d_vertices, this->d_command, 0, 1 ) ;
+    this->batch.setOrder( this->order.data(), this->order.size() ) ;
+    this->batch_dirty = true ;
+  }
+
+  void NyxDraw2D::NyxDraw2DData::updateBatch()
+  {
+    if( !this->batch_dirty ) return ;
+
+    if( this->batch.update() )
+    {
+      for( const nyx::TextRange& range : this->batch.uploads() )
+      {
+        this->copy_chain.copy( this->batch.instances(), this->d_instances, range.count, range.offset, range.offset ) ;
+      }
+
+      if( this->command.instance_count != this->batch.count() )
+      {
+        this->command.instance_count = this->batch.count() ;
+        this->copy_chain.copy( &this->command, this->d_command ) ;
+      }
+
+      if( this->batch.full() && !this->truncated )
+      {
+        Log::output( Log::Level::Warning, "Module NyxDraw2D drawing it's most instances, ", this->batch.count(), ". The rest are dropped." ) ;
+        this->truncated = true ;
+      }
+    }
+
+    this->glyph_atlas.upload( this->copy_chain ) ;
+    this->copy_chain.submit     () ;
+    this->copy_chain.synchronize() ;
+
+    this->batch_dirty = false ;
+  }
+
+  void NyxDraw2D::NyxDraw2DData::updateViewProj()
+  {
+    if( this->view_dirty )
+    {
+      const glm::mat4 projection = this->projection != nullptr ? *this->projection : glm::mat4( 1.0f ) ;
+      const glm::mat4 camera     = this->camera     != nullptr ? *this->camera     : glm::mat4( 1.0f ) ;
+      const glm::mat4 viewproj   = projection * camera                                                  ;
+
+      this->copy_chain.copy( &viewproj, this->d_viewproj ) ;
+      this->copy_chain.submit     () ;
+      this->copy_chain.synchronize() ;
+      this->view_dirty = false ;
+    }
+  }
+
+  NyxDraw2D::NyxDraw2D()
+  {
+    auto add = [=] ( unsigned id, nyx::Drawable2D& drawable )
+    {
+      this->data_2d.batch.add( id, drawable ) ;
+      this->data_2d.batch_dirty = true ;
+    };
+
+    // Sorted by layer, then id. Every kind goes out in the same draw, so there is no state to group by.
+    auto sort = [=] ( unsigned id, nyx::Drawable2D& drawable, nyx::DrawQueue& queue )
+    {
+      queue.push( nyx::makeLayerKey( drawable.layer, id ), id, 0 ) ;
+    };
+
+    auto record = [=] ( const nyx::DrawItem* items, unsigned count, nyx::Chain<Framework>& chain, nyx::Pipeline<Framework>& pipeline )
+    {
+      this->data_2d.record( items, count, chain, pipeline ) ;
+    };
+
+    NyxDrawModule::setTransformFlag     ( nyx::ArrayFlags::StorageBuffer                       ) ;
+    NyxDrawModule::setTransformKey      ( "transforms"                                         ) ;
+    NyxDrawModule::setTransformSize     ( TRANSFORM_SIZE                                       ) ;
+    NyxDrawModule::setPipeline          ( nyx::bytes::draw_2d, sizeof( nyx::bytes::draw_2d ) ) ;
+    NyxDrawModule::setAddCallback       ( add                                                  ) ;
+    NyxDrawModule::setSortCallback      ( sort                                                 ) ;
+    NyxDrawModule::setSortedDrawCallback( record                                               ) ;
+  }
+
+  NyxDraw2D::~NyxDraw2D()
+  {
+
+  }
+
+  void NyxDraw2D::initialize()
+  {
+    auto& data = this->data_2d ;
+
+    data.copy_chain .initialize( this->gpu(), nyx::ChainType::Compute                                                                   ) ;
+    data.d_viewproj .initialize( this->gpu(), 1                      , false, nyx::ArrayFlags::UniformBuffer                             ) ;
+    data.d_instances.initialize( this->gpu(), nyx::BATCH_2D_INSTANCES, false, nyx::ArrayFlags::StorageBuffer                             ) ;
+    data.d_command  .initialize( this->gpu(), 1                      , false, nyx::ArrayFlags::StorageBuffer | nyx::ArrayFlags::Indirect ) ;
+    data.d_vertices .initialize( this->gpu(), 4                      , false, nyx::ArrayFlags::Vertex                                    ) ;
+    data.d_indices  .initialize( this->gpu(), 6                      , false, nyx::ArrayFlags::Index                                     ) ;
+    data.no_atlas   .initialize( nyx::ImageFormat::RGBA8, this->gpu(), 1, 1, 1                                                           ) ;
+    data.glyph_atlas.initialize( this->gpu(), nyx::TEXT_ATLAS_SIZE, 1, 1                                                                 ) ;
+    data.glyphs     .initialize( data.source, &data.glyph_atlas                                                                          ) ;
+    data.runs       .initialize( &data.glyphs                                                                                            ) ;
+    data.batch      .initialize( &data.runs                                                                                              ) ;
+
+    // Sprites & quads draw nothing until the image atlas is set, but the binding has to be valid until then.
+    NyxDrawModule::pipeline().bind( "images"    , data.atlas != nullptr ? data.atlas->image() : data.no_atlas ) ;
+    NyxDrawModule::pipeline().bind( "glyphs"    , data.glyph_atlas.image()                                     ) ;
+    NyxDrawModule::pipeline().bind( "projection", data.d_viewproj                                              ) ;
+    NyxDrawModule::pipeline().bind( "instances" , data.d_instances                                             ) ;
+
+    data.copy_chain.copy( nyx::vertices, data.d_vertices ) ;
+    data.copy_chain.copy( nyx::indices , data.d_indices  ) ;
+    data.copy_chain.copy( &data.command, data.d_command  ) ;
+    data.copy_chain.submit     () ;
+    data.copy_chain.synchronize() ;
+  }
+
+  void NyxDraw2D::setAtlas( const nyx::Atlas<Framework>& atlas )
+  {
+    auto& data = this->data_2d ;
+
+    if( data.atlas != &atlas )
+    {
+      Log::output( "Module ", this->name(), " binding atlas." ) ;
+      Framework::deviceSynchronize( this->gpu() ) ;
+      this->pipeline().bind( "images", atlas.image() ) ;
+      Framework::deviceSynchronize( this->gpu() ) ;
+    }
+
+    // Called again every time the atlas packs new images, so sprites & quads waiting on theirs find them.
+    data.atlas       = &atlas ;
+    data.batch_dirty = true   ;
+    data.batch.setImages( &atlas ) ;
+  }
+
+  void NyxDraw2D::setAtlasInput( const char* input )
+  {
+    this->bus.enroll( this, &NyxDraw2D::setAtlas, iris::OPTIONAL, input ) ;
+  }
+
+  void NyxDraw2D::setFontName( const char* font_name )
+  {
+    this->font_name = font_name ;
+    this->bus.enroll( this, &NyxDraw2D::setFont, iris::OPTIONAL, font_name ) ;
+  }
+
+  void NyxDraw2D::setFont( const nyx::GlyphSource& source )
+  {
+    auto& data = this->data_2d ;
+
+    if( data.source == &source ) return ;
+
+    Log::output( "Module ", this->name(), " switching to font ", this->font_name.c_str(), "." ) ;
+
+    // Every glyph of the old font is dropped, text lays out again & pulls in the new font's glyphs.
+    data.source      = &source ;
+    data.batch_dirty = true    ;
+    data.glyph_atlas.AtlasPages::initialize( nyx::TEXT_ATLAS_SIZE, 1, 1 ) ;
+    data.glyphs     .initialize( data.source, &data.glyph_atlas ) ;
+    data.runs       .clear     () ;
+    data.batch      .invalidate() ;
+  }
+
+  void NyxDraw2D::subscribe( unsigned id )
+  {
+    this->bus        .setChannel( id ) ;
+    this->data_2d.bus.setChannel( id ) ;
+    NyxDrawModule::subscribe( this->bus ) ;
+
+    this->bus.enroll( this          , &NyxDraw2D::setAtlasInput          , iris::OPTIONAL, this->name(), "::atlas"       ) ;
+    this->bus.enroll( this          , &NyxDraw2D::setFontName            , iris::OPTIONAL, this->name(), "::font"        ) ;
+    this->bus.enroll( &this->data_2d, &NyxDraw2DData::setSize            , iris::OPTIONAL, this->name(), "::size"        ) ;
+    this->bus.enroll( &this->data_2d, &NyxDraw2DData::setCameraInput     , iris::OPTIONAL, this->name(), "::camera"      ) ;
+    this->bus.enroll( &this->data_2d, &NyxDraw2DData::setProjectionInput , iris::OPTIONAL, this->name(), "::projection"  ) ;
+    this->bus.enroll( &this->data_2d, &NyxDraw2DData::setTextInput       , iris::OPTIONAL, this->name(), "::text_input"  ) ;
+    this->bus.enroll( &this->data_2d, &NyxDraw2DData::setColorInput      , iris::OPTIONAL, this->name(), "::color_input" ) ;
+    this->bus.enroll( &this->data_2d, &NyxDraw2DData::setFrameInput      , iris::OPTIONAL, this->name(), "::frame_input" ) ;
+  }
+
+  void NyxDraw2D::shutdown()
+  {
+    NyxDrawModule::shutdown() ;
+    this->data_2d.d_viewproj .reset() ;
+    this->data_2d.d_instances.reset() ;
+    this->data_2d.d_command  .reset() ;
+    this->data_2d.d_vertices .reset() ;
+    this->data_2d.d_indices  .reset() ;
+    this->data_2d.no_atlas   .reset() ;
+    this->data_2d.glyph_atlas.reset() ;
+  }
+
+  void NyxDraw2D::execute()
+  {
+    this->draw() ;
+    this->data_2d.updateViewProj() ;
+    this->data_2d.updateBatch   () ;
+    this->bus.emit() ;
+  }
+}
+
+// <editor-fold defaultstate="collapsed" desc="Exported function definitions">
+/** Exported function to retrive the name of this module type.
+ * @return The name of this object's type.
+ */
+exported_function const char* name()
+{
+  return "NyxDraw2D" ;
+}
+
+/** Exported function to retrieve the version of this module.
+ * @return The version of this module.
+ */
+exported_function unsigned version()
+{
+  return VERSION ;
+}
+
+/** Exported function to make one instance of this module.
+ * @return A single instance of this module.
+ */
+exported_function ::iris::Module* make()
+{
+  return new nyx::NyxDraw2D() ;
+}
+
+/** Exported function to destroy an instance of this module.
+ * @param module A Pointer to a Module object that is of this type.
+ */
+exported_function void destroy( ::iris::Module* module )
+{
+  ::nyx::NyxDraw2D* mod ;
+
+  mod = dynamic_cast<nyx::NyxDraw2D*>( module ) ;
+  delete mod ;
+}
+// </editor-fold>
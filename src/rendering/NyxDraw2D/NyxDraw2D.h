@@ -0,0 +1,167 @@
+/*
+ * Copyright (C) 2020 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <templates/NyxDrawModule.h>
+#include <templates/NyxBatch2D.h>
+#include <Iris/data/Bus.h>
+#include <string>
+
+namespace nyx
+{
+  /** A module drawing sprites, textured quads & text together, for 2D scenes & UI.
+   * Every drawable is one or more instances of a single quad in one instance buffer, sorted by layer. Sprites & quads sample the shared image atlas,
+   * glyphs this module's distance field atlas, so the whole scene is a single indirect draw with one pipeline, whatever it's layers.
+   */
+  class NyxDraw2D : public nyx::NyxDrawModule<nyx::Drawable2D>
+  {
+    public:
+
+      /** Default Constructor.
+       */
+      NyxDraw2D() ;
+
+      /** Virtual deconstructor. Needed for inheritance.
+       */
+      ~NyxDraw2D() ;
+
+      /** Method to initialize this module after being configured.
+       */
+      void initialize() ;
+
+      /** Method to subscribe this module's configuration to the bus.
+       * @param id The id to use for this graph.
+       */
+      void subscribe( unsigned id ) ;
+
+      /** Method to shut down this object's operation.
+       */
+      void shutdown() ;
+
+      /** Method to execute a single instance of this module's operation.
+       */
+      void execute() ;
+
+      /** Method to set the atlas sprites & quads are drawn from, binding it's image the first time it is set.
+       * @param atlas The atlas to draw from.
+       */
+      void setAtlas( const nyx::Atlas<Framework>& atlas ) ;
+
+      /** Method to set the name of the atlas input.
+       * @param input The name to associate with the atlas input.
+       */
+      void setAtlasInput( const char* input ) ;
+
+      /** Method to set the name of the font to draw text with, the bus key a nyx::GlyphSource is published under.
+       * Until one is published, the built-in font is used.
+       * @param string The name of the font.
+       */
+      void setFontName( const char* string ) ;
+
+      /** Method to set the font to draw text with, rasterizing every glyph again.
+       * @param source The font.
+       */
+      void setFont( const nyx::GlyphSource& source ) ;
+
+    private:
+      struct NyxDraw2DData
+      {
+        /** Structure describing the indirect draw of every instance. A VkDrawIndexedIndirectCommand.
+         */
+        struct DrawCommand
+        {
+          unsigned index_count    ;
+          unsigned instance_count ;
+          unsigned first_index    ;
+          int      vertex_offset  ;
+          unsigned first_instance ;
+        };
+
+        nyx::Chain<Framework>                     copy_chain  ;
+        nyx::Array<Framework, glm::mat4>          d_viewproj  ;
+        nyx::Array<Framework, nyx::GlyphInstance> d_instances ;
+        nyx::Array<Framework, DrawCommand>        d_command   ;
+        nyx::Array<Framework, glm::vec4>          d_vertices  ;
+        nyx::Array<Framework, unsigned>           d_indices   ;
+        nyx::Atlas<Framework>                     glyph_atlas ;
+        nyx::Image<Framework>                     no_atlas    ;
+        nyx::BitmapFont                           builtin     ;
+        nyx::GlyphSet                             glyphs      ;
+        nyx::TextRunCache                         runs        ;
+        nyx::Batch2D                              batch       ;
+        std::vector<unsigned>                     order       ;
+        DrawCommand                               command     ;
+        iris::Bus                                 bus         ;
+        const nyx::Atlas<Framework>*              atlas       ;
+        const nyx::GlyphSource*                   source      ;
+        const glm::mat4*                          projection  ;
+        const glm::mat4*                          camera      ;
+        bool                                      batch_dirty ;
+        bool                                      view_dirty  ;
+        bool                                      truncated   ;
+
+        NyxDraw2DData() ;
+        void setProjectionInput( const char* input    ) { this->bus.enroll( this, &NyxDraw2DData::setProjection, iris::OPTIONAL, input ) ; } ;
+        void setCameraInput    ( const char* input    ) { this->bus.enroll( this, &NyxDraw2DData::setCamera    , iris::OPTIONAL, input ) ; } ;
+        void setTextInput      ( const char* input    ) { this->bus.enroll( this, &NyxDraw2DData::setText      , iris::OPTIONAL, input ) ; } ;
+        void setColorInput     ( const char* input    ) { this->bus.enroll( this, &NyxDraw2DData::setColor     , iris::OPTIONAL, input ) ; } ;
+        void setFrameInput     ( const char* input    ) { this->bus.enroll( this, &NyxDraw2DData::setFrame     , iris::OPTIONAL, input ) ; } ;
+        void setProjection     ( const glm::mat4& val ) { this->projection = &val ; this->view_dirty = true ;                              } ;
+        void setCamera         ( const glm::mat4& val ) { this->camera     = &val ; this->view_dirty = true ;                              } ;
+        void setSize           ( float val            ) { this->batch.setSize( val ) ; this->batch_dirty = true ;                          } ;
+
+        /** Method to change the string of a text drawable. Setting the string it already draws does nothing.
+         * @param id The drawable to change.
+         * @param text The string to draw.
+         */
+        void setText( unsigned id, const char* text ) ;
+
+        /** Method to change the color a drawable is tinted with.
+         * @param id The drawable to change.
+         * @param color The color to tint the drawable with.
+         */
+        void setColor( unsigned id, const glm::vec4& color ) ;
+
+        /** Method to change the cell of it's sheet a sprite shows.
+         * @param id The sprite to change.
+         * @param frame The cell, counted row by row.
+         */
+        void setFrame( unsigned id, unsigned frame ) ;
+
+        /** Method to record the draw of every instance. Only the order of drawables is kept, instances are written by @updateBatch.
+         * @param items The drawables to draw, sorted by layer.
+         * @param count The amount of drawables to draw.
+         * @param chain The chain to record into.
+         * @param pipeline The pipeline to draw with.
+         */
+        void record( const nyx::DrawItem* items, unsigned count, nyx::Chain<Framework>& chain, nyx::Pipeline<Framework>& pipeline ) ;
+
+        /** Method to upload the instances of drawables that changed, new glyphs & the draw's instance count.
+         */
+        void updateBatch() ;
+
+        /** Method to upload the projection times the camera, if either changed.
+         */
+        void updateViewProj() ;
+      };
+
+      NyxDraw2DData data_2d   ;
+      std::string   font_name ;
+      iris::Bus     bus       ;
+  };
+}
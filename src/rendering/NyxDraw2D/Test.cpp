@@ -0,0 +1,332 @@
+/*
+ * Copyright (C) 2020 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   Test.cpp
+ * Author: jhendl
+ *
+ * Created on April 17, 2021, 1:30 AM
+ */
+
+#include <templates/NyxBatch2D.h>
+#include <templates/NyxDrawQueue.h>
+#include <templates/NyxUpdateQueue.h>
+#include <glm/glm.hpp>
+#include <chrono>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <climits>
+
+/** Sorts a batch's drawables by layer the way the module does, & hands the batch the order.
+ */
+static void sortLayers( nyx::Batch2D& batch, const std::vector<nyx::Drawable2D>& drawables, nyx::DrawQueue& queue, std::vector<unsigned>& order )
+{
+  queue.clear() ;
+  order.clear() ;
+
+  for( unsigned id = 0; id < drawables.size(); id++ ) queue.push( nyx::makeLayerKey( drawables[ id ].layer, id ), id, 0 ) ;
+  queue.sort() ;
+
+  for( unsigned index = 0; index < queue.size(); index++ ) order.push_back( queue.data()[ index ].id ) ;
+  batch.setOrder( order.data(), order.size() ) ;
+}
+
+/** Draws a sprite, a quad & a label on different layers, checking instances come out in layer order with the right cell of the sheet,
+ * that a new frame is patched in place & that a quad waiting on it's image shows up once the atlas has it.
+ */
+static bool testLayers()
+{
+  nyx::BitmapFont                 font                                ;
+  nyx::AtlasPages                 glyph_atlas                         ;
+  nyx::AtlasPages                 images                              ;
+  nyx::GlyphSet                   glyphs                              ;
+  nyx::TextRunCache               runs                                ;
+  nyx::Batch2D                    batch                               ;
+  nyx::DrawQueue                  queue                               ;
+  nyx::AtlasRect                  sheet                               ;
+  std::vector<unsigned>           order                               ;
+  std::vector<unsigned char>      pixels    ( 64 * 64 * 4, 255      ) ;
+  std::vector<nyx::Drawable2D>    drawables ( 3                     ) ;
+  std::vector<nyx::GlyphInstance> label     ( 8                     ) ;
+
+  glyph_atlas.initialize( nyx::TEXT_ATLAS_SIZE, 1, 1 ) ;
+  images     .initialize( 256, 1, 0 ) ;
+  glyphs     .initialize( &font, &glyph_atlas ) ;
+  runs       .initialize( &glyphs ) ;
+  batch      .initialize( &runs, 64 ) ;
+  batch      .setImages( &images ) ;
+
+  images.add( { 7, pixels.data(), 64, 64 } ) ;
+  images.find( 7, sheet ) ;
+
+  drawables[ 0 ].kind    = nyx::Primitive2D::Quad   ; drawables[ 0 ].layer = 2 ; drawables[ 0 ].image = 9 ;
+  drawables[ 1 ].kind    = nyx::Primitive2D::Sprite ; drawables[ 1 ].layer = 1 ; drawables[ 1 ].image = 7 ;
+  drawables[ 1 ].columns = 2                        ; drawables[ 1 ].rows  = 2 ; drawables[ 1 ].frame = 3 ;
+  drawables[ 2 ].kind    = nyx::Primitive2D::Text   ; drawables[ 2 ].layer = 0 ; drawables[ 2 ].text  = "hp" ;
+
+  for( unsigned id = 0; id < drawables.size(); id++ ) batch.add( id, drawables[ id ] ) ;
+  sortLayers( batch, drawables, queue, order ) ;
+
+  // The quad's image isn't packed yet, so it draws nothing. The label is under the sprite.
+  if( !batch.update() || batch.count() != 3                                                          ) return false ;
+  if( glyphs.layout( "hp", 32.0f, 2, glm::vec4( 1.0f ), label.data(), label.size() ) != 2            ) return false ;
+  if( std::memcmp( batch.instances(), label.data(), 2 * sizeof( nyx::GlyphInstance ) ) != 0          ) return false ;
+
+  const nyx::GlyphInstance& sprite = batch.instances()[ 2 ] ;
+
+  if( sprite.mode != nyx::InstanceMode::Image || sprite.transform != 1 || sprite.page != sheet.page   ) return false ;
+  if( sprite.region.x != sheet.region.x + sheet.region.z * 0.5f                                      ) return false ;
+  if( sprite.region.y != sheet.region.y + sheet.region.w * 0.5f || sprite.region.z != sheet.region.z * 0.5f ) return false ;
+
+  // A new frame keeps the sprite a single instance, so only it is uploaded.
+  batch.setFrame( 1, 0 ) ;
+  if( !batch.update() || batch.uploads().size() != 1 || batch.uploads()[ 0 ].offset != 2             ) return false ;
+  if( batch.instances()[ 2 ].region.x != sheet.region.x || batch.instances()[ 2 ].region.y != sheet.region.y ) return false ;
+
+  // Once the atlas has the quad's image, it's drawn over everything else.
+  images.add( { 9, pixels.data(), 16, 16 } ) ;
+  batch.setImages( &images ) ;
+  if( !batch.update() || batch.count() != 4 || batch.instances()[ 3 ].transform != 0                ) return false ;
+  if( std::memcmp( batch.instances(), label.data(), 2 * sizeof( nyx::GlyphInstance ) ) != 0          ) return false ;
+
+  // Moving the label to the top layer moves it's glyphs to the end.
+  drawables[ 2 ].layer = 3 ;
+  sortLayers( batch, drawables, queue, order ) ;
+  if( !batch.update() || batch.instances()[ 0 ].transform != 1 || batch.instances()[ 1 ].transform != 0 ) return false ;
+
+  return std::memcmp( batch.instances() + 2, label.data(), 2 * sizeof( nyx::GlyphInstance ) ) == 0 ;
+}
+
+/** Runs a UI of 8 layers, each with 200 animated sprites, 50 quads & 20 labels, against what drawing it with the three separate modules takes.
+ * Separate modules can't interleave layers within one draw, so every layer costs each of them a pipeline & a draw of it's own.
+ * The host side of the separate modules is timed doing what NyxDrawSprite, NyxDrawTex2D & NyxDrawText2D do for one layer each.
+ */
+static bool testBenchmark()
+{
+  constexpr unsigned LAYERS  = 8   ;
+  constexpr unsigned SPRITES = 200 ;
+  constexpr unsigned QUADS   = 50  ;
+  constexpr unsigned LABELS  = 20  ;
+  constexpr unsigned FRAMES  = 200 ;
+  constexpr unsigned KINDS   = 3   ;
+
+  /** NyxDrawSprite's sprite record, uploaded whenever a sprite changes.
+   */
+  struct Sprite
+  {
+    glm::vec4 uv          ;
+    unsigned  tex_index   ;
+    unsigned  atlas_page  ;
+    unsigned  columns     ;
+    unsigned  first_frame ;
+    unsigned  frame_count ;
+    float     fps         ;
+    unsigned  loop        ;
+    float     start_time  ;
+  };
+
+  /** NyxDrawSprite's queued change to a sprite.
+   */
+  struct SpriteUpdate
+  {
+    unsigned  kind      ;
+    unsigned  id        ;
+    unsigned  value     ;
+    glm::mat4 transform ;
+  };
+
+  nyx::BitmapFont              font                                               ;
+  nyx::AtlasPages              glyph_atlas                                        ;
+  nyx::AtlasPages              images                                             ;
+  nyx::GlyphSet                glyphs                                             ;
+  nyx::TextRunCache            runs                                               ;
+  nyx::Batch2D                 batch                                              ;
+  nyx::DrawQueue               queue                                              ;
+  std::vector<unsigned>        order                                              ;
+  std::vector<unsigned char>   pixels    ( 32 * 32 * 4, 255                     ) ;
+  std::vector<nyx::Drawable2D> drawables ( LAYERS * ( SPRITES + QUADS + LABELS ) ) ;
+  double                       total     = 0.0                                      ;
+  double                       uploaded  = 0.0                                      ;
+  double                       separate  = 0.0                                      ;
+  double                       sent      = 0.0                                      ;
+  unsigned                     glyphed   = 0                                        ;
+
+  std::vector<nyx::TextBatch>                 texts   ( LAYERS                                           ) ;
+  std::vector<nyx::UpdateQueue<SpriteUpdate>> queues  ( LAYERS                                           ) ;
+  std::vector<std::vector<Sprite>>            sprites ( LAYERS, std::vector<Sprite>( SPRITES, Sprite() ) ) ;
+  std::vector<std::vector<nyx::AtlasRect>>    cells   ( LAYERS, std::vector<nyx::AtlasRect>( SPRITES )   ) ;
+
+  glyph_atlas.initialize( nyx::TEXT_ATLAS_SIZE, 1, 1 ) ;
+  images     .initialize() ;
+  glyphs     .initialize( &font, &glyph_atlas ) ;
+  runs       .initialize( &glyphs ) ;
+  batch      .initialize( &runs ) ;
+
+  for( unsigned image = 0; image < 16; image++ ) images.add( { image, pixels.data(), 32, 32 } ) ;
+  batch.setImages( &images ) ;
+
+  for( unsigned id = 0; id < drawables.size(); id++ )
+  {
+    const unsigned slot = id % ( SPRITES + QUADS + LABELS ) ;
+
+    drawables[ id ].layer = id / ( SPRITES + QUADS + LABELS ) ;
+    drawables[ id ].image = id % 16                           ;
+
+    if( slot < SPRITES )
+    {
+      drawables[ id ].kind    = nyx::Primitive2D::Sprite ;
+      drawables[ id ].columns = 4                        ;
+      drawables[ id ].rows    = 4                        ;
+    }
+    else if( slot < SPRITES + QUADS )
+    {
+      drawables[ id ].kind = nyx::Primitive2D::Quad ;
+    }
+    else
+    {
+      drawables[ id ].kind = nyx::Primitive2D::Text                ;
+      drawables[ id ].text = "Score: " + std::to_string( id * 10 ) ;
+    }
+
+    batch.add( id, drawables[ id ] ) ;
+  }
+
+  sortLayers( batch, drawables, queue, order ) ;
+  batch.update() ;
+
+  // One text module per layer, each laying out only it's own labels. Sprites know where their sheet is in the atlas up front.
+  for( unsigned layer = 0; layer < LAYERS; layer++ )
+  {
+    const unsigned        first  = layer * ( SPRITES + QUADS + LABELS ) ;
+    std::vector<unsigned> labels                                        ;
+
+    texts[ layer ].initialize( &runs, LABELS * 64 ) ;
+
+    for( unsigned index = 0; index < LABELS; index++ )
+    {
+      const unsigned id = first + SPRITES + QUADS + index ;
+
+      texts[ layer ].setText( id, drawables[ id ].text ) ;
+      labels.push_back( id ) ;
+    }
+
+    texts[ layer ].setOrder( labels.data(), labels.size() ) ;
+    texts[ layer ].update() ;
+
+    for( unsigned index = 0; index < SPRITES; index++ ) images.find( drawables[ first + index ].image, cells[ layer ][ index ] ) ;
+  }
+
+  for( unsigned frame = 0; frame < FRAMES; frame++ )
+  {
+    auto start = std::chrono::high_resolution_clock::now() ;
+
+    // Sprites step their animation every frame, a twentieth of the labels change.
+    for( unsigned id = 0; id < drawables.size(); id++ )
+    {
+      const unsigned slot = id % ( SPRITES + QUADS + LABELS ) ;
+
+      if     ( slot < SPRITES                                      ) batch.setFrame( id, frame % 16 ) ;
+      else if( slot >= SPRITES + QUADS && ( id + frame ) % 20 == 0 ) batch.setText( id, "Score: " + std::to_string( ( id + frame ) * 10 ) ) ;
+    }
+
+    batch.update() ;
+
+    total += std::chrono::duration<double, std::milli>( std::chrono::high_resolution_clock::now() - start ).count() ;
+
+    for( const nyx::TextRange& range : batch.uploads() ) uploaded += range.count * sizeof( nyx::GlyphInstance ) ;
+
+    start = std::chrono::high_resolution_clock::now() ;
+
+    // Sprites are set off the bus into each sprite module's queue, which is drained into it's sprite records once per frame.
+    // Quads don't change, so the Tex2D modules keep their recorded draws & do nothing.
+    glyphed = 0 ;
+    for( unsigned layer = 0; layer < LAYERS; layer++ )
+    {
+      const unsigned first = layer * ( SPRITES + QUADS + LABELS ) ;
+      unsigned       begin = UINT_MAX                            ;
+      unsigned       end   = 0                                   ;
+
+      auto apply = [&] ( const SpriteUpdate& update )
+      {
+        const nyx::AtlasRect& rect   = cells[ layer ][ update.id ]                             ;
+        const unsigned        cell   = update.value % 16                                       ;
+        const glm::vec2       extent = glm::vec2( rect.region.z / 4.0f, rect.region.w / 4.0f ) ;
+
+        sprites[ layer ][ update.id ].uv         = glm::vec4( rect.region.x + ( cell % 4 ) * extent.x, rect.region.y + ( cell / 4 ) * extent.y, extent.x, extent.y ) ;
+        sprites[ layer ][ update.id ].atlas_page = rect.page                                                                                                         ;
+        sprites[ layer ][ update.id ].columns    = 4                                                                                                                 ;
+
+        begin = std::min( begin, update.id     ) ;
+        end   = std::max( end  , update.id + 1 ) ;
+      };
+
+      for( unsigned index = 0; index < SPRITES; index++ )
+      {
+        const SpriteUpdate update = { 0, index, frame % 16, glm::mat4( 1.0f ) } ;
+
+        while( !queues[ layer ].push( update ) ) queues[ layer ].drain( apply ) ;
+      }
+
+      queues[ layer ].drain( apply ) ;
+      if( begin < end ) sent += ( end - begin ) * sizeof( Sprite ) ;
+
+      for( unsigned index = 0; index < LABELS; index++ )
+      {
+        const unsigned id = first + SPRITES + QUADS + index ;
+
+        if( ( id + frame ) % 20 == 0 ) texts[ layer ].setText( id, "Score: " + std::to_string( ( id + frame ) * 10 ) ) ;
+      }
+
+      texts[ layer ].update() ;
+
+      for( const nyx::TextRange& range : texts[ layer ].uploads() ) sent += range.count * sizeof( nyx::GlyphInstance ) ;
+      glyphed += texts[ layer ].count() ;
+    }
+
+    separate += std::chrono::duration<double, std::milli>( std::chrono::high_resolution_clock::now() - start ).count() ;
+  }
+
+  std::cout << "Drawing a UI of " << LAYERS << " layers, " << SPRITES << " sprites, " << QUADS << " quads & " << LABELS << " labels each, " << FRAMES << " frames: " << "\n"
+            << "-- Instances per frame                : " << batch.count()               << "\n"
+            << "-- Draws & pipeline binds, NyxDraw2D  : " << 1                           << "\n"
+            << "-- Draws & pipeline binds, per module : " << LAYERS * KINDS              << "\n"
+            << "-- Instance bytes uploaded per frame  : " << uploaded / FRAMES / 1024.0 << "KB" << "\n"
+            << "-- Bytes uploaded per frame, modules  : " << sent     / FRAMES / 1024.0 << "KB" << "\n"
+            << "-- Host time per frame, NyxDraw2D     : " << total    / FRAMES          << "ms" << "\n"
+            << "-- Host time per frame, per module    : " << separate / FRAMES          << "ms" << std::endl ;
+
+  return !batch.full() && batch.count() > LAYERS * ( SPRITES + QUADS + LABELS ) && glyphed != 0 ;
+}
+
+int main()
+{
+  if( !testLayers() )
+  {
+    std::cout << "2D batch layer test failed." << std::endl ;
+    return 1 ;
+  }
+
+  if( !testBenchmark() )
+  {
+    std::cout << "2D batch benchmark failed." << std::endl ;
+    return 1 ;
+  }
+
+  return 0 ;
+}
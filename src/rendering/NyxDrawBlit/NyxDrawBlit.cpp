@@ -27,6 +27,7 @@
 
 #include "NyxDrawBlit.h"
 #include "blit.h"
+#include "resample.h"
 #include <NyxGPU/library/Image.h>
 #include <NyxGPU/library/Chain.h>
 #include <NyxGPU/vkg/Vulkan.h>
@@ -65,12 +66,35 @@ namespace nyx
   
   void NyxDrawBlit::initialize()
   {
-    this->data.vertices  .initialize( this->gpu(), 6, false, nyx::ArrayFlags::Vertex ) ;
-    this->data.copy_chain.initialize( this->gpu(), nyx::ChainType::Compute           ) ;
+    auto& data = this->data ;
+
+    data.vertices  .initialize( this->gpu(), 6, false, nyx::ArrayFlags::Vertex ) ;
+    data.copy_chain.initialize( this->gpu(), nyx::ChainType::Compute           ) ;
+    
+    data.copy_chain.copy( nyx::vertices, data.vertices ) ;
+    
+    if( data.transfer )
+    {
+      // Resampling writes the image the quad samples from compute, in the same chain as the transfers.
+      if( data.filter != nyx::ResampleFilter::Bilinear )
+      {
+        data.display   .setUsage  ( nyx::ImageUsage::Storage                                           ) ;
+        data.horizontal.initialize( this->gpu(), nyx::bytes::resample, sizeof( nyx::bytes::resample ) ) ;
+        data.vertical  .initialize( this->gpu(), nyx::bytes::resample, sizeof( nyx::bytes::resample ) ) ;
+      }
+      
+      // The quad always samples this image, so it is bound once & inputs are copied into it.
+      data.transfer_chain.initialize( this->gpu(), nyx::ChainType::Graphics                                                     ) ;
+      data.display       .initialize( nyx::ImageFormat::RGBA32F, this->gpu(), this->viewportWidth(), this->viewportHeight(), 1 ) ;
+      
+      data.copy_chain.transition( data.display, nyx::ImageLayout::General ) ;
+      this->pipeline().bind( "tex", data.display ) ;
+    }
     
-    this->data.copy_chain.copy( nyx::vertices, this->data.vertices ) ;
-    this->data.copy_chain.submit     () ;
-    this->data.copy_chain.synchronize() ;
+    data.copy_chain.submit     () ;
+    data.copy_chain.synchronize() ;
+    
+    data.initialized = true ;
   }
   
   void NyxDrawBlit::subscribe( unsigned id )
@@ -78,21 +102,147 @@ namespace nyx
     this->data.bus.setChannel( id ) ;
     NyxDrawModule::subscribe( this->data.bus ) ;
     
-    this->data.bus.enroll( &this->data, &NyxDrawBlitData::setInputName, iris::OPTIONAL, this->name(), "::image" ) ;
+    this->data.bus.enroll( &this->data, &NyxDrawBlitData::setInputName, iris::OPTIONAL, this->name(), "::image"    ) ;
+    this->data.bus.enroll( &this->data, &NyxDrawBlitData::setTransfer , iris::OPTIONAL, this->name(), "::transfer" ) ;
+    this->data.bus.enroll( &this->data, &NyxDrawBlitData::setFilter   , iris::OPTIONAL, this->name(), "::filter"   ) ;
   }
   
   void NyxDrawBlit::shutdown()
   {
+    if( this->data.pending ) this->data.transfer_chain.synchronize() ;
+    
     NyxDrawModule::shutdown() ;
+    this->data.display  .reset() ;
+    this->data.between  .reset() ;
+    this->data.d_spans  .reset() ;
+    this->data.d_weights.reset() ;
+  }
+  
+  void NyxDrawBlit::prepareResample( const nyx::Image<Framework>& input )
+  {
+    auto& data = this->data ;
+    
+    data.kernel.build( data.filter, input.width(), input.height(), data.display.width(), data.display.height() ) ;
+    
+    // The horizontal pass goes first, so the vertical one reads an image already narrowed to the output's width.
+    data.between  .reset() ;
+    data.d_spans  .reset() ;
+    data.d_weights.reset() ;
+    data.between  .setUsage  ( nyx::ImageUsage::Storage                                                         ) ;
+    data.between  .initialize( nyx::ImageFormat::RGBA32F, this->gpu(), data.display.width(), input.height(), 1 ) ;
+    data.d_spans  .initialize( this->gpu(), data.kernel.spans  ().size(), false, nyx::ArrayFlags::StorageBuffer ) ;
+    data.d_weights.initialize( this->gpu(), data.kernel.weights().size(), false, nyx::ArrayFlags::StorageBuffer ) ;
+    
+    data.copy_chain.transition( data.between, nyx::ImageLayout::General                                          ) ;
+    data.copy_chain.copy      ( data.kernel.spans  ().data(), data.d_spans  , data.kernel.spans  ().size(), 0, 0 ) ;
+    data.copy_chain.copy      ( data.kernel.weights().data(), data.d_weights, data.kernel.weights().size(), 0, 0 ) ;
+    data.copy_chain.submit     () ;
+    data.copy_chain.synchronize() ;
+    
+    data.horizontal.bind( "input_tex" , input          ) ;
+    data.horizontal.bind( "output_tex", data.between   ) ;
+    data.horizontal.bind( "spans"     , data.d_spans   ) ;
+    data.horizontal.bind( "weights"   , data.d_weights ) ;
+    data.vertical  .bind( "input_tex" , data.between   ) ;
+    data.vertical  .bind( "output_tex", data.display   ) ;
+    data.vertical  .bind( "spans"     , data.d_spans   ) ;
+    data.vertical  .bind( "weights"   , data.d_weights ) ;
+    
+    for( unsigned axis = 0; axis < 2; axis++ )
+    {
+      if( !data.kernel.tiled( axis ) ) Log::output( Log::Level::Warning, "Module ", this->name(), " shrinking too far for the ", axis == 0 ? "horizontal" : "vertical", " pass to fit shared memory, reading it's input directly." ) ;
+    }
+  }
+  
+  void NyxDrawBlit::transfer( const nyx::Image<Framework>& input )
+  {
+    auto& data = this->data ;
+    
+    // Copies need matching formats as well as sizes, anything else is converted by a blit.
+    const bool same = input.width() == data.display.width() && input.height() == data.display.height() && input.format() == data.display.format() ;
+    
+    // The last transfer was submitted a frame ago, so this only waits if the device is that far behind.
+    if( data.pending )
+    {
+      data.transfer_chain.synchronize() ;
+      data.pending = false ;
+    }
+    
+    if( data.bound != &input || data.bound_width != input.width() || data.bound_height != input.height() )
+    {
+      // The first pass reads the input as an rgba32f storage image, so anything else is blitted instead.
+      const bool filtered = !same && data.filter != nyx::ResampleFilter::Bilinear                                       ;
+      const bool storable = input.format() == nyx::ImageFormat::RGBA32F && input.usage() == nyx::ImageUsage::Storage ;
+      
+      data.bound        = &input                ;
+      data.bound_width  = input.width ()        ;
+      data.bound_height = input.height()        ;
+      data.resampling   = filtered && storable ;
+      
+      if( filtered && !storable ) Log::output( Log::Level::Warning, "Module ", this->name(), " can only resample RGBA32F storage images, blitting the input instead." ) ;
+      
+      Log::output( "Module ", this->name(), same ? " copying " : data.resampling ? " resampling " : " blitting ", 
+                   input.width(), "x", input.height(), " input to ", data.display.width(), "x", data.display.height(), "." ) ;
+      
+      if( data.resampling ) this->prepareResample( input ) ;
+    }
+    
+    // The parent's chain is inside it's render pass, where transfers & dispatches aren't allowed, so they go in this module's chain ahead of it.
+    data.transfer_chain.begin() ;
+    
+    if( data.resampling )
+    {
+      // Two separable passes, each a line of the output per workgroup row. See resample.comp.glsl.
+      const nyx::ResamplePass horizontal = data.kernel.pass( 0 ) ;
+      const nyx::ResamplePass vertical   = data.kernel.pass( 1 ) ;
+      
+      data.transfer_chain.push    ( data.horizontal, horizontal                                                                                      ) ;
+      data.transfer_chain.dispatch( data.horizontal, ( horizontal.size + nyx::RESAMPLE_BLOCK - 1 ) / nyx::RESAMPLE_BLOCK, ( input.height() + nyx::RESAMPLE_LINES - 1 ) / nyx::RESAMPLE_LINES ) ;
+      data.transfer_chain.push    ( data.vertical  , vertical                                                                                        ) ;
+      data.transfer_chain.dispatch( data.vertical  , ( vertical.size   + nyx::RESAMPLE_BLOCK - 1 ) / nyx::RESAMPLE_BLOCK, ( horizontal.size + nyx::RESAMPLE_LINES - 1 ) / nyx::RESAMPLE_LINES ) ;
+    }
+    else
+    {
+      data.transfer_chain.transition( data.display, nyx::ImageLayout::TransferDst ) ;
+      
+      if( same )
+      {
+        data.transfer_chain.copy( input, data.display ) ;
+      }
+      else
+      {
+        data.transfer_chain.blit( input, data.display ) ;
+      }
+    }
+    
+    // Both chains go to the same graphics queue, so the transition's barrier orders this chain's writes before the parent's frame reads the image.
+    data.transfer_chain.transition( data.display, nyx::ImageLayout::General ) ;
+    data.transfer_chain.submit    () ;
+    data.pending = true ;
   }
   
   void NyxDrawBlit::draw()
   {
-    if( this->data.input && NyxDrawModule::dirty() )
+    const nyx::Image<Framework>* input = this->data.input ;
+    
+    if( input == nullptr ) return ;
+    
+    if( this->data.transfer )
     {
-      Log::output( "Module ", this->name(), " redrawing!" ) ;
+      if( this->data.fresh.exchange( false ) ) this->transfer( *input ) ;
+    }
+    else if( this->data.bound != input )
+    {
+      // Sampling the input directly means rebinding it, which can't happen while a frame still reads the old one.
       Framework::deviceSynchronize( this->gpu() ) ;
-      this->pipeline().bind( "tex", *this->data.input ) ;
+      this->pipeline().bind( "tex", *input ) ;
+      this->data.bound = input ;
+      NyxDrawModule::setDirty() ;
+    }
+    
+    if( NyxDrawModule::dirty() )
+    {
+      Log::output( "Module ", this->name(), " redrawing!" ) ;
       
       this->chain().begin() ;
       this->chain().draw( this->pipeline(), this->data.vertices ) ;
@@ -18,24 +18,53 @@
 #pragma once 
 
 #include <templates/NyxDrawModule.h>
+#include <templates/NyxResample.h>
 #include <NyxGPU/library/Image.h>
 #include <NyxGPU/library/Array.h>
+#include <NyxGPU/library/Pipeline.h>
 #include <Iris/data/Bus.h>
 #include <atomic>
+#include <string>
 
 namespace nyx
 {
   
   struct NyxDrawBlitData
   {
-    iris::Bus                                 bus        ;
-    std::atomic<const nyx::Image<Framework>*> input      ;
-    nyx::Array<Framework, glm::vec4>          vertices   ;
-    nyx::Chain<Framework>                     copy_chain ;
+    iris::Bus                                 bus            ;
+    std::atomic<const nyx::Image<Framework>*> input          ;
+    std::atomic<bool>                         fresh          ;
+    nyx::Array<Framework, glm::vec4>          vertices       ;
+    nyx::Chain<Framework>                     copy_chain     ;
+    nyx::Chain<Framework>                     transfer_chain ;
+    nyx::Pipeline<Framework>                  horizontal     ;
+    nyx::Pipeline<Framework>                  vertical       ;
+    nyx::Image<Framework>                     display        ;
+    nyx::Image<Framework>                     between        ;
+    nyx::Array<Framework, nyx::ResampleSpan>  d_spans        ;
+    nyx::Array<Framework, float>              d_weights      ;
+    nyx::ResampleKernel                       kernel         ;
+    nyx::ResampleFilter                       filter         ;
+    const nyx::Image<Framework>*              bound          ;
+    unsigned                                  bound_width    ;
+    unsigned                                  bound_height   ;
+    bool                                      transfer       ;
+    bool                                      resampling     ;
+    bool                                      pending        ;
+    bool                                      initialized    ;
 
     NyxDrawBlitData()
     {
-      this->input = nullptr ;
+      this->input        = nullptr                       ;
+      this->fresh        = false                         ;
+      this->bound        = nullptr                       ;
+      this->bound_width  = 0                             ;
+      this->bound_height = 0                             ;
+      this->transfer     = true                          ;
+      this->resampling   = false                         ;
+      this->pending      = false                         ;
+      this->initialized  = false                         ;
+      this->filter       = nyx::ResampleFilter::Bilinear ;
     }
     
     void setInputName( const char* signal )
@@ -44,11 +73,40 @@ namespace nyx
       this->bus.enroll( this, &NyxDrawBlitData::setInput, iris::OPTIONAL, signal ) ; 
     } ;
     
+    void setTransfer( bool value )
+    {
+      // The display image & it's chain only exist when transferring at initialization.
+      if( this->initialized )
+      {
+        Log::output( Log::Level::Warning, "NyxDrawBlit module can only change whether it transfers before being initialized, ignoring." ) ;
+        return ;
+      }
+      
+      this->transfer = value ;
+    } ;
+    
+    void setFilter( const char* name )
+    {
+      // The resampling pipelines & the display image's usage are picked from the filter at initialization.
+      if( this->initialized )
+      {
+        Log::output( Log::Level::Warning, "NyxDrawBlit module can only change it's filter before being initialized, ignoring ", name, "." ) ;
+        return ;
+      }
+      
+      this->filter = nyx::resampleFilter( name ) ;
+    } ;
+    
     void setInput( const nyx::Image<Framework>& image )
     {
-      this->input = &image ; 
+      // Inputs publish their image every time it's contents change, so every publish is a frame to copy.
+      this->fresh = true ;
       
-      Log::output( "NyxDrawBlit module setting input image to ", static_cast<const void*>( this->input ) ) ;
+      if( this->input != &image )
+      {
+        this->input = &image ; 
+        Log::output( "NyxDrawBlit module setting input image to ", static_cast<const void*>( this->input ) ) ;
+      }
     };
   };
   
@@ -77,7 +135,18 @@ namespace nyx
        */
       void subscribe( unsigned id ) ;
 
-      void updateTextures() ;
+      /** Method to copy the input into the image this module draws, in it's own chain ahead of the parent's frame.
+       * Equal sizes & formats are copied. Other sizes are resampled when a filter is set & the input is an RGBA32F storage image, anything else is blitted.
+       * Nothing is waited on, the parent's frame is ordered after it on the queue.
+       * @param input The image to copy from.
+       */
+      void transfer( const nyx::Image<Framework>& input ) ;
+      
+      /** Method to build the weights & intermediate image of a resample from the input to the image this module draws.
+       * Only done when the input or it's size changes.
+       * @param input The image to resample.
+       */
+      void prepareResample( const nyx::Image<Framework>& input ) ;
       
       /** Method to shut down this object's operation.
        */
@@ -1,20 +1,179 @@
 /*
- * To change this license header, choose License Headers in Project Properties.
- * To change this template file, choose Tools | Templates
- * and open the template in the editor.
+ * Copyright (C) 2020 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-/* 
+/*
  * File:   Test.cpp
  * Author: jhendl
  *
  * Created on April 17, 2021, 1:30 AM
  */
 
-#include <cstdlib>
+#include <templates/NyxResample.h>
+#include <chrono>
+#include <iostream>
+#include <vector>
+#include <cmath>
 
-int main()
+/** Checks every filter keeps a flat image flat & it's weights summed to one, that box averages exactly when shrinking by a whole factor,
+ * & that every filter leaves an image the same size untouched.
+ */
+static bool testKernels()
+{
+  const nyx::ResampleFilter filters[] = { nyx::ResampleFilter::Box, nyx::ResampleFilter::Bicubic, nyx::ResampleFilter::Lanczos3 } ;
+
+  nyx::ResampleKernel kernel                         ;
+  std::vector<float>  flat   ( 64 * 48 * 4, 0.25f ) ;
+  std::vector<float>  ramp   ( 64 * 48            ) ;
+  std::vector<float>  output ( 64 * 48 * 4        ) ;
+
+  for( unsigned pixel = 0; pixel < ramp.size(); pixel++ ) ramp[ pixel ] = static_cast<float>( pixel % 64 ) ;
+
+  for( nyx::ResampleFilter filter : filters )
+  {
+    kernel.build( filter, 64, 48, 17, 11 ) ;
+    kernel.apply( flat.data(), output.data() ) ;
+
+    for( unsigned value = 0; value < 17 * 11 * 4; value++ ) if( std::fabs( output[ value ] - 0.25f ) > 1e-5f ) return false ;
+
+    for( unsigned span = 0; span < kernel.spans().size(); span++ )
+    {
+      float total = 0.0f ;
+
+      if( kernel.spans()[ span ].count > static_cast<int>( kernel.taps() ) ) return false ;
+      for( int tap = 0; tap < kernel.spans()[ span ].count; tap++ ) total += kernel.weights()[ span * kernel.taps() + tap ] ;
+      if( std::fabs( total - 1.0f ) > 1e-5f ) return false ;
+    }
+
+    kernel.build( filter, 64, 48, 64, 48 ) ;
+    kernel.apply( ramp.data(), output.data(), 1 ) ;
+
+    for( unsigned pixel = 0; pixel < ramp.size(); pixel++ ) if( std::fabs( output[ pixel ] - ramp[ pixel ] ) > 1e-4f ) return false ;
+  }
+
+  // Shrinking by four, every output pixel of a box is the average of it's four input pixels along each axis.
+  kernel.build( nyx::ResampleFilter::Box, 64, 48, 16, 12 ) ;
+  kernel.apply( ramp.data(), output.data(), 1 ) ;
+
+  for( unsigned x = 0; x < 16; x++ ) if( std::fabs( output[ x ] - ( x * 4.0f + 1.5f ) ) > 1e-4f ) return false ;
+
+  return kernel.taps() <= 5 && nyx::resampleFilter( "lanczos3" ) == nyx::ResampleFilter::Lanczos3 && nyx::resampleFilter( "nearest" ) == nyx::ResampleFilter::Bilinear ;
+}
+
+/** Checks each filter shrinks a pattern of one pixel stripes by four to an even grey, without the stripes aliasing into a coarser pattern.
+ */
+static bool testAliasing()
+{
+  const nyx::ResampleFilter filters[] = { nyx::ResampleFilter::Box, nyx::ResampleFilter::Bicubic, nyx::ResampleFilter::Lanczos3 } ;
+
+  nyx::ResampleKernel kernel              ;
+  std::vector<float>  stripes ( 256 * 4 ) ;
+  std::vector<float>  output  ( 64      ) ;
+
+  for( unsigned pixel = 0; pixel < stripes.size(); pixel++ ) stripes[ pixel ] = ( pixel % 256 ) % 2 == 0 ? 1.0f : 0.0f ;
+
+  for( nyx::ResampleFilter filter : filters )
+  {
+    float low  = 1.0f ;
+    float high = 0.0f ;
+
+    kernel.build( filter, 256, 4, 64, 1 ) ;
+    kernel.apply( stripes.data(), output.data(), 1 ) ;
+
+    // Away from the edges, where the filter is cut short.
+    for( unsigned x = 4; x < 60; x++ )
+    {
+      low  = std::min( low , output[ x ] ) ;
+      high = std::max( high, output[ x ] ) ;
+    }
+
+    if( high - low > 0.05f || std::fabs( low - 0.5f ) > 0.05f ) return false ;
+  }
+
+  return true ;
+}
+
+/** Builds the kernels of shrinking an 8K feed to 1080p, checking every block of both passes fits shared memory, & times the host reference at a quarter of the size.
+ * The host reference is the same arithmetic as the shader. The passes themselves are bound by reading the input once, which the numbers below give.
+ */
+static bool testBenchmark()
 {
-  return 0;
+  constexpr unsigned IN_WIDTH   = 7680 ;
+  constexpr unsigned IN_HEIGHT  = 4320 ;
+  constexpr unsigned OUT_WIDTH  = 1920 ;
+  constexpr unsigned OUT_HEIGHT = 1080 ;
+  constexpr unsigned SHRINK     = 4    ;
+  constexpr unsigned TEXEL      = 16   ;
+
+  const nyx::ResampleFilter filters[] = { nyx::ResampleFilter::Box, nyx::ResampleFilter::Bicubic, nyx::ResampleFilter::Lanczos3 } ;
+  const char*               names  [] = { "box", "bicubic", "lanczos3" } ;
+
+  nyx::ResampleKernel kernel                                                               ;
+  std::vector<float>  input  ( ( IN_WIDTH  / SHRINK ) * ( IN_HEIGHT  / SHRINK ) * 4, 0.5f ) ;
+  std::vector<float>  output ( ( OUT_WIDTH / SHRINK ) * ( OUT_HEIGHT / SHRINK ) * 4       ) ;
+
+  const double read    = static_cast<double>( IN_WIDTH ) * IN_HEIGHT * TEXEL + static_cast<double>( OUT_WIDTH ) * IN_HEIGHT * TEXEL ;
+  const double written = static_cast<double>( OUT_WIDTH ) * IN_HEIGHT * TEXEL + static_cast<double>( OUT_WIDTH ) * OUT_HEIGHT * TEXEL ;
+
+  std::cout << "Resampling " << IN_WIDTH << "x" << IN_HEIGHT << " to " << OUT_WIDTH << "x" << OUT_HEIGHT << ", RGBA32F: " << "\n"
+            << "-- Bytes read, both passes    : " << read    / ( 1024.0 * 1024.0 ) << "MB" << "\n"
+            << "-- Bytes written, both passes : " << written / ( 1024.0 * 1024.0 ) << "MB" << "\n" ;
+
+  for( unsigned index = 0; index < 3; index++ )
+  {
+    kernel.build( filters[ index ], IN_WIDTH, IN_HEIGHT, OUT_WIDTH, OUT_HEIGHT ) ;
+
+    if( !kernel.tiled( 0 ) || !kernel.tiled( 1 ) ) return false ;
+
+    const unsigned taps = kernel.taps() ;
+
+    kernel.build( filters[ index ], IN_WIDTH / SHRINK, IN_HEIGHT / SHRINK, OUT_WIDTH / SHRINK, OUT_HEIGHT / SHRINK ) ;
+
+    auto start = std::chrono::high_resolution_clock::now() ;
+    kernel.apply( input.data(), output.data() ) ;
+    const double host = std::chrono::duration<double, std::milli>( std::chrono::high_resolution_clock::now() - start ).count() ;
+
+    std::cout << "-- " << names[ index ] << ", taps per pixel " << taps << ", both passes in shared memory, host reference at a quarter size " << host << "ms" << "\n" ;
+
+    if( std::fabs( output[ 0 ] - 0.5f ) > 1e-4f ) return false ;
+  }
+
+  std::cout << std::flush ;
+  return true ;
 }
 
+int main()
+{
+  if( !testKernels() )
+  {
+    std::cout << "Resample kernel test failed." << std::endl ;
+    return 1 ;
+  }
+
+  if( !testAliasing() )
+  {
+    std::cout << "Resample aliasing test failed." << std::endl ;
+    return 1 ;
+  }
+
+  if( !testBenchmark() )
+  {
+    std::cout << "Resample benchmark failed." << std::endl ;
+    return 1 ;
+  }
+
+  return 0 ;
+}
@@ -27,47 +27,857 @@
 
 #include "NyxDrawModel.h"
 #include "draw_model.h"
+#include "skinning.h"
+#include "draw_model_quantized.h"
+#include "skinning_quantized.h"
+#include "meshlet_cull.h"
+#include <templates/NyxLodChain.h>
+#include <templates/NyxGeometryArena.h>
+#include <templates/NyxVertexQuantization.h>
+#include <templates/NyxMeshlets.h>
+#include <templates/NyxModelTable.h>
+#include <templates/NyxSkinning.h>
 #include <NyxGPU/library/Array.h>
 #include <NyxGPU/library/Image.h>
 #include <NyxGPU/library/Chain.h>
 #include <NyxGPU/vkg/Vulkan.h>
 #include <Mars/TextureArray.h>
+#include <glm/glm.hpp>
 #include <unordered_map>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <algorithm>
 #include <queue>
+#include <cstdint>
 
 static const unsigned VERSION = 1 ;
 namespace nyx
 {
-  constexpr unsigned TRANSFORM_SIZE = 1024 ;
+  constexpr unsigned TRANSFORM_SIZE = 1024    ;
+  constexpr unsigned INSTANCE_SIZE  = 4096    ;
+  constexpr float    DEPTH_RANGE    = 5000.0f ;
+  constexpr unsigned ARENA_VERTICES = 1 << 20 ;
+  constexpr unsigned ARENA_INDICES  = 1 << 22 ;
+  constexpr unsigned BONE_SIZE      = 1 << 14 ;
+  constexpr unsigned SKIN_JOB_SIZE  = 1024    ;
+  constexpr unsigned SKINNED_SIZE   = 1 << 18 ;
+  constexpr unsigned SKIN_BLOCK     = 64      ;
+  constexpr unsigned SKINNED_DRAW   = 1u << 31 ;
+  constexpr unsigned DEQUANT_SIZE   = 1024    ;
+  constexpr unsigned MESHLET_SIZE   = 1 << 14 ;
+  constexpr unsigned CULL_JOB_SIZE  = 256     ;
+  constexpr unsigned CULLED_SIZE    = 1 << 22 ;
+  constexpr unsigned CULL_BLOCK     = 64      ;
+  constexpr unsigned CLUSTER_MIN    = 1 << 16 ;
   using Framework = nyx::vkg::Vulkan ;
+  using Model     = mars::Model<Framework> ;
+  using ModelLods = nyx::LodChain<Framework> ;
+  using MeshRef   = std::decay<decltype( *std::declval<Model&>().meshes().begin() )>::type ;
+  
+  template<typename Array>
+  struct ArrayElement ;
+  
+  template<typename Impl, typename Type>
+  struct ArrayElement<nyx::Array<Impl, Type>> { using Value = Type ; } ;
+  
+  using Vertex = ArrayElement<std::decay<decltype( std::declval<MeshRef&>()->vertices )>::type>::Value ;
+  using Arena          = nyx::GeometryArena<Framework, Vertex>               ;
+  using QuantizedArena = nyx::GeometryArena<Framework, nyx::QuantizedVertex> ;
+
+  /** Function to make sure a device buffer can hold an amount of elements, doubling it until it does.
+   * The contents of a reallocated buffer are lost, so it has to be re-uploaded & rebound.
+   * @param gpu The device the buffer lives on.
+   * @param array The buffer to grow.
+   * @param count The amount of elements the buffer has to hold.
+   * @param flags The flags the buffer was allocated with.
+   * @return Whether the buffer was reallocated.
+   */
+  template<typename Type>
+  bool reserveArray( unsigned gpu, nyx::Array<Framework, Type>& array, unsigned count, nyx::ArrayFlags flags )
+  {
+    unsigned size = std::max<unsigned>( array.size(), 1 ) ;
+    
+    if( count <= array.size() ) return false ;
+    while( size < count ) size *= 2 ;
+    
+    Framework::deviceSynchronize( gpu ) ;
+    array.reset() ;
+    array.initialize( gpu, size, false, flags ) ;
+    Framework::deviceSynchronize( gpu ) ;
+    
+    return true ;
+  }
+
+  /** Structure to contain where every mesh's vertices & indices live on the device, in either the float or the quantized vertex layout.
+   */
+  struct ModelGeometry
+  {
+    nyx::Array<Framework, Dequantization> d_dequantizations ;
+    Arena                                 arena             ;
+    QuantizedArena                        quantized_arena   ;
+    std::vector<Vertex>                   staging           ;
+    std::vector<QuantizedVertex>          packed            ;
+    std::vector<Dequantization>           dequantizations   ;
+    bool                                  quantized         ;
+    bool                                  moved             ;
+    
+    ModelGeometry()
+    {
+      this->quantized = false ;
+      this->moved     = false ;
+    }
+    
+    /** Method to place a mesh in the arena matching the vertex layout.
+     * @param chain The chain to copy the mesh with.
+     * @param mesh The mesh to place.
+     * @return Where the mesh was placed.
+     */
+    template<typename Mesh>
+    nyx::GeometryAllocation add( nyx::Chain<Framework>& chain, const Mesh& mesh )
+    {
+      return this->quantized ? this->quantize( chain, mesh ) : this->arena.add( chain, mesh.vertices, mesh.indices ) ;
+    }
+    
+    /** Method to convert a mesh into the quantized vertex layout & place it in the quantized arena.
+     * The float vertices are read back once, so the mesh's bounds are known exactly.
+     * @param chain The chain to copy the mesh with.
+     * @param mesh The mesh to quantize.
+     * @return Where the mesh was placed.
+     */
+    template<typename Mesh>
+    nyx::GeometryAllocation quantize( nyx::Chain<Framework>& chain, const Mesh& mesh )
+    {
+      nyx::GeometryAllocation geometry ;
+      
+      this->staging.resize( mesh.vertices.size() ) ;
+      this->packed .resize( mesh.vertices.size() ) ;
+      
+      chain.copy       ( mesh.vertices, this->staging.data() ) ;
+      chain.submit     () ;
+      chain.synchronize() ;
+      
+      const Dequantization dequantization = nyx::computeDequantization( this->staging.data(), this->staging.size() ) ;
+      
+      for( unsigned index = 0; index < this->staging.size(); index++ )
+      {
+        this->packed[ index ] = nyx::quantizeVertex( this->staging[ index ], dequantization ) ;
+      }
+      
+      // The packed vertices are reused by the next mesh, so they have to be on the device before returning.
+      geometry = this->quantized_arena.add( chain, this->packed.data(), this->packed.size(), mesh.indices ) ;
+      chain.submit     () ;
+      chain.synchronize() ;
+      
+      this->dequantizations.push_back( dequantization ) ;
+      this->moved = true ;
+      
+      return geometry ;
+    }
+    
+    /** Method to upload the dequantization of every quantized mesh, and point the pipelines at the quantized arena again.
+     * The arena may have been reallocated by meshes added since the last upload.
+     * @param gpu The device the buffers live on.
+     * @param chain The chain to copy the dequantizations with.
+     * @param pipeline The pipeline drawing the meshes.
+     * @param skin_pipeline The pipeline skinning the meshes.
+     */
+    void upload( unsigned gpu, nyx::Chain<Framework>& chain, nyx::Pipeline<Framework>& pipeline, nyx::Pipeline<Framework>& skin_pipeline )
+    {
+      const unsigned count = this->dequantizations.size() ;
+      
+      if( !this->moved ) return ;
+      
+      reserveArray( gpu, this->d_dequantizations, count, nyx::ArrayFlags::StorageBuffer ) ;
+      
+      this->dequantizations.resize( this->d_dequantizations.size() ) ;
+      chain.copy                  ( this->dequantizations.data(), this->d_dequantizations ) ;
+      chain.submit                () ;
+      chain.synchronize           () ;
+      this->dequantizations.resize( count ) ;
+      
+      pipeline     .bind( "vertices"      , this->quantized_arena.vertices() ) ;
+      pipeline     .bind( "dequantization", this->d_dequantizations          ) ;
+      skin_pipeline.bind( "vertices"      , this->quantized_arena.vertices() ) ;
+      skin_pipeline.bind( "dequantization", this->d_dequantizations          ) ;
+      
+      this->moved = false ;
+    }
+    
+    /** Method to overwrite the indices of a placed mesh in the arena matching the vertex layout.
+     * @param chain The chain to copy the indices with.
+     * @param geometry Where the mesh was placed.
+     * @param indices Pointer to the new indices of the mesh.
+     */
+    void setIndices( nyx::Chain<Framework>& chain, const nyx::GeometryAllocation& geometry, const unsigned* indices )
+    {
+      if( this->quantized ) this->quantized_arena.setIndices( chain, geometry, indices ) ;
+      else                  this->arena          .setIndices( chain, geometry, indices ) ;
+    }
+    
+    /** Method to retrieve the index buffer of the arena matching the vertex layout.
+     * @return The indices of every mesh.
+     */
+    const nyx::Array<Framework, unsigned>& indices() const
+    {
+      return this->quantized ? this->quantized_arena.indices() : this->arena.indices() ;
+    }
+  };
+
+  /** Structure to contain the flat handles every drawable's model was resolved to, along with it's levels of detail.
+   */
+  struct ModelLibrary
+  {
+    struct MeshHandle
+    {
+      MeshRef                 mesh          ;
+      unsigned                texture       ;
+      nyx::GeometryAllocation geometry      ;
+      unsigned                first_meshlet ;
+      unsigned                meshlet_count ;
+    };
+    
+    struct ModelHandle
+    {
+      unsigned first_mesh ;
+      unsigned mesh_count ;
+      unsigned triangles  ;
+      unsigned first_lod  ;
+      unsigned lod_count  ;
+      float    radius     ;
+    };
+    
+    nyx::ModelTable<Model>   table      ;
+    std::vector<ModelHandle> models     ;
+    std::vector<MeshHandle>  meshes     ;
+    std::vector<unsigned>    lod_models ;
+    std::vector<float>       lod_sizes  ;
+    unsigned                 saved      ;
+    
+    ModelLibrary()
+    {
+      this->saved = 0 ;
+    }
+    
+    /** Method to retrieve the handle of the model a drawable is currently drawn with, taking it's level of detail into account.
+     * @param id The id of the drawable.
+     * @return The handle of the model to draw.
+     */
+    unsigned drawnModel( unsigned id ) const
+    {
+      const auto&    model = this->models[ this->table.model( id ) ] ;
+      const unsigned level = this->table.lod( id )                   ;
+      
+      return level == 0 ? this->table.model( id ) : this->lod_models[ model.first_lod + level - 1 ] ;
+    }
+    
+    /** Method to pick the level of detail of every drawable from it's size on screen.
+     * Also tallies how many triangles the reduced levels saved over drawing everything at full detail.
+     * @param camera The view matrix, or nullptr if none was given yet.
+     * @param projection The projection matrix, or nullptr if none was given yet.
+     * @param transform Function to retrieve the transformation of a drawable.
+     * @return Whether any drawable changed level, meaning draws have to be re-recorded.
+     */
+    template<typename Transforms>
+    bool updateLods( const glm::mat4* camera, const glm::mat4* projection, Transforms transform )
+    {
+      const glm::mat4 view    = camera     ? *camera                   : glm::mat4( 1.0f ) ;
+      const float     focal   = projection ? ( *projection )[ 1 ][ 1 ] : 1.0f              ;
+      bool            changed = false                                                      ;
+      std::int64_t    saved   = 0                                                          ;
+      
+      for( unsigned id = 0; id < this->table.size(); id++ )
+      {
+        if( this->table.model( id ) == UINT_MAX ) continue ;
+        
+        const auto& model = this->models[ this->table.model( id ) ] ;
+        if( model.lod_count == 0 ) continue ;
+        
+        const glm::mat4& matrix   = transform( id )                                                    ;
+        const float      scale    = std::max( { glm::length( glm::vec3( matrix[ 0 ] ) ),
+                                                glm::length( glm::vec3( matrix[ 1 ] ) ),
+                                                glm::length( glm::vec3( matrix[ 2 ] ) ) } )                ;
+        const float      distance = glm::length( glm::vec3( view * matrix[ 3 ] ) )                         ;
+        const float      size     = distance > 0.0f ? ( model.radius * scale * focal ) / distance : 1.0f ;
+        const float*     sizes    = this->lod_sizes.data() + model.first_lod                               ;
+        const unsigned   level    = nyx::selectLod( sizes, model.lod_count, size, this->table.lod( id ) )  ;
+        
+        changed = changed || level != this->table.lod( id ) ;
+        this->table.setLod( id, level ) ;
+        // A reduced level is not guaranteed to have fewer triangles, so the difference has to be signed.
+        saved += static_cast<std::int64_t>( model.triangles ) - static_cast<std::int64_t>( this->models[ this->drawnModel( id ) ].triangles ) ;
+      }
+      
+      this->saved = static_cast<unsigned>( std::min<std::int64_t>( std::max<std::int64_t>( saved, 0 ), UINT_MAX ) ) ;
+      
+      return changed ;
+    }
+  };
+
+  /** Structure to contain the bone palettes of skinned drawables, and the compute pass writing their vertices every frame.
+   */
+  struct ModelSkinning
+  {
+    struct SkinJob
+    {
+      unsigned first_vertex   ;
+      unsigned vertex_count   ;
+      unsigned first_bone     ;
+      unsigned output         ;
+      unsigned dequantization ;
+    };
+    
+    struct SkinnedDraw
+    {
+      unsigned mesh   ;
+      unsigned output ;
+    };
+    
+    nyx::Chain<Framework>            chain            ;
+    nyx::Pipeline<Framework>         pipeline         ;
+    nyx::Array<Framework, glm::mat4> d_bones          ;
+    nyx::Array<Framework, SkinJob>   d_jobs           ;
+    nyx::Array<Framework, Vertex>    d_skinned        ;
+    nyx::BonePalettes                palettes         ;
+    std::vector<SkinJob>             jobs             ;
+    std::vector<SkinnedDraw>         draws            ;
+    unsigned                         skinned_vertices ;
+    unsigned                         job_vertices     ;
+    bool                             bones_dirty      ;
+    bool                             jobs_dirty       ;
+    bool                             changed          ;
+    bool                             pending          ;
+    
+    ModelSkinning()
+    {
+      this->pending = false ;
+      this->clear() ;
+    }
+    
+    /** Method to copy a drawable's bone palette into the host bone buffer, giving it a range of the buffer if it's size changed.
+     * @param id The id of the drawable.
+     * @param palette Pointer to the first bone of the palette.
+     * @param count The amount of bones in the palette.
+     */
+    void setPalette( unsigned id, const glm::mat4* palette, unsigned count )
+    {
+      // Jobs reference the drawable's range of the buffer, so a new range means re-recording them.
+      if( this->palettes.set( id, palette, count ) ) this->changed = true ;
+      
+      this->bones_dirty = true ;
+    }
+    
+    /** Method to give a removed drawable's range of the bone buffer back, so it can be reused by later palettes.
+     * @param id The id of the drawable.
+     */
+    void remove( unsigned id )
+    {
+      if( this->palettes.remove( id ) ) this->changed = true ;
+    }
+    
+    /** Method to check whether a drawable is skinned.
+     * @param id The id of the drawable.
+     * @return Whether the drawable has a bone palette.
+     */
+    bool skinned( unsigned id ) const
+    {
+      return this->palettes.skinned( id ) ;
+    }
+    
+    /** Method to forget this frame's skinning jobs, before draws are gathered again.
+     */
+    void clear()
+    {
+      this->jobs .clear() ;
+      this->draws.clear() ;
+      this->skinned_vertices = 0     ;
+      this->job_vertices     = 0     ;
+      this->bones_dirty      = true  ;
+      this->jobs_dirty       = true  ;
+      this->changed          = false ;
+    }
+    
+    /** Method to give a skinned drawable's mesh it's own range of skinned vertices, and queue the job filling it.
+     * @param id The id of the drawable.
+     * @param mesh The handle of the mesh.
+     * @param geometry Where the mesh lives in the arena.
+     * @return The draw payload referencing the skinned vertices.
+     */
+    unsigned add( unsigned id, unsigned mesh, const nyx::GeometryAllocation& geometry )
+    {
+      this->jobs .push_back( { geometry.base_vertex, geometry.vertex_count, this->palettes.first( id ), this->skinned_vertices, mesh } ) ;
+      this->draws.push_back( { mesh, this->skinned_vertices } ) ;
+      
+      this->skinned_vertices += geometry.vertex_count                                  ;
+      this->job_vertices      = std::max( this->job_vertices, geometry.vertex_count ) ;
+      
+      return SKINNED_DRAW | static_cast<unsigned>( this->draws.size() - 1 ) ;
+    }
+    
+    /** Method to record & submit the skinning pass, writing every skinned drawable's vertices for this frame.
+     * Only dispatches when a palette or the set of skinned drawables changed.
+     * The pass is submitted ahead of the parent's frame without waiting on it, and only waited on before it is recorded again.
+     * @param gpu The device to skin on.
+     * @param geometry The geometry the skinned meshes live in.
+     */
+    void skin( unsigned gpu, const ModelGeometry& geometry )
+    {
+      if( this->jobs.empty() || !( this->bones_dirty || this->jobs_dirty ) ) return ;
+      
+      // The last pass was submitted a frame ago, so this only waits if the device is that far behind.
+      if( this->pending )
+      {
+        this->chain.synchronize() ;
+        this->pending = false ;
+      }
+      
+      if( reserveArray( gpu, this->d_bones, this->palettes.size(), nyx::ArrayFlags::StorageBuffer ) ) this->pipeline.bind( "bones", this->d_bones ) ;
+      if( this->jobs_dirty && reserveArray( gpu, this->d_jobs, this->jobs.size(), nyx::ArrayFlags::StorageBuffer ) ) this->pipeline.bind( "jobs", this->d_jobs ) ;
+      
+      // The arena may have grown since the last dispatch. The quantized one is rebound by @ModelGeometry::upload.
+      if( this->jobs_dirty && !geometry.quantized ) this->pipeline.bind( "vertices", geometry.arena.vertices() ) ;
+      
+      this->chain.begin() ;
+      
+      // The previous frame may still be drawing the skinned vertices, so their writes wait for it.
+      this->chain.barrier() ;
+      
+      if( this->jobs_dirty )
+      {
+        this->jobs.resize( this->d_jobs.size() ) ;
+        this->chain.copy( this->jobs.data(), this->d_jobs ) ;
+        this->jobs.resize( this->draws.size() ) ;
+      }
+      
+      this->chain.copy( this->palettes.bones(), this->d_bones, this->palettes.size(), 0, 0 ) ;
+      
+      this->chain.dispatch( this->pipeline, ( this->job_vertices + SKIN_BLOCK - 1 ) / SKIN_BLOCK, this->jobs.size() ) ;
+      
+      // The chain & the parent's frame go to the same graphics queue, so this barrier orders the skinned vertices before the frame draws them.
+      this->chain.barrier() ;
+      this->chain.submit () ;
+      
+      this->pending     = true  ;
+      this->bones_dirty = false ;
+      this->jobs_dirty  = false ;
+    }
+  };
+  
+  /** Structure to contain the meshlets of every clustered mesh, and the compute pass culling them every frame.
+   */
+  struct ModelMeshlets
+  {
+    struct CullJob
+    {
+      glm::mat4 model         ;
+      unsigned  first_meshlet ;
+      unsigned  meshlet_count ;
+      unsigned  first_index   ;
+      unsigned  output        ;
+    };
+    
+    struct Command
+    {
+      unsigned index_count    ;
+      unsigned instance_count ;
+      unsigned first_index    ;
+      int      vertex_offset  ;
+      unsigned first_instance ;
+    };
+    
+    nyx::Chain<Framework>               chain          ;
+    nyx::Pipeline<Framework>            pipeline       ;
+    nyx::Array<Framework, nyx::Meshlet> d_meshlets     ;
+    nyx::Array<Framework, CullJob>      d_jobs         ;
+    nyx::Array<Framework, Command>      d_commands     ;
+    nyx::Array<Framework, unsigned>     d_culled       ;
+    std::vector<nyx::Meshlet>           meshlets       ;
+    std::vector<Vertex>                 staging        ;
+    std::vector<unsigned>               host_indices   ;
+    std::vector<CullJob>                jobs           ;
+    std::vector<Command>                commands       ;
+    std::vector<unsigned>               ids            ;
+    unsigned                            culled_indices ;
+    unsigned                            max_meshlets   ;
+    bool                                dirty          ;
+    bool                                pending        ;
+    
+    ModelMeshlets()
+    {
+      this->culled_indices = 0     ;
+      this->max_meshlets   = 0     ;
+      this->dirty          = false ;
+      this->pending        = false ;
+    }
+    
+    /** Method to split a large mesh into meshlets, so it's clusters can be culled on the GPU every frame.
+     * The mesh is read back once, and the arena's copy of it's indices is overwritten with the meshlet ordered ones. The mesh itself is left as loaded.
+     * @param copy_chain The chain to read back the mesh & write the indices with.
+     * @param mesh The mesh to split.
+     * @param geometry The geometry the mesh was placed in.
+     * @param placed Where the mesh was placed.
+     * @return The amount of meshlets the mesh was split into.
+     */
+    template<typename Mesh>
+    unsigned cluster( nyx::Chain<Framework>& copy_chain, const Mesh& mesh, ModelGeometry& geometry, const nyx::GeometryAllocation& placed )
+    {
+      unsigned count ;
+      
+      this->staging     .resize( mesh.vertices.size() ) ;
+      this->host_indices.resize( mesh.indices .size() ) ;
+      
+      copy_chain.copy       ( mesh.vertices, this->staging     .data() ) ;
+      copy_chain.copy       ( mesh.indices , this->host_indices.data() ) ;
+      copy_chain.submit     () ;
+      copy_chain.synchronize() ;
+      
+      count = nyx::buildMeshlets( this->staging.data(), this->staging.size(), this->host_indices.data(), this->host_indices.size(), this->meshlets ) ;
+      
+      geometry.setIndices   ( copy_chain, placed, this->host_indices.data() ) ;
+      copy_chain.submit     () ;
+      copy_chain.synchronize() ;
+      
+      this->dirty = true ;
+      
+      return count ;
+    }
+    
+    /** Method to forget the recorded culled draws & make sure the cull buffers fit the ones about to be recorded.
+     * Recorded draws reference these buffers, so they have to be at their final size before recording.
+     * @param gpu The device the buffers live on.
+     * @param items The sorted draws about to be recorded.
+     * @param count The amount of draws.
+     * @param meshes The handles of every mesh, indexed by the draws.
+     * @param geometry The geometry the meshes live in.
+     */
+    void prepare( unsigned gpu, const nyx::DrawItem* items, unsigned count, const std::vector<ModelLibrary::MeshHandle>& meshes, const ModelGeometry& geometry )
+    {
+      unsigned draws   = 0 ;
+      unsigned indices = 0 ;
+      
+      for( unsigned index = 0; index < count; index++ )
+      {
+        const unsigned payload = items[ index ].data ;
+        
+        if( ( payload & SKINNED_DRAW ) == 0 && meshes[ payload ].meshlet_count != 0 )
+        {
+          draws++ ;
+          indices += meshes[ payload ].geometry.index_count ;
+        }
+      }
+      
+      this->jobs    .clear() ;
+      this->commands.clear() ;
+      this->ids     .clear() ;
+      this->culled_indices = 0 ;
+      this->max_meshlets   = 0 ;
+      
+      if( draws == 0 ) return ;
+      
+      if( reserveArray( gpu, this->d_jobs    , draws  , nyx::ArrayFlags::StorageBuffer                            ) ) this->pipeline.bind( "jobs"    , this->d_jobs     ) ;
+      if( reserveArray( gpu, this->d_commands, draws  , nyx::ArrayFlags::StorageBuffer | nyx::ArrayFlags::Indirect ) ) this->pipeline.bind( "commands", this->d_commands ) ;
+      if( reserveArray( gpu, this->d_culled  , indices, nyx::ArrayFlags::StorageBuffer | nyx::ArrayFlags::Index    ) ) this->pipeline.bind( "culled"  , this->d_culled   ) ;
+      
+      // The arena may have grown since the last recording.
+      this->pipeline.bind( "indices", geometry.indices() ) ;
+    }
+    
+    /** Method to give a drawn instance of a clustered mesh it's own cull job & indirect draw.
+     * @param id The id of the drawable.
+     * @param mesh The handle of the mesh.
+     * @return The index of the indirect draw the cull pass fills in for it.
+     */
+    unsigned add( unsigned id, const ModelLibrary::MeshHandle& mesh )
+    {
+      this->jobs    .push_back( { glm::mat4( 1.0f ), mesh.first_meshlet, mesh.meshlet_count, mesh.geometry.first_index, this->culled_indices } ) ;
+      this->commands.push_back( { 0, 1, this->culled_indices, static_cast<int>( mesh.geometry.base_vertex ), 0 } ) ;
+      this->ids     .push_back( id ) ;
+      
+      this->culled_indices += mesh.geometry.index_count                           ;
+      this->max_meshlets    = std::max( this->max_meshlets, mesh.meshlet_count ) ;
+      
+      return this->jobs.size() - 1 ;
+    }
+    
+    /** Method to record & submit the meshlet cull pass, filling in every clustered draw's indices & index count for this frame.
+     * Meshlets outside the frustum, or whose normal cone faces away from the camera, are left out.
+     * The cones are exact for rotations & uniform scales, other transformations may cull slightly too much.
+     * The pass is submitted ahead of the parent's frame without waiting on it, and only waited on before it is recorded again.
+     * @param gpu The device to cull on.
+     * @param camera The view matrix, or nullptr if none was given yet.
+     * @param transform Function to retrieve the transformation of a drawable.
+     */
+    template<typename Transforms>
+    void cull( unsigned gpu, const glm::mat4* camera, Transforms transform )
+    {
+      const glm::vec4 eye = camera ? glm::inverse( *camera )[ 3 ] : glm::vec4( 0.0f, 0.0f, 0.0f, 1.0f ) ;
+      
+      if( this->jobs.empty() ) return ;
+      
+      // The last pass was submitted a frame ago, so this only waits if the device is that far behind.
+      if( this->pending )
+      {
+        this->chain.synchronize() ;
+        this->pending = false ;
+      }
+      
+      if( this->dirty && reserveArray( gpu, this->d_meshlets, this->meshlets.size(), nyx::ArrayFlags::StorageBuffer ) ) this->pipeline.bind( "meshlets", this->d_meshlets ) ;
+      
+      // Transforms & the camera move every frame, so the jobs are refreshed and the draws emptied before every dispatch.
+      for( unsigned index = 0; index < this->jobs.size(); index++ )
+      {
+        this->jobs    [ index ].model       = transform( this->ids[ index ] ) ;
+        this->commands[ index ].index_count = 0                               ;
+      }
+      
+      this->chain.begin() ;
+      
+      // The previous frame may still be drawing the culled indices, so their writes wait for it.
+      this->chain.barrier() ;
+      
+      if( this->dirty )
+      {
+        const unsigned count = this->meshlets.size() ;
+        
+        this->meshlets.resize( this->d_meshlets.size() ) ;
+        this->chain.copy     ( this->meshlets.data(), this->d_meshlets ) ;
+        this->meshlets.resize( count ) ;
+        this->dirty = false ;
+      }
+      
+      this->jobs    .resize( this->d_jobs    .size() ) ;
+      this->commands.resize( this->d_commands.size() ) ;
+      this->chain.copy      ( this->jobs    .data(), this->d_jobs     ) ;
+      this->chain.copy      ( this->commands.data(), this->d_commands ) ;
+      this->jobs    .resize( this->ids.size() ) ;
+      this->commands.resize( this->ids.size() ) ;
+      
+      this->chain.push    ( this->pipeline, eye ) ;
+      this->chain.dispatch( this->pipeline, ( this->max_meshlets + CULL_BLOCK - 1 ) / CULL_BLOCK, this->jobs.size() ) ;
+      
+      // The chain & the parent's frame go to the same graphics queue, so this barrier orders the culled draws before the frame reads them.
+      this->chain.barrier() ;
+      this->chain.submit () ;
+      
+      this->pending = true ;
+    }
+  };
+  
   struct NyxDrawModelData
   {
     struct Iterators
     {
-      unsigned index       ;
-      unsigned diffuse_tex ;
+      unsigned instance_offset ;
     };
-
-    nyx::Chain<Framework>                      copy_chain ;
-    nyx::Array<Framework, glm::mat4>           d_viewproj ;
-    std::unordered_map<std::string, Iterators> mesh_map   ;
-    iris::Bus                                  bus        ;
-    bool                                       dirty      ;
-    const glm::mat4*                           projection ;
-    const glm::mat4*                           camera     ;
-    
-    NyxDrawModelData()                              { this->dirty = false ; this->projection = nullptr ; this->camera = nullptr ;         } ;
-    void setProjectionInput( const char* input    ) { this->bus.enroll( this, &NyxDrawModelData::setProjection, iris::OPTIONAL, input ) ; } ;
-    void setCameraInput    ( const char* input    ) { this->bus.enroll( this, &NyxDrawModelData::setCamera    , iris::OPTIONAL, input ) ; } ;
-    void setProjection     ( const glm::mat4& val ) { this->projection = &val ; this->dirty = true ;                                      } ;
-    void setCamera         ( const glm::mat4& val ) { this->camera     = &val ; this->dirty = true ;                                      } ;
+    
+    struct QuantizedIterators
+    {
+      unsigned instance_offset ;
+      unsigned dequantization  ;
+    };
+    
+    struct Instance
+    {
+      unsigned transform ;
+      unsigned texture   ;
+    };
+    
+    nyx::Chain<Framework>            copy_chain     ;
+    nyx::Array<Framework, glm::mat4> d_viewproj     ;
+    nyx::Array<Framework, Instance>  d_instances    ;
+    std::vector<Instance>            instances      ;
+    unsigned                         instance_count ;
+    ModelGeometry                    geometry       ;
+    ModelLibrary                     library        ;
+    ModelSkinning                    skinning       ;
+    ModelMeshlets                    meshlets       ;
+    iris::Bus                        bus            ;
+    bool                             dirty          ;
+    bool                             initialized    ;
+    const glm::mat4*                 projection     ;
+    const glm::mat4*                 camera         ;
+    glm::mat4                        recorded_view  ;
+    
+    NyxDrawModelData()
+    {
+      this->dirty          = false   ;
+      this->initialized    = false   ;
+      this->projection     = nullptr ;
+      this->camera         = nullptr ;
+      this->instance_count = 0       ;
+      this->recorded_view  = glm::mat4( 1.0f ) ;
+    }
+    
+    void setProjectionInput( const char* input    ) { this->bus.enroll ( this, &NyxDrawModelData::setProjection, iris::OPTIONAL, input ) ; } ;
+    void setCameraInput    ( const char* input    ) { this->bus.enroll ( this, &NyxDrawModelData::setCamera    , iris::OPTIONAL, input ) ; } ;
+    void setSavedOutput    ( const char* output   ) { this->bus.publish( this, &NyxDrawModelData::trianglesSaved, output               ) ; } ;
+    void setProjection     ( const glm::mat4& val ) { this->projection = &val ; this->dirty = true ;                                       } ;
+    void setCamera         ( const glm::mat4& val ) { this->camera     = &val ; this->dirty = true ;                                       } ;
+    const unsigned& trianglesSaved()                { return this->library.saved ;                                                         } ;
+    
+    /** Method to resolve a model into flat handles, so that recording never has to touch the model itself.
+     * Mesh, texture & level of detail lookups are only done the first time a model is seen.
+     * @param model The model to resolve.
+     * @return The handle of the model.
+     */
+    unsigned resolveModel( const Model& model )
+    {
+      return this->library.table.handle( model, [=] ( const Model& found ) { return this->buildModel( found ) ; } ) ;
+    }
+    
+    /** Method to place a model not seen before in the arena, and build it's handle.
+     * @param model The model to build.
+     * @return The handle of the model.
+     */
+    unsigned buildModel( const Model& model )
+    {
+      const auto                levels = ModelLods::levels( model )  ;
+      const unsigned            index  = this->library.models.size() ;
+      ModelLibrary::ModelHandle handle                               ;
+      
+      // Draw keys only have room for so many mesh handles, past which draws of different meshes are no longer grouped.
+      if( this->library.meshes.size() + model.meshes().size() > nyx::DRAW_KEY_MESH_MAX + 1 && this->library.meshes.size() <= nyx::DRAW_KEY_MESH_MAX + 1 )
+      {
+        Log::output( Log::Level::Warning, "Module NyxDrawModel has more than ", nyx::DRAW_KEY_MESH_MAX + 1, " meshes, so draws of the ones past that are no longer grouped." ) ;
+      }
+      
+      handle.first_mesh = this->library.meshes.size() ;
+      handle.mesh_count = 0                           ;
+      handle.triangles  = 0                           ;
+      handle.lod_count  = levels.size()               ;
+      handle.radius     = ModelLods::radius( model )  ;
+      
+      for( auto mesh : model.meshes() )
+      {
+        unsigned texture   = 0                                ;
+        auto     mesh_iter = mesh->textures.find( "diffuse" ) ;
+        if( mesh_iter != mesh->textures.end() ) texture = mesh_iter->second ;
+        
+        // Large meshes are split into meshlets once placed, which reorders the arena's copy of their indices.
+        const nyx::GeometryAllocation placed        = this->geometry.add( this->copy_chain, *mesh )                                                                           ;
+        const unsigned                first_meshlet = this->meshlets.meshlets.size()                                                                                          ;
+        const unsigned                meshlet_count = mesh->indices.size() / 3 >= CLUSTER_MIN ? this->meshlets.cluster( this->copy_chain, *mesh, this->geometry, placed ) : 0 ;
+        
+        this->library.meshes.push_back( { mesh, texture, placed, first_meshlet, meshlet_count } ) ;
+        handle.triangles += mesh->indices.size() / 3 ;
+        handle.mesh_count++ ;
+      }
+      
+      this->copy_chain.submit     () ;
+      this->copy_chain.synchronize() ;
+      
+      // Reserve this model's levels up front, since resolving them appends to the same lists.
+      handle.first_lod = this->library.lod_models.size() ;
+      this->library.lod_models.resize( handle.first_lod + handle.lod_count ) ;
+      this->library.lod_sizes .resize( handle.first_lod + handle.lod_count ) ;
+      this->library.models    .push_back( handle ) ;
+      
+      for( unsigned level = 0; level < handle.lod_count; level++ )
+      {
+        const unsigned lod = this->resolveModel( *levels[ level ].model ) ;
+        
+        this->library.lod_models[ handle.first_lod + level ] = lod                  ;
+        this->library.lod_sizes [ handle.first_lod + level ] = levels[ level ].size ;
+      }
+      
+      return index ;
+    }
+    
+    /** Method to resolve the models of every drawable added since the last call, once the arena & chains exist.
+     * Drawables arrive on the bus, possibly before initialization, so they are only queued when added.
+     * @return Whether any drawable was resolved.
+     */
+    bool resolveModels()
+    {
+      return this->library.table.resolve( [=] ( const Model& model ) { return this->buildModel( model ) ; } ) != 0 ;
+    }
+    
+    /** Method to check whether the camera moved since the draws were last recorded.
+     * The depths in the draw keys are only calculated when recording, so a moved camera has to re-record to keep them ordered.
+     * @return Whether the view differs from the one the draws were recorded with.
+     */
+    bool viewMoved() const
+    {
+      return this->camera && *this->camera != this->recorded_view ;
+    }
+    
+    /** Method to remember the view the draws are about to be recorded with. See @viewMoved.
+     */
+    void recordView()
+    {
+      if( this->camera ) this->recorded_view = *this->camera ;
+    }
+    
+    /** Method to calculate the quantized camera distance of a transformation, for use in draw keys.
+     * @param transform The model transformation of the drawable.
+     * @return The quantized depth of the drawable.
+     */
+    unsigned depth( const glm::mat4& transform ) const
+    {
+      const glm::mat4 view     = this->camera ? *this->camera : glm::mat4( 1.0f ) ;
+      const glm::vec4 position = view * transform[ 3 ]                            ;
+      
+      return nyx::quantizeDepth( -position.z, DEPTH_RANGE ) ;
+    }
+    
+    /** Method to set the name of the input bone palettes arrive on, either per drawable or in batches.
+     * @param input The name of the input.
+     */
+    void setBonesInput( const char* input )
+    {
+      this->bus.enroll( this, &NyxDrawModelData::setBones    , iris::OPTIONAL, input ) ;
+      this->bus.enroll( this, &NyxDrawModelData::setBoneBatch, iris::OPTIONAL, input ) ;
+    }
+    
+    /** Method to set the bone palette of a drawable, making it skinned. Given through the bus by whatever animates it.
+     * @param id The id of the drawable.
+     * @param palette The bone transformations of the drawable, indexed by the bone ids of it's vertices.
+     */
+    void setBones( unsigned id, const std::vector<glm::mat4>& palette )
+    {
+      this->skinning.setPalette( id, palette.data(), palette.size() ) ;
+    }
+    
+    /** Method to set the bone palettes of many consecutive drawables at once, e.g. everything an animator evaluated this frame.
+     * @param batch The palettes to set.
+     */
+    void setBoneBatch( const nyx::PaletteBatch& batch )
+    {
+      for( unsigned index = 0; index < batch.count; index++ )
+      {
+        this->skinning.setPalette( batch.first + index, batch.palettes + index * batch.bones, batch.bones ) ;
+      }
+    }
+    
+    /** Method to make room for this recording's instance records, growing the device buffer if they would not fit.
+     * Has to be called before anything is recorded, as recorded draws reference the bound buffer.
+     * @param gpu The device the instance buffer lives on.
+     * @param count The amount of instances about to be recorded.
+     * @param pipeline The pipeline to rebind the instance buffer to when it is reallocated.
+     */
+    void reserveInstances( unsigned gpu, unsigned count, nyx::Pipeline<Framework>& pipeline )
+    {
+      if( reserveArray( gpu, this->d_instances, count, nyx::ArrayFlags::StorageBuffer ) ) pipeline.bind( "instance", this->d_instances ) ;
+      
+      this->instances.resize( this->d_instances.size() ) ;
+      this->instance_count = 0 ;
+    }
+    
+    /** Method to upload this recording's instance records into the buffer reserved by @reserveInstances.
+     */
+    void uploadInstances()
+    {
+      this->copy_chain.copy( this->instances.data(), this->d_instances ) ;
+      this->copy_chain.submit     () ;
+      this->copy_chain.synchronize() ;
+    }
     
     void updateViewProj()
     {
       glm::mat4 viewproj ;
       if( this->dirty && this->projection != nullptr && this->camera != nullptr )
       {
-        viewproj = ( *this->projection * *this->camera ) ; 
+        viewproj = ( *this->projection * *this->camera ) ;
         
         this->copy_chain.copy( &viewproj, this->d_viewproj ) ;
         this->copy_chain.submit     () ;
@@ -76,37 +886,131 @@ namespace nyx
     }
   };
   
-  static NyxDrawModelData model_data ;
-  
   NyxDrawModel::NyxDrawModel()
   {
-    auto function = [=] ( unsigned id, mars::Reference<mars::Model<Framework>>& model, nyx::Chain<Framework>& draw_chain, nyx::Pipeline<Framework>& pipeline )
+    this->module_data = new NyxDrawModelData() ;
+    
+    auto add = [=] ( unsigned id, mars::Reference<mars::Model<Framework>>& model )
     {
-          auto& meshes = model->meshes() ;
-
-          for( auto mesh : meshes )
+      data().library.table.add( id, *model ) ;
+    };
+    
+    auto remove = [=] ( unsigned id )
+    {
+      data().library.table.remove( id ) ;
+      data().skinning     .remove( id ) ;
+    };
+    
+    auto sort = [=] ( unsigned id, mars::Reference<mars::Model<Framework>>&, nyx::DrawQueue& queue )
+    {
+      const auto&    model = data().library.models[ data().library.drawnModel( id ) ] ;
+      const unsigned depth = data().depth( NyxDrawModule::transform( id ) )           ;
+      
+      for( unsigned mesh = model.first_mesh; mesh < model.first_mesh + model.mesh_count; mesh++ )
+      {
+        const auto&    handle  = data().library.meshes[ mesh ]                                                    ;
+        const unsigned payload = data().skinning.skinned( id ) ? data().skinning.add( id, mesh, handle.geometry ) : mesh ;
+        
+        queue.push( nyx::makeDrawKey( 0, handle.texture, mesh, depth ), id, payload ) ;
+      }
+    };
+    
+    auto record = [=] ( const nyx::DrawItem* items, unsigned count, nyx::Chain<Framework>& draw_chain, nyx::Pipeline<Framework>& pipeline )
+    {
+      NyxDrawModelData::Iterators          iter       ;
+      NyxDrawModelData::QuantizedIterators quant_iter ;
+      unsigned                             end        ;
+      
+      // Draws are about to reference the instance & skinned buffers, so they have to be at their final size first.
+      data().reserveInstances( this->gpu(), count, pipeline ) ;
+      
+      if( nyx::reserveArray( this->gpu(), data().skinning.d_skinned, data().skinning.skinned_vertices, nyx::ArrayFlags::Vertex | nyx::ArrayFlags::StorageBuffer ) )
+      {
+        data().skinning.pipeline.bind( "skinned", data().skinning.d_skinned ) ;
+        if( data().geometry.quantized ) pipeline.bind( "skinned", data().skinning.d_skinned ) ;
+      }
+      
+      if( data().geometry.quantized ) data().geometry.upload( this->gpu(), data().copy_chain, pipeline, data().skinning.pipeline ) ;
+      
+      data().meshlets.prepare( this->gpu(), items, count, data().library.meshes, data().geometry ) ;
+      
+      // Draws of the same mesh are adjacent once sorted, so each run of them becomes one instanced draw.
+      for( unsigned begin = 0; begin < count; begin = end )
+      {
+        const unsigned payload  = items[ begin ].data                                                         ;
+        const bool     skinned  = ( payload & SKINNED_DRAW ) != 0                                             ;
+        const auto     draw     = skinned ? data().skinning.draws[ payload & ~SKINNED_DRAW ] 
+                                          : ModelSkinning::SkinnedDraw{ payload, data().library.meshes[ payload ].geometry.base_vertex } ;
+        const auto&    mesh     = data().library.meshes[ draw.mesh ]                                          ;
+        const auto&    vertices = skinned ? data().skinning.d_skinned : data().geometry.arena.vertices()      ;
+        
+        iter      .instance_offset = data().instance_count          ;
+        quant_iter.instance_offset = data().instance_count          ;
+        quant_iter.dequantization  = skinned ? UINT_MAX : draw.mesh ;
+        
+        // Clustered meshes are culled per instance, so every instance draws it's own compacted indices.
+        if( !skinned && mesh.meshlet_count != 0 )
+        {
+          for( end = begin; end < count && items[ end ].data == items[ begin ].data; end++ )
           {
-            auto& iter = model_data.mesh_map[ mesh->name ] ;
-            auto mesh_iter = mesh->textures.find( "diffuse" ) ;
-            if( mesh_iter != mesh->textures.end() ) iter.diffuse_tex = mesh->textures[ "diffuse" ] ;
-            else                                    iter.diffuse_tex = 0                           ;
+            const unsigned command = data().meshlets.add( items[ end ].id, mesh ) ;
             
-            iter.index = id ;
-            draw_chain.push       ( pipeline, iter                          ) ;
-            draw_chain.drawIndexed( pipeline, mesh->indices, mesh->vertices ) ;
+            iter      .instance_offset = data().instance_count ;
+            quant_iter.instance_offset = data().instance_count ;
+            data().instances[ data().instance_count++ ] = { items[ end ].id, mesh.texture } ;
+            
+            // The arenas hold different vertex types, so each layout records it's own draw.
+            if( data().geometry.quantized )
+            {
+              draw_chain.push               ( pipeline, quant_iter ) ;
+              draw_chain.drawIndexedIndirect( pipeline, data().meshlets.d_culled, data().geometry.quantized_arena.vertices(), data().meshlets.d_commands, command, 1 ) ;
+            }
+            else
+            {
+              draw_chain.push               ( pipeline, iter ) ;
+              draw_chain.drawIndexedIndirect( pipeline, data().meshlets.d_culled, data().geometry.arena.vertices(), data().meshlets.d_commands, command, 1 ) ;
+            }
           }
+          
+          continue ;
+        }
+        
+        for( end = begin; end < count && items[ end ].data == items[ begin ].data; end++ )
+        {
+          data().instances[ data().instance_count++ ] = { items[ end ].id, mesh.texture } ;
+        }
+        
+        // Static meshes share the arena's buffers & skinned ones the skinned buffer, so draws only differ by their offsets.
+        if( data().geometry.quantized )
+        {
+          // The quantized shader pulls it's vertices itself, so the bound vertex buffer only has to be valid.
+          draw_chain.push                ( pipeline, quant_iter ) ;
+          draw_chain.drawIndexedInstanced( end - begin, pipeline, data().geometry.quantized_arena.indices(), data().geometry.quantized_arena.vertices(), mesh.geometry.index_count, mesh.geometry.first_index, draw.output ) ;
+        }
+        else
+        {
+          draw_chain.push                ( pipeline, iter ) ;
+          draw_chain.drawIndexedInstanced( end - begin, pipeline, data().geometry.arena.indices(), vertices, mesh.geometry.index_count, mesh.geometry.first_index, draw.output ) ;
+        }
+      }
+      
+      data().uploadInstances() ;
     };
     
-    NyxDrawModule::setTransformFlag  ( nyx::ArrayFlags::StorageBuffer                           ) ;
-    NyxDrawModule::setTransformKey   ( "transform"                                              ) ;
-    NyxDrawModule::setTransformSize  ( TRANSFORM_SIZE                                           ) ;
-    NyxDrawModule::setPipeline       ( nyx::bytes::draw_model, sizeof( nyx::bytes::draw_model ) ) ;
-    NyxDrawModule::setPerDrawCallback( function                                                 ) ;
+    NyxDrawModule::setTransformFlag     ( nyx::ArrayFlags::StorageBuffer                           ) ;
+    NyxDrawModule::setTransformKey      ( "transform"                                              ) ;
+    NyxDrawModule::setTransformSize     ( TRANSFORM_SIZE                                           ) ;
+    NyxDrawModule::setTransformGrowth   ( true                                                     ) ;
+    NyxDrawModule::setPipeline          ( nyx::bytes::draw_model, sizeof( nyx::bytes::draw_model ) ) ;
+    NyxDrawModule::setAddCallback       ( add                                                      ) ;
+    NyxDrawModule::setRemoveCallback    ( remove                                                   ) ;
+    NyxDrawModule::setSortCallback      ( sort                                                     ) ;
+    NyxDrawModule::setSortedDrawCallback( record                                                   ) ;
   }
   
   NyxDrawModel::~NyxDrawModel()
   {
-    
+    delete this->module_data ;
   }
   
   void NyxDrawModel::updateTextures()
@@ -119,34 +1023,151 @@ namespace nyx
   
   void NyxDrawModel::initialize()
   {
-    model_data.copy_chain.initialize( this->gpu(), nyx::ChainType::Compute                  ) ;
-    model_data.d_viewproj.initialize( this->gpu(), 1, false, nyx::ArrayFlags::UniformBuffer ) ;
+    auto& geometry = data().geometry ;
+    auto& skinning = data().skinning ;
+    auto& meshlets = data().meshlets ;
+    
+    data().copy_chain .initialize( this->gpu(), nyx::ChainType::Compute                              ) ;
+    data().d_viewproj .initialize( this->gpu(), 1            , false, nyx::ArrayFlags::UniformBuffer ) ;
+    data().d_instances.initialize( this->gpu(), INSTANCE_SIZE, false, nyx::ArrayFlags::StorageBuffer ) ;
     
-    NyxDrawModule::pipeline().bind( "projection", model_data.d_viewproj ) ;
+    skinning.d_bones  .initialize( this->gpu(), BONE_SIZE    , false, nyx::ArrayFlags::StorageBuffer ) ;
+    skinning.d_jobs   .initialize( this->gpu(), SKIN_JOB_SIZE, false, nyx::ArrayFlags::StorageBuffer ) ;
+    skinning.d_skinned.initialize( this->gpu(), SKINNED_SIZE , false, nyx::ArrayFlags::Vertex | nyx::ArrayFlags::StorageBuffer ) ;
+    skinning.palettes .initialize( BONE_SIZE ) ;
+    skinning.chain    .initialize( this->gpu(), nyx::ChainType::Graphics ) ;
+    
+    meshlets.chain     .initialize( this->gpu(), nyx::ChainType::Graphics                                                         ) ;
+    meshlets.d_meshlets.initialize( this->gpu(), MESHLET_SIZE , false, nyx::ArrayFlags::StorageBuffer                             ) ;
+    meshlets.d_jobs    .initialize( this->gpu(), CULL_JOB_SIZE, false, nyx::ArrayFlags::StorageBuffer                             ) ;
+    meshlets.d_commands.initialize( this->gpu(), CULL_JOB_SIZE, false, nyx::ArrayFlags::StorageBuffer | nyx::ArrayFlags::Indirect ) ;
+    meshlets.d_culled  .initialize( this->gpu(), CULLED_SIZE  , false, nyx::ArrayFlags::StorageBuffer | nyx::ArrayFlags::Index    ) ;
+    meshlets.pipeline  .initialize( this->gpu(), nyx::bytes::meshlet_cull, sizeof( nyx::bytes::meshlet_cull )                     ) ;
+    
+    // Only the arena matching the vertex layout is ever filled, so only it is allocated.
+    if( geometry.quantized )
+    {
+      geometry.quantized_arena  .initialize( this->gpu(), ARENA_VERTICES, ARENA_INDICES                                            ) ;
+      geometry.d_dequantizations.initialize( this->gpu(), DEQUANT_SIZE, false, nyx::ArrayFlags::StorageBuffer                     ) ;
+      skinning.pipeline         .initialize( this->gpu(), nyx::bytes::skinning_quantized, sizeof( nyx::bytes::skinning_quantized ) ) ;
+      skinning.pipeline         .bind      ( "vertices"      , geometry.quantized_arena.vertices() ) ;
+      skinning.pipeline         .bind      ( "dequantization", geometry.d_dequantizations          ) ;
+      
+      NyxDrawModule::pipeline().bind( "vertices"      , geometry.quantized_arena.vertices() ) ;
+      NyxDrawModule::pipeline().bind( "skinned"       , skinning.d_skinned                  ) ;
+      NyxDrawModule::pipeline().bind( "dequantization", geometry.d_dequantizations          ) ;
+    }
+    else
+    {
+      geometry.arena   .initialize( this->gpu(), ARENA_VERTICES, ARENA_INDICES                        ) ;
+      skinning.pipeline.initialize( this->gpu(), nyx::bytes::skinning, sizeof( nyx::bytes::skinning ) ) ;
+      skinning.pipeline.bind      ( "vertices", geometry.arena.vertices() ) ;
+    }
+    
+    skinning.pipeline.bind( "bones"  , skinning.d_bones   ) ;
+    skinning.pipeline.bind( "jobs"   , skinning.d_jobs    ) ;
+    skinning.pipeline.bind( "skinned", skinning.d_skinned ) ;
+    
+    meshlets.pipeline.bind( "projection", data().d_viewproj   ) ;
+    meshlets.pipeline.bind( "meshlets"  , meshlets.d_meshlets ) ;
+    meshlets.pipeline.bind( "jobs"      , meshlets.d_jobs     ) ;
+    meshlets.pipeline.bind( "commands"  , meshlets.d_commands ) ;
+    meshlets.pipeline.bind( "culled"    , meshlets.d_culled   ) ;
+    meshlets.pipeline.bind( "indices"   , geometry.indices()  ) ;
+    
+    NyxDrawModule::pipeline().bind( "projection", data().d_viewproj  ) ;
+    NyxDrawModule::pipeline().bind( "instance"  , data().d_instances ) ;
     
     mars::TextureArray<Framework>::addCallback( this, &NyxDrawModel::updateTextures, this->name() ) ;
+    
+    data().initialized = true ;
   }
   
   void NyxDrawModel::subscribe( unsigned id )
   {
-    this->bus.setChannel( id ) ;
+    this->bus .setChannel( id ) ;
+    data().bus.setChannel( id ) ;
     NyxDrawModule::subscribe( this->bus ) ;
     
-    this->bus.enroll( &model_data, &NyxDrawModelData::setCameraInput    , iris::OPTIONAL, this->name(), "::camera"     ) ;
-    this->bus.enroll( &model_data, &NyxDrawModelData::setProjectionInput, iris::OPTIONAL, this->name(), "::projection" ) ;
+    this->bus.enroll( this->module_data, &NyxDrawModelData::setCameraInput    , iris::OPTIONAL, this->name(), "::camera"     ) ;
+    this->bus.enroll( this->module_data, &NyxDrawModelData::setProjectionInput, iris::OPTIONAL, this->name(), "::projection" ) ;
+    this->bus.enroll( this->module_data, &NyxDrawModelData::setBonesInput     , iris::OPTIONAL, this->name(), "::bones"      ) ;
+    this->bus.enroll( this->module_data, &NyxDrawModelData::setSavedOutput    , iris::OPTIONAL, this->name(), "::lod_saved"  ) ;
+    this->bus.enroll( this                 , &NyxDrawModel::setQuantized          , iris::OPTIONAL, this->name(), "::quantize"   ) ;
+  }
+  
+  void NyxDrawModel::setQuantized( bool value )
+  {
+    // Only the arena & pipelines of the layout at initialization exist, and meshes already placed keep their layout.
+    if( data().initialized )
+    {
+      Log::output( Log::Level::Warning, "Module ", this->name(), " can only change it's vertex layout before being initialized, ignoring." ) ;
+      return ;
+    }
+    
+    Log::output( "Module ", this->name(), " set quantized vertex layout ", value ? "on" : "off" ) ;
+    data().geometry.quantized = value ;
+    
+    if( value ) NyxDrawModule::setPipeline( nyx::bytes::draw_model_quantized, sizeof( nyx::bytes::draw_model_quantized ) ) ;
+    else        NyxDrawModule::setPipeline( nyx::bytes::draw_model          , sizeof( nyx::bytes::draw_model           ) ) ;
   }
   
   void NyxDrawModel::shutdown()
   {
     NyxDrawModule::shutdown() ;
-    model_data.d_viewproj.reset() ;
+    data().d_viewproj .reset() ;
+    data().d_instances.reset() ;
+    
+    if( data().skinning.pending ) data().skinning.chain.synchronize() ;
+    
+    data().skinning.d_bones  .reset() ;
+    data().skinning.d_jobs   .reset() ;
+    data().skinning.d_skinned.reset() ;
+    data().skinning.chain    .reset() ;
+    
+    if( data().meshlets.pending ) data().meshlets.chain.synchronize() ;
+    
+    data().meshlets.d_meshlets.reset() ;
+    data().meshlets.d_jobs    .reset() ;
+    data().meshlets.d_commands.reset() ;
+    data().meshlets.d_culled  .reset() ;
+    data().meshlets.chain     .reset() ;
+    
+    data().geometry.arena            .reset() ;
+    data().geometry.quantized_arena  .reset() ;
+    data().geometry.d_dequantizations.reset() ;
   }
   
   void NyxDrawModel::execute()
   {
-    model_data.updateViewProj() ;
+    auto transform = [=] ( unsigned id ) -> const glm::mat4& { return NyxDrawModule::transform( id ) ; } ;
+    
+    if( data().resolveModels() ) NyxDrawModule::setDirty() ;
+    data().updateViewProj() ;
+    if( data().library.updateLods( data().camera, data().projection, transform ) || data().skinning.changed ) NyxDrawModule::setDirty() ;
+    if( data().viewMoved()                                                                                  ) NyxDrawModule::setDirty() ;
+    if( NyxDrawModule::dirty()                                                                              ) data().skinning.clear()   ;
+    if( NyxDrawModule::dirty()                                                                              ) data().recordView()       ;
     this->draw() ;
-    this->bus.emit() ;
+    data().skinning.skin( this->gpu(), data().geometry ) ;
+    data().meshlets.cull( this->gpu(), data().camera, transform ) ;
+    this->bus .emit() ;
+    data().bus.emit() ;
+  }
+  
+  unsigned NyxDrawModel::pendingModels() const
+  {
+    return data().library.table.pending() ;
+  }
+  
+  NyxDrawModelData& NyxDrawModel::data()
+  {
+    return *this->module_data ;
+  }
+  
+  const NyxDrawModelData& NyxDrawModel::data() const
+  {
+    return *this->module_data ;
   }
 }
 
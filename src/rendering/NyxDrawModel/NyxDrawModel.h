@@ -57,8 +57,34 @@ namespace nyx
       /** Method to execute a single instance of this module's operation.
        */
       void execute() ;
+      
+      /** Method to retrieve the amount of drawables waiting for their models to be resolved on the next execution.
+       * @return The amount of queued drawables of this object.
+       */
+      unsigned pendingModels() const ;
 
     private:
+      
+      /** Forward-declared structure to contain this object's internal data.
+       */
+      struct NyxDrawModelData *module_data ;
+      
       iris::Bus bus ;
+
+      /** Method to set whether meshes are stored in the quantized vertex layout, picking the matching shader variants.
+       * Only accepted before this module is initialized.
+       * @param value Whether to quantize meshes when they are loaded.
+       */
+      void setQuantized( bool value ) ;
+
+      /** Method to retrieve a reference to this object's internal data.
+       * @return Reference to this object's internal data.
+       */
+      NyxDrawModelData& data() ;
+      
+      /** Method to retrieve a const-reference to this object's internal data.
+       * @return Const-reference to this object's internal data.
+       */
+      const NyxDrawModelData& data() const ;
   };
 }
\ No newline at end of file
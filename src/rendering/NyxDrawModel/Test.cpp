@@ -1,20 +1,647 @@
 /*
- * To change this license header, choose License Headers in Project Properties.
- * To change this template file, choose Tools | Templates
- * and open the template in the editor.
+ * Copyright (C) 2020 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-/* 
+/*
  * File:   Test.cpp
  * Author: jhendl
  *
  * Created on April 17, 2021, 1:30 AM
  */
 
+#include "NyxDrawModel.h"
+#include <templates/NyxDrawQueue.h>
+#include <templates/NyxLodChain.h>
+#include <templates/NyxGeometryArena.h>
+#include <templates/NyxVertexQuantization.h>
+#include <templates/NyxMeshlets.h>
+#include <templates/NyxModelTable.h>
+#include <templates/NyxSkinning.h>
+#include <Iris/data/Bus.h>
+#include <Mars/Manager.h>
+#include <glm/glm.hpp>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <map>
+#include <array>
+#include <algorithm>
+#include <vector>
+#include <thread>
 #include <cstdlib>
 
-int main()
+constexpr unsigned SCENE_MESHES = 10000 ;
+constexpr unsigned TEXTURES     = 64    ;
+constexpr unsigned MESHES       = 256   ;
+
+/** Counts how many times consecutive draws change texture or mesh, i.e. how many binds recording would issue.
+ */
+static unsigned stateChanges( const nyx::DrawQueue& queue )
 {
-  return 0;
+  unsigned changes = 0 ;
+
+  for( unsigned index = 1; index < queue.size(); index++ )
+  {
+    if( nyx::drawKeyState( queue.data()[ index ].key ) != nyx::drawKeyState( queue.data()[ index - 1 ].key ) ) changes++ ;
+  }
+
+  return changes ;
 }
 
+/** Benchmarks gathering & sorting a 10k mesh scene, and verifies the result is ordered.
+ */
+static bool testSortedRecording()
+{
+  std::mt19937                            rng( 1337 )                ;
+  std::uniform_int_distribution<unsigned> texture( 0, TEXTURES - 1 ) ;
+  std::uniform_int_distribution<unsigned> mesh   ( 0, MESHES   - 1 ) ;
+  std::uniform_real_distribution<float>   depth  ( 0.0f, 5000.0f   ) ;
+  nyx::DrawQueue                          queue                      ;
+  unsigned                                unsorted_changes           ;
+
+  auto start = std::chrono::high_resolution_clock::now() ;
+
+  for( unsigned id = 0; id < SCENE_MESHES; id++ )
+  {
+    queue.push( nyx::makeDrawKey( 0, texture( rng ), mesh( rng ), nyx::quantizeDepth( depth( rng ), 5000.0f ) ), id, id ) ;
+  }
+
+  unsorted_changes = stateChanges( queue ) ;
+
+  auto sort_start = std::chrono::high_resolution_clock::now() ;
+  queue.sort() ;
+  auto end = std::chrono::high_resolution_clock::now() ;
+
+  std::cout << "Sorted recording of " << SCENE_MESHES << " meshes: "                                                        << "\n"
+            << "-- Gather time : " << std::chrono::duration<double, std::micro>( sort_start - start      ).count() << "us" << "\n"
+            << "-- Sort time   : " << std::chrono::duration<double, std::micro>( end        - sort_start ).count() << "us" << "\n"
+            << "-- State changes unsorted: " << unsorted_changes << ", sorted: " << stateChanges( queue )                    << std::endl ;
+
+  for( unsigned index = 1; index < queue.size(); index++ )
+  {
+    if( queue.data()[ index - 1 ].key > queue.data()[ index ].key ) return false ;
+  }
+
+  // Handles past a field's range have to sort after the ones that fit, instead of wrapping onto small handles.
+  if( nyx::makeDrawKey( 0, 0, nyx::DRAW_KEY_MESH_MAX + 1, 0 ) <= nyx::makeDrawKey( 0, 0, 1, 0 ) ) return false ;
+  if( nyx::makeDrawKey( 0, 0, nyx::DRAW_KEY_MESH_MAX + 1, 0 ) >= nyx::makeDrawKey( 0, 1, 0, 0 ) ) return false ;
+
+  return stateChanges( queue ) < unsorted_changes ;
+}
+
+/** Resolves a 10k drawable scene sharing 256 models through the module's model table, checking every model is only resolved once & removed drawables never are.
+ * Also benchmarks the recording loop looking meshes up by name every draw against the handles the table resolved once.
+ */
+static bool testMeshHandles()
+{
+  struct Mesh
+  {
+    std::string                     name     ;
+    std::map<std::string, unsigned> textures ;
+  };
+  
+  constexpr unsigned FRAMES = 100 ;
+  
+  std::vector<Mesh>                         meshes          ;
+  std::vector<unsigned>                     handles         ;
+  std::unordered_map<std::string, unsigned> mesh_map        ;
+  nyx::ModelTable<Mesh>                     table           ;
+  unsigned long long                        checksum_string ;
+  unsigned long long                        checksum_handle ;
+  
+  checksum_string = 0 ;
+  checksum_handle = 0 ;
+  
+  for( unsigned index = 0; index < MESHES; index++ )
+  {
+    meshes.push_back( { "Untitled_" + std::to_string( index ) + "-mesh", { { "diffuse", index % TEXTURES }, { "normal", 0 } } } ) ;
+  }
+  
+  auto resolve = [&] ( const Mesh& mesh )
+  {
+    handles.push_back( mesh.textures.at( "diffuse" ) ) ;
+    return static_cast<unsigned>( handles.size() - 1 ) ;
+  };
+  
+  for( unsigned id = 0; id < SCENE_MESHES; id++ ) table.add( id, meshes[ id % MESHES ] ) ;
+  
+  // Removed before ever being resolved, like a drawable added & removed within one frame.
+  table.remove( SCENE_MESHES - 1 ) ;
+  
+  auto resolve_start = std::chrono::high_resolution_clock::now() ;
+  const unsigned resolved = table.resolve( resolve ) ;
+  auto start = std::chrono::high_resolution_clock::now() ;
+  
+  if( resolved != SCENE_MESHES - 1 || handles.size() != MESHES || table.pending() != 0 || table.model( SCENE_MESHES - 1 ) != UINT_MAX ) return false ;
+  
+  for( unsigned frame = 0; frame < FRAMES; frame++ )
+  {
+    for( unsigned id = 0; id < SCENE_MESHES - 1; id++ )
+    {
+      auto& mesh = meshes[ id % MESHES ]           ;
+      auto& iter = mesh_map[ mesh.name ]           ;
+      auto  tex  = mesh.textures.find( "diffuse" ) ;
+      
+      iter             = tex != mesh.textures.end() ? tex->second : 0 ;
+      checksum_string += iter                                         ;
+    }
+  }
+  auto middle = std::chrono::high_resolution_clock::now() ;
+  for( unsigned frame = 0; frame < FRAMES; frame++ )
+  {
+    for( unsigned id = 0; id < SCENE_MESHES - 1; id++ )
+    {
+      checksum_handle += handles[ table.model( id ) ] ;
+    }
+  }
+  auto end = std::chrono::high_resolution_clock::now() ;
+  
+  std::cout << "Recording " << SCENE_MESHES << " meshes, averaged over " << FRAMES << " re-records: "                                 << "\n"
+            << "-- Resolving once : " << std::chrono::duration<double, std::micro>( start  - resolve_start ).count()          << "us" << "\n"
+            << "-- String lookups : " << std::chrono::duration<double, std::micro>( middle - start         ).count() / FRAMES << "us" << "\n"
+            << "-- Integer handles: " << std::chrono::duration<double, std::micro>( end    - middle        ).count() / FRAMES << "us" << std::endl ;
+  
+  // A resolved drawable removed & added again keeps using the model's existing handle.
+  table.setLod( 0, 2 ) ;
+  table.remove( 0 ) ;
+  if( table.model( 0 ) != UINT_MAX || table.lod( 0 ) != 0 ) return false ;
+  
+  table.add( 0, meshes[ 0 ] ) ;
+  table.resolve( resolve ) ;
+  
+  return checksum_string == checksum_handle && handles.size() == MESHES && table.model( 0 ) == 0 ;
+}
+
+/** Sweeps a drawable back and forth across a level's switch size, and verifies hysteresis keeps it from popping.
+ * Also reports the triangles saved by drawing a field of 10k models with a three level chain.
+ */
+static bool testLodSelection()
+{
+  const float        sizes    [] = { 0.25f, 0.1f, 0.05f }    ;
+  const unsigned     triangles[] = { 20000, 5000, 1250, 300 } ;
+  unsigned           level       = 0                          ;
+  unsigned           switches    = 0                          ;
+  unsigned long long full        = 0                          ;
+  unsigned long long drawn       = 0                          ;
+  
+  // Jitter just around the first switch size, closer than the hysteresis band.
+  for( unsigned frame = 0; frame < 1000; frame++ )
+  {
+    const float    size = 0.25f + ( frame % 2 ? 0.01f : -0.01f ) ;
+    const unsigned next = nyx::selectLod( sizes, 3, size, level ) ;
+    
+    if( next != level ) switches++ ;
+    level = next ;
+  }
+  
+  if( switches != 0 ) return false ;
+  
+  // Clearly crossing a switch size must still change level.
+  if( nyx::selectLod( sizes, 3, 0.2f , 0 ) != 1 ) return false ;
+  if( nyx::selectLod( sizes, 3, 0.01f, 0 ) != 3 ) return false ;
+  if( nyx::selectLod( sizes, 3, 0.5f , 3 ) != 0 ) return false ;
+  
+  for( unsigned id = 0; id < SCENE_MESHES; id++ )
+  {
+    const float distance = 1.0f + static_cast<float>( id % 100 ) ;
+    
+    level  = nyx::selectLod( sizes, 3, 1.0f / distance, 0 ) ;
+    full  += triangles[ 0     ] ;
+    drawn += triangles[ level ] ;
+  }
+  
+  std::cout << "Level of detail over " << SCENE_MESHES << " models: " << "\n"
+            << "-- Full detail triangles: " << full            << "\n"
+            << "-- Drawn triangles      : " << drawn           << "\n"
+            << "-- Triangles saved      : " << ( full - drawn ) << std::endl ;
+  
+  return drawn < full ;
+}
+
+/** Places & releases a churn of mesh-sized ranges in an arena free list, and verifies released space is merged back.
+ */
+static bool testGeometryArena()
+{
+  struct Range
+  {
+    unsigned offset ;
+    unsigned count  ;
+  };
+  
+  constexpr unsigned CAPACITY = 1 << 20 ;
+  
+  std::mt19937                            rng( 1337 )      ;
+  std::uniform_int_distribution<unsigned> size( 64, 4096 ) ;
+  nyx::FreeList                           list             ;
+  std::vector<Range>                      ranges           ;
+  
+  list.initialize( CAPACITY ) ;
+  
+  auto start = std::chrono::high_resolution_clock::now() ;
+  for( unsigned iteration = 0; iteration < SCENE_MESHES; iteration++ )
+  {
+    // Release a random range every third placement, like models being unloaded.
+    if( iteration % 3 == 2 && !ranges.empty() )
+    {
+      const unsigned index = rng() % ranges.size() ;
+      list.release( ranges[ index ].offset, ranges[ index ].count ) ;
+      ranges[ index ] = ranges.back() ;
+      ranges.pop_back() ;
+    }
+    
+    const unsigned count  = size( rng )           ;
+    const unsigned offset = list.allocate( count ) ;
+    
+    if( offset == UINT_MAX ) list.grow( list.capacity() * 2 ) ;
+    else                     ranges.push_back( { offset, count } ) ;
+  }
+  auto end = std::chrono::high_resolution_clock::now() ;
+  
+  std::cout << "Geometry arena churn of " << SCENE_MESHES << " meshes: "                                  << "\n"
+            << "-- Time           : " << std::chrono::duration<double, std::micro>( end - start ).count() << "us" << "\n"
+            << "-- Live ranges    : " << ranges.size()                                                     << "\n"
+            << "-- Used / capacity: " << list.used() << " / " << list.capacity()                           << "\n"
+            << "-- Free ranges    : " << list.ranges()                                                     << std::endl ;
+  
+  for( auto& range : ranges ) list.release( range.offset, range.count ) ;
+  
+  return list.used() == 0 && list.ranges() == 1 ;
+}
+
+/** Packs the bone palettes of a crowd of characters the way the module does, and skins them with the pass's per-vertex math.
+ * Palettes translate & scale differently per character and bone, so every skinned vertex is checked against where it's palette has to move it.
+ * Also removes & re-adds part of the crowd, checking released bone ranges are reused instead of growing the buffer.
+ * The timing is only a host reference for the compute pass, which does the same per-vertex work.
+ */
+static bool testSkinningThroughput()
+{
+  struct Vertex
+  {
+    glm::vec4  vertex     ;
+    glm::vec4  normals    ;
+    glm::vec4  weights    ;
+    glm::uvec4 ids        ;
+    glm::vec2  tex_coords ;
+  };
+  
+  constexpr unsigned CHARACTERS = 300  ;
+  constexpr unsigned VERTICES   = 5000 ;
+  constexpr unsigned BONES      = 64   ;
+  
+  std::mt19937                            rng( 1337 )          ;
+  std::uniform_int_distribution<unsigned> bone( 0, BONES - 1 ) ;
+  std::uniform_real_distribution<float>   value( -1.0f, 1.0f ) ;
+  std::vector<Vertex>                     vertices( VERTICES ) ;
+  std::vector<Vertex>                     skinned( VERTICES )  ;
+  std::vector<glm::mat4>                  palette( BONES )     ;
+  nyx::BonePalettes                       palettes             ;
+  unsigned                                capacity             ;
+  bool                                    valid                ;
+  
+  // Every bone of a character scales by the character's scale & then moves by the bone's offset.
+  auto scale  = [] ( unsigned character ) { return 1.0f + 0.01f * character ; } ;
+  auto offset = [] ( unsigned character, unsigned index ) { return glm::vec3( static_cast<float>( index ), 0.5f * character, -1.0f ) ; } ;
+  
+  auto fill = [&] ( unsigned character )
+  {
+    for( unsigned index = 0; index < BONES; index++ )
+    {
+      palette[ index ]      = glm::mat4( scale( character ) )                 ;
+      palette[ index ][ 3 ] = glm::vec4( offset( character, index ), 1.0f ) ;
+    }
+  };
+  
+  for( auto& vert : vertices )
+  {
+    vert.vertex  = glm::vec4( value( rng ), value( rng ), value( rng ), 1.0f ) ;
+    vert.normals = glm::vec4( 0.0f, 1.0f, 0.0f, 0.0f ) ;
+    vert.weights = glm::vec4( 0.4f, 0.3f, 0.2f, 0.1f ) ;
+    vert.ids     = glm::uvec4( bone( rng ), bone( rng ), bone( rng ), bone( rng ) ) ;
+  }
+  
+  palettes.initialize( BONES * CHARACTERS / 2 ) ;
+  
+  for( unsigned character = 0; character < CHARACTERS; character++ )
+  {
+    fill( character ) ;
+    palettes.set( character, palette.data(), BONES ) ;
+  }
+  
+  // Every other character leaves & comes back, which has to fit in the ranges they gave back.
+  capacity = palettes.size() ;
+  for( unsigned character = 0; character < CHARACTERS; character += 2 ) palettes.remove( character ) ;
+  for( unsigned character = 0; character < CHARACTERS; character += 2 )
+  {
+    fill( character ) ;
+    palettes.set( character, palette.data(), BONES ) ;
+  }
+  
+  valid = palettes.size() == capacity && palettes.used() == CHARACTERS * BONES ;
+  
+  auto start = std::chrono::high_resolution_clock::now() ;
+  for( unsigned character = 0; character < CHARACTERS; character++ )
+  {
+    for( unsigned index = 0; index < VERTICES; index++ )
+    {
+      skinned[ index ] = nyx::skinVertex( vertices[ index ], palettes.bones(), palettes.first( character ) ) ;
+    }
+    
+    const Vertex&   vert     = vertices[ character % VERTICES ]                                                     ;
+    const glm::vec3 moved    = vert.weights.x * offset( character, vert.ids.x ) + vert.weights.y * offset( character, vert.ids.y ) +
+                               vert.weights.z * offset( character, vert.ids.z ) + vert.weights.w * offset( character, vert.ids.w ) ;
+    const glm::vec3 expected = scale( character ) * glm::vec3( vert.vertex ) + moved                                ;
+    
+    valid = valid && glm::length( glm::vec3( skinned[ character % VERTICES ].vertex ) - expected ) < 0.001f                 ;
+    valid = valid && glm::length( glm::vec3( skinned[ character % VERTICES ].normals ) - glm::vec3( vert.normals ) ) < 0.001f ;
+  }
+  auto end = std::chrono::high_resolution_clock::now() ;
+  
+  const double seconds = std::chrono::duration<double>( end - start ).count() ;
+  
+  std::cout << "Skinning " << CHARACTERS << " characters of " << VERTICES << " vertices, host reference: "              << "\n"
+            << "-- Bone buffer : " << palettes.used() << " of " << palettes.size() << " bones used"                   << "\n"
+            << "-- Time        : " << seconds * 1000.0 << "ms"                                                        << "\n"
+            << "-- Throughput  : " << ( CHARACTERS * VERTICES ) / seconds / 1000000.0 << " Mvertices/s" << std::endl ;
+  
+  return valid ;
+}
+
+/** Quantizes random NGG vertices and checks they decode back within the precision of the quantized layout.
+ */
+static bool testVertexQuantization()
+{
+  struct Vertex
+  {
+    glm::vec4  vertex     ;
+    glm::vec4  normals    ;
+    glm::vec4  weights    ;
+    glm::uvec4 ids        ;
+    glm::vec2  tex_coords ;
+  };
+  
+  constexpr unsigned VERTICES = 100000 ;
+  
+  std::mt19937                            rng( 1337 )           ;
+  std::uniform_int_distribution<unsigned> bone( 0, 63 )         ;
+  std::uniform_real_distribution<float>   value( -1.0f, 1.0f )  ;
+  std::vector<Vertex>                     vertices( VERTICES )  ;
+  float                                   position_error = 0.0f ;
+  float                                   normal_error   = 0.0f ;
+  bool                                    weights_valid  = true ;
+  
+  for( auto& vert : vertices )
+  {
+    const glm::vec4 weights = glm::abs( glm::vec4( value( rng ), value( rng ), value( rng ), value( rng ) ) ) ;
+    
+    vert.vertex     = glm::vec4( value( rng ) * 50.0f, value( rng ) * 2.0f, value( rng ) * 10.0f, 1.0f )           ;
+    vert.normals    = glm::vec4( glm::normalize( glm::vec3( value( rng ), value( rng ), value( rng ) ) ), 0.0f ) ;
+    vert.weights    = weights / ( weights.x + weights.y + weights.z + weights.w )                                  ;
+    vert.ids        = glm::uvec4( bone( rng ), bone( rng ), bone( rng ), bone( rng ) )                             ;
+    vert.tex_coords = glm::vec2( value( rng ), value( rng ) ) * 0.5f + 0.5f                                        ;
+  }
+  
+  const nyx::Dequantization dequant = nyx::computeDequantization( vertices.data(), vertices.size() ) ;
+  
+  for( const auto& vert : vertices )
+  {
+    const nyx::QuantizedVertex packed   = nyx::quantizeVertex( vert, dequant )                                                          ;
+    const glm::vec3            snorm    = glm::vec3( packed.position[ 0 ], packed.position[ 1 ], packed.position[ 2 ] ) / 32767.0f ;
+    const glm::vec3            position = glm::vec3( dequant.offset ) + glm::vec3( dequant.scale ) * snorm                        ;
+    const glm::vec3            normal   = nyx::octDecode( glm::unpackSnorm2x16( packed.normal ) )                                  ;
+    const unsigned             total    = ( packed.weights & 0xFF ) + ( ( packed.weights >> 8 ) & 0xFF ) + ( ( packed.weights >> 16 ) & 0xFF ) + ( packed.weights >> 24 ) ;
+    
+    position_error = std::max( position_error, glm::length( position - glm::vec3( vert.vertex ) ) )                        ;
+    normal_error   = std::max( normal_error  , std::acos( glm::clamp( glm::dot( normal, glm::vec3( vert.normals ) ), -1.0f, 1.0f ) ) ) ;
+    weights_valid  = weights_valid && total == 255 && ( packed.ids & 0xFF ) == vert.ids.x && ( packed.ids >> 24 ) == vert.ids.w          ;
+  }
+  
+  std::cout << "Quantized vertex layout over " << VERTICES << " vertices: "                   << "\n"
+            << "-- Bytes per vertex    : " << sizeof( Vertex ) << " -> " << sizeof( nyx::QuantizedVertex ) << "\n"
+            << "-- Max position error  : " << position_error                                    << "\n"
+            << "-- Max normal error    : " << normal_error << " radians"                        << std::endl ;
+  
+  // Half a step of a 16-bit grid over the widest axis, and well under a degree for the normals.
+  return weights_valid && position_error < 50.0f / 32767.0f && normal_error < 0.001f && sizeof( Vertex ) > 2 * sizeof( nyx::QuantizedVertex ) ;
+}
+
+/** Splits a shuffled sphere into meshlets, and checks that they keep the mesh intact & that cone culling is conservative.
+ */
+static bool testMeshlets()
+{
+  struct Vertex
+  {
+    glm::vec4 vertex ;
+  };
+  
+  constexpr unsigned RINGS    = 128                   ;
+  constexpr unsigned SEGMENTS = 256                   ;
+  constexpr float    PI       = 3.14159265358979f     ;
+  
+  std::mt19937                         rng( 1337 )              ;
+  std::vector<Vertex>                  vertices                 ;
+  std::vector<unsigned>                indices                  ;
+  std::vector<std::array<unsigned, 3>> triangles                ;
+  std::vector<nyx::Meshlet>            meshlets                 ;
+  std::vector<unsigned>                seen                     ;
+  const glm::vec3                      eye( 0.0f, 0.0f, 5.0f )  ;
+  unsigned                             culled    = 0            ;
+  bool                                 valid     = true         ;
+  
+  for( unsigned ring = 0; ring <= RINGS; ring++ )
+  {
+    for( unsigned segment = 0; segment <= SEGMENTS; segment++ )
+    {
+      const float theta = PI * ring / RINGS ;
+      const float phi   = 2.0f * PI * segment / SEGMENTS ;
+      
+      vertices.push_back( { glm::vec4( std::sin( theta ) * std::cos( phi ), std::sin( theta ) * std::sin( phi ), std::cos( theta ), 1.0f ) } ) ;
+    }
+  }
+  
+  for( unsigned ring = 0; ring < RINGS; ring++ )
+  {
+    for( unsigned segment = 0; segment < SEGMENTS; segment++ )
+    {
+      const unsigned a = ring * ( SEGMENTS + 1 ) + segment ;
+      const unsigned b = a + SEGMENTS + 1                  ;
+      
+      // The poles collapse a corner of these, leave the degenerate ones out like an exporter would.
+      if( ring != 0         ) triangles.push_back( { a, a + 1, b } ) ;
+      if( ring != RINGS - 1 ) triangles.push_back( { a + 1, b + 1, b } ) ;
+    }
+  }
+  
+  std::shuffle( triangles.begin(), triangles.end(), rng ) ;
+  for( const auto& triangle : triangles ) indices.insert( indices.end(), triangle.begin(), triangle.end() ) ;
+  
+  auto start = std::chrono::high_resolution_clock::now() ;
+  nyx::buildMeshlets( vertices.data(), vertices.size(), indices.data(), indices.size(), meshlets ) ;
+  auto time  = std::chrono::duration<double, std::milli>( std::chrono::high_resolution_clock::now() - start ).count() ;
+  
+  auto sorted = [] ( std::vector<std::array<unsigned, 3>> list )
+  {
+    for( auto& triangle : list ) std::rotate( triangle.begin(), std::min_element( triangle.begin(), triangle.end() ), triangle.end() ) ;
+    std::sort( list.begin(), list.end() ) ;
+    return list ;
+  };
+  
+  std::vector<std::array<unsigned, 3>> after ;
+  for( unsigned index = 0; index < indices.size(); index += 3 ) after.push_back( { indices[ index ], indices[ index + 1 ], indices[ index + 2 ] } ) ;
+  
+  valid = sorted( triangles ) == sorted( after ) ;
+  
+  for( unsigned index = 0; index < meshlets.size(); index++ )
+  {
+    const auto&    meshlet = meshlets[ index ]                                                         ;
+    const unsigned next    = index + 1 < meshlets.size() ? meshlets[ index + 1 ].first_index : indices.size() ;
+    const bool     back    = nyx::meshletBackfacing( meshlet, eye )                                    ;
+    
+    seen.assign( indices.data() + meshlet.first_index, indices.data() + meshlet.first_index + meshlet.index_count ) ;
+    std::sort( seen.begin(), seen.end() ) ;
+    
+    valid = valid && next == meshlet.first_index + meshlet.index_count && meshlet.index_count <= nyx::MESHLET_TRIANGLES * 3 ;
+    valid = valid && std::unique( seen.begin(), seen.end() ) - seen.begin() <= nyx::MESHLET_VERTICES ;
+    
+    for( unsigned corner = meshlet.first_index; corner < meshlet.first_index + meshlet.index_count; corner++ )
+    {
+      valid = valid && glm::length( glm::vec3( vertices[ indices[ corner ] ].vertex ) - glm::vec3( meshlet.sphere ) ) <= meshlet.sphere.w + 1e-5f ;
+    }
+    
+    // A culled meshlet must not contain a single triangle facing the eye.
+    for( unsigned corner = meshlet.first_index; back && corner < meshlet.first_index + meshlet.index_count; corner += 3 )
+    {
+      const glm::vec3 a = glm::vec3( vertices[ indices[ corner     ] ].vertex ) ;
+      const glm::vec3 b = glm::vec3( vertices[ indices[ corner + 1 ] ].vertex ) ;
+      const glm::vec3 c = glm::vec3( vertices[ indices[ corner + 2 ] ].vertex ) ;
+      
+      valid = valid && glm::dot( glm::cross( b - a, c - a ), a - eye ) >= 0.0f ;
+    }
+    
+    if( back ) culled++ ;
+  }
+  
+  std::cout << "Meshlets of a " << triangles.size() << " triangle sphere: "                                     << "\n"
+            << "-- Build time       : " << time << "ms"                                                          << "\n"
+            << "-- Meshlets         : " << meshlets.size() << ", " << static_cast<float>( triangles.size() ) / meshlets.size() << " triangles each" << "\n"
+            << "-- Backface culled  : " << culled << " seen from outside"                                      << std::endl ;
+  
+  // Nearly half the sphere faces away, most of it should be caught by the cones.
+  return valid && culled > meshlets.size() / 4 && triangles.size() / meshlets.size() > nyx::MESHLET_TRIANGLES / 2 ;
+}
+
+/** Adds & removes drawables on two model drawers from separate threads, like two passes of one graph, checking neither sees the other's drawables.
+ * Models are only resolved once a device is there, so this checks the drawables each instance holds & has queued for resolving.
+ */
+static bool testConcurrentInstances()
+{
+  using Model        = mars::Model<nyx::vkg::Vulkan>  ;
+  using ModelManager = mars::Manager<unsigned, Model> ;
+  
+  constexpr unsigned MODELS = 16 ;
+  
+  nyx::NyxDrawModel                   opaque      ;
+  nyx::NyxDrawModel                   transparent ;
+  std::vector<mars::Reference<Model>> models      ;
+  
+  for( unsigned index = 0; index < MODELS; index++ ) models.push_back( ModelManager::create( index ) ) ;
+  
+  opaque     .setName( "opaque"      ) ;
+  transparent.setName( "transparent" ) ;
+  opaque     .subscribe( 0 ) ;
+  transparent.subscribe( 0 ) ;
+  
+  // Adds every drawable in the range, then removes every n-th one of them again.
+  auto run = [&] ( std::string name, unsigned count, unsigned removed )
+  {
+    iris::Bus         bus                         ;
+    const std::string add    = name + "_drawables" ;
+    const std::string remove = name + "_removals"  ;
+    
+    bus.emit<const char*>( add   .c_str(), ( name + "::drawable" ).c_str() ) ;
+    bus.emit<const char*>( remove.c_str(), ( name + "::remove"   ).c_str() ) ;
+    
+    for( unsigned id = 0; id < count; id++ ) bus.emitIndexed( models[ id % MODELS ], id, add.c_str() ) ;
+    for( unsigned id = 0; id < count; id += removed ) bus.emit( id, remove.c_str() ) ;
+  };
+  
+  std::thread first ( run, "opaque"     , 600, 3 ) ;
+  std::thread second( run, "transparent", 400, 2 ) ;
+  
+  first .join() ;
+  second.join() ;
+  
+  std::cout << "Concurrent instances: "                                                                                  << "\n"
+            << "-- Opaque      : " << opaque     .drawableCount() << " drawables, " << opaque     .pendingModels() << " queued" << "\n"
+            << "-- Transparent : " << transparent.drawableCount() << " drawables, " << transparent.pendingModels() << " queued" << std::endl ;
+  
+  return opaque     .drawableCount() == 400 && opaque     .pendingModels() == 400 &&
+         transparent.drawableCount() == 200 && transparent.pendingModels() == 200 ;
+}
+
+int main()
+{
+  if( !testSortedRecording() )
+  {
+    std::cout << "Sorted draw recording test failed." << std::endl ;
+    return 1 ;
+  }
+  
+  if( !testMeshHandles() )
+  {
+    std::cout << "Mesh handle test failed." << std::endl ;
+    return 1 ;
+  }
+  
+  if( !testLodSelection() )
+  {
+    std::cout << "Level of detail selection test failed." << std::endl ;
+    return 1 ;
+  }
+  
+  if( !testGeometryArena() )
+  {
+    std::cout << "Geometry arena test failed." << std::endl ;
+    return 1 ;
+  }
+  
+  if( !testSkinningThroughput() )
+  {
+    std::cout << "Skinning throughput test failed." << std::endl ;
+    return 1 ;
+  }
+  
+  if( !testVertexQuantization() )
+  {
+    std::cout << "Vertex quantization test failed." << std::endl ;
+    return 1 ;
+  }
+  
+  if( !testMeshlets() )
+  {
+    std::cout << "Meshlet test failed." << std::endl ;
+    return 1 ;
+  }
+  
+  if( !testConcurrentInstances() )
+  {
+    std::cout << "Concurrent NyxDrawModel instance test failed." << std::endl ;
+    return 1 ;
+  }
+
+  return 0 ;
+}
@@ -27,6 +27,8 @@
 
 #include "NyxDrawSprite.h"
 #include "draw_sprite.h"
+#include <templates/NyxUpdateQueue.h>
+#include <templates/NyxAtlas.h>
 #include <Iris/data/Bus.h>
 #include <Iris/log/Log.h>
 #include <Iris/profiling/Timer.h>
@@ -46,22 +48,51 @@
 #include <algorithm>
 #include <climits>
 #include <mutex>
+#include <atomic>
+#include <thread>
 #include <map>
 #include <unordered_map>
+#include <chrono>
 
 static const unsigned VERSION = 1 ;
 namespace nyx
 {
+  /** The amount of sprites space is allocated for up front. Grown by doubling whenever a higher sprite id shows up.
+   */
+  constexpr unsigned SPRITE_CAPACITY = 1024 ;
+  
+  /** The atlas page of sprites drawn from a texture instead. Matches NO_ATLAS in the sprite shaders.
+   */
+  constexpr unsigned NO_ATLAS = UINT_MAX ;
+  
   namespace vkg
   {
+    /** Structure describing a sprite as the shader reads it. Matches Sprite in draw_sprite.vert.glsl.
+     */
     struct Sprite
     {
-      unsigned sprite_index  = 0    ;
-      unsigned tex_index     = 0    ;
-      unsigned sprite_width  = 64   ;
-      unsigned sprite_height = 64   ;
-      unsigned image_width   = 1240 ;
-      unsigned image_height  = 1080 ;
+      glm::vec4 uv          = glm::vec4( 0.0f, 0.0f, 1.0f, 1.0f ) ; ///< The sprite's current frame in it's texture or atlas page, or the sheet's first cell when animated. xy is the offset, zw the size.
+      unsigned  tex_index   = 0                                   ;
+      unsigned  atlas_page  = NO_ATLAS                            ;
+      unsigned  columns     = 1                                   ; ///< The amount of cells in a row of the sheet, to step an animation's frames through.
+      unsigned  first_frame = 0                                   ;
+      unsigned  frame_count = 0                                   ; ///< One or less means the sprite isn't animated & uv is used as is.
+      float     fps         = 0.0f                                ;
+      unsigned  loop        = 0                                   ;
+      float     start_time  = 0.0f                                ; ///< The module's clock when the animation was set.
+    };
+    
+    /** Structure describing a single change to a sprite, queued by whichever thread made it & applied once per frame.
+     */
+    struct SpriteUpdate
+    {
+      enum Kind : unsigned { Index, Texture, Atlas, Transform, Remove, Animation } ;
+      
+      Kind            kind      ;
+      unsigned        id        ;
+      unsigned        value     ;
+      glm::mat4       transform ;
+      SpriteAnimation animation ;
     };
 
       glm::vec4 sprite_vertices[] = 
@@ -77,12 +108,13 @@ namespace nyx
       };
     
     // <editor-fold defaultstate="collapsed" desc="Aliases">
-    using Log       = iris::log::Log               ;
-    using Impl      = nyx::vkg::Vulkan             ;
-    using Matrix    = glm::mat4                    ;
-    using IdVec     = std::vector<unsigned>        ;
-    using IdMap     = std::map<unsigned, unsigned> ;
-    using SpriteMap = std::map<unsigned, Sprite>   ;
+    using Log       = iris::log::Log                  ;
+    using Impl      = nyx::vkg::Vulkan                ;
+    using Matrix    = glm::mat4                       ;
+    using IdVec     = std::vector<unsigned>           ;
+    using IdMap     = std::map<unsigned, unsigned>    ;
+    using SpriteMap = std::map<unsigned, SpriteFrame> ;
+    using Atlas     = nyx::Atlas<Impl>                ;
     // </editor-fold>
     
     // <editor-fold defaultstate="collapsed" desc="NyxDrawSpriteData Class & Function Declerations">
@@ -93,10 +125,7 @@ namespace nyx
         Matrix proj ;
       };
       
-      struct Iterators
-      {
-        nyx::Iterator<Impl, glm::mat4> positions ;
-      };
+      using Clock = std::chrono::steady_clock ;
       
       IdMap                        drawables        ;
       SpriteMap                    sprite_map       ;
@@ -104,9 +133,10 @@ namespace nyx
       nyx::Array<Impl, glm::vec4>  d_vertices       ;
       nyx::Array<Impl, glm::mat4>  d_transforms     ;
       nyx::Array<Impl, glm::mat4>  d_viewproj       ;
+      nyx::Array<Impl, float    >  d_time           ;
       std::vector<glm::mat4>       h_transforms     ;
       std::vector<Sprite>          h_sprites        ;
-      Iterators                    h_iterator       ;
+      std::vector<SpriteFrame>     h_frames         ;
       nyx::Viewport                viewport         ;
       Proj                         mvp              ;
       const Matrix*                camera           ;
@@ -125,15 +155,37 @@ namespace nyx
       bool                         dirty_flag       ;
       bool                         vp_dirty_flag    ;
       std::mutex                   lock             ;
+      std::mutex                   sheet_lock       ;
+      UpdateQueue<SpriteUpdate>    updates          ;
+      std::atomic_flag             applying         ;
+      unsigned                     transform_begin  ;
+      unsigned                     transform_end    ;
+      unsigned                     sprite_begin     ;
+      unsigned                     sprite_end       ;
+      bool                         transforms_grown ;
+      bool                         sprites_grown    ;
+      unsigned                     drawn            ;
+      IdMap                        atlased          ;
+      std::atomic<const Atlas*>    atlas            ;
+      std::atomic<bool>            atlas_changed    ;
+      std::atomic<bool>            sizes_changed    ;
+      nyx::Image<Impl>             no_atlas         ;
+      Clock::time_point            epoch            ;
+      float                        time             ;
       
       /** Default constructor.
        */
       NyxDrawSpriteData() ;
       
-      /** Helper method to synchronize the VP matrix from the host to the device.
+      /** Helper method to synchronize the VP matrix & the animation clock from the host to the device.
        */
       void syncVPMatrix() ;
       
+      /** Method to retrieve the module's clock, which animations are played back against.
+       * @return The seconds since this module was made.
+       */
+      float now() const ;
+      
       /** Method to help update textures when the database is updated.
        */
       void updateTextures() ;
@@ -142,23 +194,107 @@ namespace nyx
        */
       void redrawSprites() ;
       
+      /** Method to queue a change to a sprite. Safe to call from any thread, and never blocks unless the queue is full.
+       * @param update The change to queue.
+       */
+      void queueUpdate( const SpriteUpdate& update ) ;
+      
+      /** Method to apply every queued change to the host copies, if no other thread is already doing so.
+       * @return Whether the queue was drained by this call.
+       */
+      bool applyUpdates() ;
+      
+      /** Method to apply a single queued change to the host copies, widening the dirty ranges it touched.
+       * @param update The change to apply.
+       */
+      void applyUpdate( const SpriteUpdate& update ) ;
+      
+      /** Method to apply this frame's queued changes, then upload only the dirty ranges of the transforms & sprite records.
+       */
+      void flushUpdates() ;
+      
+      /** Method to bind the sprite records & transforms to the pipeline.
+       */
+      void bindBuffers() ;
+      
+      /** Method to bind the atlas image to the pipeline, or a blank one until an atlas is set.
+       */
+      void bindAtlas() ;
+      
+      /** Method to make sure the sprite records & their frames can hold an id.
+       * @param index The id that has to fit.
+       */
+      void growSprites( unsigned index ) ;
+      
+      /** Method to recompute a sprite's uv from it's frame & mark it for upload.
+       * @param index The sprite to update.
+       */
+      void updateUV( unsigned index ) ;
+      
+      /** Method to take a sprite's frame size from the parsed sprite sheets, if it's image is one of them.
+       * @param index The sprite to update.
+       */
+      void applySheet( unsigned index ) ;
+      
+      /** Method to recompute the uv of every sprite, after the sprite sheets or the atlas changed.
+       */
+      void refreshFrames() ;
+      
+      /** Method to point a sprite's record at it's image in the atlas. Sprites whose image isn't packed yet keep their texture.
+       * @param index The sprite to update.
+       * @param atlas_id The id of the image in the atlas.
+       */
+      void placeInAtlas( unsigned index, unsigned atlas_id ) ;
+      
       /** Method to retrieve the const chain from this object.
        * @return The const reference to this object's chain object.
        */
       const nyx::Chain<Impl>& chain() ;
       
-      /** Method to set the model at the specified index.
-       * @param index The index of model to set.
-       * @param texture The id associated with the texture in the database.
+      /** Method to set the sheet index a sprite shows. Stops any animation the sprite was playing.
+       * @param index The index of the sprite to set.
+       * @param sprite The index of the cell in the sprite's sheet.
        */
       void setSprite( unsigned index, unsigned sprite ) ;
       
+      /** Method to start a sprite playing an animation, from it's first frame. Every frame after is picked by the shader.
+       * @param index The index of the sprite to animate.
+       * @param animation The animation to play.
+       */
+      void setSpriteAnimation( unsigned index, const nyx::SpriteAnimation& animation ) ;
+      
+      /** Method to set the name to associate with the sprite animation input.
+       * @param name The name to associate with the sprite animation input.
+       */
+      void setSpriteAnimationInputName( const char* name ) ;
+      
       /** Method to set the model at the specified index.
        * @param index The index of model to set.
        * @param texture The id associated with the texture in the database.
        */
       void setSpriteTexture( unsigned index, unsigned texture ) ;
       
+      /** Method to draw a sprite from an image in the atlas instead of from a texture.
+       * @param index The index of the sprite to set.
+       * @param atlas_id The id of the image in the atlas.
+       */
+      void setSpriteAtlas( unsigned index, unsigned atlas_id ) ;
+      
+      /** Method to set the reference to the atlas sprites can be drawn from.
+       * @param atlas The atlas, whose pages are bound as one image.
+       */
+      void setAtlasRef( const Atlas& atlas ) ;
+      
+      /** Method to set the name of the atlas reference input.
+       * @param name The name to associate with the atlas input.
+       */
+      void setAtlasRefName( const char* name ) ;
+      
+      /** Method to set the name to associate with the sprite atlas input.
+       * @param name The name to associate with the sprite atlas input.
+       */
+      void setSpriteAtlasInputName( const char* name ) ;
+      
       /** Method to set the model at the specified index.
        * @param index The index of model to set.
        * @param model_id The id associated with the model in the database.
@@ -275,20 +411,24 @@ namespace nyx
 
     void NyxDrawSpriteData::updateTextures()
     {
-      this->lock.lock() ;
+      // The host sprites belong to whoever applies updates, so wait for the next frame's upload instead of copying here.
+      while( this->applying.test_and_set( std::memory_order_acquire ) ) std::this_thread::yield() ;
       
-      for( auto& sprite : this->h_sprites )
+      for( unsigned index = 0; index < this->h_sprites.size(); index++ )
       {
-        sprite.image_width  = mars::TextureArray<Impl>::images()[ sprite.tex_index ]->width () ;
-        sprite.image_height = mars::TextureArray<Impl>::images()[ sprite.tex_index ]->height() ;
+        // Atlas images keep their own size, it's the rectangle they were packed into.
+        if( this->h_sprites[ index ].atlas_page != NO_ATLAS ) continue ;
+        
+        this->h_frames[ index ].image_width  = mars::TextureArray<Impl>::images()[ this->h_sprites[ index ].tex_index ]->width () ;
+        this->h_frames[ index ].image_height = mars::TextureArray<Impl>::images()[ this->h_sprites[ index ].tex_index ]->height() ;
+        this->updateUV( index ) ;
       }
       
+      this->applying.clear( std::memory_order_release ) ;
+      
+      this->lock.lock() ;
       Impl::deviceSynchronize( this->device ) ;
-      auto images = mars::TextureArray<Impl>::images() ;
-      images = images ;
       this->pipeline.bind( "textures", mars::TextureArray<Impl>::images(), mars::TextureArray<Impl>::count() ) ;
-      this->copy_chain.copy( this->h_sprites.data(), this->d_sprites ) ;
-      this->copy_chain.submit() ;
       this->dirty_flag = true ;
       Impl::deviceSynchronize( this->device ) ;
       this->lock.unlock() ;
@@ -299,7 +439,9 @@ namespace nyx
       if( this->copy_chain.initialized() ) 
       {
         this->lock.lock() ;
+        this->time = this->now() ;
         this->copy_chain.copy( &this->projection, this->d_viewproj )  ;
+        this->copy_chain.copy( &this->time      , this->d_time     )  ;
         this->copy_chain.submit() ;
         this->copy_chain.synchronize() ;
         this->vp_dirty_flag = false ;
@@ -307,14 +449,16 @@ namespace nyx
       }
     }
     
+    float NyxDrawSpriteData::now() const
+    {
+      return std::chrono::duration<float>( Clock::now() - this->epoch ).count() ;
+    }
+    
     void NyxDrawSpriteData::redrawSprites()
     {
-        if( this->dirty_flag && this->draw_chain.initialized() && this->drawables.size() != 0 )
+        if( this->dirty_flag && this->draw_chain.initialized() && this->drawn != 0 )
       {
-        this->h_iterator.positions = this->d_transforms.iterator() ;
-        
-        this->draw_chain.push( this->pipeline, this->h_iterator ) ;
-        this->draw_chain.drawInstanced( this->drawables.size(), this->pipeline, this->d_vertices ) ;
+        this->draw_chain.drawInstanced( this->drawn, this->pipeline, this->d_vertices ) ;
         
         this->draw_chain.end() ;
         this->dirty_flag = false ;
@@ -326,68 +470,316 @@ namespace nyx
       }
     }
     
-    void NyxDrawSpriteData::wait()
+    void NyxDrawSpriteData::queueUpdate( const SpriteUpdate& update )
     {
+      // A full queue is drained right here by the first producer to get to it, the rest wait for that.
+      while( !this->updates.push( update ) )
+      {
+        if( !this->applyUpdates() ) std::this_thread::yield() ;
+      }
     }
     
-    void NyxDrawSpriteData::signal()
+    bool NyxDrawSpriteData::applyUpdates()
     {
+      if( this->applying.test_and_set( std::memory_order_acquire ) ) return false ;
+      
+      this->updates.drain( [=] ( const SpriteUpdate& update ) { this->applyUpdate( update ) ; } ) ;
+      this->applying.clear( std::memory_order_release ) ;
+      
+      return true ;
     }
     
-    void NyxDrawSpriteData::setSprite( unsigned index, unsigned sprite_index )
+    void NyxDrawSpriteData::applyUpdate( const SpriteUpdate& update )
     {
-      if( index < this->d_sprites.size() ) 
+      const unsigned index = update.id ;
+      
+      switch( update.kind )
       {
-        this->lock.lock() ;
-        this->h_sprites[ index ].sprite_index = sprite_index ;
-        this->copy_chain.copy( this->h_sprites.data(), this->d_sprites ) ;
-        this->copy_chain.submit() ;
-        this->lock.unlock() ;
+        case SpriteUpdate::Index :
+          this->growSprites( index ) ;
+          
+          this->h_frames [ index ].sprite_index = update.value ;
+          this->h_sprites[ index ].frame_count  = 0            ;
+          this->updateUV( index ) ;
+          
+          this->drawables[ index ] = update.value ;
+          this->dirty_flag = true ;
+          break ;
+          
+        case SpriteUpdate::Texture :
+          this->growSprites( index ) ;
+          
+          this->h_sprites[ index ].tex_index  = update.value                        ;
+          this->h_sprites[ index ].atlas_page = NO_ATLAS                            ;
+          this->h_frames [ index ].image_id   = update.value                        ;
+          this->h_frames [ index ].region     = glm::vec4( 0.0f, 0.0f, 1.0f, 1.0f ) ;
+          
+          if( update.value < mars::TextureArray<Impl>::count() && mars::TextureArray<Impl>::images()[ update.value ] )
+          {
+            this->h_frames[ index ].image_width  = mars::TextureArray<Impl>::images()[ update.value ]->width () ;
+            this->h_frames[ index ].image_height = mars::TextureArray<Impl>::images()[ update.value ]->height() ;
+          }
+          
+          this->atlased.erase( index ) ;
+          this->applySheet( index ) ;
+          this->updateUV  ( index ) ;
+          break ;
+          
+        case SpriteUpdate::Atlas :
+          this->growSprites( index ) ;
+          
+          this->h_frames[ index ].image_id = update.value ;
+          this->atlased[ index ] = update.value ;
+          this->applySheet  ( index               ) ;
+          this->placeInAtlas( index, update.value ) ;
+          break ;
+          
+        case SpriteUpdate::Transform :
+          if( nyx::growList( this->h_transforms, index, glm::mat4( 1.0f ), SPRITE_CAPACITY ) ) this->transforms_grown = true ;
+          
+          this->h_transforms[ index ] = update.transform ;
+          nyx::widenRange( this->transform_begin, this->transform_end, index ) ;
+          break ;
+          
+        case SpriteUpdate::Animation :
+          this->growSprites( index ) ;
+          
+          this->h_sprites[ index ].first_frame  = update.animation.first_frame                   ;
+          this->h_sprites[ index ].frame_count  = update.animation.frame_count                   ;
+          this->h_sprites[ index ].fps          = update.animation.fps                           ;
+          this->h_sprites[ index ].loop         = static_cast<unsigned>( update.animation.loop ) ;
+          this->h_sprites[ index ].start_time   = this->now()                                    ;
+          this->h_frames [ index ].sprite_index = update.animation.first_frame                   ;
+          this->updateUV( index ) ;
+          break ;
+          
+        case SpriteUpdate::Remove :
+          this->drawables.erase( index ) ;
+          this->dirty_flag = true ;
+          break ;
       }
-
-      this->drawables[ index ] = sprite_index ; 
-      this->dirty_flag = true ;
     }
     
-    void NyxDrawSpriteData::setSpriteTexture( unsigned index, unsigned texture )
+    void NyxDrawSpriteData::flushUpdates()
     {
-      if( index < this->d_sprites.size() ) 
+      bool submit = false ;
+      
+      while( this->applying.test_and_set( std::memory_order_acquire ) ) std::this_thread::yield() ;
+      
+      this->updates.drain( [=] ( const SpriteUpdate& update ) { this->applyUpdate( update ) ; } ) ;
+      
+      // Images packed since the last frame may be ones sprites were already waiting on.
+      if( this->atlas_changed.exchange( false, std::memory_order_acquire ) )
       {
-        lock.lock() ;
-        this->h_sprites[ index ].tex_index = texture ;
-        this->copy_chain.copy( this->h_sprites.data(), this->d_sprites ) ;
-        this->copy_chain.submit() ;
-        lock.unlock() ;
+        for( const auto& entry : this->atlased ) this->placeInAtlas( entry.first, entry.second ) ;
       }
-    }
-    
-    void NyxDrawSpriteData::setSpriteTransform( unsigned index, const glm::mat4& position )
-    {
-      if( this->d_transforms.size() < index )
+      
+      if( this->sizes_changed.exchange( false, std::memory_order_acquire ) ) this->refreshFrames() ;
+      
+      this->lock.lock() ;
+      
+      // A grown buffer is a new buffer, so it is filled completely, rebound & the draws re-recorded.
+      if( this->transforms_grown || this->sprites_grown )
       {
-        this->d_transforms.reset() ;
-        this->d_transforms.initialize( this->device, index + 1024 ) ;
+        Impl::deviceSynchronize( this->device ) ;
+        
+        if( this->transforms_grown )
+        {
+          this->d_transforms.reset() ;
+          this->d_transforms.initialize( this->device, this->h_transforms.size(), false, nyx::ArrayFlags::StorageBuffer ) ;
+          this->transform_begin = 0                          ;
+          this->transform_end   = this->h_transforms.size() ;
+        }
+        
+        if( this->sprites_grown )
+        {
+          this->d_sprites.reset() ;
+          this->d_sprites.initialize( this->device, this->h_sprites.size(), false, nyx::ArrayFlags::StorageBuffer ) ;
+          this->sprite_begin = 0                       ;
+          this->sprite_end   = this->h_sprites.size() ;
+        }
+        
+        if( this->pipeline.initialized() ) this->bindBuffers() ;
+        Impl::deviceSynchronize( this->device ) ;
+        
+        this->transforms_grown = false ;
+        this->sprites_grown    = false ;
+        this->dirty_flag       = true  ;
       }
       
-      this->h_transforms[ index ] = position ;
-      this->lock.lock() ;
-      this->copy_chain.synchronize() ;
-      this->copy_chain.copy( this->h_transforms.data(), this->d_transforms ) ;
-      this->copy_chain.submit() ;
-      this->copy_chain.synchronize() ;
+      if( this->transform_begin < this->transform_end )
+      {
+        this->copy_chain.copy( this->h_transforms.data(), this->d_transforms, this->transform_end - this->transform_begin, this->transform_begin, this->transform_begin ) ;
+        submit = true ;
+      }
+      
+      if( this->sprite_begin < this->sprite_end )
+      {
+        this->copy_chain.copy( this->h_sprites.data(), this->d_sprites, this->sprite_end - this->sprite_begin, this->sprite_begin, this->sprite_begin ) ;
+        submit = true ;
+      }
+      
+      if( submit )
+      {
+        this->copy_chain.submit     () ;
+        this->copy_chain.synchronize() ;
+      }
+      
+      this->transform_begin = UINT_MAX ;
+      this->transform_end   = 0        ;
+      this->sprite_begin    = UINT_MAX ;
+      this->sprite_end      = 0        ;
+      
+      // Producers may drain a full queue between frames, so recording only reads the count taken here.
+      this->drawn = this->drawables.size() ;
+      
       this->lock.unlock() ;
+      this->applying.clear( std::memory_order_release ) ;
     }
     
-    void NyxDrawSpriteData::removeSprite( unsigned index )
+    void NyxDrawSpriteData::bindBuffers()
+    {
+      this->pipeline.bind( "sprite"   , this->d_sprites    ) ;
+      this->pipeline.bind( "transform", this->d_transforms ) ;
+    }
+    
+    void NyxDrawSpriteData::bindAtlas()
+    {
+      const Atlas* current = this->atlas.load( std::memory_order_acquire ) ;
+      
+      this->pipeline.bind( "atlas", current != nullptr ? current->image() : this->no_atlas ) ;
+    }
+    
+    void NyxDrawSpriteData::placeInAtlas( unsigned index, unsigned atlas_id )
+    {
+      const Atlas* current = this->atlas.load( std::memory_order_acquire ) ;
+      AtlasRect    rect                                                    ;
+      
+      if( current == nullptr || !current->find( atlas_id, rect ) ) return ;
+      
+      this->h_sprites[ index ].atlas_page   = rect.page   ;
+      this->h_frames [ index ].region       = rect.region ;
+      this->h_frames [ index ].image_width  = rect.width  ;
+      this->h_frames [ index ].image_height = rect.height ;
+      
+      this->updateUV( index ) ;
+    }
+    
+    void NyxDrawSpriteData::growSprites( unsigned index )
+    {
+      if( nyx::growList( this->h_sprites, index, Sprite(), SPRITE_CAPACITY ) ) this->sprites_grown = true ;
+      
+      nyx::growList( this->h_frames, index, SpriteFrame(), SPRITE_CAPACITY ) ;
+    }
+    
+    void NyxDrawSpriteData::updateUV( unsigned index )
+    {
+      const SpriteFrame& frame = this->h_frames[ index ]                                           ;
+      const unsigned     cell  = this->h_sprites[ index ].frame_count > 1 ? 0 : frame.sprite_index ;
+      
+      // Animated sprites get the sheet's first cell, which the shader offsets by whole cells to reach the current frame.
+      this->h_sprites[ index ].uv      = nyx::frameUV     ( frame, cell ) ;
+      this->h_sprites[ index ].columns = nyx::sheetColumns( frame       ) ;
+      
+      nyx::widenRange( this->sprite_begin, this->sprite_end, index ) ;
+    }
+    
+    void NyxDrawSpriteData::applySheet( unsigned index )
     {
-      auto iter = this->drawables.find( index ) ;
+      std::lock_guard<std::mutex> guard( this->sheet_lock ) ;
+      
+      auto iter = this->sprite_map.find( this->h_frames[ index ].image_id ) ;
       
-      if( iter != this->drawables.end() )
+      if( iter != this->sprite_map.end() )
+      {
+        this->h_frames[ index ].sprite_width  = iter->second.sprite_width  ;
+        this->h_frames[ index ].sprite_height = iter->second.sprite_height ;
+      }
+    }
+    
+    void NyxDrawSpriteData::refreshFrames()
+    {
+      for( const auto& drawable : this->drawables )
+      {
+        this->applySheet( drawable.first ) ;
+        this->updateUV  ( drawable.first ) ;
+      }
+    }
+    
+    void NyxDrawSpriteData::wait()
+    {
+    }
+    
+    void NyxDrawSpriteData::signal()
+    {
+    }
+    
+    void NyxDrawSpriteData::setSprite( unsigned index, unsigned sprite_index )
+    {
+      this->queueUpdate( { SpriteUpdate::Index, index, sprite_index, glm::mat4( 1.0f ), {} } ) ;
+    }
+    
+    void NyxDrawSpriteData::setSpriteAnimation( unsigned index, const nyx::SpriteAnimation& animation )
+    {
+      this->queueUpdate( { SpriteUpdate::Animation, index, 0, glm::mat4( 1.0f ), animation } ) ;
+    }
+    
+    void NyxDrawSpriteData::setSpriteTexture( unsigned index, unsigned texture )
+    {
+      this->queueUpdate( { SpriteUpdate::Texture, index, texture, glm::mat4( 1.0f ), {} } ) ;
+    }
+    
+    void NyxDrawSpriteData::setSpriteTransform( unsigned index, const glm::mat4& position )
+    {
+      this->queueUpdate( { SpriteUpdate::Transform, index, 0, position, {} } ) ;
+    }
+    
+    void NyxDrawSpriteData::setSpriteAtlas( unsigned index, unsigned atlas_id )
+    {
+      this->queueUpdate( { SpriteUpdate::Atlas, index, atlas_id, glm::mat4( 1.0f ), {} } ) ;
+    }
+    
+    void NyxDrawSpriteData::setAtlasRef( const Atlas& atlas )
+    {
+      // The atlas signals every time it uploads, but only a different atlas needs binding.
+      if( this->atlas.exchange( &atlas, std::memory_order_acq_rel ) != &atlas )
       {
-        this->drawables.erase( iter ) ;
+        Log::output( "Module ", this->name.c_str(), " set input atlas reference as ", reinterpret_cast<const void*>( &atlas ) ) ;
+        
+        this->lock.lock() ;
+        if( this->pipeline.initialized() )
+        {
+          Impl::deviceSynchronize( this->device ) ;
+          this->bindAtlas() ;
+          Impl::deviceSynchronize( this->device ) ;
+        }
+        this->lock.unlock() ;
       }
       
-      this->dirty_flag = true ;
+      this->atlas_changed.store( true, std::memory_order_release ) ;
+    }
+    
+    void NyxDrawSpriteData::setAtlasRefName( const char* name )
+    {
+      Log::output( "Module ", this->name.c_str(), " set input atlas reference name as \"", name, "\"" ) ;
+      this->bus.enroll( this, &NyxDrawSpriteData::setAtlasRef, iris::OPTIONAL, name ) ;
+    }
+    
+    void NyxDrawSpriteData::setSpriteAtlasInputName( const char* name )
+    {
+      Log::output( "Module ", this->name.c_str(), " set input set sprite atlas signal as \"", name, "\"" ) ;
+      this->bus.enroll( this, &NyxDrawSpriteData::setSpriteAtlas, iris::OPTIONAL, name ) ;
+    }
+    
+    void NyxDrawSpriteData::setSpriteAnimationInputName( const char* name )
+    {
+      Log::output( "Module ", this->name.c_str(), " set input set sprite animation signal as \"", name, "\"" ) ;
+      this->bus.enroll( this, &NyxDrawSpriteData::setSpriteAnimation, iris::OPTIONAL, name ) ;
+    }
+    
+    void NyxDrawSpriteData::removeSprite( unsigned index )
+    {
+      this->queueUpdate( { SpriteUpdate::Remove, index, 0, glm::mat4( 1.0f ), {} } ) ;
     }
     
     void NyxDrawSpriteData::parseSprites( const iris::config::json::Token& token )
@@ -400,6 +792,8 @@ namespace nyx
       width  = UINT32_MAX ;
       height = UINT32_MAX ;
       
+      this->sizes_changed.store( true, std::memory_order_release ) ;
+      
       for( unsigned index = 0; index < token.size(); index++ )
       {
         auto sprite_token = token.token( index )            ;
@@ -414,6 +808,8 @@ namespace nyx
         if( id != UINT32_MAX && width != UINT32_MAX && height != UINT32_MAX ) 
         {
           Log::output( "Module ", this->name.c_str(), " added sprite with the following parameters { ID: ", id, " Sprite Width: ", width, " Sprite Height: ", height, " }" ) ;
+          
+          std::lock_guard<std::mutex> guard( this->sheet_lock ) ;
           this->sprite_map[ id ].sprite_width  = width  ;
           this->sprite_map[ id ].sprite_height = height ;
         }
@@ -527,6 +923,20 @@ namespace nyx
       this->parent        = nullptr ;
       this->camera        = nullptr ;
       this->rebuild_chain = true    ;
+      
+      this->transform_begin  = UINT_MAX     ;
+      this->transform_end    = 0            ;
+      this->sprite_begin     = UINT_MAX     ;
+      this->sprite_end       = 0            ;
+      this->transforms_grown = false        ;
+      this->sprites_grown    = false        ;
+      this->drawn            = 0            ;
+      this->epoch            = Clock::now() ;
+      this->time             = 0.0f         ;
+      this->applying.clear() ;
+      this->atlas        .store( nullptr ) ;
+      this->atlas_changed.store( false   ) ;
+      this->sizes_changed.store( false   ) ;
     }
     
     // </editor-fold>
@@ -547,15 +957,20 @@ namespace nyx
       data().copy_chain   .initialize( data().device, nyx::ChainType::Compute                     ) ;
       data().d_vertices   .initialize( data().device, 6   , false, nyx::ArrayFlags::Vertex        ) ;
       data().d_viewproj   .initialize( data().device, 1   , false, nyx::ArrayFlags::UniformBuffer ) ;
-      data().d_sprites    .initialize( data().device, 1024, false, nyx::ArrayFlags::UniformBuffer ) ;
-      data().d_transforms .initialize( data().device, 1024 ) ;
-      data().h_transforms .resize( 1024 )                    ;
-      data().h_sprites    .resize( 1024 )                    ;
+      data().d_time       .initialize( data().device, 1   , false, nyx::ArrayFlags::UniformBuffer ) ;
+      data().no_atlas     .initialize( nyx::ImageFormat::RGBA8, data().device, 1, 1, 1             ) ;
+      
+      // A full queue drained before initialization may already have grown the host copies.
+      nyx::growList( data().h_transforms, SPRITE_CAPACITY - 1, glm::mat4( 1.0f ), SPRITE_CAPACITY ) ;
+      nyx::growList( data().h_sprites   , SPRITE_CAPACITY - 1, Sprite()         , SPRITE_CAPACITY ) ;
+      nyx::growList( data().h_frames    , SPRITE_CAPACITY - 1, SpriteFrame()    , SPRITE_CAPACITY ) ;
       
-      std::fill( data().h_transforms.begin(), data().h_transforms.end(), glm::mat4( 1.0f ) ) ;
+      data().d_sprites    .initialize( data().device, data().h_sprites   .size(), false, nyx::ArrayFlags::StorageBuffer ) ;
+      data().d_transforms .initialize( data().device, data().h_transforms.size(), false, nyx::ArrayFlags::StorageBuffer ) ;
       
       data().lock.lock() ;
       data().copy_chain.copy( data().h_transforms.data(), data().d_transforms ) ;
+      data().copy_chain.copy( data().h_sprites   .data(), data().d_sprites    ) ;
       data().copy_chain.submit() ;
       data().copy_chain.synchronize() ;
       
@@ -574,7 +989,9 @@ namespace nyx
         data().lock.lock() ;
         Impl::deviceSynchronize( data().device ) ;
         data().pipeline.bind( "projection", data().d_viewproj ) ;
-        data().pipeline.bind( "sprite"    , data().d_sprites  ) ;
+        data().pipeline.bind( "clock"     , data().d_time     ) ;
+        data().bindBuffers() ;
+        data().bindAtlas  () ;
         data().pipeline.bind( "textures", mars::TextureArray<Impl>::images(), mars::TextureArray<Impl>::count() ) ;
         Impl::deviceSynchronize( data().device ) ;
         data().lock.unlock() ;
@@ -589,21 +1006,25 @@ namespace nyx
       data().bus.setChannel( id ) ;
       data().name = this->name() ;
       
-      data().bus.enroll( this->module_data, &NyxDrawSpriteData::setInputNames       , iris::OPTIONAL, this->name(), "::input"                ) ;
-      data().bus.enroll( this->module_data, &NyxDrawSpriteData::setOutputName       , iris::OPTIONAL, this->name(), "::output"               ) ;
-      data().bus.enroll( this->module_data, &NyxDrawSpriteData::setParentRefName    , iris::OPTIONAL, this->name(), "::parent"               ) ;
-      data().bus.enroll( this->module_data, &NyxDrawSpriteData::setSpriteInputName  , iris::OPTIONAL, this->name(), "::sprite_input"         ) ;
-      data().bus.enroll( this->module_data, &NyxDrawSpriteData::parseSprites        , iris::OPTIONAL, this->name(), "::sprites"              ) ;
-      data().bus.enroll( this->module_data, &NyxDrawSpriteData::setSubpassName      , iris::OPTIONAL, this->name(), "::subpass"              ) ;
-      data().bus.enroll( this->module_data, &NyxDrawSpriteData::setSpriteTexture    , iris::OPTIONAL, this->name(), "::sprite_texture_input" ) ;
-      data().bus.enroll( this->module_data, &NyxDrawSpriteData::setTextureClearName , iris::OPTIONAL, this->name(), "::sprite_remove"        ) ;
-      data().bus.enroll( this->module_data, &NyxDrawSpriteData::setOutRefName       , iris::OPTIONAL, this->name(), "::reference"            ) ;
-      data().bus.enroll( this->module_data, &NyxDrawSpriteData::setDevice           , iris::OPTIONAL, this->name(), "::device"               ) ;
+      data().bus.enroll( this->module_data, &NyxDrawSpriteData::setInputNames              , iris::OPTIONAL, this->name(), "::input"                  ) ;
+      data().bus.enroll( this->module_data, &NyxDrawSpriteData::setOutputName              , iris::OPTIONAL, this->name(), "::output"                 ) ;
+      data().bus.enroll( this->module_data, &NyxDrawSpriteData::setParentRefName           , iris::OPTIONAL, this->name(), "::parent"                 ) ;
+      data().bus.enroll( this->module_data, &NyxDrawSpriteData::setSpriteInputName         , iris::OPTIONAL, this->name(), "::sprite_input"           ) ;
+      data().bus.enroll( this->module_data, &NyxDrawSpriteData::parseSprites               , iris::OPTIONAL, this->name(), "::sprites"                ) ;
+      data().bus.enroll( this->module_data, &NyxDrawSpriteData::setSubpassName             , iris::OPTIONAL, this->name(), "::subpass"                ) ;
+      data().bus.enroll( this->module_data, &NyxDrawSpriteData::setSpriteTexture           , iris::OPTIONAL, this->name(), "::sprite_texture_input"   ) ;
+      data().bus.enroll( this->module_data, &NyxDrawSpriteData::setSpriteAtlasInputName    , iris::OPTIONAL, this->name(), "::sprite_atlas_input"     ) ;
+      data().bus.enroll( this->module_data, &NyxDrawSpriteData::setSpriteAnimationInputName, iris::OPTIONAL, this->name(), "::sprite_animation_input" ) ;
+      data().bus.enroll( this->module_data, &NyxDrawSpriteData::setAtlasRefName            , iris::OPTIONAL, this->name(), "::atlas"                  ) ;
+      data().bus.enroll( this->module_data, &NyxDrawSpriteData::setTextureClearName        , iris::OPTIONAL, this->name(), "::sprite_remove"          ) ;
+      data().bus.enroll( this->module_data, &NyxDrawSpriteData::setOutRefName              , iris::OPTIONAL, this->name(), "::reference"              ) ;
+      data().bus.enroll( this->module_data, &NyxDrawSpriteData::setDevice                  , iris::OPTIONAL, this->name(), "::device"                 ) ;
     }
 
     void NyxDrawSprite::shutdown()
     {
       Impl::deviceSynchronize( data().device ) ;
+      data().no_atlas.reset() ;
     }
 
     void NyxDrawSprite::execute()
@@ -611,6 +1032,7 @@ namespace nyx
       data().wait_and_publish.wait() ;
       
       data().syncVPMatrix() ;
+      data().flushUpdates() ;
       
       if( data().parent != nullptr && data().rebuild_chain )
       {
@@ -627,7 +1049,9 @@ namespace nyx
         data().lock.lock() ;
         Impl::deviceSynchronize( data().device ) ;
         data().pipeline.bind( "projection", data().d_viewproj ) ;
-        data().pipeline.bind( "sprite"    , data().d_sprites  ) ;
+        data().pipeline.bind( "clock"     , data().d_time     ) ;
+        data().bindBuffers() ;
+        data().bindAtlas  () ;
         data().pipeline.bind( "textures", mars::TextureArray<Impl>::images(), mars::TextureArray<Impl>::count() ) ;
         Impl::deviceSynchronize( data().device ) ;
         data().lock.unlock() ;
@@ -16,9 +16,136 @@
  */
 
 #include <Iris/module/Module.h>
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <vector>
 
 namespace nyx
 {
+  /** How an animation carries on after it's last frame. Matches the loop modes in draw_sprite.vert.glsl.
+   */
+  enum class SpriteLoop : unsigned
+  {
+    Once     = 0, ///< Stops on the last frame.
+    Repeat   = 1, ///< Starts over at the first frame.
+    PingPong = 2, ///< Plays backwards to the first frame, then forwards again.
+  };
+  
+  /** Structure describing a sprite sheet animation. Once set, it is played back by the vertex shader without any work on the host.
+   */
+  struct SpriteAnimation
+  {
+    unsigned   first_frame = 0                  ; ///< The sheet index of the animation's first frame.
+    unsigned   frame_count = 1                  ; ///< The amount of frames, following each other in the sheet. One or less stops animating.
+    float      fps         = 12.0f              ; ///< The frames shown per second.
+    SpriteLoop loop        = SpriteLoop::Repeat ; ///< What to do after the last frame.
+  };
+  
+  /** Function to compute which sheet index an animation shows. Mirrors the frame selection in draw_sprite.vert.glsl.
+   * @param animation The animation being played.
+   * @param elapsed The seconds since the animation was started.
+   * @return The sheet index of the frame to show.
+   */
+  inline unsigned animationFrame( const SpriteAnimation& animation, float elapsed )
+  {
+    const unsigned count = animation.frame_count > 1 ? animation.frame_count : 1                                      ;
+    unsigned       frame = static_cast<unsigned>( elapsed * animation.fps > 0.0f ? elapsed * animation.fps : 0.0f ) ;
+    
+    switch( animation.loop )
+    {
+      case SpriteLoop::Once     : frame = frame < count ? frame : count - 1 ; break ;
+      case SpriteLoop::Repeat   : frame = frame % count ;                     break ;
+      case SpriteLoop::PingPong :
+        if( count > 1 )
+        {
+          frame = frame % ( 2 * count - 2 ) ;
+          if( frame >= count ) frame = 2 * count - 2 - frame ;
+        }
+        else
+        {
+          frame = 0 ;
+        }
+        break ;
+    }
+    
+    return animation.first_frame + frame ;
+  }
+  
+  /** Structure describing what a sprite's frame is cut out of. Only kept on the host, the shader just gets the resulting uv.
+   */
+  struct SpriteFrame
+  {
+    unsigned  sprite_index  = 0                                   ;
+    unsigned  image_id      = 0                                   ;
+    unsigned  sprite_width  = 64                                  ;
+    unsigned  sprite_height = 64                                  ;
+    unsigned  image_width   = 1240                                ;
+    unsigned  image_height  = 1080                                ;
+    glm::vec4 region        = glm::vec4( 0.0f, 0.0f, 1.0f, 1.0f ) ; ///< Where the image sits in what is sampled, the whole texture or it's atlas rectangle.
+  };
+  
+  /** Function to compute how many cells of a frame's sheet fit in a row of it's image.
+   * @param frame The frame of the sprite.
+   * @return The amount of columns of the sheet.
+   */
+  inline unsigned sheetColumns( const SpriteFrame& frame )
+  {
+    const unsigned image_width = std::max( 1u, frame.image_width ) ;
+    
+    return image_width / std::max( 1u, std::min( frame.sprite_width, image_width ) ) ;
+  }
+  
+  /** Function to compute the uv of a cell of a frame's sheet, in whatever the frame's image is sampled from.
+   * The vertex shader only adds the corner of the quad, scaled by the size.
+   * @param frame The frame of the sprite.
+   * @param cell The sheet index of the cell.
+   * @return The uv of the cell. xy is the offset, zw the size.
+   */
+  inline glm::vec4 frameUV( const SpriteFrame& frame, unsigned cell )
+  {
+    const unsigned  image_width  = std::max( 1u, frame.image_width  )                                       ;
+    const unsigned  image_height = std::max( 1u, frame.image_height )                                       ;
+    const unsigned  width        = std::max( 1u, std::min( frame.sprite_width , image_width  ) )            ;
+    const unsigned  height       = std::max( 1u, std::min( frame.sprite_height, image_height ) )            ;
+    const unsigned  columns      = image_width / width                                                      ;
+    const unsigned  row          = cell / columns                                                           ;
+    const unsigned  column       = cell - row * columns                                                     ;
+    const glm::vec2 scale        = glm::vec2( frame.region.z / image_width, frame.region.w / image_height ) ;
+    
+    // The cell's rectangle in pixels of the image, then mapped into wherever the image is sampled from.
+    return glm::vec4( frame.region.x + column * width * scale.x, frame.region.y + row * height * scale.y, width * scale.x, height * scale.y ) ;
+  }
+  
+  /** Function to make sure a host copy can hold an id, doubling it until it does.
+   * @param list The host copy to grow.
+   * @param index The id that has to fit.
+   * @param value The value to fill new elements with.
+   * @param minimum The size an empty host copy grows to first.
+   * @return Whether the host copy grew, meaning it's device buffer has to be reallocated.
+   */
+  template<typename Type>
+  bool growList( std::vector<Type>& list, unsigned index, const Type& value, std::size_t minimum )
+  {
+    std::size_t size = std::max<std::size_t>( list.size(), minimum ) ;
+    
+    if( index < list.size() ) return false ;
+    while( size <= index ) size *= 2 ;
+    
+    list.resize( size, value ) ;
+    return true ;
+  }
+  
+  /** Function to widen the dirty range of a host copy to an id, so only the range is uploaded.
+   * @param begin The first dirty id, UINT_MAX when nothing is dirty.
+   * @param end One past the last dirty id, 0 when nothing is dirty.
+   * @param index The id that changed.
+   */
+  inline void widenRange( unsigned& begin, unsigned& end, unsigned index )
+  {
+    begin = std::min( begin, index     ) ;
+    end   = std::max( end  , index + 1 ) ;
+  }
+  
   namespace vkg
   {
     /** A module for managing converting images on the host to Vulkan images on the GPU.
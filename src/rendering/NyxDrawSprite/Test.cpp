@@ -11,10 +11,307 @@
  * Created on April 17, 2021, 1:30 AM
  */
 
+#include "NyxDrawSprite.h"
+#include <templates/NyxUpdateQueue.h>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <climits>
 #include <cstdlib>
+#include <cmath>
+#include <glm/glm.hpp>
 
-int main()
+/** Has several threads push sprite-sized updates through a deliberately small queue while one thread drains it,
+ *  checking that nothing is lost or duplicated & that every producer's updates arrive in the order they were pushed.
+ */
+static bool testUpdateQueue()
 {
-  return 0;
+  constexpr unsigned PRODUCERS = 4     ;
+  constexpr unsigned UPDATES   = 50000 ;
+  
+  struct Update
+  {
+    unsigned producer        ;
+    unsigned sequence        ;
+    float    transform[ 16 ] ;
+  };
+  
+  nyx::UpdateQueue<Update> queue   ( 1024 )           ;
+  std::vector<unsigned>    next    ( PRODUCERS, 0 )   ;
+  std::vector<std::thread> threads                    ;
+  std::atomic<unsigned>    done    ( 0 )              ;
+  unsigned                 received = 0               ;
+  bool                     ordered  = true            ;
+  
+  auto consume = [&] ( const Update& update )
+  {
+    ordered = ordered && update.sequence == next[ update.producer ] ;
+    next[ update.producer ] = update.sequence + 1 ;
+    received++ ;
+  };
+  
+  auto start = std::chrono::high_resolution_clock::now() ;
+  
+  for( unsigned producer = 0; producer < PRODUCERS; producer++ )
+  {
+    threads.emplace_back( [&, producer] ()
+    {
+      Update update = { producer, 0, {} } ;
+      
+      for( unsigned index = 0; index < UPDATES; index++ )
+      {
+        update.sequence = index ;
+        while( !queue.push( update ) ) std::this_thread::yield() ;
+      }
+      
+      done++ ;
+    } ) ;
+  }
+  
+  while( done.load() != PRODUCERS ) queue.drain( consume ) ;
+  queue.drain( consume ) ;
+  
+  for( auto& thread : threads ) thread.join() ;
+  
+  auto time = std::chrono::duration<double, std::milli>( std::chrono::high_resolution_clock::now() - start ).count() ;
+  
+  std::cout << "Update queue, " << PRODUCERS << " producers & one consumer: " << "\n"
+            << "-- Updates : " << received << " of " << PRODUCERS * UPDATES   << "\n"
+            << "-- Time    : " << time << "ms"                                 << std::endl ;
+  
+  return ordered && received == PRODUCERS * UPDATES ;
 }
 
+/** Measures the host side of a frame at 10k, 100k & 1M sprites: every sprite moves, the queue is drained into the
+ *  growable host copy, and the dirty range is what would be uploaded to the storage buffer.
+ */
+static bool testSpriteThroughput()
+{
+  constexpr unsigned COUNTS[] = { 10000, 100000, 1000000 } ;
+  constexpr unsigned FRAMES   = 4                          ;
+  
+  struct Update
+  {
+    unsigned kind            ;
+    unsigned id              ;
+    unsigned value           ;
+    float    transform[ 16 ] ;
+  };
+  
+  struct Transform
+  {
+    float values[ 16 ] ;
+  };
+  
+  bool valid = true ;
+  
+  for( auto count : COUNTS )
+  {
+    nyx::UpdateQueue<Update> queue      ;
+    std::vector<Transform>   transforms ;
+    unsigned                 grown  = 0 ;
+    unsigned                 begin  = 0 ;
+    unsigned                 end    = 0 ;
+    
+    // The module's transform update, on a plain transform instead of a matrix.
+    auto apply = [&] ( const Update& update )
+    {
+      if( nyx::growList( transforms, update.id, Transform(), 1024 ) ) grown++ ;
+      
+      std::copy( update.transform, update.transform + 16, transforms[ update.id ].values ) ;
+      nyx::widenRange( begin, end, update.id ) ;
+    };
+    
+    auto start = std::chrono::high_resolution_clock::now() ;
+    
+    for( unsigned frame = 0; frame < FRAMES; frame++ )
+    {
+      Update update = { 2, 0, 0, {} } ;
+      
+      begin = UINT_MAX ;
+      end   = 0        ;
+      
+      for( unsigned id = 0; id < count; id++ )
+      {
+        update.id              = id                          ;
+        update.transform[ 12 ] = static_cast<float>( frame ) ;
+        
+        // The module drains a full queue on the producer's thread, do the same here.
+        while( !queue.push( update ) ) queue.drain( apply ) ;
+      }
+      
+      queue.drain( apply ) ;
+      valid = valid && begin == 0 && end == count && transforms[ count - 1 ].values[ 12 ] == static_cast<float>( frame ) ;
+    }
+    
+    auto time = std::chrono::duration<double, std::milli>( std::chrono::high_resolution_clock::now() - start ).count() / FRAMES ;
+    
+    std::cout << "Moving " << count << " sprites: " << "\n"
+              << "-- Host time per frame : " << time << "ms" << "\n"
+              << "-- Uploaded per frame  : " << ( end - begin ) * sizeof( Transform ) / 1024 << "KiB" << "\n"
+              << "-- Buffer growths      : " << grown << std::endl ;
+  }
+  
+  return valid ;
+}
+
+/** Runs the sprite vertex stage on the host for 1M sprites, six vertices each: once cutting the frame out of the sheet
+ *  per vertex like the shader used to, once reading the uv the module computes per sprite. Both have to land on the same coordinates.
+ */
+static bool testFrameCost()
+{
+  constexpr unsigned COUNT = 1000000 ;
+  
+  // Position of each of the six vertices, and the corner it took from the old shader's coordinate array.
+  static const unsigned corners[ 6 ][ 3 ] = { { 0, 1, 0 }, { 1, 0, 1 }, { 0, 0, 2 }, { 0, 1, 0 }, { 1, 1, 3 }, { 1, 0, 1 } } ;
+  
+  std::vector<nyx::SpriteFrame> sheets ( COUNT     ) ;
+  std::vector<glm::vec4>        uvs    ( COUNT     ) ;
+  std::vector<glm::vec2>        cut    ( COUNT * 6 ) ;
+  std::vector<glm::vec2>        read   ( COUNT * 6 ) ;
+  
+  for( unsigned index = 0; index < COUNT; index++ )
+  {
+    sheets[ index ].sprite_index  = index % 64 ;
+    sheets[ index ].sprite_width  = 32         ;
+    sheets[ index ].sprite_height = 48         ;
+    sheets[ index ].image_width   = 512        ;
+    sheets[ index ].image_height  = 384        ;
+  }
+  
+  // What the module does once, whenever a sprite's frame changes.
+  for( unsigned index = 0; index < COUNT; index++ ) uvs[ index ] = nyx::frameUV( sheets[ index ], sheets[ index ].sprite_index ) ;
+  
+  auto start = std::chrono::high_resolution_clock::now() ;
+  
+  for( unsigned index = 0; index < COUNT; index++ )
+  {
+    for( unsigned vertex = 0; vertex < 6; vertex++ )
+    {
+      const auto&    sheet   = sheets[ index ]                                             ;
+      const unsigned columns = sheet.image_width / sheet.sprite_width                      ;
+      const unsigned row     = sheet.sprite_index / columns                                ;
+      const unsigned column  = sheet.sprite_index - row * columns                          ;
+      const float    x       = static_cast<float>( column * sheet.sprite_width  )          ;
+      const float    y       = static_cast<float>( row    * sheet.sprite_height )          ;
+      const float    width   = static_cast<float>( sheet.image_width  )                    ;
+      const float    height  = static_cast<float>( sheet.image_height )                    ;
+      
+      const glm::vec2 coords[ 4 ] =
+      {
+        glm::vec2( x                        / width, ( y + sheet.sprite_height ) / height ),
+        glm::vec2( ( x + sheet.sprite_width ) / width, y                         / height ),
+        glm::vec2( x                        / width, y                         / height ),
+        glm::vec2( ( x + sheet.sprite_width ) / width, ( y + sheet.sprite_height ) / height ),
+      };
+      
+      cut[ index * 6 + vertex ] = coords[ corners[ vertex ][ 2 ] ] ;
+    }
+  }
+  
+  auto per_vertex = std::chrono::duration<double, std::milli>( std::chrono::high_resolution_clock::now() - start ).count() ;
+  start           = std::chrono::high_resolution_clock::now() ;
+  
+  for( unsigned index = 0; index < COUNT; index++ )
+  {
+    for( unsigned vertex = 0; vertex < 6; vertex++ )
+    {
+      const glm::vec4& uv = uvs[ index ] ;
+      
+      read[ index * 6 + vertex ] = glm::vec2( uv.x + corners[ vertex ][ 0 ] * uv.z, uv.y + corners[ vertex ][ 1 ] * uv.w ) ;
+    }
+  }
+  
+  auto precomputed = std::chrono::duration<double, std::milli>( std::chrono::high_resolution_clock::now() - start ).count() ;
+  
+  for( unsigned index = 0; index < COUNT * 6; index++ )
+  {
+    if( std::abs( cut[ index ].x - read[ index ].x ) > 1e-6f || std::abs( cut[ index ].y - read[ index ].y ) > 1e-6f ) return false ;
+  }
+  
+  // A frame packed into an atlas lands inside it's rectangle, scaled by how much of the page the image covers.
+  nyx::SpriteFrame packed ;
+  
+  packed.sprite_index  = 5                                       ;
+  packed.sprite_width  = 32                                      ;
+  packed.sprite_height = 32                                      ;
+  packed.image_width   = 128                                     ;
+  packed.image_height  = 64                                      ;
+  packed.region        = glm::vec4( 0.5f, 0.25f, 0.25f, 0.125f ) ;
+  
+  const glm::vec4 uv = nyx::frameUV( packed, packed.sprite_index ) ;
+  
+  if( nyx::sheetColumns( packed ) != 4 ) return false ;
+  if( std::abs( uv.x - 0.5625f ) > 1e-6f || std::abs( uv.y - 0.3125f ) > 1e-6f || std::abs( uv.z - 0.0625f ) > 1e-6f || std::abs( uv.w - 0.0625f ) > 1e-6f ) return false ;
+  
+  std::cout << "Sprite frame coordinates, " << COUNT << " sprites: " << "\n"
+            << "-- Cut out per vertex : " << per_vertex  << "ms" << "\n"
+            << "-- Precomputed uv     : " << precomputed << "ms" << std::endl ;
+  
+  return true ;
+}
+
+/** Steps each loop mode through two full cycles, checking the frame the shader would pick at every step.
+ */
+static bool testAnimation()
+{
+  nyx::SpriteAnimation animation ;
+  
+  animation.first_frame = 8     ;
+  animation.frame_count = 4     ;
+  animation.fps         = 10.0f ;
+  
+  static const unsigned repeat   [ 8 ] = { 8, 9, 10, 11, 8 , 9 , 10, 11 } ;
+  static const unsigned once     [ 8 ] = { 8, 9, 10, 11, 11, 11, 11, 11 } ;
+  static const unsigned pingpong [ 8 ] = { 8, 9, 10, 11, 10, 9 , 8 , 9  } ;
+  
+  for( unsigned step = 0; step < 8; step++ )
+  {
+    // Sample the middle of each frame, so float rounding can't land on a neighbour.
+    const float elapsed = ( step + 0.5f ) / animation.fps ;
+    
+    animation.loop = nyx::SpriteLoop::Repeat   ; if( nyx::animationFrame( animation, elapsed ) != repeat  [ step ] ) return false ;
+    animation.loop = nyx::SpriteLoop::Once     ; if( nyx::animationFrame( animation, elapsed ) != once    [ step ] ) return false ;
+    animation.loop = nyx::SpriteLoop::PingPong ; if( nyx::animationFrame( animation, elapsed ) != pingpong[ step ] ) return false ;
+  }
+  
+  // Animations set in the future hold their first frame, and a single frame never moves.
+  if( nyx::animationFrame( animation, -1.0f ) != 8 ) return false ;
+  
+  animation.frame_count = 1 ;
+  animation.loop        = nyx::SpriteLoop::PingPong ;
+  
+  return nyx::animationFrame( animation, 100.0f ) == 8 ;
+}
+
+int main()
+{
+  if( !testUpdateQueue() )
+  {
+    std::cout << "Update queue test failed." << std::endl ;
+    return 1 ;
+  }
+  
+  if( !testSpriteThroughput() )
+  {
+    std::cout << "Sprite throughput test failed." << std::endl ;
+    return 1 ;
+  }
+  
+  if( !testFrameCost() )
+  {
+    std::cout << "Sprite frame test failed." << std::endl ;
+    return 1 ;
+  }
+  
+  if( !testAnimation() )
+  {
+    std::cout << "Sprite animation test failed." << std::endl ;
+    return 1 ;
+  }
+  
+  return 0 ;
+}
@@ -55,20 +55,33 @@ namespace nyx
   
   NyxDrawTex2D::NyxDrawTex2D()
   {
-    auto function = [=] ( unsigned id, unsigned tex_id, nyx::Chain<Framework>& chain, nyx::Pipeline<Framework>& pipeline )
+    auto add = [=] ( unsigned id, unsigned& tex_id )
     {
-      this->data_2d.indices[ id ] = tex_id ;
-      this->data_2d.count++ ;
-      data_2d.draw( chain, pipeline ) ;
+      this->data_2d.addQuad( id, tex_id ) ;
+    };
+    
+    // Drawn in id order. Everything goes out in one draw, so there is no state to group by.
+    auto sort = [=] ( unsigned id, unsigned&, nyx::DrawQueue& queue )
+    {
+      queue.push( id, id, 0 ) ;
+    };
+    
+    auto record = [=] ( const nyx::DrawItem* items, unsigned count, nyx::Chain<Framework>& chain, nyx::Pipeline<Framework>& pipeline )
+    {
+      this->data_2d.draw( items, count, chain, pipeline ) ;
     };
     
     this->updated_textures = false                 ;
-    this->data_2d.indices.resize( TRANSFORM_SIZE ) ;
-    NyxDrawModule::setTransformFlag  ( nyx::ArrayFlags::StorageBuffer                           ) ;
-    NyxDrawModule::setTransformKey   ( "transform"                                              ) ;
-    NyxDrawModule::setTransformSize  ( TRANSFORM_SIZE                                           ) ;
-    NyxDrawModule::setPipeline       ( nyx::bytes::draw_tex2d, sizeof( nyx::bytes::draw_tex2d ) ) ;
-    NyxDrawModule::setPerDrawCallback( function                                                 ) ;
+    this->data_2d.indices  .resize( TRANSFORM_SIZE, 0                 ) ;
+    this->data_2d.instances.resize( TRANSFORM_SIZE                    ) ;
+    this->data_2d.regions  .resize( TRANSFORM_SIZE, glm::vec4( 0.0f ) ) ;
+    NyxDrawModule::setTransformFlag     ( nyx::ArrayFlags::StorageBuffer                           ) ;
+    NyxDrawModule::setTransformKey      ( "transform"                                              ) ;
+    NyxDrawModule::setTransformSize     ( TRANSFORM_SIZE                                           ) ;
+    NyxDrawModule::setPipeline          ( nyx::bytes::draw_tex2d, sizeof( nyx::bytes::draw_tex2d ) ) ;
+    NyxDrawModule::setAddCallback       ( add                                                      ) ;
+    NyxDrawModule::setSortCallback      ( sort                                                     ) ;
+    NyxDrawModule::setSortedDrawCallback( record                                                   ) ;
   }
   
   NyxDrawTex2D::~NyxDrawTex2D()
@@ -85,17 +98,43 @@ namespace nyx
     this->updated_textures = true ;
   }
   
+  void NyxDrawTex2D::setAtlas( const nyx::Atlas<Framework>& atlas )
+  {
+    if( this->data_2d.atlas != &atlas )
+    {
+      Log::output( "Module ", this->name(), " binding atlas." ) ;
+      Framework::deviceSynchronize( this->gpu() ) ;
+      this->pipeline().bind( "atlas", atlas.image() ) ;
+      Framework::deviceSynchronize( this->gpu() ) ;
+    }
+    
+    this->data_2d.setAtlas( atlas ) ;
+  }
+  
+  void NyxDrawTex2D::setAtlasInput( const char* input )
+  {
+    this->bus.enroll( this, &NyxDrawTex2D::setAtlas, iris::OPTIONAL, input ) ;
+  }
+  
   void NyxDrawTex2D::initialize()
   {
-    this->data_2d.copy_chain.initialize( this->gpu(), nyx::ChainType::Compute                                             ) ;
-    this->data_2d.d_viewproj.initialize( this->gpu(), 1                           , false, nyx::ArrayFlags::UniformBuffer ) ;
-    this->data_2d.d_indices .initialize( this->gpu(), this->data_2d.indices.size(), false, nyx::ArrayFlags::StorageBuffer ) ;
-    this->data_2d.d_vertices.initialize( this->gpu(), 6                           , false, nyx::ArrayFlags::Vertex        ) ;
+    this->data_2d.copy_chain  .initialize( this->gpu(), nyx::ChainType::Compute                                               ) ;
+    this->data_2d.upload_chain.initialize( this->gpu(), nyx::ChainType::Graphics                                             ) ;
+    this->data_2d.d_viewproj  .initialize( this->gpu(), 1                             , false, nyx::ArrayFlags::UniformBuffer ) ;
+    this->data_2d.d_indices   .initialize( this->gpu(), this->data_2d.indices  .size(), false, nyx::ArrayFlags::StorageBuffer ) ;
+    this->data_2d.d_instances .initialize( this->gpu(), this->data_2d.instances.size(), false, nyx::ArrayFlags::StorageBuffer ) ;
+    this->data_2d.d_vertices  .initialize( this->gpu(), 6                             , false, nyx::ArrayFlags::Vertex        ) ;
+    this->data_2d.d_regions   .initialize( this->gpu(), this->data_2d.regions  .size(), false, nyx::ArrayFlags::StorageBuffer ) ;
+    this->data_2d.no_atlas    .initialize( nyx::ImageFormat::RGBA8, this->gpu(), 1, 1, 1                                      ) ;
     
-    NyxDrawModule::pipeline().bind( "projection", this->data_2d.d_viewproj ) ;
-    NyxDrawModule::pipeline().bind( "texture_id", this->data_2d.d_indices  ) ;
+    NyxDrawModule::pipeline().bind( "projection"  , this->data_2d.d_viewproj  ) ;
+    NyxDrawModule::pipeline().bind( "texture_id"  , this->data_2d.d_indices   ) ;
+    NyxDrawModule::pipeline().bind( "instance_id" , this->data_2d.d_instances ) ;
+    NyxDrawModule::pipeline().bind( "atlas_region", this->data_2d.d_regions   ) ;
+    NyxDrawModule::pipeline().bind( "atlas"       , this->data_2d.no_atlas    ) ;
     
-    this->data_2d.copy_chain.copy( nyx::vertices, this->data_2d.d_vertices ) ;
+    this->data_2d.copy_chain.copy( nyx::vertices               , this->data_2d.d_vertices ) ;
+    this->data_2d.copy_chain.copy( this->data_2d.regions.data(), this->data_2d.d_regions  ) ;
     this->data_2d.copy_chain.submit     () ;
     this->data_2d.copy_chain.synchronize() ;
 
@@ -107,24 +146,33 @@ namespace nyx
     this->bus.setChannel( id ) ;
     NyxDrawModule::subscribe( this->bus ) ;
     
-    this->bus.enroll( &this->data_2d, &NyxDrawTex2DData::setCameraInput    , iris::OPTIONAL, this->name(), "::camera"     ) ;
-    this->bus.enroll( &this->data_2d, &NyxDrawTex2DData::setProjectionInput, iris::OPTIONAL, this->name(), "::projection" ) ;
+    this->bus.enroll( &this->data_2d, &NyxDrawTex2DData::setCameraInput    , iris::OPTIONAL, this->name(), "::camera"      ) ;
+    this->bus.enroll( &this->data_2d, &NyxDrawTex2DData::setProjectionInput, iris::OPTIONAL, this->name(), "::projection"  ) ;
+    this->bus.enroll( &this->data_2d, &NyxDrawTex2DData::setQuadAtlasInput , iris::OPTIONAL, this->name(), "::atlas_input" ) ;
+    this->bus.enroll( this          , &NyxDrawTex2D::setAtlasInput         , iris::OPTIONAL, this->name(), "::atlas"       ) ;
   }
   
   void NyxDrawTex2D::shutdown()
   {
+    if( this->data_2d.pending ) this->data_2d.upload_chain.synchronize() ;
+    
     NyxDrawModule::shutdown() ;
-    this->data_2d.d_viewproj.reset() ;
+    this->data_2d.d_viewproj .reset() ;
+    this->data_2d.d_indices  .reset() ;
+    this->data_2d.d_instances.reset() ;
+    this->data_2d.d_regions  .reset() ;
+    this->data_2d.no_atlas   .reset() ;
   }
   
   void NyxDrawTex2D::execute()
   {
     if( this->updated_textures )
     {
-      this->data_2d.updateViewProj() ;
-      this->data_2d.count = 0 ;
-      this->draw() ;
+      this->data_2d.updateViewProj  () ;
+      this->data_2d.updateRegions   () ;
       this->data_2d.updateTextureIds() ;
+      this->draw() ;
+      this->data_2d.updateInstances () ;
     }
     this->bus.emit() ;
   }
@@ -18,6 +18,7 @@
 #pragma once 
 
 #include <templates/NyxDrawModule.h>
+#include <templates/NyxAtlas.h>
 #include <Mars/Model.h>
 #include <Iris/data/Bus.h>
 
@@ -50,6 +51,16 @@ namespace nyx
        */
       void updateTextures() ;
       
+      /** Method to set the atlas quads can be drawn from, binding it's image the first time it is set.
+       * @param atlas The atlas to draw from.
+       */
+      void setAtlas( const nyx::Atlas<Framework>& atlas ) ;
+      
+      /** Method to set the name of the atlas input.
+       * @param input The name to associate with the atlas input.
+       */
+      void setAtlasInput( const char* input ) ;
+      
       /** Method to shut down this object's operation.
        */
       void shutdown() ;
@@ -61,30 +72,140 @@ namespace nyx
     private:
       struct NyxDrawTex2DData
       {
-        nyx::Chain<Framework>             copy_chain ;
-        nyx::Array<Framework, glm::mat4 > d_viewproj ;
-        nyx::Array<Framework, unsigned  > d_indices  ;
-        nyx::Array<Framework, glm::vec4 > d_vertices ;
-        std::vector<unsigned>             indices    ;
-        iris::Bus                         bus        ;
-        bool                              dirty      ;
-        const glm::mat4*                  projection ;
-        const glm::mat4*                  camera     ;
-        unsigned                          count      ;
+        using Atlas = nyx::Atlas<Framework>                  ;
+        using IdMap = std::unordered_map<unsigned, unsigned> ;
+        
+        nyx::Chain<Framework>             copy_chain      ;
+        nyx::Chain<Framework>             upload_chain    ;
+        nyx::Array<Framework, glm::mat4 > d_viewproj      ;
+        nyx::Array<Framework, unsigned  > d_indices       ;
+        nyx::Array<Framework, unsigned  > d_instances     ;
+        nyx::Array<Framework, glm::vec4 > d_vertices      ;
+        nyx::Array<Framework, glm::vec4 > d_regions       ;
+        nyx::Image<Framework>             no_atlas        ;
+        std::vector<unsigned>             indices         ;
+        std::vector<unsigned>             instances       ;
+        std::vector<glm::vec4>            regions         ;
+        IdMap                             atlased         ;
+        iris::Bus                         bus             ;
+        bool                              dirty           ;
+        bool                              regions_dirty   ;
+        bool                              ids_dirty       ;
+        bool                              instances_dirty ;
+        bool                              pending         ;
+        const glm::mat4*                  projection      ;
+        const glm::mat4*                  camera          ;
+        const Atlas*                      atlas           ;
+        unsigned                          count           ;
         
-        NyxDrawTex2DData()                                      { this->dirty = false ; this->projection = nullptr ; this->camera = nullptr ;         } ;
+        NyxDrawTex2DData()                                      { this->dirty = false ; this->regions_dirty = false ; this->ids_dirty = true ; this->instances_dirty = false ; this->pending = false ; this->projection = nullptr ; this->camera = nullptr ; this->atlas = nullptr ; this->count = 0 ; } ;
         void setProjectionInput( const char* input            ) { this->bus.enroll( this, &NyxDrawTex2DData::setProjection, iris::OPTIONAL, input ) ; } ;
         void setCameraInput    ( const char* input            ) { this->bus.enroll( this, &NyxDrawTex2DData::setCamera    , iris::OPTIONAL, input ) ; } ;
+        void setQuadAtlasInput ( const char* input            ) { this->bus.enroll( this, &NyxDrawTex2DData::setQuadAtlas , iris::OPTIONAL, input ) ; } ;
         void setProjection     ( const glm::mat4& val         ) { this->projection = &val ; this->dirty = true ;                                      } ;
         void setCamera         ( const glm::mat4& val         ) { this->camera     = &val ; this->dirty = true ;                                      } ;
+        void setQuadAtlas      ( unsigned id, unsigned atlas_id ) { this->atlased[ id ] = atlas_id ; this->placeInAtlas( id, atlas_id ) ;              } ;
+        
+        /** Method to set the atlas quads can be drawn from. Called again every time the atlas uploads new images.
+         * @param val The atlas.
+         */
+        void setAtlas( const Atlas& val )
+        {
+          this->atlas = &val ;
+          for( const auto& entry : this->atlased ) this->placeInAtlas( entry.first, entry.second ) ;
+        }
+        
+        /** Method to point a quad at it's image in the atlas. The quad's texture id is then the atlas page to sample.
+         * @param id The quad to update.
+         * @param atlas_id The id of the image in the atlas.
+         */
+        void placeInAtlas( unsigned id, unsigned atlas_id )
+        {
+          AtlasRect rect ;
+          
+          if( id >= this->regions.size() || this->atlas == nullptr || !this->atlas->find( atlas_id, rect ) ) return ;
+          
+          this->regions[ id ] = rect.region ;
+          this->indices[ id ] = rect.page   ;
+          this->regions_dirty = true        ;
+          this->ids_dirty     = true        ;
+        }
+        
+        /** Method to resolve a quad's texture id once, when it is added. Quads in the atlas keep their page instead.
+         * @param id The quad that was added.
+         * @param tex_id The texture the quad draws.
+         */
+        void addQuad( unsigned id, unsigned tex_id )
+        {
+          if( id >= this->indices.size() || this->regions[ id ].z > 0.0f || this->indices[ id ] == tex_id ) return ;
+          
+          this->indices[ id ] = tex_id ;
+          this->ids_dirty     = true   ;
+        }
+        
+        void updateRegions()
+        {
+          if( this->regions_dirty )
+          {
+            this->copy_chain.copy( this->regions.data(), this->d_regions ) ;
+            this->copy_chain.submit     () ;
+            this->copy_chain.synchronize() ;
+            this->regions_dirty = false ;
+          }
+        }
         
-        void draw( nyx::Chain<Framework>& chain, nyx::Pipeline<Framework>& pipeline )
+        /** Method to record every quad with a single instanced draw. Each instance looks it's quad up in the instance buffer.
+         * Only gathers the quads, which are uploaded by @updateInstances once recording is done.
+         * @param items The quads to draw, in the order to draw them.
+         * @param count The amount of quads to draw.
+         * @param chain The chain to record into.
+         * @param pipeline The pipeline to draw with.
+         */
+        void draw( const nyx::DrawItem* items, unsigned count, nyx::Chain<Framework>& chain, nyx::Pipeline<Framework>& pipeline )
         {
-          chain.begin() ;
-          chain.draw( pipeline, this->d_vertices ) ; 
-          chain.end() ;
+          this->count = 0 ;
+          
+          for( unsigned index = 0; index < count; index++ )
+          {
+            if( items[ index ].id < this->instances.size() ) this->instances[ this->count++ ] = items[ index ].id ;
+          }
+          
+          if( this->count != 0 )
+          {
+            this->instances_dirty = true ;
+            chain.drawInstanced( this->count, pipeline, this->d_vertices ) ;
+          }
         };
         
+        /** Method to upload the quads gathered by @draw, ahead of the parent's frame.
+         * Only re-recorded when quads are added or removed, so this doesn't happen per frame.
+         * The upload is submitted without waiting on it, and only waited on before the next one.
+         */
+        void updateInstances()
+        {
+          if( !this->instances_dirty ) return ;
+          
+          // The last upload was submitted at least a frame ago, so this only waits if the device is that far behind.
+          if( this->pending )
+          {
+            this->upload_chain.synchronize() ;
+            this->pending = false ;
+          }
+          
+          this->upload_chain.begin() ;
+          
+          // The previous frame may still be reading the instance buffer, so the copy waits for it.
+          this->upload_chain.barrier() ;
+          this->upload_chain.copy   ( this->instances.data(), this->d_instances, this->count, 0, 0 ) ;
+          
+          // The chain & the parent's frame go to the same graphics queue, so this barrier orders the copy before the frame reads it.
+          this->upload_chain.barrier() ;
+          this->upload_chain.submit () ;
+          
+          this->pending         = true  ;
+          this->instances_dirty = false ;
+        }
+        
         void updateViewProj()
         {
           glm::mat4 viewproj ;
@@ -100,9 +221,13 @@ namespace nyx
         
         void updateTextureIds()
         {
-          this->copy_chain.copy( this->indices.data(), this->d_indices ) ;
-          this->copy_chain.submit     () ;
-          this->copy_chain.synchronize() ;
+          if( this->ids_dirty )
+          {
+            this->copy_chain.copy( this->indices.data(), this->d_indices ) ;
+            this->copy_chain.submit     () ;
+            this->copy_chain.synchronize() ;
+            this->ids_dirty = false ;
+          }
         }
       };
       
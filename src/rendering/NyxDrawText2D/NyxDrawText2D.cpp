@@ -15,10 +15,10 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-/* 
+/*
  * File:   NyxDrawText2D.cpp
  * Author: Jordan Hendl
- * 
+ *
  * Created on April 14, 2021, 6:58 PM
  */
 
@@ -26,63 +26,230 @@
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 
 #include "NyxDrawText2D.h"
-#include "draw_text2D.h"
+#include "draw_text2d.h"
 #include <NyxGPU/library/Array.h>
 #include <NyxGPU/library/Image.h>
 #include <NyxGPU/library/Chain.h>
 #include <NyxGPU/vkg/Vulkan.h>
-#include <queue>
 
 static const unsigned VERSION = 1 ;
 namespace nyx
 {
   constexpr unsigned TRANSFORM_SIZE = 2048 ;
-  
+
+  /** The unit quad every glyph is drawn with.
+   */
+  const static glm::vec4 vertices[] =
+  {
+    glm::vec4( 0.0f, 1.0f, 0.0f, 0.0f ),
+    glm::vec4( 1.0f, 0.0f, 0.0f, 0.0f ),
+    glm::vec4( 0.0f, 0.0f, 0.0f, 0.0f ),
+    glm::vec4( 1.0f, 1.0f, 0.0f, 0.0f ),
+  };
+
+  const static unsigned indices[] = { 0, 1, 2, 0, 3, 1 } ;
+
+  NyxDrawText2D::NyxDrawText2DData::NyxDrawText2DData()
+  {
+    this->command    = { 6, 0, 0, 0, 0 } ;
+    this->source     = &this->builtin    ;
+    this->projection = nullptr           ;
+    this->camera     = nullptr           ;
+    this->text_dirty = true              ;
+    this->view_dirty = true              ;
+    this->truncated  = false             ;
+  }
+
+  void NyxDrawText2D::NyxDrawText2DData::setText( unsigned id, const char* text )
+  {
+    this->batch.setText( id, text ) ;
+    this->text_dirty = true ;
+  }
+
+  void NyxDrawText2D::NyxDrawText2DData::setColor( unsigned id, const glm::vec4& color )
+  {
+    this->batch.setColor( id, color ) ;
+    this->text_dirty = true ;
+  }
+
+  void NyxDrawText2D::NyxDrawText2DData::record( const nyx::DrawItem* items, unsigned count, nyx::Chain<Framework>& chain, nyx::Pipeline<Framework>& pipeline )
+  {
+    this->order.clear() ;
+
+    for( unsigned index = 0; index < count; index++ )
+    {
+      if( items[ index ].id < TRANSFORM_SIZE ) this->order.push_back( items[ index ].id ) ;
+    }
+
+    // The instance count lives on the device, so changing strings never needs this to be recorded again.
+    chain.drawIndexedIndirect( pipeline, this->d_indices, this->d_vertices, this->d_command, 0, 1 ) ;
+    this->batch.setOrder( this->order.data(), this->order.size() ) ;
+    this->text_dirty = true ;
+  }
+
+  void NyxDrawText2D::NyxDrawText2DData::updateText()
+  {
+    if( !this->text_dirty ) return ;
+
+    // Strings set to what they already were don't show up here, unchanged ones are never laid out again.
+    if( this->batch.update() )
+    {
+      for( const nyx::TextRange& range : this->batch.uploads() )
+      {
+        this->copy_chain.copy( this->batch.instances(), this->d_glyphs, range.count, range.offset, range.offset ) ;
+      }
+
+      if( this->command.instance_count != this->batch.count() )
+      {
+        this->command.instance_count = this->batch.count() ;
+        this->copy_chain.copy( &this->command, this->d_command ) ;
+      }
+
+      if( this->batch.full() && !this->truncated )
+      {
+        Log::output( Log::Level::Warning, "Module NyxDrawText2D drawing it's most glyphs, ", this->batch.count(), ". The rest are dropped." ) ;
+        this->truncated = true ;
+      }
+    }
+
+    this->atlas.upload( this->copy_chain ) ;
+    this->copy_chain.submit     () ;
+    this->copy_chain.synchronize() ;
+
+    this->text_dirty = false ;
+  }
+
+  void NyxDrawText2D::NyxDrawText2DData::updateViewProj()
+  {
+    if( this->view_dirty )
+    {
+      const glm::mat4 projection = this->projection != nullptr ? *this->projection : glm::mat4( 1.0f ) ;
+      const glm::mat4 camera     = this->camera     != nullptr ? *this->camera     : glm::mat4( 1.0f ) ;
+      const glm::mat4 viewproj   = projection * camera                                                  ;
+
+      this->copy_chain.copy( &viewproj, this->d_viewproj ) ;
+      this->copy_chain.submit     () ;
+      this->copy_chain.synchronize() ;
+      this->view_dirty = false ;
+    }
+  }
+
   NyxDrawText2D::NyxDrawText2D()
   {
-    auto function = [=] ( unsigned , std::string& string, nyx::Chain<Framework>& , nyx::Pipeline<Framework>&  )
+    auto add = [=] ( unsigned id, std::string& string )
+    {
+      this->data_text.setText( id, string.c_str() ) ;
+    };
+
+    // Drawn in id order, later strings over earlier ones. Every glyph goes out in one draw, so there is no state to group by.
+    auto sort = [=] ( unsigned id, std::string&, nyx::DrawQueue& queue )
+    {
+      queue.push( id, id, 0 ) ;
+    };
+
+    auto record = [=] ( const nyx::DrawItem* items, unsigned count, nyx::Chain<Framework>& chain, nyx::Pipeline<Framework>& pipeline )
     {
-      string.size() ;
+      this->data_text.record( items, count, chain, pipeline ) ;
     };
-    
-    NyxDrawModule::setTransformKey   ( "transforms"                                               ) ;
-    NyxDrawModule::setTransformSize  ( TRANSFORM_SIZE                                             ) ;
-    NyxDrawModule::setPipeline       ( nyx::bytes::draw_text2D, sizeof( nyx::bytes::draw_text2D ) ) ;
-    NyxDrawModule::setPerDrawCallback( function                                                   ) ;
+
+    NyxDrawModule::setTransformFlag     ( nyx::ArrayFlags::StorageBuffer                             ) ;
+    NyxDrawModule::setTransformKey      ( "transforms"                                               ) ;
+    NyxDrawModule::setTransformSize     ( TRANSFORM_SIZE                                             ) ;
+    NyxDrawModule::setPipeline          ( nyx::bytes::draw_text2d, sizeof( nyx::bytes::draw_text2d ) ) ;
+    NyxDrawModule::setAddCallback       ( add                                                        ) ;
+    NyxDrawModule::setSortCallback      ( sort                                                       ) ;
+    NyxDrawModule::setSortedDrawCallback( record                                                     ) ;
   }
-  
+
   NyxDrawText2D::~NyxDrawText2D()
   {
-    
+
   }
-  
+
   void NyxDrawText2D::initialize()
   {
-    
+    auto& data = this->data_text ;
+
+    data.copy_chain.initialize( this->gpu(), nyx::ChainType::Compute                                                                  ) ;
+    data.d_viewproj.initialize( this->gpu(), 1                    , false, nyx::ArrayFlags::UniformBuffer                             ) ;
+    data.d_glyphs  .initialize( this->gpu(), nyx::TEXT_GLYPHS     , false, nyx::ArrayFlags::StorageBuffer                             ) ;
+    data.d_command .initialize( this->gpu(), 1                    , false, nyx::ArrayFlags::StorageBuffer | nyx::ArrayFlags::Indirect ) ;
+    data.d_vertices.initialize( this->gpu(), 4                    , false, nyx::ArrayFlags::Vertex                                    ) ;
+    data.d_indices .initialize( this->gpu(), 6                    , false, nyx::ArrayFlags::Index                                     ) ;
+    data.atlas     .initialize( this->gpu(), nyx::TEXT_ATLAS_SIZE, 1, 1                                                               ) ;
+    data.glyphs    .initialize( data.source, &data.atlas                                                                              ) ;
+    data.runs      .initialize( &data.glyphs                                                                                          ) ;
+    data.batch     .initialize( &data.runs                                                                                            ) ;
+
+    NyxDrawModule::pipeline().bind( "atlas"     , data.atlas.image() ) ;
+    NyxDrawModule::pipeline().bind( "projection", data.d_viewproj    ) ;
+    NyxDrawModule::pipeline().bind( "glyphs"    , data.d_glyphs      ) ;
+
+    data.copy_chain.copy( nyx::vertices, data.d_vertices ) ;
+    data.copy_chain.copy( nyx::indices , data.d_indices  ) ;
+    data.copy_chain.copy( &data.command, data.d_command  ) ;
+    data.copy_chain.submit     () ;
+    data.copy_chain.synchronize() ;
   }
-  
+
   void NyxDrawText2D::setFontName( const char* font_name )
   {
-    std::string name = font_name ;
+    this->font_name = font_name ;
+    this->bus.enroll( this, &NyxDrawText2D::setFont, iris::OPTIONAL, font_name ) ;
+  }
+
+  void NyxDrawText2D::setFont( const nyx::GlyphSource& source )
+  {
+    auto& data = this->data_text ;
+
+    if( data.source == &source ) return ;
+
+    Log::output( "Module ", this->name(), " switching to font ", this->font_name.c_str(), "." ) ;
+
+    // Every glyph of the old font is dropped, strings lay out again & pull in the new font's glyphs.
+    data.source     = &source ;
+    data.text_dirty = true    ;
+    data.atlas .AtlasPages::initialize( nyx::TEXT_ATLAS_SIZE, 1, 1 ) ;
+    data.glyphs.initialize( data.source, &data.atlas ) ;
+    data.runs  .clear     () ;
+    data.batch .invalidate() ;
   }
-  
+
   void NyxDrawText2D::subscribe( unsigned id )
   {
-    this->bus.setChannel( id ) ;
+    this->bus          .setChannel( id ) ;
+    this->data_text.bus.setChannel( id ) ;
     NyxDrawModule::subscribe( this->bus ) ;
-    
-    this->bus.enroll( this, &NyxDrawText2D::setFontName, iris::OPTIONAL, this->name(), "::font" ) ;
+
+    this->bus.enroll( this             , &NyxDrawText2D::setFontName             , iris::OPTIONAL, this->name(), "::font"        ) ;
+    this->bus.enroll( &this->data_text , &NyxDrawText2DData::setSize             , iris::OPTIONAL, this->name(), "::size"        ) ;
+    this->bus.enroll( &this->data_text , &NyxDrawText2DData::setCameraInput      , iris::OPTIONAL, this->name(), "::camera"      ) ;
+    this->bus.enroll( &this->data_text , &NyxDrawText2DData::setProjectionInput  , iris::OPTIONAL, this->name(), "::projection"  ) ;
+    this->bus.enroll( &this->data_text , &NyxDrawText2DData::setTextInput        , iris::OPTIONAL, this->name(), "::text_input"  ) ;
+    this->bus.enroll( &this->data_text , &NyxDrawText2DData::setColorInput       , iris::OPTIONAL, this->name(), "::color_input" ) ;
+    this->bus.enroll( &this->data_text , &NyxDrawText2DData::setRunStatsName     , iris::OPTIONAL, this->name(), "::run_stats"   ) ;
   }
-  
+
   void NyxDrawText2D::shutdown()
   {
+    const nyx::TextRunStats& stats = this->data_text.runs.stats() ;
+
+    Log::output( "Module ", this->name(), " text run cache hit rate ", stats.rate() * 100.0f, "%, ", stats.hits, " hits, ", stats.misses, " misses, ", stats.evictions, " evictions." ) ;
+
     NyxDrawModule::shutdown() ;
-    
+    this->data_text.d_viewproj.reset() ;
+    this->data_text.d_glyphs  .reset() ;
+    this->data_text.d_command .reset() ;
+    this->data_text.d_vertices.reset() ;
+    this->data_text.d_indices .reset() ;
+    this->data_text.atlas     .reset() ;
   }
-  
+
   void NyxDrawText2D::execute()
   {
     this->draw() ;
+    this->data_text.updateViewProj() ;
+    this->data_text.updateText    () ;
     this->bus.emit() ;
   }
 }
@@ -118,8 +285,8 @@ exported_function ::iris::Module* make()
 exported_function void destroy( ::iris::Module* module )
 {
   ::nyx::NyxDrawText2D* mod ;
-  
+
   mod = dynamic_cast<nyx::NyxDrawText2D*>( module ) ;
   delete mod ;
   // </editor-fold>
-}
\ No newline at end of file
+}
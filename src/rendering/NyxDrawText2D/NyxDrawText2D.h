@@ -18,14 +18,14 @@
 #pragma once
 
 #include <templates/NyxDrawModule.h>
-#include <Mars/Font.h>
-#include <Mars/Factory.h>
-#include <Mars/Manager.h>
+#include <templates/NyxText.h>
 #include <Iris/data/Bus.h>
+#include <string>
 
 namespace nyx
 {
-  /** A module for managing converting images on the host to Vulkan images on the GPU.
+  /** A module for drawing strings with glyphs from a signed distance field atlas, so text stays sharp at any scale.
+   * Every glyph of every string is an instance of one quad, drawn together with a single indirect draw.
    */
   class NyxDrawText2D : public nyx::NyxDrawModule<std::string>
   {
@@ -56,11 +56,94 @@ namespace nyx
        */
       void execute() ;
 
+      /** Method to set the name of the font to draw with, the bus key a nyx::GlyphSource is published under.
+       * Until one is published, the built-in font is used.
+       * @param string The name of the font.
+       */
       void setFontName( const char* string ) ;
+
+      /** Method to set the font to draw with, rasterizing every glyph again.
+       * @param source The font.
+       */
+      void setFont( const nyx::GlyphSource& source ) ;
+
     private:
-      
-      mars::Reference<mars::Font<Framework>> font      ;
-      std::string                            font_name ;
-      iris::Bus                              bus       ;
+      struct NyxDrawText2DData
+      {
+        /** Structure describing the indirect draw of every glyph. A VkDrawIndexedIndirectCommand.
+         */
+        struct DrawCommand
+        {
+          unsigned index_count    ;
+          unsigned instance_count ;
+          unsigned first_index    ;
+          int      vertex_offset  ;
+          unsigned first_instance ;
+        };
+
+        nyx::Chain<Framework>                     copy_chain ;
+        nyx::Array<Framework, glm::mat4>          d_viewproj ;
+        nyx::Array<Framework, nyx::GlyphInstance> d_glyphs   ;
+        nyx::Array<Framework, DrawCommand>        d_command  ;
+        nyx::Array<Framework, glm::vec4>          d_vertices ;
+        nyx::Array<Framework, unsigned>           d_indices  ;
+        nyx::Atlas<Framework>                     atlas      ;
+        nyx::BitmapFont                           builtin    ;
+        nyx::GlyphSet                             glyphs     ;
+        nyx::TextRunCache                         runs       ;
+        nyx::TextBatch                            batch      ;
+        std::vector<unsigned>                     order      ;
+        DrawCommand                               command    ;
+        iris::Bus                                 bus        ;
+        const nyx::GlyphSource*                   source     ;
+        const glm::mat4*                          projection ;
+        const glm::mat4*                          camera     ;
+        bool                                      text_dirty ;
+        bool                                      view_dirty ;
+        bool                                      truncated  ;
+
+        NyxDrawText2DData() ;
+        void setProjectionInput( const char* input      ) { this->bus.enroll( this, &NyxDrawText2DData::setProjection, iris::OPTIONAL, input ) ; } ;
+        void setCameraInput    ( const char* input      ) { this->bus.enroll( this, &NyxDrawText2DData::setCamera    , iris::OPTIONAL, input ) ; } ;
+        void setTextInput      ( const char* input      ) { this->bus.enroll( this, &NyxDrawText2DData::setText      , iris::OPTIONAL, input ) ; } ;
+        void setColorInput     ( const char* input      ) { this->bus.enroll( this, &NyxDrawText2DData::setColor     , iris::OPTIONAL, input ) ; } ;
+        void setRunStatsName   ( const char* name       ) { this->bus.publish( this, &NyxDrawText2DData::runStats    , name                 ) ; } ;
+        const nyx::TextRunStats& runStats()               { return this->runs.stats() ;                                                      } ;
+        void setProjection     ( const glm::mat4& val   ) { this->projection = &val ; this->view_dirty = true ;                                  } ;
+        void setCamera         ( const glm::mat4& val   ) { this->camera     = &val ; this->view_dirty = true ;                                  } ;
+        void setSize           ( float val              ) { this->batch.setSize( val ) ; this->text_dirty = true ;                               } ;
+
+        /** Method to change the string drawn by a drawable. Setting the string it already draws does nothing.
+         * @param id The drawable to change.
+         * @param text The string to draw.
+         */
+        void setText( unsigned id, const char* text ) ;
+
+        /** Method to change the color of a drawable's string.
+         * @param id The drawable to change.
+         * @param color The color to draw the string in.
+         */
+        void setColor( unsigned id, const glm::vec4& color ) ;
+
+        /** Method to record the draw of every glyph. Only the order of strings is kept, glyphs are written by @updateText.
+         * @param items The strings to draw, in the order to draw them.
+         * @param count The amount of strings to draw.
+         * @param chain The chain to record into.
+         * @param pipeline The pipeline to draw with.
+         */
+        void record( const nyx::DrawItem* items, unsigned count, nyx::Chain<Framework>& chain, nyx::Pipeline<Framework>& pipeline ) ;
+
+        /** Method to upload the glyph instances of strings that changed, new glyphs & the draw's instance count.
+         */
+        void updateText() ;
+
+        /** Method to upload the projection times the camera, if either changed.
+         */
+        void updateViewProj() ;
+      };
+
+      NyxDrawText2DData data_text ;
+      std::string       font_name ;
+      iris::Bus         bus       ;
   };
-}
\ No newline at end of file
+}
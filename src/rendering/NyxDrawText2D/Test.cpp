@@ -1,20 +1,406 @@
 /*
- * To change this license header, choose License Headers in Project Properties.
- * To change this template file, choose Tools | Templates
- * and open the template in the editor.
+ * Copyright (C) 2020 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-/* 
+/*
  * File:   Test.cpp
  * Author: jhendl
  *
  * Created on April 17, 2021, 1:30 AM
  */
 
-#include <cstdlib>
+#include <templates/NyxText.h>
+#include <glm/glm.hpp>
+#include <chrono>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cmath>
+#include <cstring>
 
-int main()
+/** Turns an 8 x 8 block into a distance field, checking the edge sits at one half & the field falls off evenly around it.
+ */
+static bool testDistance()
+{
+  const unsigned             spread = 4                                                              ;
+  const unsigned             width  = 8 + 2 * spread                                                 ;
+  nyx::GlyphBitmap           block  = { std::vector<unsigned char>( 64, 255 ), 8, 8, 0.0f, 0.0f, 8.0f } ;
+  std::vector<unsigned char> pixels                                                                  ;
+
+  nyx::signedDistance( block, spread, pixels ) ;
+
+  if( pixels.size() != width * width * 4 ) return false ;
+
+  auto alpha = [&] ( unsigned x, unsigned y ) { return static_cast<int>( pixels[ ( y * width + x ) * 4 + 3 ] ) ; } ;
+
+  // Half a pixel in & out of the edge, then further away on either side.
+  if( std::abs( alpha( spread    , 8 ) - 143 ) > 1 ) return false ;
+  if( std::abs( alpha( spread - 1, 8 ) - 112 ) > 1 ) return false ;
+  if( std::abs( alpha( spread + 3, 8 ) - 239 ) > 1 ) return false ;
+  if( alpha( 0, 0 ) != 0                          ) return false ;
+
+  for( unsigned x = 1; x < width / 2; x++ )
+  {
+    if( alpha( x, width / 2 ) < alpha( x - 1, width / 2 ) ) return false ;
+  }
+
+  // The corner of the block is the same distance from both edges it touches.
+  return alpha( spread - 1, spread + 2 ) == alpha( spread + 2, spread - 1 ) ;
+}
+
+/** Lays out a few strings with the built-in font, checking where the pen puts every glyph & that glyphs are only packed once.
+ */
+static bool testLayout()
+{
+  nyx::BitmapFont                 font                                 ;
+  nyx::AtlasPages                 atlas                                ;
+  nyx::GlyphSet                   glyphs                               ;
+  std::vector<nyx::GlyphInstance> instances ( 16                     ) ;
+  const glm::vec4                 red       ( 1.0f, 0.0f, 0.0f, 1.0f ) ;
+  const float                     line      = font.lineHeight()        ;
+  const float                     spread    = nyx::GLYPH_SPREAD        ;
+  const float                     advance   = 6.0f * nyx::GLYPH_SCALE  ;
+
+  atlas .initialize( nyx::TEXT_ATLAS_SIZE, 1, 1 ) ;
+  glyphs.initialize( &font, &atlas ) ;
+
+  // A size of one line height draws the font's pixels as they are.
+  if( glyphs.layout( "Hi\nyo", line, 7, red, instances.data(), instances.size() ) != 4 ) return false ;
+
+  const nyx::GlyphInstance& h = instances[ 0 ] ;
+  const nyx::GlyphInstance& i = instances[ 1 ] ;
+  const nyx::GlyphInstance& y = instances[ 2 ] ;
+
+  if( h.rect.x != -spread || h.rect.y != nyx::GLYPH_SCALE - spread || h.rect.z != 5 * nyx::GLYPH_SCALE + 2 * spread ) return false ;
+  if( i.rect.x != advance - spread || y.rect.x != -spread || y.rect.y != line + nyx::GLYPH_SCALE - spread           ) return false ;
+  if( h.transform != 7 || h.color.x != 1.0f || h.color.y != 0.0f                                                   ) return false ;
+  if( h.region.z <= 0.0f || h.region.x + h.region.z > 1.0f || h.region.y + h.region.w > 1.0f                       ) return false ;
+
+  // Spaces move the pen without a glyph, and double the size doubles everything.
+  if( glyphs.layout( "a b", 2.0f * line, 0, red, instances.data(), instances.size() ) != 2 ) return false ;
+  if( instances[ 1 ].rect.x != 2.0f * ( 2.0f * advance - spread )                         ) return false ;
+
+  // Unknown glyphs draw as the missing glyph, and no glyph is packed twice.
+  const unsigned packed = atlas.count() ;
+
+  if( glyphs.layout( "\xC3\xA9?", line, 0, red, instances.data(), instances.size() ) != 2 ) return false ;
+  if( instances[ 0 ].region.x != instances[ 1 ].region.x                                 ) return false ;
+  if( atlas.count() != packed + 1                                                        ) return false ;
+
+  // Running out of room stops the layout.
+  return glyphs.layout( "telemetry", line, 0, red, instances.data(), 4 ) == 4 ;
+}
+
+/** Lays out 2000 strings of 50 glyphs every frame, the 100k glyphs of a busy telemetry overlay.
+ */
+static bool testThroughput()
+{
+  constexpr unsigned STRINGS = 2000 ;
+  constexpr unsigned LENGTH  = 50   ;
+  constexpr unsigned FRAMES  = 100  ;
+
+  nyx::BitmapFont                 font                                    ;
+  nyx::AtlasPages                 atlas                                   ;
+  nyx::GlyphSet                   glyphs                                  ;
+  std::vector<nyx::GlyphInstance> instances ( nyx::TEXT_GLYPHS          ) ;
+  std::vector<std::string>        strings   ( STRINGS                   ) ;
+  const glm::vec4                 white     ( 1.0f                      ) ;
+  double                          total     = 0.0                         ;
+  unsigned                        count     = 0                           ;
+
+  atlas .initialize( nyx::TEXT_ATLAS_SIZE, 1, 1 ) ;
+  glyphs.initialize( &font, &atlas ) ;
+
+  for( unsigned index = 0; index < STRINGS; index++ )
+  {
+    for( unsigned glyph = 0; glyph < LENGTH; glyph++ ) strings[ index ] += static_cast<char>( '!' + ( index * 7 + glyph * 13 ) % 94 ) ;
+  }
+
+  for( unsigned frame = 0; frame < FRAMES; frame++ )
+  {
+    auto start = std::chrono::high_resolution_clock::now() ;
+
+    count = 0 ;
+    for( unsigned index = 0; index < STRINGS; index++ )
+    {
+      count += glyphs.layout( strings[ index ], 16.0f, index, white, instances.data() + count, instances.size() - count ) ;
+    }
+
+    total += std::chrono::duration<double, std::milli>( std::chrono::high_resolution_clock::now() - start ).count() ;
+  }
+
+  std::cout << "Laying out " << STRINGS << " strings of " << LENGTH << " glyphs, " << FRAMES << " frames: " << "\n"
+            << "-- Glyphs per frame     : " << count                         << "\n"
+            << "-- Glyphs in the atlas  : " << atlas.count()                 << "\n"
+            << "-- Atlas page occupancy : " << atlas.occupancy( 0 ) * 100.0f << "%"  << "\n"
+            << "-- Host time per frame  : " << total / FRAMES                << "ms" << std::endl ;
+
+  return count == STRINGS * LENGTH && atlas.count() == 94 ;
+}
+
+/** Shapes strings through a small run cache, checking hits, misses & which runs are evicted, and that runs match laying out directly.
+ */
+static bool testRuns()
+{
+  nyx::BitmapFont                 font                                 ;
+  nyx::AtlasPages                 atlas                                ;
+  nyx::GlyphSet                   glyphs                               ;
+  nyx::TextRunCache               runs                                 ;
+  std::vector<nyx::GlyphInstance> direct    ( 16                     ) ;
+  std::vector<nyx::GlyphInstance> cached    ( 16                     ) ;
+  const glm::vec4                 green     ( 0.0f, 1.0f, 0.0f, 1.0f ) ;
+
+  atlas .initialize( nyx::TEXT_ATLAS_SIZE, 1, 1 ) ;
+  glyphs.initialize( &font, &atlas ) ;
+  runs  .initialize( &glyphs, 3 ) ;
+
+  runs.shape( "a", 16.0f ) ;
+  runs.shape( "b", 16.0f ) ;
+  runs.shape( "c", 16.0f ) ;
+  runs.shape( "a", 16.0f ) ;
+
+  // The least recently used run makes room, "a" was just used so "b" & then "c" go.
+  runs.shape( "d", 16.0f ) ;
+  runs.shape( "b", 16.0f ) ;
+  runs.shape( "a", 16.0f ) ;
+
+  const nyx::TextRunStats& stats = runs.stats() ;
+
+  if( stats.hits != 2 || stats.misses != 5 || stats.evictions != 2 || stats.runs != 3 ) return false ;
+
+  // Another size is another run.
+  runs.shape( "a", 32.0f ) ;
+  if( stats.misses != 6 ) return false ;
+
+  const unsigned count = glyphs.layout( "km/h 120", 24.0f, 9, green, direct.data(), direct.size() ) ;
+
+  for( unsigned pass = 0; pass < 2; pass++ )
+  {
+    if( runs.write( "km/h 120", 24.0f, 9, green, cached.data(), cached.size() ) != count ) return false ;
+
+    for( unsigned index = 0; index < count; index++ )
+    {
+      const nyx::GlyphInstance& a = direct[ index ] ;
+      const nyx::GlyphInstance& b = cached[ index ] ;
+
+      if( a.rect.x != b.rect.x || a.rect.y != b.rect.y || a.region.x != b.region.x || a.page != b.page ) return false ;
+      if( b.transform != 9 || b.color.y != 1.0f || b.color.x != 0.0f                                   ) return false ;
+    }
+  }
+
+  return stats.hits == 3 ;
+}
+
+/** Checks a batch's glyphs match glyphs laid out directly, skipping the blank slack of every string's slot.
+ * @param batch The batch to check.
+ * @param direct The glyphs laid out directly, every one of them opaque.
+ * @param count The amount of glyphs laid out directly.
+ * @return Whether the batch draws the same glyphs in the same order.
+ */
+static bool sameGlyphs( const nyx::TextBatch& batch, const nyx::GlyphInstance* direct, unsigned count )
+{
+  unsigned glyph = 0 ;
+  
+  for( unsigned index = 0; index < batch.count(); index++ )
+  {
+    const nyx::GlyphInstance& instance = batch.instances()[ index ] ;
+    
+    if( instance.color.w == 0.0f ) continue ;
+    if( glyph == count || std::memcmp( &instance, direct + glyph, sizeof( nyx::GlyphInstance ) ) != 0 ) return false ;
+    glyph++ ;
+  }
+  
+  return glyph == count ;
+}
+
+/** Patches, moves, drops & adds back strings of a small batch, checking it always matches laying the drawn strings out directly.
+ */
+static bool testBatch()
+{
+  nyx::BitmapFont                 font                            ;
+  nyx::AtlasPages                 atlas                           ;
+  nyx::GlyphSet                   glyphs                          ;
+  nyx::TextRunCache               runs                            ;
+  nyx::TextBatch                  batch                           ;
+  std::vector<nyx::GlyphInstance> direct ( 64                   ) ;
+  const glm::vec4                 white  ( 1.0f                 ) ;
+  const unsigned                  all[]  = { 0, 1, 2 }            ;
+  const unsigned                  some[] = { 0, 2 }               ;
+
+  atlas .initialize( nyx::TEXT_ATLAS_SIZE, 1, 1 ) ;
+  glyphs.initialize( &font, &atlas ) ;
+  runs  .initialize( &glyphs ) ;
+  batch .initialize( &runs, 64 ) ;
+
+  // Lays the strings out the slow way, to compare the batch against.
+  auto matches = [&] ( const char* const* strings, const unsigned* ids, unsigned count )
+  {
+    unsigned total = 0 ;
+    for( unsigned index = 0; index < count; index++ ) total += glyphs.layout( strings[ ids[ index ] ], 32.0f, ids[ index ], white, direct.data() + total, direct.size() - total ) ;
+    return sameGlyphs( batch, direct.data(), total ) ;
+  };
+
+  const char* first [] = { "abc", "12", "xyz" } ;
+  const char* second[] = { "abc", "34", "xyz" } ;
+  const char* third [] = { "abc", "345", "xyz" } ;
+  const char* fourth[] = { "abc", "0123456789", "xyz" } ;
+
+  for( unsigned index = 0; index < 3; index++ ) batch.setText( index, first[ index ] ) ;
+  batch.setOrder( all, 3 ) ;
+  if( !batch.update() || !matches( first, all, 3 ) ) return false ;
+
+  // Nothing changed, nothing to do.
+  batch.setText( 1, "12" ) ;
+  if( batch.update() ) return false ;
+
+  // Same amount of glyphs, only that string's range is uploaded. Every slot is rounded up to the slack.
+  batch.setText( 1, "34" ) ;
+  if( !batch.update() || !matches( second, all, 3 ) ) return false ;
+  if( batch.uploads().size() != 1 || batch.uploads()[ 0 ].offset != nyx::TEXT_SLACK || batch.uploads()[ 0 ].count != 2 ) return false ;
+
+  // A longer string still fitting it's slot is patched in place too.
+  batch.setText( 1, "345" ) ;
+  if( !batch.update() || !matches( third, all, 3 ) ) return false ;
+  if( batch.uploads().size() != 1 || batch.uploads()[ 0 ].offset != nyx::TEXT_SLACK || batch.uploads()[ 0 ].count != 3 ) return false ;
+
+  // So is a shorter one, blanking the glyphs it no longer has.
+  batch.setText( 1, "34" ) ;
+  if( !batch.update() || !matches( second, all, 3 ) ) return false ;
+  if( batch.uploads().size() != 1 || batch.uploads()[ 0 ].offset != nyx::TEXT_SLACK || batch.uploads()[ 0 ].count != 3 ) return false ;
+
+  // A string outgrowing it's slot moves everything after it.
+  batch.setText( 1, "0123456789" ) ;
+  if( !batch.update() || !matches( fourth, all, 3 ) ) return false ;
+  if( batch.uploads().size() != 1 || batch.uploads()[ 0 ].offset != 0 ) return false ;
+
+  // Dropping a string from the order & adding it back lays it out where it lands.
+  batch.setOrder( some, 2 ) ;
+  if( !batch.update() || !matches( fourth, some, 2 ) ) return false ;
+  batch.setOrder( all, 3 ) ;
+  if( !batch.update() || !matches( fourth, all, 3 ) ) return false ;
+
+  return true ;
+}
+
+/** Runs a HUD of 2000 labels where a twentieth of them change every frame to one of a few values,
+ * comparing laying every string out with keeping them in a text batch.
+ */
+static bool testRunThroughput()
 {
-  return 0;
+  constexpr unsigned STRINGS = 2000 ;
+  constexpr unsigned FRAMES  = 200  ;
+
+  nyx::BitmapFont                 font                                    ;
+  nyx::AtlasPages                 atlas                                   ;
+  nyx::GlyphSet                   glyphs                                  ;
+  nyx::TextRunCache               runs                                    ;
+  nyx::TextBatch                  batch                                   ;
+  std::vector<nyx::GlyphInstance> direct    ( nyx::TEXT_GLYPHS          ) ;
+  std::vector<std::string>        strings   ( STRINGS                   ) ;
+  std::vector<unsigned>           order     ( STRINGS                   ) ;
+  const glm::vec4                 white     ( 1.0f                      ) ;
+  double                          layout    = 0.0                         ;
+  double                          update    = 0.0                         ;
+  unsigned                        count     = 0                           ;
+
+  atlas .initialize( nyx::TEXT_ATLAS_SIZE, 1, 1 ) ;
+  glyphs.initialize( &font, &atlas ) ;
+  runs  .initialize( &glyphs ) ;
+  batch .initialize( &runs ) ;
+  batch .setSize( 16.0f ) ;
+
+  for( unsigned index = 0; index < STRINGS; index++ ) order[ index ] = index ;
+  batch.setOrder( order.data(), STRINGS ) ;
+
+  for( unsigned frame = 0; frame < FRAMES; frame++ )
+  {
+    for( unsigned index = frame % 20; index < STRINGS; index += 20 )
+    {
+      strings[ index ] = "Unit " + std::to_string( index % 50 ) + " altitude: " + std::to_string( ( frame + index ) % 64 * 250 ) + " m" ;
+    }
+
+    auto start = std::chrono::high_resolution_clock::now() ;
+
+    count = 0 ;
+    for( unsigned index = 0; index < STRINGS; index++ )
+    {
+      count += glyphs.layout( strings[ index ], 16.0f, index, white, direct.data() + count, direct.size() - count ) ;
+    }
+
+    auto middle = std::chrono::high_resolution_clock::now() ;
+
+    // Strings are set every frame, as they would be off the bus. Only the ones that changed cost anything.
+    for( unsigned index = 0; index < STRINGS; index++ ) batch.setText( index, strings[ index ] ) ;
+    batch.update() ;
+
+    auto end = std::chrono::high_resolution_clock::now() ;
+
+    layout += std::chrono::duration<double, std::milli>( middle - start ).count() ;
+    update += std::chrono::duration<double, std::milli>( end    - middle ).count() ;
+
+    if( !sameGlyphs( batch, direct.data(), count ) ) return false ;
+  }
+
+  std::cout << "Laying out a " << STRINGS << " label HUD, " << FRAMES << " frames, 1 in 20 labels changing each frame: " << "\n"
+            << "-- Glyphs per frame                : " << count                          << "\n"
+            << "-- Run cache hit rate              : " << runs.stats().rate() * 100.0f    << "%"  << "\n"
+            << "-- Runs kept                       : " << runs.stats().runs               << "\n"
+            << "-- Host time per frame, full layout: " << layout / FRAMES                 << "ms" << "\n"
+            << "-- Host time per frame, text batch : " << update / FRAMES                 << "ms" << std::endl ;
+
+  return runs.stats().rate() > 0.9f && update < layout ;
 }
 
+int main()
+{
+  if( !testDistance() )
+  {
+    std::cout << "Text distance field test failed." << std::endl ;
+    return 1 ;
+  }
+
+  if( !testLayout() )
+  {
+    std::cout << "Text layout test failed." << std::endl ;
+    return 1 ;
+  }
+
+  if( !testThroughput() )
+  {
+    std::cout << "Text throughput test failed." << std::endl ;
+    return 1 ;
+  }
+
+  if( !testRuns() )
+  {
+    std::cout << "Text run cache test failed." << std::endl ;
+    return 1 ;
+  }
+
+  if( !testBatch() )
+  {
+    std::cout << "Text batch test failed." << std::endl ;
+    return 1 ;
+  }
+
+  if( !testRunThroughput() )
+  {
+    std::cout << "Text run cache throughput test failed." << std::endl ;
+    return 1 ;
+  }
+
+  return 0 ;
+}
@@ -0,0 +1,637 @@
+/*
+ * Copyright (C) 2020 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   NyxDrawTilemap.cpp
+ * Author: Jordan Hendl
+ *
+ * Created on April 15, 2021, 9:12 PM
+ */
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+
+#include "NyxDrawTilemap.h"
+#include "draw_tilemap.h"
+#include <templates/NyxTilemap.h>
+#include <Iris/data/Bus.h>
+#include <Iris/log/Log.h>
+#include <Iris/config/Parser.h>
+#include <NyxGPU/library/Array.h>
+#include <NyxGPU/library/Chain.h>
+#include <NyxGPU/vkg/Vulkan.h>
+#include <Mars/TextureArray.h>
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <mutex>
+
+static const unsigned VERSION = 1 ;
+namespace nyx
+{
+  namespace vkg
+  {
+    /** Structure describing the map as the shaders read it. Matches map in the tilemap shaders.
+     */
+    struct Map
+    {
+      glm::mat4 viewproj     ;
+      unsigned  tileset      ; ///< The database texture the tiles are cut out of.
+      unsigned  tile_size    ; ///< The size of a single tile in the tileset, in pixels.
+      unsigned  padding[ 2 ] ;
+    };
+
+    /** The unit quad every chunk is drawn with, the same one sprites use.
+     */
+    glm::vec4 tilemap_vertices[] =
+    {
+      glm::vec4( 0.0f, 1.0f, 0.0f, 0.0f ),
+      glm::vec4( 1.0f, 0.0f, 0.0f, 0.0f ),
+      glm::vec4( 0.0f, 0.0f, 0.0f, 0.0f ),
+
+      glm::vec4( 0.0f, 1.0f, 0.0f, 0.0f ),
+      glm::vec4( 1.0f, 1.0f, 0.0f, 0.0f ),
+      glm::vec4( 1.0f, 0.0f, 0.0f, 0.0f )
+    };
+
+    // <editor-fold defaultstate="collapsed" desc="Aliases">
+    using Log   = iris::log::Log            ;
+    using Impl  = nyx::vkg::Vulkan          ;
+    using Token = iris::config::json::Token ;
+    // </editor-fold>
+
+    // <editor-fold defaultstate="collapsed" desc="NyxDrawTilemapData Class & Function Declerations">
+    struct NyxDrawTilemapData
+    {
+      nyx::Array<Impl, TileChunk>  d_chunks         ;
+      nyx::Array<Impl, unsigned >  d_tiles          ;
+      nyx::Array<Impl, glm::vec4>  d_vertices       ;
+      nyx::Array<Impl, Map      >  d_map            ;
+      nyx::TileStreamer            streamer         ;
+      nyx::TileGrid                grid             ;
+      nyx::Viewport                viewport         ;
+      Map                          map              ;
+      const nyx::TileSource*       source           ;
+      const glm::mat4*             camera           ;
+      const glm::mat4*             projection       ;
+      unsigned                     subpass          ;
+      nyx::Pipeline<Impl>          pipeline         ;
+      const nyx::Chain<Impl>*      parent           ;
+      const nyx::RenderPass<Impl>* parent_pass      ;
+      bool                         rebuild_chain    ;
+      nyx::Chain<Impl>             draw_chain       ;
+      nyx::Chain<Impl>             copy_chain       ;
+      unsigned                     device           ;
+      iris::Bus                    bus              ;
+      iris::Bus                    wait_and_publish ;
+      std::string                  name             ;
+      bool                         dirty_flag       ;
+      std::mutex                   lock             ;
+
+      /** Default constructor.
+       */
+      NyxDrawTilemapData() ;
+
+      /** Method to rebind the textures after the database changed them.
+       */
+      void updateTextures() ;
+
+      /** Method to record the draw of every visible chunk. Only done when something it references changed.
+       */
+      void redrawTilemap() ;
+
+      /** Method to pick this frame's chunks, streaming in the missing ones & uploading what changed.
+       */
+      void stream() ;
+
+      /** Method to bind the map's buffers & the textures to the draw pipeline.
+       */
+      void bindDraw() ;
+
+      /** Method to retrieve the const chain from this object.
+       * @return The const reference to this object's chain object.
+       */
+      const nyx::Chain<Impl>& chain() ;
+
+      /** Method to parse a map small enough to be kept whole.
+       * @param token The token to parse, holding the width, height & every tile row by row.
+       */
+      void parseTiles( const Token& token ) ;
+
+      /** Method to change a single tile of the map parsed from the configuration.
+       * @param x The tile's column.
+       * @param y The tile's row.
+       * @param tile The tile index, one past the tileset cell it shows. Zero empties the tile.
+       */
+      void setTile( unsigned x, unsigned y, unsigned tile ) ;
+
+      /** Method to set the name to associate with the tile input.
+       * @param name The name to associate with the tile input.
+       */
+      void setTileInputName( const char* name ) ;
+
+      /** Method to set the source to stream the map from.
+       * @param source The reference to the tile source.
+       */
+      void setTileSourceRef( const nyx::TileSource& source ) ;
+
+      /** Method to set the name of the tile source input.
+       * @param name The name to associate with the tile source input.
+       */
+      void setTileSourceRefName( const char* name ) ;
+
+      /** Method to set the database texture the tiles are cut out of.
+       * @param id The id of the texture in the database.
+       */
+      void setTileset( unsigned id ) ;
+
+      /** Method to set the size of a single tile in the tileset.
+       * @param size The size of a tile, in pixels.
+       */
+      void setTileSize( unsigned size ) ;
+
+      /** Method to set the parent chain of this object.
+       * @param parent The chain to inherit from and to use for appending draw calls to.
+       */
+      void setParentRef( const nyx::Chain<Impl>& parent ) ;
+
+      /** Method to set the parent render pass of this object.
+       * @param parent The render pass to draw in.
+       */
+      void setParentPassRef( const nyx::RenderPass<Impl>& parent ) ;
+
+      /** Method to set the name of the parent reference input.
+       * @param name The name to associate with the parent input.
+       */
+      void setParentRefName( const char* name ) ;
+
+      /** Method to set the subpass of the parent render pass to draw in.
+       * @param index The index of the subpass.
+       */
+      void setSubpass( unsigned index ) ;
+
+      /** Method to set the name of the subpass input.
+       * @param name The name to associate with the subpass input.
+       */
+      void setSubpassName( const char* name ) ;
+
+      /** Method to set the reference to the view matrix to use when rendering the map.
+       * @param view The reference to the matrix used to represent a camera.
+       */
+      void setViewRef( const glm::mat4& view ) ;
+
+      /** Method to set the name to associate with the camera input.
+       * @param name The name to associate with the camera input.
+       */
+      void setViewRefName( const char* name ) ;
+
+      /** Method to set the reference to the projection matrix to use when rendering the map.
+       * @param proj The reference to the matrix used to represent the view frustum.
+       */
+      void setProjRef( const glm::mat4& proj ) ;
+
+      /** Method to set the name to associate with the projection input.
+       * @param name the name to associate with the projection input.
+       */
+      void setProjRefName( const char* name ) ;
+
+      /** Method to set the output name of this module.
+       * @param name The name to associate with this module's output.
+       */
+      void setOutRefName( const char* name ) ;
+
+      /** The function to use to signal when this module has finished.
+       */
+      void wait() ;
+
+      /** The function to use to signal when this module is to begin operation.
+       */
+      void signal() ;
+
+      /** Method to set then name of the input signal to signal when operation is finished.
+       * @param name The name of the signal to signal.
+       */
+      void setOutputName( const char* name ) ;
+
+      /** Method to set the name of the input width parameter.
+       * @param name The name to associate with the input.
+       */
+      void setInputNames( unsigned idx, const char* name ) ;
+
+      /** Method to set the device to use for this module's operations.
+       * @param device The device to set.
+       */
+      void setDevice( unsigned id ) ;
+    };
+    // </editor-fold>
+
+    // <editor-fold defaultstate="collapsed" desc="NyxDrawTilemapData Function Definitions">
+    void NyxDrawTilemapData::updateTextures()
+    {
+      this->lock.lock() ;
+      if( this->pipeline.initialized() )
+      {
+        Impl::deviceSynchronize( this->device ) ;
+        this->pipeline.bind( "textures", mars::TextureArray<Impl>::images(), mars::TextureArray<Impl>::count() ) ;
+        this->dirty_flag = true ;
+        Impl::deviceSynchronize( this->device ) ;
+      }
+      this->lock.unlock() ;
+    }
+
+    void NyxDrawTilemapData::redrawTilemap()
+    {
+      if( this->dirty_flag && this->draw_chain.initialized() && this->pipeline.initialized() )
+      {
+        // Every slot is drawn, the ones without a chunk collapse in the vertex shader. So this is recorded once and replayed every frame.
+        this->draw_chain.drawInstanced( nyx::TILEMAP_VISIBLE, this->pipeline, this->d_vertices ) ;
+
+        this->draw_chain.end() ;
+        this->dirty_flag = false ;
+        this->bus.emit() ;
+      }
+      else
+      {
+        this->draw_chain.advance() ;
+      }
+    }
+
+    void NyxDrawTilemapData::stream()
+    {
+      const glm::mat4 view = this->camera     ? *this->camera     : glm::mat4( 1.0f ) ;
+      const glm::mat4 proj = this->projection ? *this->projection : glm::mat4( 1.0f ) ;
+      const unsigned  size = nyx::TILEMAP_CHUNK * nyx::TILEMAP_CHUNK                ;
+
+      std::lock_guard<std::mutex> guard( this->lock ) ;
+
+      this->map.viewproj = proj * view ;
+      this->streamer.stream( this->map.viewproj ) ;
+
+      // Only the chunks streamed in this frame are uploaded, at most TILEMAP_UPLOADS of them no matter the size of the map.
+      for( unsigned index = 0; index < this->streamer.uploads().size(); index++ )
+      {
+        this->copy_chain.copy( this->streamer.tiles(), this->d_tiles, size, index * size, this->streamer.uploads()[ index ] * size ) ;
+      }
+
+      if( this->streamer.dirty() != 0 ) this->copy_chain.copy( this->streamer.chunks().data(), this->d_chunks, this->streamer.dirty(), 0, 0 ) ;
+
+      this->copy_chain.copy       ( &this->map, this->d_map ) ;
+      this->copy_chain.submit     () ;
+      this->copy_chain.synchronize() ;
+    }
+
+    void NyxDrawTilemapData::bindDraw()
+    {
+      this->pipeline.bind( "map"     , this->d_map    ) ;
+      this->pipeline.bind( "chunks"  , this->d_chunks ) ;
+      this->pipeline.bind( "tiles"   , this->d_tiles  ) ;
+      this->pipeline.bind( "textures", mars::TextureArray<Impl>::images(), mars::TextureArray<Impl>::count() ) ;
+    }
+
+    void NyxDrawTilemapData::parseTiles( const Token& token )
+    {
+      std::lock_guard<std::mutex> guard( this->lock ) ;
+
+      auto     width  = token[ "width"  ] ;
+      auto     height = token[ "height" ] ;
+      auto     tiles  = token[ "tiles"  ] ;
+      unsigned count  = 0                 ;
+
+      if( !width || !height ) return ;
+
+      this->grid.initialize( width.number(), height.number() ) ;
+
+      if( tiles )
+      {
+        count = std::min<unsigned>( tiles.size(), width.number() * height.number() ) ;
+        for( unsigned index = 0; index < count; index++ ) this->grid.set( index % width.number(), index / width.number(), tiles.number( index ) ) ;
+      }
+
+      Log::output( "Module ", this->name.c_str(), " set map of ", width.number(), "x", height.number(), " tiles with ", count, " set" ) ;
+
+      this->source = &this->grid ;
+      this->streamer.setSource( this->source ) ;
+    }
+
+    void NyxDrawTilemapData::setTile( unsigned x, unsigned y, unsigned tile )
+    {
+      std::lock_guard<std::mutex> guard( this->lock ) ;
+
+      if( this->source == &this->grid )
+      {
+        this->grid    .set       ( x, y, tile ) ;
+        this->streamer.invalidate( x, y       ) ;
+      }
+    }
+
+    void NyxDrawTilemapData::setTileInputName( const char* name )
+    {
+      Log::output( "Module ", this->name.c_str(), " set input tile signal as \"", name, "\"" ) ;
+      this->bus.enroll( this, &NyxDrawTilemapData::setTile, iris::OPTIONAL, name ) ;
+    }
+
+    void NyxDrawTilemapData::setTileSourceRef( const nyx::TileSource& source )
+    {
+      std::lock_guard<std::mutex> guard( this->lock ) ;
+
+      Log::output( "Module ", this->name.c_str(), " set input tile source reference as ", reinterpret_cast<const void*>( &source ) ) ;
+      this->source = &source ;
+      this->streamer.setSource( this->source ) ;
+    }
+
+    void NyxDrawTilemapData::setTileSourceRefName( const char* name )
+    {
+      Log::output( "Module ", this->name.c_str(), " set input tile source reference name as \"", name, "\"" ) ;
+      this->bus.enroll( this, &NyxDrawTilemapData::setTileSourceRef, iris::OPTIONAL, name ) ;
+    }
+
+    void NyxDrawTilemapData::setTileset( unsigned id )
+    {
+      Log::output( "Module ", this->name.c_str(), " set tileset as texture ", id ) ;
+      this->map.tileset = id ;
+    }
+
+    void NyxDrawTilemapData::setTileSize( unsigned size )
+    {
+      Log::output( "Module ", this->name.c_str(), " set tile size as ", size ) ;
+      this->map.tile_size = std::max( size, 1u ) ;
+    }
+
+    void NyxDrawTilemapData::setParentRef( const nyx::Chain<Impl>& parent )
+    {
+      Log::output( "Module ", this->name.c_str(), " set input parent chain reference as ", reinterpret_cast<const void*>( &parent ) ) ;
+      this->rebuild_chain = true ;
+      this->parent = &parent ;
+    }
+
+    void NyxDrawTilemapData::setParentPassRef( const nyx::RenderPass<Impl>& parent )
+    {
+      Log::output( "Module ", this->name.c_str(), " set input parent reference as ", reinterpret_cast<const void*>( &parent ) ) ;
+      this->parent_pass = &parent ;
+    }
+
+    void NyxDrawTilemapData::setParentRefName( const char* name )
+    {
+      Log::output( "Module ", this->name.c_str(), " set input parent reference name as \"", name, "\"" ) ;
+      this->bus.enroll( this, &NyxDrawTilemapData::setParentRef    , iris::OPTIONAL, name ) ;
+      this->bus.enroll( this, &NyxDrawTilemapData::setParentPassRef, iris::OPTIONAL, name ) ;
+    }
+
+    void NyxDrawTilemapData::setSubpass( unsigned index )
+    {
+      Log::output( "Module ", this->name.c_str(), " set input subpass as ", index ) ;
+      this->subpass = index ;
+    }
+
+    void NyxDrawTilemapData::setSubpassName( const char* name )
+    {
+      Log::output( "Module ", this->name.c_str(), " set input subpass signal as ", name ) ;
+      this->bus.enroll( this, &NyxDrawTilemapData::setSubpass, iris::OPTIONAL, name ) ;
+    }
+
+    void NyxDrawTilemapData::setViewRef( const glm::mat4& view )
+    {
+      Log::output( "Module ", this->name.c_str(), " set input camera reference as ", reinterpret_cast<const void*>( &view ) ) ;
+      this->camera = &view ;
+    }
+
+    void NyxDrawTilemapData::setViewRefName( const char* name )
+    {
+      Log::output( "Module ", this->name.c_str(), " set input camera reference name as \"", name, "\"" ) ;
+      this->bus.enroll( this, &NyxDrawTilemapData::setViewRef, iris::OPTIONAL, name ) ;
+    }
+
+    void NyxDrawTilemapData::setProjRef( const glm::mat4& proj )
+    {
+      Log::output( "Module ", this->name.c_str(), " set input projection reference as ", reinterpret_cast<const void*>( &proj ) ) ;
+      this->projection = &proj ;
+    }
+
+    void NyxDrawTilemapData::setProjRefName( const char* name )
+    {
+      Log::output( "Module ", this->name.c_str(), " set input projection reference name as \"", name, "\"" ) ;
+      this->bus.enroll( this, &NyxDrawTilemapData::setProjRef, iris::OPTIONAL, name ) ;
+    }
+
+    const nyx::Chain<Impl>& NyxDrawTilemapData::chain()
+    {
+      return this->draw_chain ;
+    }
+
+    void NyxDrawTilemapData::setOutRefName( const char* name )
+    {
+      Log::output( "Module ", this->name.c_str(), " set output reference as \"", name, "\"" ) ;
+      this->bus.publish( this, &NyxDrawTilemapData::chain, name ) ;
+    }
+
+    void NyxDrawTilemapData::wait()
+    {
+    }
+
+    void NyxDrawTilemapData::signal()
+    {
+    }
+
+    void NyxDrawTilemapData::setInputNames( unsigned idx, const char* name )
+    {
+      idx = idx ;
+      this->wait_and_publish.enroll( this, &NyxDrawTilemapData::wait, iris::REQUIRED, name ) ;
+    }
+
+    void NyxDrawTilemapData::setOutputName( const char* name )
+    {
+      this->wait_and_publish.publish( this, &NyxDrawTilemapData::signal, name ) ;
+    }
+
+    void NyxDrawTilemapData::setDevice( unsigned id )
+    {
+      Log::output( "Module ", this->name.c_str(), " set input device as ", id ) ;
+      this->device = id ;
+    }
+
+    NyxDrawTilemapData::NyxDrawTilemapData()
+    {
+      this->viewport.setWidth ( 1280 ) ;
+      this->viewport.setHeight( 1024 ) ;
+
+      this->map.viewproj     = glm::mat4( 1.0f ) ;
+      this->map.tileset      = 0                 ;
+      this->map.tile_size    = 16                ;
+      this->map.padding[ 0 ] = 0                 ;
+      this->map.padding[ 1 ] = 0                 ;
+
+      this->name          = ""      ;
+      this->device        = 0       ;
+      this->subpass       = 0       ;
+      this->source        = nullptr ;
+      this->parent_pass   = nullptr ;
+      this->parent        = nullptr ;
+      this->camera        = nullptr ;
+      this->projection    = nullptr ;
+      this->rebuild_chain = true    ;
+      this->dirty_flag    = true    ;
+
+      this->streamer.initialize() ;
+    }
+    // </editor-fold>
+
+    // <editor-fold defaultstate="collapsed" desc="NyxDrawTilemap Function Definitions">
+    NyxDrawTilemap::NyxDrawTilemap()
+    {
+      this->module_data = new NyxDrawTilemapData() ;
+    }
+
+    NyxDrawTilemap::~NyxDrawTilemap()
+    {
+      delete this->module_data ;
+    }
+
+    void NyxDrawTilemap::initialize()
+    {
+      const unsigned size = nyx::TILEMAP_CHUNK * nyx::TILEMAP_CHUNK ;
+
+      data().copy_chain.initialize( data().device, nyx::ChainType::Compute ) ;
+
+      // The cache is a fixed pool of chunk layers, so the memory used doesn't depend on the map either.
+      data().d_tiles   .initialize( data().device, data().streamer.layers() * size, false, nyx::ArrayFlags::StorageBuffer ) ;
+      data().d_chunks  .initialize( data().device, nyx::TILEMAP_VISIBLE         , false, nyx::ArrayFlags::StorageBuffer ) ;
+      data().d_vertices.initialize( data().device, 6                            , false, nyx::ArrayFlags::Vertex        ) ;
+      data().d_map     .initialize( data().device, 1                            , false, nyx::ArrayFlags::UniformBuffer ) ;
+
+      data().lock.lock() ;
+      data().copy_chain.copy( vkg::tilemap_vertices, data().d_vertices ) ;
+      data().copy_chain.submit() ;
+      data().copy_chain.synchronize() ;
+      data().lock.unlock() ;
+
+      data().draw_chain.setMode( nyx::ChainMode::All ) ;
+
+      mars::TextureArray<Impl>::addCallback( this->module_data, &NyxDrawTilemapData::updateTextures, this->name() ) ;
+    }
+
+    void NyxDrawTilemap::subscribe( unsigned id )
+    {
+      data().bus.setChannel( id ) ;
+      data().name = this->name() ;
+
+      data().bus.enroll( this->module_data, &NyxDrawTilemapData::setInputNames       , iris::OPTIONAL, this->name(), "::input"       ) ;
+      data().bus.enroll( this->module_data, &NyxDrawTilemapData::setOutputName       , iris::OPTIONAL, this->name(), "::output"      ) ;
+      data().bus.enroll( this->module_data, &NyxDrawTilemapData::setParentRefName    , iris::OPTIONAL, this->name(), "::parent"      ) ;
+      data().bus.enroll( this->module_data, &NyxDrawTilemapData::setSubpassName      , iris::OPTIONAL, this->name(), "::subpass"     ) ;
+      data().bus.enroll( this->module_data, &NyxDrawTilemapData::setViewRefName      , iris::OPTIONAL, this->name(), "::camera"      ) ;
+      data().bus.enroll( this->module_data, &NyxDrawTilemapData::setProjRefName      , iris::OPTIONAL, this->name(), "::projection"  ) ;
+      data().bus.enroll( this->module_data, &NyxDrawTilemapData::setTileset          , iris::OPTIONAL, this->name(), "::tileset"     ) ;
+      data().bus.enroll( this->module_data, &NyxDrawTilemapData::setTileSize         , iris::OPTIONAL, this->name(), "::tile_size"   ) ;
+      data().bus.enroll( this->module_data, &NyxDrawTilemapData::parseTiles          , iris::OPTIONAL, this->name(), "::tiles"       ) ;
+      data().bus.enroll( this->module_data, &NyxDrawTilemapData::setTileInputName    , iris::OPTIONAL, this->name(), "::tile_input"  ) ;
+      data().bus.enroll( this->module_data, &NyxDrawTilemapData::setTileSourceRefName, iris::OPTIONAL, this->name(), "::tile_source" ) ;
+      data().bus.enroll( this->module_data, &NyxDrawTilemapData::setOutRefName       , iris::OPTIONAL, this->name(), "::reference"   ) ;
+      data().bus.enroll( this->module_data, &NyxDrawTilemapData::setDevice           , iris::OPTIONAL, this->name(), "::device"      ) ;
+    }
+
+    void NyxDrawTilemap::shutdown()
+    {
+      Impl::deviceSynchronize( data().device ) ;
+
+      data().d_chunks  .reset() ;
+      data().d_tiles   .reset() ;
+      data().d_vertices.reset() ;
+      data().d_map     .reset() ;
+    }
+
+    void NyxDrawTilemap::execute()
+    {
+      data().wait_and_publish.wait() ;
+
+      data().stream() ;
+
+      if( data().parent != nullptr && data().rebuild_chain )
+      {
+        Log::output( "Module ", this->name(), " rebuilding chain" ) ;
+        data().rebuild_chain = false ;
+        data().draw_chain.initialize( *data().parent, data().subpass ) ;
+        data().dirty_flag = true ;
+      }
+
+      if( !data().pipeline.initialized() && data().parent_pass )
+      {
+        data().pipeline.addViewport( data().viewport ) ;
+        data().pipeline.setTestDepth( true ) ;
+        data().pipeline.initialize( *data().parent_pass, nyx::bytes::draw_tilemap, sizeof( nyx::bytes::draw_tilemap ) ) ;
+        data().lock.lock() ;
+        Impl::deviceSynchronize( data().device ) ;
+        data().bindDraw() ;
+        Impl::deviceSynchronize( data().device ) ;
+        data().lock.unlock() ;
+        data().dirty_flag = true ;
+      }
+
+      data().redrawTilemap() ;
+
+      data().wait_and_publish.emit() ;
+    }
+
+    NyxDrawTilemapData& NyxDrawTilemap::data()
+    {
+      return *this->module_data ;
+    }
+
+    const NyxDrawTilemapData& NyxDrawTilemap::data() const
+    {
+      return *this->module_data ;
+    }
+    // </editor-fold>
+  }
+}
+
+// <editor-fold defaultstate="collapsed" desc="Exported function definitions">
+/** Exported function to retrive the name of this module type.
+ * @return The name of this object's type.
+ */
+exported_function const char* name()
+{
+  return "NyxDrawTilemap" ;
+}
+
+/** Exported function to retrieve the version of this module.
+ * @return The version of this module.
+ */
+exported_function unsigned version()
+{
+  return VERSION ;
+}
+
+/** Exported function to make one instance of this module.
+ * @return A single instance of this module.
+ */
+exported_function ::iris::Module* make()
+{
+  return new nyx::vkg::NyxDrawTilemap() ;
+}
+
+/** Exported function to destroy an instance of this module.
+ * @param module A Pointer to a Module object that is of this type.
+ */
+exported_function void destroy( ::iris::Module* module )
+{
+  ::nyx::vkg::NyxDrawTilemap* mod ;
+
+  mod = dynamic_cast<nyx::vkg::NyxDrawTilemap*>( module ) ;
+  delete mod ;
+}
+// </editor-fold>
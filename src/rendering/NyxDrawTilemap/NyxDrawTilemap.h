@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2020 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <Iris/module/Module.h>
+
+namespace nyx
+{
+  namespace vkg
+  {
+    /** A module for drawing large 2D tile maps with a tileset from the database.
+     * Chunks around the camera are streamed from a tile source into a fixed cache on the device, and every visible chunk
+     * is drawn as a single quad whose tiles are looked up in the fragment shader.
+     */
+    class NyxDrawTilemap : public ::iris::Module
+    {
+      public:
+
+        /** Default Constructor.
+         */
+        NyxDrawTilemap() ;
+
+        /** Virtual deconstructor. Needed for inheritance.
+         */
+        ~NyxDrawTilemap() ;
+
+        /** Method to initialize this module after being configured.
+         */
+        void initialize() ;
+
+        /** Method to subscribe this module's configuration to the bus.
+         * @param id The id to use for this graph.
+         */
+        void subscribe( unsigned id ) ;
+
+        /** Method to shut down this object's operation.
+         */
+        void shutdown() ;
+
+        /** Method to execute a single instance of this module's operation.
+         */
+        void execute() ;
+
+      private:
+
+        /** Forward-declared structure to contain this object's internal data.
+         */
+        struct NyxDrawTilemapData *module_data ;
+
+        /** Method to retrieve a reference to this object's internal data.
+         * @return Reference to this object's internal data.
+         */
+        NyxDrawTilemapData& data() ;
+
+        /** Method to retrieve a const-reference to this object's internal data.
+         * @return Const-reference to this object's internal data.
+         */
+        const NyxDrawTilemapData& data() const ;
+    };
+  }
+}
@@ -0,0 +1,277 @@
+/*
+ * Copyright (C) 2020 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   Test.cpp
+ * Author: jhendl
+ *
+ * Created on April 17, 2021, 1:30 AM
+ */
+
+#include "NyxDrawTilemap.h"
+#include <templates/NyxTilemap.h>
+#include <glm/glm.hpp>
+#include <chrono>
+#include <iostream>
+#include <vector>
+#include <cmath>
+
+/** A map of 100k x 100k tiles made up on the spot, far too large to ever keep whole. Counts the chunks asked for.
+ */
+class ProceduralMap : public nyx::TileSource
+{
+  public:
+
+    static unsigned tile( unsigned x, unsigned y )
+    {
+      unsigned hash = x * 73856093u ^ y * 19349663u ;
+
+      return hash % 255 + 1 ;
+    }
+
+    unsigned width () const override { return 100000 ; }
+    unsigned height() const override { return 100000 ; }
+
+    void chunk( unsigned chunk_x, unsigned chunk_y, unsigned* tiles ) const override
+    {
+      for( unsigned row = 0; row < nyx::TILEMAP_CHUNK; row++ )
+      {
+        for( unsigned column = 0; column < nyx::TILEMAP_CHUNK; column++ )
+        {
+          const unsigned x = chunk_x * nyx::TILEMAP_CHUNK + column ;
+          const unsigned y = chunk_y * nyx::TILEMAP_CHUNK + row    ;
+
+          tiles[ row * nyx::TILEMAP_CHUNK + column ] = x < this->width() && y < this->height() ? tile( x, y ) : 0 ;
+        }
+      }
+
+      this->requests++ ;
+    }
+
+    mutable unsigned requests = 0 ;
+};
+
+/** Builds an orthographic projection looking straight down at the map.
+ */
+static glm::mat4 ortho( float left, float right, float bottom, float top )
+{
+  glm::mat4 proj( 1.0f ) ;
+
+  proj[ 0 ][ 0 ] =  2.0f / ( right - left )            ;
+  proj[ 1 ][ 1 ] =  2.0f / ( top - bottom )            ;
+  proj[ 3 ][ 0 ] = -( right + left ) / ( right - left ) ;
+  proj[ 3 ][ 1 ] = -( top + bottom ) / ( top - bottom ) ;
+
+  return proj ;
+}
+
+/** Copies whatever the streamer uploaded this frame into a host copy of the device's buffers.
+ */
+static void upload( const nyx::TileStreamer& streamer, std::vector<unsigned>& cache, std::vector<nyx::TileChunk>& chunks )
+{
+  const unsigned size = nyx::TILEMAP_CHUNK * nyx::TILEMAP_CHUNK ;
+
+  for( unsigned index = 0; index < streamer.uploads().size(); index++ )
+  {
+    std::copy( streamer.tiles() + index * size, streamer.tiles() + ( index + 1 ) * size, cache.begin() + streamer.uploads()[ index ] * size ) ;
+  }
+
+  std::copy( streamer.chunks().begin(), streamer.chunks().begin() + streamer.dirty(), chunks.begin() ) ;
+}
+
+/** Casts orthographic & perspective cameras onto the map, checking the rectangle of tiles they see.
+ */
+static bool testVisible()
+{
+  glm::vec2 low  ;
+  glm::vec2 high ;
+
+  if( !nyx::visibleTiles( ortho( 100.0f, 740.0f, 50.0f, 410.0f ), low, high ) ) return false ;
+  if( std::abs( low.x - 100.0f ) > 0.01f || std::abs( high.x - 740.0f ) > 0.01f ) return false ;
+  if( std::abs( low.y -  50.0f ) > 0.01f || std::abs( high.y - 410.0f ) > 0.01f ) return false ;
+
+  // A camera 100 tiles above (500, 300) with a 90 degree field of view sees 100 tiles to either side, times the aspect along x.
+  const float near   = 0.1f         ;
+  const float far    = 1000.0f      ;
+  const float aspect = 16.0f / 9.0f ;
+  glm::mat4   view   ( 1.0f )       ;
+  glm::mat4   proj   ( 1.0f )       ;
+
+  view[ 3 ][ 0 ] = -500.0f ;
+  view[ 3 ][ 1 ] = -300.0f ;
+  view[ 3 ][ 2 ] = -100.0f ;
+
+  proj[ 0 ][ 0 ] = 1.0f / aspect               ;
+  proj[ 1 ][ 1 ] = 1.0f                        ;
+  proj[ 2 ][ 2 ] = far / ( near - far )        ;
+  proj[ 2 ][ 3 ] = -1.0f                       ;
+  proj[ 3 ][ 2 ] = near * far / ( near - far ) ;
+  proj[ 3 ][ 3 ] = 0.0f                        ;
+
+  if( !nyx::visibleTiles( proj * view, low, high ) ) return false ;
+  if( std::abs( low.x - ( 500.0f - 100.0f * aspect ) ) > 0.5f || std::abs( high.x - ( 500.0f + 100.0f * aspect ) ) > 0.5f ) return false ;
+  if( std::abs( low.y - 200.0f ) > 0.5f || std::abs( high.y - 400.0f ) > 0.5f ) return false ;
+
+  return true ;
+}
+
+/** Pans a 1280 x 720 tile view across a 100k x 100k map, then jumps to the far corner. Every frame streams in at most
+ * the upload budget, and once caught up every chunk on screen is resident & holds exactly the tiles of the map.
+ */
+static bool testStreaming()
+{
+  constexpr unsigned FRAMES = 4000 ;
+  constexpr unsigned SPEED  = 8    ;
+  constexpr unsigned SIZE   = nyx::TILEMAP_CHUNK * nyx::TILEMAP_CHUNK ;
+
+  ProceduralMap               map                                    ;
+  nyx::TileStreamer           streamer                               ;
+  std::vector<unsigned>       cache   ( nyx::TILEMAP_LAYERS * SIZE ) ;
+  std::vector<nyx::TileChunk> chunks  ( nyx::TILEMAP_VISIBLE       ) ;
+  unsigned                    most    = 0                            ;
+  double                      first   = 0.0                          ;
+  double                      last    = 0.0                          ;
+
+  streamer.initialize() ;
+  streamer.setSource( &map ) ;
+
+  for( unsigned frame = 0; frame < FRAMES; frame++ )
+  {
+    // The last quarter is spent on the far side of the map, streaming it in from scratch.
+    const bool     jumped   = frame >= FRAMES * 3 / 4                                          ;
+    const float    x        = jumped ? 98000.0f : static_cast<float>( 50 + frame * SPEED )     ;
+    const float    y        = jumped ? 98500.0f : static_cast<float>( 70 + frame * SPEED / 2 ) ;
+    const unsigned requests = map.requests                                                     ;
+    auto           start    = std::chrono::high_resolution_clock::now()                        ;
+    const unsigned drawn    = streamer.stream( ortho( x, x + 1280.0f, y, y + 720.0f ) )        ;
+    const double   time     = std::chrono::duration<double, std::milli>( std::chrono::high_resolution_clock::now() - start ).count() ;
+
+    if( frame < 100                              ) first += time ;
+    if( frame >= FRAMES * 3 / 4 - 100 && !jumped ) last  += time ;
+
+    upload( streamer, cache, chunks ) ;
+    most = std::max<unsigned>( most, streamer.uploads().size() ) ;
+
+    if( streamer.uploads().size() > nyx::TILEMAP_UPLOADS || map.requests - requests != streamer.uploads().size() ) return false ;
+    if( streamer.resident() > streamer.layers() || drawn == 0 || drawn > nyx::TILEMAP_VISIBLE                      ) return false ;
+
+    // Give the cache time to fill after the first frame & after the jump.
+    const bool settled = ( frame > 40 && !jumped ) || frame > FRAMES * 3 / 4 + 40 ;
+
+    for( unsigned index = 0; index < nyx::TILEMAP_VISIBLE; index++ )
+    {
+      const nyx::TileChunk& chunk = chunks[ index ] ;
+
+      if( index >= drawn )
+      {
+        if( chunk.layer != nyx::NO_CHUNK ) return false ;
+        continue ;
+      }
+
+      if( chunk.layer == nyx::NO_CHUNK )
+      {
+        if( settled ) return false ;
+        continue ;
+      }
+
+      for( unsigned sample = 0; sample < 4; sample++ )
+      {
+        const unsigned column = ( sample * 37 + frame ) % nyx::TILEMAP_CHUNK ;
+        const unsigned row    = ( sample * 11 + frame ) % nyx::TILEMAP_CHUNK ;
+        const unsigned tile_x = static_cast<unsigned>( chunk.rect.x ) + column ;
+        const unsigned tile_y = static_cast<unsigned>( chunk.rect.y ) + row    ;
+
+        if( cache[ chunk.layer * SIZE + row * nyx::TILEMAP_CHUNK + column ] != ProceduralMap::tile( tile_x, tile_y ) ) return false ;
+      }
+    }
+  }
+
+  std::cout << "Streaming a 100000x100000 tile map, " << FRAMES << " frames: " << "\n"
+            << "-- Chunks streamed in             : " << map.requests << "\n"
+            << "-- Most chunks streamed a frame   : " << most         << "\n"
+            << "-- Host time per frame, first 100 : " << first / 100.0 << "ms" << "\n"
+            << "-- Host time per frame, last 100  : " << last  / 100.0 << "ms" << std::endl ;
+
+  return most <= nyx::TILEMAP_UPLOADS ;
+}
+
+/** Edits tiles of a small map kept whole, checking the edited chunk streams in again in place & the map's edges stay empty.
+ */
+static bool testEdits()
+{
+  constexpr unsigned SIZE = nyx::TILEMAP_CHUNK * nyx::TILEMAP_CHUNK ;
+
+  nyx::TileGrid               grid                                   ;
+  nyx::TileStreamer           streamer                               ;
+  std::vector<unsigned>       cache   ( nyx::TILEMAP_LAYERS * SIZE ) ;
+  std::vector<nyx::TileChunk> chunks  ( nyx::TILEMAP_VISIBLE       ) ;
+  const glm::mat4             camera  = ortho( 0.0f, 300.0f, 0.0f, 200.0f ) ;
+
+  grid.initialize( 300, 200 ) ;
+  for( unsigned y = 0; y < 200; y++ ) for( unsigned x = 0; x < 300; x++ ) grid.set( x, y, 1 + ( x + y ) % 4 ) ;
+
+  streamer.initialize( nyx::TILEMAP_LAYERS, nyx::TILEMAP_VISIBLE, 32 ) ;
+  streamer.setSource( &grid ) ;
+
+  // 5 x 4 chunks cover the whole map, with a budget big enough to stream them all in at once.
+  if( streamer.stream( camera ) != 20 ) return false ;
+  upload( streamer, cache, chunks ) ;
+
+  const unsigned corner = chunks[ 19 ].layer ;
+
+  if( corner == nyx::NO_CHUNK || cache[ corner * SIZE + 63 * nyx::TILEMAP_CHUNK + 63 ] != 0 ) return false ;
+  if( cache[ corner * SIZE + 7 * nyx::TILEMAP_CHUNK + 43 ] != 1 + ( 299 + 199 ) % 4       ) return false ;
+
+  grid    .set       ( 299, 199, 9 ) ;
+  streamer.invalidate( 299, 199    ) ;
+  streamer.invalidate( 298, 199    ) ;
+
+  streamer.stream( camera ) ;
+  upload( streamer, cache, chunks ) ;
+
+  if( streamer.uploads().size() != 1 || streamer.uploads()[ 0 ] != corner  ) return false ;
+  if( chunks[ 19 ].layer != corner                                          ) return false ;
+  if( cache[ corner * SIZE + 7 * nyx::TILEMAP_CHUNK + 43 ] != 9             ) return false ;
+
+  // Nothing changed, nothing is streamed.
+  streamer.stream( camera ) ;
+
+  return streamer.uploads().empty() ;
+}
+
+int main()
+{
+  if( !testVisible() )
+  {
+    std::cout << "Tilemap visibility test failed." << std::endl ;
+    return 1 ;
+  }
+
+  if( !testStreaming() )
+  {
+    std::cout << "Tilemap streaming test failed." << std::endl ;
+    return 1 ;
+  }
+
+  if( !testEdits() )
+  {
+    std::cout << "Tilemap edit test failed." << std::endl ;
+    return 1 ;
+  }
+
+  return 0 ;
+}
@@ -0,0 +1,847 @@
+/*
+ * Copyright (C) 2020 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   NyxParticles.cpp
+ * Author: Jordan Hendl
+ *
+ * Created on April 14, 2021, 6:58 PM
+ */
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+
+#include "NyxParticles.h"
+#include "draw_particles.h"
+#include "particle_emit.h"
+#include "particle_simulate.h"
+#include <Iris/data/Bus.h>
+#include <Iris/log/Log.h>
+#include <Iris/config/Parser.h>
+#include <NyxGPU/library/Array.h>
+#include <NyxGPU/library/Chain.h>
+#include <NyxGPU/vkg/Vulkan.h>
+#include <Mars/TextureArray.h>
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <climits>
+#include <mutex>
+#include <chrono>
+
+static const unsigned VERSION = 1 ;
+namespace nyx
+{
+  /** The amount of particles the pool holds unless configured otherwise.
+   */
+  constexpr unsigned PARTICLE_CAPACITY = 1 << 20 ;
+
+  /** The amount of emitters space is allocated for up front.
+   */
+  constexpr unsigned EMITTER_CAPACITY = 64 ;
+
+  /** The local size of the particle compute shaders.
+   */
+  constexpr unsigned PARTICLE_BLOCK = 64 ;
+
+  /** The longest step a single frame simulates, so a stall doesn't fling every particle away.
+   */
+  constexpr float MAX_DELTA = 0.1f ;
+
+  /** The texture of emitters that draw plain dots. Matches NO_TEXTURE in draw_particles.frag.glsl.
+   */
+  constexpr unsigned NO_TEXTURE = UINT_MAX ;
+
+  namespace vkg
+  {
+    /** Structure describing a single particle of the pool. Matches Particle in the particle shaders.
+     */
+    struct Particle
+    {
+      glm::vec4 position     ; ///< xyz is the position, w the age in seconds.
+      glm::vec4 velocity     ; ///< xyz is the velocity, w the lifetime in seconds.
+      unsigned  emitter      ;
+      unsigned  padding[ 3 ] ;
+    };
+
+    /** Structure describing an emitter as the shaders read it. Matches Emitter in the particle shaders.
+     */
+    struct Emitter
+    {
+      glm::vec4 position          = glm::vec4( 0.0f, 0.0f, 0.0f, 0.0f ) ; ///< xyz is the position, w the spread of the cone particles leave in, in radians.
+      glm::vec4 direction         = glm::vec4( 0.0f, 1.0f, 0.0f, 1.0f ) ; ///< xyz is the direction, w the speed.
+      glm::vec4 gravity           = glm::vec4( 0.0f, 0.0f, 0.0f, 0.0f ) ; ///< xyz is the acceleration, w the drag.
+      glm::vec4 color_start       = glm::vec4( 1.0f, 1.0f, 1.0f, 1.0f ) ;
+      glm::vec4 color_end         = glm::vec4( 1.0f, 1.0f, 1.0f, 0.0f ) ;
+      float     lifetime          = 1.0f                                ;
+      float     lifetime_variance = 0.0f                                ;
+      float     size_start        = 0.1f                                ;
+      float     size_end          = 0.1f                                ;
+      unsigned  texture           = NO_TEXTURE                          ;
+      unsigned  first_spawn       = 0                                   ; ///< This frame's spawns are one range, every emitter owns a slice of it.
+      unsigned  spawn_count       = 0                                   ;
+      unsigned  padding           = 0                                   ;
+    };
+
+    /** Structure describing how fast an emitter spawns. Only kept on the host.
+     */
+    struct EmitterRate
+    {
+      float rate  = 0.0f ; ///< The particles spawned per second.
+      float carry = 0.0f ; ///< The fraction of a particle left over from earlier frames.
+    };
+
+    /** Structure describing the indirect draw of the particles & the pool's bookkeeping. Matches Counters in the particle shaders.
+     * The first five members are a VkDrawIndexedIndirectCommand, filled in by the simulation every frame.
+     */
+    struct Counters
+    {
+      unsigned index_count      ;
+      unsigned instance_count   ;
+      unsigned first_index      ;
+      int      vertex_offset    ;
+      unsigned first_instance   ;
+      int      dead_count       ;
+      unsigned alive_count[ 2 ] ;
+    };
+
+    /** Structure describing the push constant of both particle compute shaders.
+     */
+    struct Step
+    {
+      float    delta         ;
+      unsigned seed          ;
+      unsigned current       ;
+      unsigned spawn_count   ;
+      unsigned capacity      ;
+      unsigned emitter_count ;
+    };
+
+    /** Structure describing the camera the particles are billboarded towards.
+     */
+    struct Camera
+    {
+      glm::mat4 view ;
+      glm::mat4 proj ;
+    };
+
+    /** The unit quad every particle is drawn with, the same one sprites use.
+     */
+    glm::vec4 particle_vertices[] =
+    {
+      glm::vec4( 0.0f, 1.0f, 0.0f, 0.0f ),
+      glm::vec4( 1.0f, 0.0f, 0.0f, 0.0f ),
+      glm::vec4( 0.0f, 0.0f, 0.0f, 0.0f ),
+      glm::vec4( 1.0f, 1.0f, 0.0f, 0.0f ),
+    };
+
+    unsigned particle_indices[] = { 0, 1, 2, 0, 3, 1 } ;
+
+    // <editor-fold defaultstate="collapsed" desc="Aliases">
+    using Log   = iris::log::Log            ;
+    using Impl  = nyx::vkg::Vulkan          ;
+    using Clock = std::chrono::steady_clock ;
+    using Token = iris::config::json::Token ;
+    // </editor-fold>
+
+    // <editor-fold defaultstate="collapsed" desc="NyxParticlesData Class & Function Declerations">
+    struct NyxParticlesData
+    {
+      nyx::Array<Impl, Particle >  d_particles       ;
+      nyx::Array<Impl, Emitter  >  d_emitters        ;
+      nyx::Array<Impl, Counters >  d_counters        ;
+      nyx::Array<Impl, unsigned >  d_dead            ;
+      nyx::Array<Impl, unsigned >  d_alive           ;
+      nyx::Array<Impl, glm::vec4>  d_vertices        ;
+      nyx::Array<Impl, unsigned >  d_indices         ;
+      nyx::Array<Impl, Camera   >  d_camera          ;
+      std::vector<Emitter>         emitters          ;
+      std::vector<EmitterRate>     rates             ;
+      nyx::Viewport                viewport          ;
+      Camera                       camera_data       ;
+      const glm::mat4*             camera            ;
+      const glm::mat4*             projection        ;
+      unsigned                     subpass           ;
+      nyx::Pipeline<Impl>          pipeline          ;
+      nyx::Pipeline<Impl>          emit_pipeline     ;
+      nyx::Pipeline<Impl>          simulate_pipeline ;
+      const nyx::Chain<Impl>*      parent            ;
+      const nyx::RenderPass<Impl>* parent_pass       ;
+      bool                         rebuild_chain     ;
+      nyx::Chain<Impl>             draw_chain        ;
+      nyx::Chain<Impl>             copy_chain        ;
+      nyx::Chain<Impl>             compute_chain     ;
+      unsigned                     device            ;
+      iris::Bus                    bus               ;
+      iris::Bus                    wait_and_publish  ;
+      std::string                  name              ;
+      bool                         dirty_flag        ;
+      bool                         emitters_grown    ;
+      bool                         pending           ;
+      std::mutex                   lock              ;
+      unsigned                     capacity          ;
+      unsigned                     current           ;
+      unsigned                     frame             ;
+      Clock::time_point            last              ;
+
+      /** Default constructor.
+       */
+      NyxParticlesData() ;
+
+      /** Method to rebind the textures after the database changed them.
+       */
+      void updateTextures() ;
+
+      /** Method to record the indirect draw of the particles. Only done when something it references changed.
+       */
+      void redrawParticles() ;
+
+      /** Method to record the upload of the camera the particles are billboarded towards.
+       */
+      void syncCamera() ;
+
+      /** Method to spawn this frame's particles & advance every living one, compacting the survivors for drawing.
+       */
+      void simulate() ;
+
+      /** Method to bind the pool's buffers to both compute pipelines.
+       */
+      void bindCompute() ;
+
+      /** Method to bind the pool's buffers & the textures to the draw pipeline.
+       */
+      void bindDraw() ;
+
+      /** Method to retrieve the const chain from this object.
+       * @return The const reference to this object's chain object.
+       */
+      const nyx::Chain<Impl>& chain() ;
+
+      /** Method to parse the emitters of this module.
+       * @param token The token to parse.
+       */
+      void parseEmitters( const Token& token ) ;
+
+      /** Method to move an emitter.
+       * @param index The index of the emitter to move.
+       * @param position The new position of the emitter.
+       */
+      void setEmitterPosition( unsigned index, const glm::vec3& position ) ;
+
+      /** Method to change how fast an emitter spawns. A rate of zero stops it, leaving it's living particles be.
+       * @param index The index of the emitter to change.
+       * @param rate The particles spawned per second.
+       */
+      void setEmitterRate( unsigned index, float rate ) ;
+
+      /** Method to set the name to associate with the emitter input.
+       * @param name The name to associate with the emitter input.
+       */
+      void setEmitterInputName( const char* name ) ;
+
+      /** Method to set the amount of particles the pool holds. Only read when initializing.
+       * @param capacity The most particles alive at once.
+       */
+      void setCapacity( unsigned capacity ) ;
+
+      /** Method to set the parent chain of this object.
+       * @param parent The chain to inherit from and to use for appending draw calls to.
+       */
+      void setParentRef( const nyx::Chain<Impl>& parent ) ;
+
+      /** Method to set the parent render pass of this object.
+       * @param parent The render pass to draw in.
+       */
+      void setParentPassRef( const nyx::RenderPass<Impl>& parent ) ;
+
+      /** Method to set the name of the parent reference input.
+       * @param name The name to associate with the parent input.
+       */
+      void setParentRefName( const char* name ) ;
+
+      /** Method to set the subpass of the parent render pass to draw in.
+       * @param index The index of the subpass.
+       */
+      void setSubpass( unsigned index ) ;
+
+      /** Method to set the name of the subpass input.
+       * @param name The name to associate with the subpass input.
+       */
+      void setSubpassName( const char* name ) ;
+
+      /** Method to set the reference to the view matrix to use when rendering particles.
+       * @param view The reference to the matrix used to represent a camera.
+       */
+      void setViewRef( const glm::mat4& view ) ;
+
+      /** Method to set the name to associate with the camera input.
+       * @param name The name to associate with the camera input.
+       */
+      void setViewRefName( const char* name ) ;
+
+      /** Method to set the reference to the projection matrix to use when rendering particles.
+       * @param proj The reference to the matrix used to represent the view frustum.
+       */
+      void setProjRef( const glm::mat4& proj ) ;
+
+      /** Method to set the name to associate with the projection input.
+       * @param name the name to associate with the projection input.
+       */
+      void setProjRefName( const char* name ) ;
+
+      /** Method to set the output name of this module.
+       * @param name The name to associate with this module's output.
+       */
+      void setOutRefName( const char* name ) ;
+
+      /** The function to use to signal when this module has finished.
+       */
+      void wait() ;
+
+      /** The function to use to signal when this module is to begin operation.
+       */
+      void signal() ;
+
+      /** Method to set then name of the input signal to signal when operation is finished.
+       * @param name The name of the signal to signal.
+       */
+      void setOutputName( const char* name ) ;
+
+      /** Method to set the name of the input width parameter.
+       * @param name The name to associate with the input.
+       */
+      void setInputNames( unsigned idx, const char* name ) ;
+
+      /** Method to set the device to use for this module's operations.
+       * @param device The device to set.
+       */
+      void setDevice( unsigned id ) ;
+    };
+    // </editor-fold>
+
+    // <editor-fold defaultstate="collapsed" desc="NyxParticlesData Function Definitions">
+    void NyxParticlesData::updateTextures()
+    {
+      this->lock.lock() ;
+      if( this->pipeline.initialized() )
+      {
+        Impl::deviceSynchronize( this->device ) ;
+        this->pipeline.bind( "textures", mars::TextureArray<Impl>::images(), mars::TextureArray<Impl>::count() ) ;
+        this->dirty_flag = true ;
+        Impl::deviceSynchronize( this->device ) ;
+      }
+      this->lock.unlock() ;
+    }
+
+    void NyxParticlesData::redrawParticles()
+    {
+      if( this->dirty_flag && this->draw_chain.initialized() && this->pipeline.initialized() )
+      {
+        // The simulation fills in the instance count & first instance, so this is recorded once and replayed every frame.
+        this->draw_chain.drawIndexedIndirect( this->pipeline, this->d_indices, this->d_vertices, this->d_counters, 0, 1 ) ;
+
+        this->draw_chain.end() ;
+        this->dirty_flag = false ;
+        this->bus.emit() ;
+      }
+      else
+      {
+        this->draw_chain.advance() ;
+      }
+    }
+
+    void NyxParticlesData::syncCamera()
+    {
+      this->camera_data.view = this->camera     ? *this->camera     : glm::mat4( 1.0f ) ;
+      this->camera_data.proj = this->projection ? *this->projection : glm::mat4( 1.0f ) ;
+
+      this->compute_chain.copy( &this->camera_data, this->d_camera ) ;
+    }
+
+    void NyxParticlesData::simulate()
+    {
+      const Clock::time_point now    = Clock::now()                                                                    ;
+      const float             delta  = std::min( std::chrono::duration<float>( now - this->last ).count(), MAX_DELTA ) ;
+      Step                    step                                                                                     ;
+      unsigned                spawns = 0                                                                               ;
+
+      this->last = now ;
+
+      this->lock.lock() ;
+
+      // The last step was submitted a frame ago, so this only waits if the device is that far behind.
+      if( this->pending )
+      {
+        this->compute_chain.synchronize() ;
+        this->pending = false ;
+      }
+
+      // Emitters configured after initialization may not fit anymore. The draw reads them too, so it is recorded again.
+      if( this->emitters_grown )
+      {
+        Impl::deviceSynchronize( this->device ) ;
+        this->d_emitters.reset() ;
+        this->d_emitters.initialize( this->device, std::max<std::size_t>( this->emitters.size(), EMITTER_CAPACITY ), false, nyx::ArrayFlags::StorageBuffer ) ;
+        this->bindCompute() ;
+        if( this->pipeline.initialized() ) this->bindDraw() ;
+        Impl::deviceSynchronize( this->device ) ;
+
+        this->emitters_grown = false ;
+        this->dirty_flag     = true  ;
+      }
+
+      // Every emitter owns a slice of this frame's spawns. Past the pool's capacity the rest of the frame's spawns are dropped.
+      for( unsigned index = 0; index < this->emitters.size(); index++ )
+      {
+        const unsigned count = nyx::particleSpawns( this->rates[ index ].rate, delta, this->rates[ index ].carry ) ;
+
+        this->emitters[ index ].first_spawn = spawns                                       ;
+        this->emitters[ index ].spawn_count = std::min( count, this->capacity - spawns ) ;
+        spawns += this->emitters[ index ].spawn_count ;
+      }
+
+      step.delta         = delta                     ;
+      step.seed          = this->frame * 0x9E3779B9u ;
+      step.current       = this->current             ;
+      step.spawn_count   = spawns                    ;
+      step.capacity      = this->capacity            ;
+      step.emitter_count = this->emitters.size()     ;
+
+      // Uploads, both passes & the frame's draw all go to the graphics queue, so barriers order them & the step is never waited on here.
+      this->compute_chain.begin() ;
+
+      // The previous frame may still be drawing from the buffers this step writes.
+      this->compute_chain.barrier() ;
+      if( !this->emitters.empty() ) this->compute_chain.copy( this->emitters.data(), this->d_emitters, this->emitters.size(), 0, 0 ) ;
+      this->syncCamera() ;
+      this->compute_chain.barrier() ;
+
+      // The emit pass always runs, it also empties the list the simulation is about to fill.
+      this->compute_chain.push    ( this->emit_pipeline, step ) ;
+      this->compute_chain.dispatch( this->emit_pipeline, std::max( 1u, ( spawns + PARTICLE_BLOCK - 1 ) / PARTICLE_BLOCK ), 1 ) ;
+      this->compute_chain.barrier () ;
+
+      // The living count stays on the GPU, so the whole pool is dispatched & groups past it leave after one read.
+      this->compute_chain.push    ( this->simulate_pipeline, step ) ;
+      this->compute_chain.dispatch( this->simulate_pipeline, ( this->capacity + PARTICLE_BLOCK - 1 ) / PARTICLE_BLOCK, 1 ) ;
+
+      // Orders the simulation before the parent's frame draws the particles.
+      this->compute_chain.barrier() ;
+      this->compute_chain.submit () ;
+      this->pending = true ;
+
+      this->lock.unlock() ;
+
+      this->current = 1 - this->current ;
+      this->frame++ ;
+    }
+
+    void NyxParticlesData::bindCompute()
+    {
+      this->emit_pipeline    .bind( "particles", this->d_particles ) ;
+      this->emit_pipeline    .bind( "emitters" , this->d_emitters  ) ;
+      this->emit_pipeline    .bind( "counters" , this->d_counters  ) ;
+      this->emit_pipeline    .bind( "dead"     , this->d_dead      ) ;
+      this->emit_pipeline    .bind( "alive"    , this->d_alive     ) ;
+      this->simulate_pipeline.bind( "particles", this->d_particles ) ;
+      this->simulate_pipeline.bind( "emitters" , this->d_emitters  ) ;
+      this->simulate_pipeline.bind( "counters" , this->d_counters  ) ;
+      this->simulate_pipeline.bind( "dead"     , this->d_dead      ) ;
+      this->simulate_pipeline.bind( "alive"    , this->d_alive     ) ;
+    }
+
+    void NyxParticlesData::bindDraw()
+    {
+      this->pipeline.bind( "projection", this->d_camera    ) ;
+      this->pipeline.bind( "particles" , this->d_particles ) ;
+      this->pipeline.bind( "emitters"  , this->d_emitters  ) ;
+      this->pipeline.bind( "alive"     , this->d_alive     ) ;
+      this->pipeline.bind( "textures"  , mars::TextureArray<Impl>::images(), mars::TextureArray<Impl>::count() ) ;
+    }
+
+    void NyxParticlesData::parseEmitters( const Token& token )
+    {
+      std::lock_guard<std::mutex> guard( this->lock ) ;
+
+      this->emitters.clear() ;
+      this->rates   .clear() ;
+
+      for( unsigned index = 0; index < token.size(); index++ )
+      {
+        auto        emitter_token     = token.token( index )                 ;
+        auto        position          = emitter_token[ "position"          ] ;
+        auto        direction         = emitter_token[ "direction"         ] ;
+        auto        spread            = emitter_token[ "spread"            ] ;
+        auto        speed             = emitter_token[ "speed"             ] ;
+        auto        rate              = emitter_token[ "rate"              ] ;
+        auto        lifetime          = emitter_token[ "lifetime"          ] ;
+        auto        lifetime_variance = emitter_token[ "lifetime_variance" ] ;
+        auto        gravity           = emitter_token[ "gravity"           ] ;
+        auto        drag              = emitter_token[ "drag"              ] ;
+        auto        size_start        = emitter_token[ "size_start"        ] ;
+        auto        size_end          = emitter_token[ "size_end"          ] ;
+        auto        color_start       = emitter_token[ "color_start"       ] ;
+        auto        color_end         = emitter_token[ "color_end"         ] ;
+        auto        texture           = emitter_token[ "texture"           ] ;
+        Emitter     emitter                                                  ;
+        EmitterRate emitter_rate                                             ;
+
+        if( position          ) emitter.position          = glm::vec4( position .decimal( 0 ), position .decimal( 1 ), position .decimal( 2 ), 0.0f ) ;
+        if( direction         ) emitter.direction         = glm::vec4( glm::normalize( glm::vec3( direction.decimal( 0 ), direction.decimal( 1 ), direction.decimal( 2 ) ) ), 1.0f ) ;
+        if( gravity           ) emitter.gravity           = glm::vec4( gravity  .decimal( 0 ), gravity  .decimal( 1 ), gravity  .decimal( 2 ), 0.0f ) ;
+        if( color_start       ) emitter.color_start       = glm::vec4( color_start.decimal( 0 ), color_start.decimal( 1 ), color_start.decimal( 2 ), color_start.decimal( 3 ) ) ;
+        if( color_end         ) emitter.color_end         = glm::vec4( color_end  .decimal( 0 ), color_end  .decimal( 1 ), color_end  .decimal( 2 ), color_end  .decimal( 3 ) ) ;
+        if( spread            ) emitter.position.w        = glm::radians( spread.decimal() ) ;
+        if( speed             ) emitter.direction.w       = speed            .decimal() ;
+        if( drag              ) emitter.gravity.w         = drag             .decimal() ;
+        if( lifetime          ) emitter.lifetime          = lifetime         .decimal() ;
+        if( lifetime_variance ) emitter.lifetime_variance = lifetime_variance.decimal() ;
+        if( size_start        ) emitter.size_start        = size_start       .decimal() ;
+        if( size_end          ) emitter.size_end          = size_end         .decimal() ;
+        if( texture           ) emitter.texture           = texture          .number () ;
+        if( rate              ) emitter_rate.rate         = rate             .decimal() ;
+
+        Log::output( "Module ", this->name.c_str(), " added emitter ", index, " spawning ", emitter_rate.rate, " particles per second" ) ;
+
+        this->emitters.push_back( emitter      ) ;
+        this->rates   .push_back( emitter_rate ) ;
+      }
+
+      // Before initialization the buffer is simply made big enough, see NyxParticles::initialize.
+      if( this->emitters.size() > this->d_emitters.size() ) this->emitters_grown = true ;
+    }
+
+    void NyxParticlesData::setEmitterPosition( unsigned index, const glm::vec3& position )
+    {
+      std::lock_guard<std::mutex> guard( this->lock ) ;
+
+      if( index < this->emitters.size() ) this->emitters[ index ].position = glm::vec4( position, this->emitters[ index ].position.w ) ;
+    }
+
+    void NyxParticlesData::setEmitterRate( unsigned index, float rate )
+    {
+      std::lock_guard<std::mutex> guard( this->lock ) ;
+
+      if( index < this->rates.size() ) this->rates[ index ].rate = rate ;
+    }
+
+    void NyxParticlesData::setEmitterInputName( const char* name )
+    {
+      Log::output( "Module ", this->name.c_str(), " set input emitter signal as \"", name, "\"" ) ;
+      this->bus.enroll( this, &NyxParticlesData::setEmitterPosition, iris::OPTIONAL, name ) ;
+      this->bus.enroll( this, &NyxParticlesData::setEmitterRate    , iris::OPTIONAL, name ) ;
+    }
+
+    void NyxParticlesData::setCapacity( unsigned capacity )
+    {
+      Log::output( "Module ", this->name.c_str(), " set particle capacity as ", capacity ) ;
+      this->capacity = std::max( capacity, PARTICLE_BLOCK ) ;
+    }
+
+    void NyxParticlesData::setParentRef( const nyx::Chain<Impl>& parent )
+    {
+      Log::output( "Module ", this->name.c_str(), " set input parent chain reference as ", reinterpret_cast<const void*>( &parent ) ) ;
+      this->rebuild_chain = true ;
+      this->parent = &parent ;
+    }
+
+    void NyxParticlesData::setParentPassRef( const nyx::RenderPass<Impl>& parent )
+    {
+      Log::output( "Module ", this->name.c_str(), " set input parent reference as ", reinterpret_cast<const void*>( &parent ) ) ;
+      this->parent_pass = &parent ;
+    }
+
+    void NyxParticlesData::setParentRefName( const char* name )
+    {
+      Log::output( "Module ", this->name.c_str(), " set input parent reference name as \"", name, "\"" ) ;
+      this->bus.enroll( this, &NyxParticlesData::setParentRef    , iris::OPTIONAL, name ) ;
+      this->bus.enroll( this, &NyxParticlesData::setParentPassRef, iris::OPTIONAL, name ) ;
+    }
+
+    void NyxParticlesData::setSubpass( unsigned index )
+    {
+      Log::output( "Module ", this->name.c_str(), " set input subpass as ", index ) ;
+      this->subpass = index ;
+    }
+
+    void NyxParticlesData::setSubpassName( const char* name )
+    {
+      Log::output( "Module ", this->name.c_str(), " set input subpass signal as ", name ) ;
+      this->bus.enroll( this, &NyxParticlesData::setSubpass, iris::OPTIONAL, name ) ;
+    }
+
+    void NyxParticlesData::setViewRef( const glm::mat4& view )
+    {
+      Log::output( "Module ", this->name.c_str(), " set input camera reference as ", reinterpret_cast<const void*>( &view ) ) ;
+      this->camera = &view ;
+    }
+
+    void NyxParticlesData::setViewRefName( const char* name )
+    {
+      Log::output( "Module ", this->name.c_str(), " set input camera reference name as \"", name, "\"" ) ;
+      this->bus.enroll( this, &NyxParticlesData::setViewRef, iris::OPTIONAL, name ) ;
+    }
+
+    void NyxParticlesData::setProjRef( const glm::mat4& proj )
+    {
+      Log::output( "Module ", this->name.c_str(), " set input projection reference as ", reinterpret_cast<const void*>( &proj ) ) ;
+      this->projection = &proj ;
+    }
+
+    void NyxParticlesData::setProjRefName( const char* name )
+    {
+      Log::output( "Module ", this->name.c_str(), " set input projection reference name as \"", name, "\"" ) ;
+      this->bus.enroll( this, &NyxParticlesData::setProjRef, iris::OPTIONAL, name ) ;
+    }
+
+    const nyx::Chain<Impl>& NyxParticlesData::chain()
+    {
+      return this->draw_chain ;
+    }
+
+    void NyxParticlesData::setOutRefName( const char* name )
+    {
+      Log::output( "Module ", this->name.c_str(), " set output reference as \"", name, "\"" ) ;
+      this->bus.publish( this, &NyxParticlesData::chain, name ) ;
+    }
+
+    void NyxParticlesData::wait()
+    {
+    }
+
+    void NyxParticlesData::signal()
+    {
+    }
+
+    void NyxParticlesData::setInputNames( unsigned idx, const char* name )
+    {
+      idx = idx ;
+      this->wait_and_publish.enroll( this, &NyxParticlesData::wait, iris::REQUIRED, name ) ;
+    }
+
+    void NyxParticlesData::setOutputName( const char* name )
+    {
+      this->wait_and_publish.publish( this, &NyxParticlesData::signal, name ) ;
+    }
+
+    void NyxParticlesData::setDevice( unsigned id )
+    {
+      Log::output( "Module ", this->name.c_str(), " set input device as ", id ) ;
+      this->device = id ;
+    }
+
+    NyxParticlesData::NyxParticlesData()
+    {
+      this->viewport.setWidth ( 1280 ) ;
+      this->viewport.setHeight( 1024 ) ;
+
+      this->name           = ""                ;
+      this->device         = 0                 ;
+      this->subpass        = 0                 ;
+      this->parent_pass    = nullptr           ;
+      this->parent         = nullptr           ;
+      this->camera         = nullptr           ;
+      this->projection     = nullptr           ;
+      this->rebuild_chain  = true              ;
+      this->dirty_flag     = true              ;
+      this->emitters_grown = false             ;
+      this->pending        = false             ;
+      this->capacity       = PARTICLE_CAPACITY ;
+      this->current        = 0                 ;
+      this->frame          = 0                 ;
+      this->last           = Clock::now()      ;
+    }
+    // </editor-fold>
+
+    // <editor-fold defaultstate="collapsed" desc="NyxParticles Function Definitions">
+    NyxParticles::NyxParticles()
+    {
+      this->module_data = new NyxParticlesData() ;
+    }
+
+    NyxParticles::~NyxParticles()
+    {
+      delete this->module_data ;
+    }
+
+    void NyxParticles::initialize()
+    {
+      const unsigned        capacity = data().capacity ;
+      std::vector<unsigned> dead     ( capacity )      ;
+      Counters              counters                   ;
+
+      // Every particle starts out dead, and the draw starts out empty.
+      for( unsigned index = 0; index < capacity; index++ ) dead[ index ] = index ;
+
+      counters.index_count      = 6                            ;
+      counters.instance_count   = 0                            ;
+      counters.first_index      = 0                            ;
+      counters.vertex_offset    = 0                            ;
+      counters.first_instance   = 0                            ;
+      counters.dead_count       = static_cast<int>( capacity ) ;
+      counters.alive_count[ 0 ] = 0                            ;
+      counters.alive_count[ 1 ] = 0                            ;
+
+      data().copy_chain   .initialize( data().device, nyx::ChainType::Compute  ) ;
+      data().compute_chain.initialize( data().device, nyx::ChainType::Graphics ) ;
+
+      data().d_particles.initialize( data().device, capacity    , false, nyx::ArrayFlags::StorageBuffer                            ) ;
+      data().d_counters .initialize( data().device, 1           , false, nyx::ArrayFlags::StorageBuffer | nyx::ArrayFlags::Indirect ) ;
+      data().d_dead     .initialize( data().device, capacity    , false, nyx::ArrayFlags::StorageBuffer                            ) ;
+      data().d_alive    .initialize( data().device, capacity * 2, false, nyx::ArrayFlags::StorageBuffer                            ) ;
+      data().d_vertices .initialize( data().device, 4           , false, nyx::ArrayFlags::Vertex                                   ) ;
+      data().d_indices  .initialize( data().device, 6           , false, nyx::ArrayFlags::Index                                    ) ;
+      data().d_camera   .initialize( data().device, 1           , false, nyx::ArrayFlags::UniformBuffer                            ) ;
+      data().d_emitters .initialize( data().device, std::max<std::size_t>( data().emitters.size(), EMITTER_CAPACITY ), false, nyx::ArrayFlags::StorageBuffer ) ;
+      data().emitters_grown = false ;
+
+      data().emit_pipeline    .initialize( data().device, nyx::bytes::particle_emit    , sizeof( nyx::bytes::particle_emit     ) ) ;
+      data().simulate_pipeline.initialize( data().device, nyx::bytes::particle_simulate, sizeof( nyx::bytes::particle_simulate ) ) ;
+
+      data().lock.lock() ;
+      data().copy_chain.copy( dead.data()           , data().d_dead     ) ;
+      data().copy_chain.copy( &counters             , data().d_counters ) ;
+      data().copy_chain.copy( vkg::particle_vertices, data().d_vertices ) ;
+      data().copy_chain.copy( vkg::particle_indices , data().d_indices  ) ;
+      data().copy_chain.submit() ;
+      data().copy_chain.synchronize() ;
+
+      Impl::deviceSynchronize( data().device ) ;
+      data().bindCompute() ;
+      Impl::deviceSynchronize( data().device ) ;
+      data().lock.unlock() ;
+
+      data().draw_chain.setMode( nyx::ChainMode::All ) ;
+      data().last = Clock::now() ;
+
+      mars::TextureArray<Impl>::addCallback( this->module_data, &NyxParticlesData::updateTextures, this->name() ) ;
+    }
+
+    void NyxParticles::subscribe( unsigned id )
+    {
+      data().bus.setChannel( id ) ;
+      data().name = this->name() ;
+
+      data().bus.enroll( this->module_data, &NyxParticlesData::setInputNames      , iris::OPTIONAL, this->name(), "::input"         ) ;
+      data().bus.enroll( this->module_data, &NyxParticlesData::setOutputName      , iris::OPTIONAL, this->name(), "::output"        ) ;
+      data().bus.enroll( this->module_data, &NyxParticlesData::setParentRefName   , iris::OPTIONAL, this->name(), "::parent"        ) ;
+      data().bus.enroll( this->module_data, &NyxParticlesData::setSubpassName     , iris::OPTIONAL, this->name(), "::subpass"       ) ;
+      data().bus.enroll( this->module_data, &NyxParticlesData::setViewRefName     , iris::OPTIONAL, this->name(), "::camera"        ) ;
+      data().bus.enroll( this->module_data, &NyxParticlesData::setProjRefName     , iris::OPTIONAL, this->name(), "::projection"    ) ;
+      data().bus.enroll( this->module_data, &NyxParticlesData::parseEmitters      , iris::OPTIONAL, this->name(), "::emitters"      ) ;
+      data().bus.enroll( this->module_data, &NyxParticlesData::setEmitterInputName, iris::OPTIONAL, this->name(), "::emitter_input" ) ;
+      data().bus.enroll( this->module_data, &NyxParticlesData::setCapacity        , iris::OPTIONAL, this->name(), "::capacity"      ) ;
+      data().bus.enroll( this->module_data, &NyxParticlesData::setOutRefName      , iris::OPTIONAL, this->name(), "::reference"     ) ;
+      data().bus.enroll( this->module_data, &NyxParticlesData::setDevice          , iris::OPTIONAL, this->name(), "::device"        ) ;
+    }
+
+    void NyxParticles::shutdown()
+    {
+      Impl::deviceSynchronize( data().device ) ;
+
+      data().d_particles.reset() ;
+      data().d_emitters .reset() ;
+      data().d_counters .reset() ;
+      data().d_dead     .reset() ;
+      data().d_alive    .reset() ;
+      data().d_vertices .reset() ;
+      data().d_indices  .reset() ;
+      data().d_camera   .reset() ;
+    }
+
+    void NyxParticles::execute()
+    {
+      data().wait_and_publish.wait() ;
+
+      data().simulate() ;
+
+      if( data().parent != nullptr && data().rebuild_chain )
+      {
+        Log::output( "Module ", this->name(), " rebuilding chain" ) ;
+        data().rebuild_chain = false ;
+        data().draw_chain.initialize( *data().parent, data().subpass ) ;
+        data().dirty_flag = true ;
+      }
+
+      if( !data().pipeline.initialized() && data().parent_pass )
+      {
+        data().pipeline.addViewport( data().viewport ) ;
+        data().pipeline.setTestDepth( true ) ;
+        data().pipeline.initialize( *data().parent_pass, nyx::bytes::draw_particles, sizeof( nyx::bytes::draw_particles ) ) ;
+        data().lock.lock() ;
+        Impl::deviceSynchronize( data().device ) ;
+        data().bindDraw() ;
+        Impl::deviceSynchronize( data().device ) ;
+        data().lock.unlock() ;
+        data().dirty_flag = true ;
+      }
+
+      data().redrawParticles() ;
+
+      data().wait_and_publish.emit() ;
+    }
+
+    NyxParticlesData& NyxParticles::data()
+    {
+      return *this->module_data ;
+    }
+
+    const NyxParticlesData& NyxParticles::data() const
+    {
+      return *this->module_data ;
+    }
+    // </editor-fold>
+  }
+}
+
+// <editor-fold defaultstate="collapsed" desc="Exported function definitions">
+/** Exported function to retrive the name of this module type.
+ * @return The name of this object's type.
+ */
+exported_function const char* name()
+{
+  return "NyxParticles" ;
+}
+
+/** Exported function to retrieve the version of this module.
+ * @return The version of this module.
+ */
+exported_function unsigned version()
+{
+  return VERSION ;
+}
+
+/** Exported function to make one instance of this module.
+ * @return A single instance of this module.
+ */
+exported_function ::iris::Module* make()
+{
+  return new nyx::vkg::NyxParticles() ;
+}
+
+/** Exported function to destroy an instance of this module.
+ * @param module A Pointer to a Module object that is of this type.
+ */
+exported_function void destroy( ::iris::Module* module )
+{
+  ::nyx::vkg::NyxParticles* mod ;
+
+  mod = dynamic_cast<nyx::vkg::NyxParticles*>( module ) ;
+  delete mod ;
+}
+// </editor-fold>
@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2020 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <Iris/module/Module.h>
+
+namespace nyx
+{
+  /** Function to compute how many particles an emitter spawns this frame, carrying the fraction over to the next one.
+   * @param rate The particles spawned per second.
+   * @param delta The seconds since the last frame.
+   * @param carry The fraction of a particle left over from earlier frames. Updated in place.
+   * @return The amount of whole particles to spawn.
+   */
+  inline unsigned particleSpawns( float rate, float delta, float& carry )
+  {
+    const float    total = carry + ( rate > 0.0f ? rate * delta : 0.0f ) ;
+    const unsigned whole = static_cast<unsigned>( total )                ;
+
+    carry = total - static_cast<float>( whole ) ;
+
+    return whole ;
+  }
+
+  namespace vkg
+  {
+    /** A module for simulating & drawing particles entirely on the GPU.
+     * Emitters are configured in JSON, and the simulated particles are drawn as instanced quads with one indirect draw.
+     */
+    class NyxParticles : public ::iris::Module
+    {
+      public:
+
+        /** Default Constructor.
+         */
+        NyxParticles() ;
+
+        /** Virtual deconstructor. Needed for inheritance.
+         */
+        ~NyxParticles() ;
+
+        /** Method to initialize this module after being configured.
+         */
+        void initialize() ;
+
+        /** Method to subscribe this module's configuration to the bus.
+         * @param id The id to use for this graph.
+         */
+        void subscribe( unsigned id ) ;
+
+        /** Method to shut down this object's operation.
+         */
+        void shutdown() ;
+
+        /** Method to execute a single instance of this module's operation.
+         */
+        void execute() ;
+
+      private:
+
+        /** Forward-declared structure to contain this object's internal data.
+         */
+        struct NyxParticlesData *module_data ;
+
+        /** Method to retrieve a reference to this object's internal data.
+         * @return Reference to this object's internal data.
+         */
+        NyxParticlesData& data() ;
+
+        /** Method to retrieve a const-reference to this object's internal data.
+         * @return Const-reference to this object's internal data.
+         */
+        const NyxParticlesData& data() const ;
+    };
+  }
+}
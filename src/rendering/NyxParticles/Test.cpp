@@ -0,0 +1,174 @@
+/*
+ * Copyright (C) 2020 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   Test.cpp
+ * Author: jhendl
+ *
+ * Created on April 17, 2021, 1:30 AM
+ */
+
+#include "NyxParticles.h"
+#include <chrono>
+#include <iostream>
+#include <vector>
+#include <algorithm>
+
+/** Spawns from fractional rates over many frames, checking nothing is lost to rounding.
+ */
+static bool testSpawns()
+{
+  constexpr unsigned FRAMES = 6000 ;
+
+  const float rates[] = { 0.5f, 7.0f, 90.0f, 1000000.0f } ;
+
+  for( auto rate : rates )
+  {
+    float    carry = 0.0f ;
+    unsigned total = 0    ;
+
+    for( unsigned frame = 0; frame < FRAMES; frame++ ) total += nyx::particleSpawns( rate, 1.0f / 60.0f, carry ) ;
+
+    // Whatever is left is carried, so the total is at most a particle short, give or take the rounding of rate * delta.
+    const float expected = rate * FRAMES / 60.0f   ;
+    const float slack    = 1.0f + expected * 1e-6f ;
+
+    if( total > expected + slack || total + slack < expected ) return false ;
+  }
+
+  float carry = 0.0f ;
+  return nyx::particleSpawns( -10.0f, 1.0f, carry ) == 0 && carry == 0.0f ;
+}
+
+/** Runs the emit & simulate passes on the host the way the compute shaders do, group by group, on a pool of 1M particles.
+ * Spawns outrun the pool, so the dead list runs dry. Every particle has to end up in exactly one of the lists every frame.
+ */
+static bool testPool()
+{
+  constexpr unsigned CAPACITY = 1 << 20 ;
+  constexpr unsigned BLOCK    = 64      ;
+  constexpr unsigned FRAMES   = 12      ;
+  constexpr unsigned SPAWNS   = 300000  ;
+
+  std::vector<float>    age      ( CAPACITY, 0.0f ) ;
+  std::vector<float>    lifetime ( CAPACITY, 0.0f ) ;
+  std::vector<unsigned> dead     ( CAPACITY       ) ;
+  std::vector<unsigned> alive    ( CAPACITY * 2   ) ;
+  std::vector<unsigned> seen     ( CAPACITY       ) ;
+  unsigned              alive_count[ 2 ] = { 0, 0 } ;
+  unsigned              instances        = 0        ;
+  int                   dead_count       = CAPACITY ;
+  unsigned              current          = 0        ;
+  unsigned              dropped          = 0        ;
+  double                time             = 0.0      ;
+
+  for( unsigned index = 0; index < CAPACITY; index++ ) dead[ index ] = index ;
+
+  for( unsigned frame = 0; frame < FRAMES; frame++ )
+  {
+    const unsigned next  = 1 - current                               ;
+    auto           start = std::chrono::high_resolution_clock::now() ;
+
+    // Emit pass.
+    instances           = 0 ;
+    alive_count[ next ] = 0 ;
+
+    for( unsigned index = 0; index < SPAWNS; index++ )
+    {
+      const int slot = --dead_count ;
+
+      if( slot < 0 ) { dead_count++ ; dropped++ ; continue ; }
+
+      age     [ dead[ slot ] ] = 0.0f                                   ;
+      lifetime[ dead[ slot ] ] = 1.0f + static_cast<float>( index % 8 ) ;
+      alive   [ current * CAPACITY + alive_count[ current ]++ ] = dead[ slot ] ;
+    }
+
+    // Simulate pass, compacting every group's survivors & dead with one reservation each.
+    for( unsigned group = 0; group < CAPACITY / BLOCK; group++ )
+    {
+      unsigned ids   [ BLOCK ] ;
+      bool     living[ BLOCK ] ;
+      unsigned group_alive = 0 ;
+      unsigned group_dead  = 0 ;
+      unsigned active      = 0 ;
+
+      for( unsigned local = 0; local < BLOCK; local++ )
+      {
+        const unsigned index = group * BLOCK + local ;
+
+        if( index >= alive_count[ current ] ) break ;
+
+        ids   [ local ]         = alive[ current * CAPACITY + index ]             ;
+        age   [ ids[ local ] ] += 1.0f                                           ;
+        living[ local ]         = age[ ids[ local ] ] < lifetime[ ids[ local ] ] ;
+        active++ ;
+
+        if( living[ local ] ) group_alive++ ;
+        else                  group_dead++  ;
+      }
+
+      if( active == 0 ) continue ;
+
+      unsigned alive_base = alive_count[ next ] ; alive_count[ next ] += group_alive ; instances += group_alive ;
+      unsigned dead_base  = dead_count          ; dead_count          += group_dead  ;
+
+      for( unsigned local = 0; local < active; local++ )
+      {
+        if( living[ local ] ) alive[ next * CAPACITY + alive_base++ ] = ids[ local ] ;
+        else                  dead [ dead_base++                    ] = ids[ local ] ;
+      }
+    }
+
+    time += std::chrono::duration<double, std::milli>( std::chrono::high_resolution_clock::now() - start ).count() ;
+
+    // Every particle is either alive or dead, never both & never lost.
+    std::fill( seen.begin(), seen.end(), 0 ) ;
+    for( unsigned index = 0; index < alive_count[ next ]; index++ ) seen[ alive[ next * CAPACITY + index ] ]++ ;
+    for( int      index = 0; index < dead_count         ; index++ ) seen[ dead[ index ]                      ]++ ;
+
+    if( instances != alive_count[ next ] || alive_count[ next ] + dead_count != CAPACITY ) return false ;
+    if( std::any_of( seen.begin(), seen.end(), [] ( unsigned count ) { return count != 1 ; } ) ) return false ;
+
+    current = next ;
+  }
+
+  std::cout << "Particle pool of " << CAPACITY << ", " << SPAWNS << " spawns a frame: " << "\n"
+            << "-- Alive after " << FRAMES << " frames   : " << alive_count[ current ] << "\n"
+            << "-- Spawns dropped          : " << dropped                << "\n"
+            << "-- Host emulation per frame : " << time / FRAMES << "ms" << std::endl ;
+
+  // The pool has to have run dry & kept spawning into the particles that died since.
+  return dropped != 0 && alive_count[ current ] > CAPACITY / 2 ;
+}
+
+int main()
+{
+  if( !testSpawns() )
+  {
+    std::cout << "Particle spawn test failed." << std::endl ;
+    return 1 ;
+  }
+
+  if( !testPool() )
+  {
+    std::cout << "Particle pool test failed." << std::endl ;
+    return 1 ;
+  }
+
+  return 0 ;
+}
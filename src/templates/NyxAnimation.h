@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2020 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <cmath>
+
+#if defined( __SSE2__ ) || defined( _M_X64 )
+  #include <emmintrin.h>
+  #define NYX_ANIMATION_SSE
+#endif
+
+namespace nyx
+{
+  /** Structure describing a bulk update of consecutive drawable transformations, sent once per frame instead of one event per drawable.
+   */
+  struct TransformBatch
+  {
+    unsigned         first      ; ///< The id of the first drawable to update.
+    unsigned         count      ; ///< The amount of drawables to update.
+    const glm::mat4* transforms ; ///< The transformations, one per drawable.
+  };
+
+  /** Structure describing a bulk update of the bone palettes of consecutive drawables.
+   */
+  struct PaletteBatch
+  {
+    unsigned         first    ; ///< The id of the first drawable to update.
+    unsigned         count    ; ///< The amount of drawables to update.
+    unsigned         bones    ; ///< The amount of bones in each drawable's palette.
+    const glm::mat4* palettes ; ///< The palettes, packed one after the other.
+  };
+
+  /** Structure of four quaternions stored component by component, so they can be processed together.
+   */
+  struct QuaternionLanes
+  {
+    alignas( 16 ) float x[ 4 ] ;
+    alignas( 16 ) float y[ 4 ] ;
+    alignas( 16 ) float z[ 4 ] ;
+    alignas( 16 ) float w[ 4 ] ;
+  };
+
+  /** Function to interpolate between two rotations.
+   * Approximates slerp with a corrected nlerp, which avoids the trigonometry and stays within a thousandth of a radian of the exact result.
+   * @param a The rotation at t = 0.
+   * @param b The rotation at t = 1.
+   * @param t The interpolation factor.
+   * @return The normalized interpolated rotation, taking the shortest path.
+   */
+  inline glm::quat fastSlerp( const glm::quat& a, const glm::quat& b, float t ) ;
+
+  /** Function to interpolate four pairs of rotations at once. Uses SSE when available.
+   * @param a The rotations at t = 0.
+   * @param b The rotations at t = 1.
+   * @param t The interpolation factor of each pair.
+   * @param out The lanes to write the interpolated rotations to.
+   */
+  inline void fastSlerp4( const QuaternionLanes& a, const QuaternionLanes& b, const float* t, QuaternionLanes& out ) ;
+
+  glm::quat fastSlerp( const glm::quat& a, const glm::quat& b, float t )
+  {
+    const float cos_angle = glm::dot( a, b )                                                ;
+    const float sign      = cos_angle < 0.0f ? -1.0f : 1.0f                                 ;
+    const float d         = std::fabs( cos_angle )                                          ;
+    const float fa        = 1.0904f   + d * ( -3.2452f  + d * ( 3.55645f - d * 1.43519f ) ) ;
+    const float fb        = 0.848013f + d * ( -1.06021f + d * 0.215638f )                   ;
+    const float k         = fa * ( t - 0.5f ) * ( t - 0.5f ) + fb                           ;
+    const float ot        = t + t * ( t - 0.5f ) * ( t - 1.0f ) * k                         ;
+
+    return glm::normalize( a * ( 1.0f - ot ) + b * ( ot * sign ) ) ;
+  }
+
+  void fastSlerp4( const QuaternionLanes& a, const QuaternionLanes& b, const float* t, QuaternionLanes& out )
+  {
+#ifdef NYX_ANIMATION_SSE
+    const __m128 sign_bit = _mm_set1_ps( -0.0f ) ;
+    const __m128 half     = _mm_set1_ps( 0.5f  ) ;
+    const __m128 one      = _mm_set1_ps( 1.0f  ) ;
+
+    const __m128 ax = _mm_load_ps( a.x ), ay = _mm_load_ps( a.y ), az = _mm_load_ps( a.z ), aw = _mm_load_ps( a.w ) ;
+    const __m128 bx = _mm_load_ps( b.x ), by = _mm_load_ps( b.y ), bz = _mm_load_ps( b.z ), bw = _mm_load_ps( b.w ) ;
+    const __m128 tt = _mm_loadu_ps( t ) ;
+
+    const __m128 cos_angle = _mm_add_ps( _mm_add_ps( _mm_mul_ps( ax, bx ), _mm_mul_ps( ay, by ) ), _mm_add_ps( _mm_mul_ps( az, bz ), _mm_mul_ps( aw, bw ) ) ) ;
+    const __m128 sign      = _mm_and_ps   ( cos_angle, sign_bit ) ;
+    const __m128 d         = _mm_andnot_ps( sign_bit , cos_angle ) ;
+
+    // fa = 1.0904 + d * ( -3.2452 + d * ( 3.55645 - d * 1.43519 ) )
+    __m128 fa = _mm_sub_ps( _mm_set1_ps( 3.55645f ), _mm_mul_ps( d, _mm_set1_ps( 1.43519f ) ) ) ;
+    fa = _mm_add_ps( _mm_set1_ps( -3.2452f ), _mm_mul_ps( d, fa ) ) ;
+    fa = _mm_add_ps( _mm_set1_ps( 1.0904f  ), _mm_mul_ps( d, fa ) ) ;
+
+    // fb = 0.848013 + d * ( -1.06021 + d * 0.215638 )
+    __m128 fb = _mm_add_ps( _mm_set1_ps( -1.06021f ), _mm_mul_ps( d, _mm_set1_ps( 0.215638f ) ) ) ;
+    fb = _mm_add_ps( _mm_set1_ps( 0.848013f ), _mm_mul_ps( d, fb ) ) ;
+
+    const __m128 centered = _mm_sub_ps( tt, half ) ;
+    const __m128 k        = _mm_add_ps( _mm_mul_ps( fa, _mm_mul_ps( centered, centered ) ), fb ) ;
+    const __m128 ot       = _mm_add_ps( tt, _mm_mul_ps( _mm_mul_ps( tt, centered ), _mm_mul_ps( _mm_sub_ps( tt, one ), k ) ) ) ;
+    const __m128 wa       = _mm_sub_ps( one, ot ) ;
+    const __m128 wb       = _mm_xor_ps( ot , sign ) ;
+
+    __m128 rx = _mm_add_ps( _mm_mul_ps( ax, wa ), _mm_mul_ps( bx, wb ) ) ;
+    __m128 ry = _mm_add_ps( _mm_mul_ps( ay, wa ), _mm_mul_ps( by, wb ) ) ;
+    __m128 rz = _mm_add_ps( _mm_mul_ps( az, wa ), _mm_mul_ps( bz, wb ) ) ;
+    __m128 rw = _mm_add_ps( _mm_mul_ps( aw, wa ), _mm_mul_ps( bw, wb ) ) ;
+
+    const __m128 length = _mm_sqrt_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( rx, rx ), _mm_mul_ps( ry, ry ) ), _mm_add_ps( _mm_mul_ps( rz, rz ), _mm_mul_ps( rw, rw ) ) ) ) ;
+
+    _mm_store_ps( out.x, _mm_div_ps( rx, length ) ) ;
+    _mm_store_ps( out.y, _mm_div_ps( ry, length ) ) ;
+    _mm_store_ps( out.z, _mm_div_ps( rz, length ) ) ;
+    _mm_store_ps( out.w, _mm_div_ps( rw, length ) ) ;
+#else
+    for( unsigned lane = 0; lane < 4; lane++ )
+    {
+      const glm::quat result = fastSlerp( glm::quat( a.w[ lane ], a.x[ lane ], a.y[ lane ], a.z[ lane ] ),
+                                          glm::quat( b.w[ lane ], b.x[ lane ], b.y[ lane ], b.z[ lane ] ), t[ lane ] ) ;
+
+      out.x[ lane ] = result.x ;
+      out.y[ lane ] = result.y ;
+      out.z[ lane ] = result.z ;
+      out.w[ lane ] = result.w ;
+    }
+#endif
+  }
+}
@@ -0,0 +1,518 @@
+/*
+ * Copyright (C) 2020 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <NyxGPU/library/Array.h>
+#include <NyxGPU/library/Image.h>
+#include <NyxGPU/library/Chain.h>
+#include <glm/glm.hpp>
+#include <unordered_map>
+#include <vector>
+#include <mutex>
+#include <algorithm>
+#include <climits>
+
+namespace nyx
+{
+  /** The width & height of a single atlas page, in pixels.
+   */
+  constexpr unsigned ATLAS_PAGE_SIZE = 2048 ;
+
+  /** The default amount of pages, the layers of the atlas image.
+   */
+  constexpr unsigned ATLAS_PAGES = 2 ;
+
+  /** The default amount of pixels around every packed image, filled with it's edge pixels so filtering never picks up a neighbour.
+   */
+  constexpr unsigned ATLAS_PADDING = 2 ;
+
+  /** Structure describing where an image was packed into an atlas.
+   */
+  struct AtlasRect
+  {
+    glm::vec4 region ; ///< The image's rectangle in normalized coordinates of it's page. xy is the offset, zw the size.
+    unsigned  page   ; ///< The page, or layer of the atlas image, the image was packed into.
+    unsigned  x      ; ///< The image's first column on the page, in pixels. Padding excluded.
+    unsigned  y      ; ///< The image's first row on the page, in pixels. Padding excluded.
+    unsigned  width  ; ///< The width of the image, in pixels.
+    unsigned  height ; ///< The height of the image, in pixels.
+  };
+
+  /** Structure describing an RGBA8 image on the host to add to an atlas.
+   */
+  struct AtlasImage
+  {
+    unsigned             id     ; ///< The id to look the image up by.
+    const unsigned char* pixels ; ///< The image's pixels, four bytes each, row by row.
+    unsigned             width  ; ///< The width of the image, in pixels.
+    unsigned             height ; ///< The height of the image, in pixels.
+  };
+
+  /** Rectangle packer keeping only the skyline, the top edge of everything packed so far.
+   * Every rectangle is placed where it's top ends lowest, which keeps the skyline flat and wastes little space under it.
+   */
+  class SkylinePacker
+  {
+    public:
+
+      /** Constructor.
+       * @param width The width of the area to pack into.
+       * @param height The height of the area to pack into.
+       */
+      SkylinePacker( unsigned width = ATLAS_PAGE_SIZE, unsigned height = ATLAS_PAGE_SIZE ) ;
+
+      /** Method to empty this packer.
+       * @param width The width of the area to pack into.
+       * @param height The height of the area to pack into.
+       */
+      void reset( unsigned width, unsigned height ) ;
+
+      /** Method to find space for a rectangle & claim it.
+       * @param width The width of the rectangle.
+       * @param height The height of the rectangle.
+       * @param x The column the rectangle was placed at.
+       * @param y The row the rectangle was placed at.
+       * @return Whether the rectangle fit.
+       */
+      bool pack( unsigned width, unsigned height, unsigned& x, unsigned& y ) ;
+
+      /** Method to retrieve the part of the area covered by packed rectangles.
+       * @return The covered area over the whole area, from 0 to 1.
+       */
+      float occupancy() const ;
+
+    private:
+
+      /** Structure describing one horizontal run of the skyline.
+       */
+      struct Segment
+      {
+        unsigned x     ;
+        unsigned y     ;
+        unsigned width ;
+      };
+
+      /** Method to find the lowest a rectangle can be placed with it's left edge at a segment.
+       * @param index The segment to start at.
+       * @param width The width of the rectangle.
+       * @param height The height of the rectangle.
+       * @param top The row the rectangle would be placed at.
+       * @return Whether the rectangle fits there.
+       */
+      bool fit( unsigned index, unsigned width, unsigned height, unsigned& top ) const ;
+
+      std::vector<Segment> skyline ;
+      unsigned             width   ;
+      unsigned             height  ;
+      unsigned long long   used    ;
+  };
+
+  /** The host side of an atlas: packs images into pages & keeps their pixels, with every image's edges bled into it's padding.
+   * Safe to add to & look up from any thread.
+   */
+  class AtlasPages
+  {
+    public:
+
+      /** Default constructor.
+       */
+      AtlasPages() ;
+
+      /** Method to initialize this object's pages.
+       * @param size The width & height of every page, in pixels.
+       * @param pages The most pages this atlas can fill.
+       * @param padding The amount of pixels to bleed around every image.
+       */
+      void initialize( unsigned size = ATLAS_PAGE_SIZE, unsigned pages = ATLAS_PAGES, unsigned padding = ATLAS_PADDING ) ;
+
+      /** Method to pack an image into the atlas & copy it's pixels.
+       * Adding an id again with the same size overwrites it in place, otherwise it is packed anew.
+       * @param image The image to add.
+       * @return Whether the image fit into one of the pages.
+       */
+      bool add( const AtlasImage& image ) ;
+
+      /** Method to look up where an image was packed.
+       * @param id The id the image was added with.
+       * @param rect The rectangle to write to.
+       * @return Whether the image is in the atlas.
+       */
+      bool find( unsigned id, AtlasRect& rect ) const ;
+
+      /** Method to retrieve the width & height of every page.
+       * @return The size of a page, in pixels.
+       */
+      unsigned size() const ;
+
+      /** Method to retrieve the most pages this atlas can fill.
+       * @return The amount of layers of the atlas.
+       */
+      unsigned pages() const ;
+
+      /** Method to retrieve the amount of images packed.
+       * @return The amount of images in this atlas.
+       */
+      unsigned count() const ;
+
+      /** Method to retrieve the part of a page covered by images, padding included.
+       * @param page The page to check.
+       * @return The covered area over the page's area, from 0 to 1.
+       */
+      float occupancy( unsigned page ) const ;
+
+      /** Method to retrieve the pixels of a page.
+       * @param page The page to retrieve.
+       * @return The first of the page's size * size RGBA8 pixels.
+       */
+      const unsigned char* pixels( unsigned page ) const ;
+
+    protected:
+
+      /** Method to copy an image to it's rectangle, extruding it's edge pixels over the padding.
+       * @param image The image to copy.
+       * @param rect The rectangle to copy it to.
+       */
+      void blit( const AtlasImage& image, const AtlasRect& rect ) ;
+
+      using RectMap = std::unordered_map<unsigned, AtlasRect> ;
+
+      std::vector<unsigned char> host_pixels ;
+      std::vector<SkylinePacker> packers     ;
+      std::vector<bool>          dirty       ;
+      RectMap                    rects       ;
+      mutable std::mutex         lock        ;
+      unsigned                   page_size   ;
+      unsigned                   padding     ;
+  };
+
+  /** An atlas of many small images packed into the layers of one image, so everything sampling it can be drawn in one batch.
+   * Images are added on the host and uploaded once per frame, only the pages they touched.
+   */
+  template<typename Framework>
+  class Atlas : public AtlasPages
+  {
+    public:
+
+      /** Method to initialize this atlas's pages & it's image on the device.
+       * @param device The device to allocate the atlas image on.
+       * @param size The width & height of every page, in pixels.
+       * @param pages The amount of pages, allocated up front as layers of the atlas image.
+       * @param padding The amount of pixels to bleed around every image.
+       */
+      void initialize( unsigned device, unsigned size = ATLAS_PAGE_SIZE, unsigned pages = ATLAS_PAGES, unsigned padding = ATLAS_PADDING ) ;
+
+      /** Method to record the upload of every page changed since the last upload. The chain still has to be submitted.
+       * @param chain The chain to record the upload to.
+       * @return Whether anything was recorded.
+       */
+      bool upload( nyx::Chain<Framework>& chain ) ;
+
+      /** Method to retrieve the atlas image, with one layer per page.
+       * @return Reference to the atlas image.
+       */
+      const nyx::Image<Framework>& image() const ;
+
+      /** Method to release this atlas's device memory.
+       */
+      void reset() ;
+
+    private:
+      nyx::Array<Framework, unsigned char> staging     ;
+      nyx::Image<Framework>                atlas_image ;
+  };
+
+  inline SkylinePacker::SkylinePacker( unsigned width, unsigned height )
+  {
+    this->reset( width, height ) ;
+  }
+
+  inline void SkylinePacker::reset( unsigned width, unsigned height )
+  {
+    this->width  = width  ;
+    this->height = height ;
+    this->used   = 0      ;
+
+    this->skyline.assign( 1, { 0, 0, width } ) ;
+  }
+
+  inline bool SkylinePacker::fit( unsigned index, unsigned width, unsigned height, unsigned& top ) const
+  {
+    unsigned remaining = width ;
+
+    if( this->skyline[ index ].x + width > this->width ) return false ;
+
+    top = 0 ;
+    for( unsigned segment = index; remaining > 0; segment++ )
+    {
+      top        = std::max( top, this->skyline[ segment ].y )             ;
+      remaining -= std::min( remaining, this->skyline[ segment ].width ) ;
+
+      if( top + height > this->height ) return false ;
+    }
+
+    return true ;
+  }
+
+  inline bool SkylinePacker::pack( unsigned width, unsigned height, unsigned& x, unsigned& y )
+  {
+    unsigned best        = UINT_MAX ;
+    unsigned best_bottom = UINT_MAX ;
+    unsigned best_width  = UINT_MAX ;
+    unsigned top                    ;
+
+    if( width == 0 || height == 0 ) return false ;
+
+    // Lowest resulting top wins, ties go to the narrowest segment so wide gaps stay open for wide rectangles.
+    for( unsigned index = 0; index < this->skyline.size(); index++ )
+    {
+      if( !this->fit( index, width, height, top ) ) continue ;
+
+      if( top + height < best_bottom || ( top + height == best_bottom && this->skyline[ index ].width < best_width ) )
+      {
+        best        = index                           ;
+        best_bottom = top + height                    ;
+        best_width  = this->skyline[ index ].width    ;
+        x           = this->skyline[ index ].x        ;
+        y           = top                             ;
+      }
+    }
+
+    if( best == UINT_MAX ) return false ;
+
+    this->skyline.insert( this->skyline.begin() + best, { x, y + height, width } ) ;
+
+    // Cut the segments now under the rectangle.
+    for( unsigned index = best + 1; index < this->skyline.size(); )
+    {
+      Segment&       segment = this->skyline[ index     ] ;
+      const Segment& prev    = this->skyline[ index - 1 ] ;
+      const unsigned end     = prev.x + prev.width        ;
+
+      if( segment.x >= end ) break ;
+
+      if( segment.x + segment.width <= end )
+      {
+        this->skyline.erase( this->skyline.begin() + index ) ;
+        continue ;
+      }
+
+      segment.width -= end - segment.x ;
+      segment.x      = end             ;
+      break ;
+    }
+
+    for( unsigned index = 0; index + 1 < this->skyline.size(); )
+    {
+      if( this->skyline[ index ].y == this->skyline[ index + 1 ].y )
+      {
+        this->skyline[ index ].width += this->skyline[ index + 1 ].width ;
+        this->skyline.erase( this->skyline.begin() + index + 1 ) ;
+      }
+      else
+      {
+        index++ ;
+      }
+    }
+
+    this->used += static_cast<unsigned long long>( width ) * height ;
+
+    return true ;
+  }
+
+  inline float SkylinePacker::occupancy() const
+  {
+    return static_cast<float>( static_cast<double>( this->used ) / ( static_cast<double>( this->width ) * this->height ) ) ;
+  }
+
+  inline AtlasPages::AtlasPages()
+  {
+    this->page_size = 0 ;
+    this->padding   = 0 ;
+  }
+
+  inline void AtlasPages::initialize( unsigned size, unsigned pages, unsigned padding )
+  {
+    std::lock_guard<std::mutex> guard( this->lock ) ;
+
+    this->page_size = size    ;
+    this->padding   = padding ;
+
+    this->host_pixels.assign( static_cast<std::size_t>( size ) * size * 4 * pages, 0 ) ;
+    this->packers    .assign( pages, SkylinePacker( size, size ) ) ;
+    this->dirty      .assign( pages, true                        ) ;
+    this->rects      .clear() ;
+  }
+
+  inline bool AtlasPages::add( const AtlasImage& image )
+  {
+    std::lock_guard<std::mutex> guard( this->lock ) ;
+
+    const unsigned padded_width  = image.width  + 2 * this->padding ;
+    const unsigned padded_height = image.height + 2 * this->padding ;
+    auto           iter          = this->rects.find( image.id )     ;
+    AtlasRect      rect                                             ;
+    unsigned       x                                                ;
+    unsigned       y                                                ;
+
+    if( iter != this->rects.end() && iter->second.width == image.width && iter->second.height == image.height )
+    {
+      this->blit( image, iter->second ) ;
+      return true ;
+    }
+
+    for( unsigned page = 0; page < this->packers.size(); page++ )
+    {
+      if( !this->packers[ page ].pack( padded_width, padded_height, x, y ) ) continue ;
+
+      const float scale = 1.0f / this->page_size ;
+
+      rect.page   = page                 ;
+      rect.x      = x + this->padding    ;
+      rect.y      = y + this->padding    ;
+      rect.width  = image.width          ;
+      rect.height = image.height         ;
+      rect.region = glm::vec4( rect.x * scale, rect.y * scale, rect.width * scale, rect.height * scale ) ;
+
+      this->blit( image, rect ) ;
+      this->rects[ image.id ] = rect ;
+
+      return true ;
+    }
+
+    return false ;
+  }
+
+  inline void AtlasPages::blit( const AtlasImage& image, const AtlasRect& rect )
+  {
+    const std::size_t    row_size = static_cast<std::size_t>( this->page_size ) * 4                  ;
+    unsigned char*       page     = this->host_pixels.data() + row_size * this->page_size * rect.page ;
+    const int            pad      = static_cast<int>( this->padding )                                ;
+    const int            width    = static_cast<int>( rect.width  )                                  ;
+    const int            height   = static_cast<int>( rect.height )                                  ;
+
+    // Every padding pixel takes the closest edge pixel, so linear filtering & mipmaps at the border stay inside the image.
+    for( int row = -pad; row < height + pad; row++ )
+    {
+      const int            source_row = std::min( std::max( row, 0 ), height - 1 )                               ;
+      const unsigned char* source     = image.pixels + static_cast<std::size_t>( source_row ) * rect.width * 4 ;
+      unsigned char*       dest       = page + ( rect.y + row ) * row_size + ( rect.x - pad ) * 4              ;
+
+      for( int column = -pad; column < 0; column++, dest += 4 ) std::copy( source, source + 4, dest ) ;
+
+      dest = std::copy( source, source + rect.width * 4, dest ) ;
+
+      for( int column = 0; column < pad; column++, dest += 4 ) std::copy( source + ( width - 1 ) * 4, source + width * 4, dest ) ;
+    }
+
+    this->dirty[ rect.page ] = true ;
+  }
+
+  inline bool AtlasPages::find( unsigned id, AtlasRect& rect ) const
+  {
+    std::lock_guard<std::mutex> guard( this->lock ) ;
+
+    auto iter = this->rects.find( id ) ;
+
+    if( iter == this->rects.end() ) return false ;
+
+    rect = iter->second ;
+    return true ;
+  }
+
+  inline unsigned AtlasPages::size() const
+  {
+    return this->page_size ;
+  }
+
+  inline unsigned AtlasPages::pages() const
+  {
+    return this->packers.size() ;
+  }
+
+  inline unsigned AtlasPages::count() const
+  {
+    std::lock_guard<std::mutex> guard( this->lock ) ;
+
+    return this->rects.size() ;
+  }
+
+  inline float AtlasPages::occupancy( unsigned page ) const
+  {
+    std::lock_guard<std::mutex> guard( this->lock ) ;
+
+    return page < this->packers.size() ? this->packers[ page ].occupancy() : 0.0f ;
+  }
+
+  inline const unsigned char* AtlasPages::pixels( unsigned page ) const
+  {
+    return this->host_pixels.data() + static_cast<std::size_t>( this->page_size ) * this->page_size * 4 * page ;
+  }
+
+  template<typename Framework>
+  void Atlas<Framework>::initialize( unsigned device, unsigned size, unsigned pages, unsigned padding )
+  {
+    AtlasPages::initialize( size, pages, padding ) ;
+
+    this->atlas_image.initialize( nyx::ImageFormat::RGBA8, device, size, size, pages                          ) ;
+    this->staging    .initialize( device, this->host_pixels.size(), true, nyx::ArrayFlags::TransferSrc ) ;
+  }
+
+  template<typename Framework>
+  bool Atlas<Framework>::upload( nyx::Chain<Framework>& chain )
+  {
+    std::lock_guard<std::mutex> guard( this->lock ) ;
+
+    const std::size_t page_bytes = static_cast<std::size_t>( this->page_size ) * this->page_size * 4 ;
+    bool              recorded   = false                                                           ;
+
+    // Only touched pages go through the staging buffer & into their layers of the image, neighbouring ones in a single copy.
+    for( unsigned page = 0; page < this->dirty.size(); page++ )
+    {
+      unsigned count = 0 ;
+
+      while( page + count < this->dirty.size() && this->dirty[ page + count ] )
+      {
+        this->dirty[ page + count ] = false ;
+        count++ ;
+      }
+
+      if( count == 0 ) continue ;
+
+      chain.copy( this->host_pixels.data(), this->staging    , count * page_bytes, page * page_bytes, page * page_bytes ) ;
+      chain.copy( this->staging           , this->atlas_image, count             , page * page_bytes, page              ) ;
+
+      page    += count ;
+      recorded = true  ;
+    }
+
+    return recorded ;
+  }
+
+  template<typename Framework>
+  const nyx::Image<Framework>& Atlas<Framework>::image() const
+  {
+    return this->atlas_image ;
+  }
+
+  template<typename Framework>
+  void Atlas<Framework>::reset()
+  {
+    this->atlas_image.reset() ;
+    this->staging    .reset() ;
+  }
+}
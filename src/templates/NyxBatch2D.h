@@ -0,0 +1,457 @@
+/*
+ * Copyright (C) 2020 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "NyxText.h"
+#include "NyxAtlas.h"
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <cstdint>
+
+namespace nyx
+{
+  /** The default most instances drawn in a frame, the size of the instance buffer. A sprite or quad is one instance, text one per glyph.
+   */
+  constexpr unsigned BATCH_2D_INSTANCES = 131072 ;
+
+  /** The kinds of primitive a 2D batch draws.
+   */
+  enum class Primitive2D : unsigned
+  {
+    Sprite = 0, ///< A cell of a sprite sheet packed into the image atlas.
+    Quad   = 1, ///< A whole image packed into the image atlas.
+    Text   = 2, ///< A string, one glyph instance per glyph.
+  };
+
+  /** Structure describing a single thing to draw in 2D. Every kind is drawn as a unit quad scaled & moved by it's transform.
+   */
+  struct Drawable2D
+  {
+    Primitive2D kind    = Primitive2D::Quad ;
+    unsigned    layer   = 0                 ; ///< Drawables on higher layers are drawn over lower ones. Equal layers are drawn in id order.
+    unsigned    image   = 0                 ; ///< The id of the image in the image atlas, for sprites & quads.
+    unsigned    columns = 1                 ; ///< The amount of cells in a row of a sprite sheet.
+    unsigned    rows    = 1                 ; ///< The amount of rows of cells in a sprite sheet.
+    unsigned    frame   = 0                 ; ///< The cell of the sheet a sprite shows, counted row by row.
+    glm::vec4   color   = glm::vec4( 1.0f ) ; ///< The color the drawable is tinted with.
+    std::string text    = ""                ; ///< The UTF-8 string of text.
+  };
+
+  /** Function to make the sort key of a 2D drawable, so the draw queue orders drawables by layer, then id.
+   * @param layer The layer of the drawable.
+   * @param id The id of the drawable.
+   * @return The sort key.
+   */
+  inline std::uint64_t makeLayerKey( unsigned layer, unsigned id )
+  {
+    return ( static_cast<std::uint64_t>( layer ) << 32 ) | id ;
+  }
+
+  /** Every sprite, quad & glyph of a 2D scene in a single buffer of instances, in the order they are drawn.
+   * Like a text batch, drawables that didn't change are never written again: changes keeping the amount of instances are patched in place,
+   * anything else packs the buffer again with unchanged drawables copied from where they were.
+   */
+  class Batch2D
+  {
+    public:
+
+      /** Default constructor.
+       */
+      Batch2D() ;
+
+      /** Method to initialize this batch, dropping every drawable.
+       * @param runs The run cache to lay text out with.
+       * @param capacity The most instances in the batch.
+       */
+      void initialize( TextRunCache* runs, unsigned capacity = BATCH_2D_INSTANCES ) ;
+
+      /** Method to set the atlas sprites & quads are drawn from. Called again whenever the atlas packs new images, to find them.
+       * @param images The image atlas.
+       */
+      void setImages( const AtlasPages* images ) ;
+
+      /** Method to add a drawable, replacing whatever was at it's id.
+       * @param id The id of the drawable, also it's transform.
+       * @param drawable The drawable.
+       */
+      void add( unsigned id, const Drawable2D& drawable ) ;
+
+      /** Method to set the drawables drawn & the order they are drawn in. Drawables not in the order are kept, but not drawn.
+       * @param ids The ids of the drawables to draw.
+       * @param count The amount of drawables to draw.
+       */
+      void setOrder( const unsigned* ids, unsigned count ) ;
+
+      /** Method to set the string of a text drawable. Setting the string it already is, or setting one on an id never added, does nothing.
+       * @param id The id of the drawable.
+       * @param text The UTF-8 string.
+       */
+      void setText( unsigned id, const std::string& text ) ;
+
+      /** Method to set the color of a drawable.
+       * @param id The id of the drawable.
+       * @param color The color to tint the drawable with.
+       */
+      void setColor( unsigned id, const glm::vec4& color ) ;
+
+      /** Method to set the cell of it's sheet a sprite shows.
+       * @param id The id of the sprite.
+       * @param frame The cell, counted row by row.
+       */
+      void setFrame( unsigned id, unsigned frame ) ;
+
+      /** Method to set the height of a line of every string, laying all text out again.
+       * @param size The height of a line in the space of the strings.
+       */
+      void setSize( float size ) ;
+
+      /** Method to lay all text out again, for when the font changed.
+       */
+      void invalidate() ;
+
+      /** Method to bring the instances up to date with every change since the last update.
+       * @return Whether any instance changed.
+       */
+      bool update() ;
+
+      /** Method to retrieve the ranges of instances the last update changed.
+       * @return The ranges to upload.
+       */
+      const std::vector<TextRange>& uploads() const ;
+
+      /** Method to retrieve the instances of every drawable.
+       * @return The first of @count instances.
+       */
+      const GlyphInstance* instances() const ;
+
+      /** Method to retrieve the amount of instances of every drawable.
+       * @return The amount of instances to draw.
+       */
+      unsigned count() const ;
+
+      /** Method to retrieve whether the drawables fill every instance, so anything past that is dropped.
+       * @return Whether the batch is full.
+       */
+      bool full() const ;
+
+    private:
+
+      /** Structure describing a single drawable of the batch.
+       */
+      struct Entry
+      {
+        Drawable2D drawable        ;
+        unsigned   offset  = 0     ;
+        unsigned   count   = 0     ;
+        bool       placed  = false ; ///< Whether the drawable's instances are at it's offset in the current instances.
+        bool       changed = true  ; ///< Whether the drawable changed since it's instances were written.
+      };
+
+      /** Method to mark a drawable as changed, so the next update writes it again.
+       * @param id The id of the drawable.
+       * @param entry The drawable's entry.
+       */
+      void touch( unsigned id, Entry& entry ) ;
+
+      /** Method to make the instance of a sprite or quad.
+       * @param id The id of the drawable.
+       * @param drawable The sprite or quad.
+       * @param instance The instance to write.
+       * @return The amount of instances, zero while the image isn't in the atlas.
+       */
+      unsigned image( unsigned id, const Drawable2D& drawable, GlyphInstance& instance ) const ;
+
+      /** Method to write every instance of a drawable.
+       * @param id The id of the drawable.
+       * @param drawable The drawable.
+       * @param instances The instances to write.
+       * @param capacity The most instances to write.
+       * @return The amount of instances written.
+       */
+      unsigned write( unsigned id, const Drawable2D& drawable, GlyphInstance* instances, unsigned capacity ) ;
+
+      using EntryMap = std::unordered_map<unsigned, Entry> ;
+
+      EntryMap                   entries  ;
+      std::vector<unsigned>      order    ;
+      std::vector<unsigned>      changed  ;
+      std::vector<GlyphInstance> current  ;
+      std::vector<GlyphInstance> previous ;
+      std::vector<TextRange>     ranges   ;
+      TextRunCache*              runs     ;
+      const AtlasPages*          atlas    ;
+      float                      size     ;
+      unsigned                   total    ;
+      bool                       repack   ;
+      bool                       reshape  ;
+      bool                       dropped  ;
+  };
+
+  inline Batch2D::Batch2D()
+  {
+    this->runs    = nullptr ;
+    this->atlas   = nullptr ;
+    this->size    = 32.0f   ;
+    this->total   = 0       ;
+    this->repack  = true    ;
+    this->reshape = true    ;
+    this->dropped = false   ;
+  }
+
+  inline void Batch2D::initialize( TextRunCache* runs, unsigned capacity )
+  {
+    this->runs    = runs  ;
+    this->total   = 0     ;
+    this->repack  = true  ;
+    this->reshape = true  ;
+    this->dropped = false ;
+
+    this->current .assign( capacity, GlyphInstance() ) ;
+    this->previous.assign( capacity, GlyphInstance() ) ;
+    this->entries .clear() ;
+    this->order   .clear() ;
+    this->changed .clear() ;
+    this->ranges  .clear() ;
+  }
+
+  inline void Batch2D::setImages( const AtlasPages* images )
+  {
+    this->atlas = images ;
+
+    for( auto& entry : this->entries )
+    {
+      if( entry.second.drawable.kind != Primitive2D::Text ) this->touch( entry.first, entry.second ) ;
+    }
+  }
+
+  inline void Batch2D::add( unsigned id, const Drawable2D& drawable )
+  {
+    Entry& entry = this->entries[ id ] ;
+
+    entry.drawable = drawable ;
+    this->touch( id, entry ) ;
+  }
+
+  inline void Batch2D::setOrder( const unsigned* ids, unsigned count )
+  {
+    this->order.assign( ids, ids + count ) ;
+    this->repack = true ;
+  }
+
+  inline void Batch2D::setText( unsigned id, const std::string& text )
+  {
+    auto iter = this->entries.find( id ) ;
+
+    if( iter == this->entries.end() || ( iter->second.drawable.text == text && !iter->second.changed ) ) return ;
+
+    iter->second.drawable.text = text ;
+    this->touch( id, iter->second ) ;
+  }
+
+  inline void Batch2D::setColor( unsigned id, const glm::vec4& color )
+  {
+    auto iter = this->entries.find( id ) ;
+
+    if( iter == this->entries.end() ) return ;
+
+    const glm::vec4& old = iter->second.drawable.color ;
+    if( old.x == color.x && old.y == color.y && old.z == color.z && old.w == color.w ) return ;
+
+    iter->second.drawable.color = color ;
+    this->touch( id, iter->second ) ;
+  }
+
+  inline void Batch2D::setFrame( unsigned id, unsigned frame )
+  {
+    auto iter = this->entries.find( id ) ;
+
+    if( iter == this->entries.end() || iter->second.drawable.frame == frame ) return ;
+
+    iter->second.drawable.frame = frame ;
+    this->touch( id, iter->second ) ;
+  }
+
+  inline void Batch2D::setSize( float size )
+  {
+    if( this->size == size ) return ;
+
+    this->size    = size ;
+    this->reshape = true ;
+  }
+
+  inline void Batch2D::invalidate()
+  {
+    this->reshape = true ;
+  }
+
+  inline void Batch2D::touch( unsigned id, Entry& entry )
+  {
+    if( !entry.changed || !entry.placed ) this->changed.push_back( id ) ;
+    entry.changed = true ;
+  }
+
+  inline unsigned Batch2D::image( unsigned id, const Drawable2D& drawable, GlyphInstance& instance ) const
+  {
+    AtlasRect rect ;
+
+    if( this->atlas == nullptr || !this->atlas->find( drawable.image, rect ) ) return 0 ;
+
+    // Quads are a sheet of a single cell.
+    const bool      sprite  = drawable.kind == Primitive2D::Sprite                                       ;
+    const unsigned  columns = sprite ? std::max( drawable.columns, 1u ) : 1u                            ;
+    const unsigned  rows    = sprite ? std::max( drawable.rows   , 1u ) : 1u                            ;
+    const unsigned  cell    = sprite ? drawable.frame % ( columns * rows ) : 0u                         ;
+    const glm::vec2 extent  = glm::vec2( rect.region.z / columns, rect.region.w / rows )                 ;
+    const glm::vec2 offset  = glm::vec2( ( cell % columns ) * extent.x, ( cell / columns ) * extent.y ) ;
+
+    instance.rect      = glm::vec4( 0.0f, 0.0f, 1.0f, 1.0f )                                                ;
+    instance.region    = glm::vec4( rect.region.x + offset.x, rect.region.y + offset.y, extent.x, extent.y ) ;
+    instance.color     = drawable.color                                                                     ;
+    instance.page      = rect.page                                                                          ;
+    instance.transform = id                                                                                 ;
+    instance.mode      = InstanceMode::Image                                                                ;
+    instance.padding   = 0                                                                                  ;
+
+    return 1 ;
+  }
+
+  inline unsigned Batch2D::write( unsigned id, const Drawable2D& drawable, GlyphInstance* instances, unsigned capacity )
+  {
+    if( drawable.kind == Primitive2D::Text ) return this->runs->write( drawable.text, this->size, id, drawable.color, instances, capacity ) ;
+
+    GlyphInstance instance ;
+
+    if( capacity == 0 || this->image( id, drawable, instance ) == 0 ) return 0 ;
+
+    instances[ 0 ] = instance ;
+    return 1 ;
+  }
+
+  inline bool Batch2D::update()
+  {
+    this->ranges.clear() ;
+
+    if( this->runs == nullptr || ( this->changed.empty() && !this->repack && !this->reshape ) ) return false ;
+
+    // Changes keeping a drawable's amount of instances are patched where they are, nothing else moves.
+    for( unsigned index = 0; index < this->changed.size() && !this->repack && !this->reshape; index++ )
+    {
+      const unsigned id    = this->changed[ index ] ;
+      Entry&         entry = this->entries[ id ]    ;
+
+      if( !entry.placed ) { this->repack = true ; break ; }
+
+      if( entry.drawable.kind == Primitive2D::Text )
+      {
+        const std::vector<GlyphInstance>& run = this->runs->shape( entry.drawable.text, this->size ) ;
+
+        if( run.size() != entry.count ) { this->repack = true ; break ; }
+
+        TextRunCache::copy( run, id, entry.drawable.color, this->current.data() + entry.offset, entry.count ) ;
+      }
+      else
+      {
+        GlyphInstance instance ;
+
+        if( this->image( id, entry.drawable, instance ) != entry.count ) { this->repack = true ; break ; }
+
+        if( entry.count != 0 ) this->current[ entry.offset ] = instance ;
+      }
+
+      entry.changed = false ;
+      if( entry.count != 0 ) this->ranges.push_back( { entry.offset, entry.count } ) ;
+    }
+
+    // Otherwise every drawable is packed again in order. Unchanged ones are copied from where they were.
+    if( this->repack || this->reshape )
+    {
+      const unsigned capacity = this->current.size() ;
+      unsigned       count    = 0                     ;
+
+      std::swap( this->current, this->previous ) ;
+      this->ranges.clear() ;
+
+      // Only drawables placed before are in the old instances, the rest have to be written.
+      for( auto& entry : this->entries )
+      {
+        if( !entry.second.placed ) entry.second.changed = true ;
+        entry.second.placed = false ;
+      }
+
+      for( unsigned id : this->order )
+      {
+        auto iter = this->entries.find( id ) ;
+
+        if( iter == this->entries.end() || iter->second.placed ) continue ;
+
+        Entry&         entry = iter->second                                              ;
+        const unsigned room  = capacity - count                                          ;
+        const bool     stale = this->reshape && entry.drawable.kind == Primitive2D::Text ;
+
+        if( !stale && !entry.changed && entry.count <= room )
+        {
+          std::copy( this->previous.begin() + entry.offset, this->previous.begin() + entry.offset + entry.count, this->current.begin() + count ) ;
+        }
+        else
+        {
+          entry.count = this->write( id, entry.drawable, this->current.data() + count, room ) ;
+        }
+
+        entry.offset  = count ;
+        entry.placed  = true  ;
+        entry.changed = false ;
+        count        += entry.count ;
+      }
+
+      this->total   = count             ;
+      this->dropped = count == capacity ;
+      if( count != 0 ) this->ranges.push_back( { 0, count } ) ;
+    }
+
+    for( unsigned id : this->changed ) this->entries[ id ].changed = !this->entries[ id ].placed ;
+
+    this->changed.clear() ;
+    this->repack  = false ;
+    this->reshape = false ;
+
+    return true ;
+  }
+
+  inline const std::vector<TextRange>& Batch2D::uploads() const
+  {
+    return this->ranges ;
+  }
+
+  inline const GlyphInstance* Batch2D::instances() const
+  {
+    return this->current.data() ;
+  }
+
+  inline unsigned Batch2D::count() const
+  {
+    return this->total ;
+  }
+
+  inline bool Batch2D::full() const
+  {
+    return this->dropped ;
+  }
+}
@@ -17,6 +17,8 @@
 
 #include <climits>
 #include <templates/NyxModule.h>
+#include <templates/NyxDrawQueue.h>
+#include <templates/NyxAnimation.h>
 #include <NyxGPU/library/Chain.h>
 #include <NyxGPU/library/Pipeline.h>
 #include <NyxGPU/vkg/Vulkan.h>
@@ -25,6 +27,7 @@
 #include <glm/glm.hpp>
 #include <unordered_map>
 #include <functional>
+#include <algorithm>
 
 namespace nyx
 {
@@ -84,6 +87,12 @@ namespace nyx
        * @param sz The size in elements to use for this transformation buffer.
        */
       void setTransformSize( unsigned sz ) ;
+      
+      /** Method to let this object's transformation buffer grow to fit the largest drawable ID it is sent.
+       * Only usable when the pipeline reads the transforms from a storage buffer, as a uniform buffer's size is fixed in the shader.
+       * @param value Whether or not the transformation buffer may grow.
+       */
+      void setTransformGrowth( bool value ) ;
 
       /** Method to draw this object's data. 
        * Calls the specified input callback for every element being drawn.
@@ -96,6 +105,16 @@ namespace nyx
        */
       unsigned drawableCount() const ;
 
+      /** Method to retrieve the width of the viewport this object draws to.
+       * @return The width in pixels of this object's viewport.
+       */
+      unsigned viewportWidth() const ;
+
+      /** Method to retrieve the height of the viewport this object draws to.
+       * @return The height in pixels of this object's viewport.
+       */
+      unsigned viewportHeight() const ;
+
       /** Method to draw this object's input with the specified parameters.
        * @param vertices The vertex buffer to use for drawing instanced.
        * @param count The amount of instances to draw.
@@ -107,20 +126,59 @@ namespace nyx
       
       void setPerDrawCallback( std::function<void( unsigned, Drawable&, nyx::Chain<Framework>&, nyx::Pipeline<Framework>& )> callback ) ;
       
+      /** Method to set the callback used to generate the sorted draws of a drawable.
+       * When both this and @setSortedDrawCallback are set, they are used for recording instead of the per-draw callback.
+       * @param callback The function to call for every drawable to push it's draws onto the queue.
+       */
+      void setSortCallback( std::function<void( unsigned, Drawable&, nyx::DrawQueue& )> callback ) ;
+      
+      /** Method to set the callback used to record the draws once they are sorted by key.
+       * @param callback The function to call with all sorted draws of this object.
+       */
+      void setSortedDrawCallback( std::function<void( const nyx::DrawItem*, unsigned, nyx::Chain<Framework>&, nyx::Pipeline<Framework>& )> callback ) ;
+      
+      /** Method to set the callback invoked whenever a new drawable is added to this object.
+       * Useful for resolving per-drawable data once instead of on every re-record.
+       * @param callback The function to call with the id and drawable that was added.
+       */
+      void setAddCallback( std::function<void( unsigned, Drawable& )> callback ) ;
+      
+      /** Method to set the callback invoked whenever a drawable is removed from this object.
+       * Useful for releasing the per-drawable data resolved by the add callback.
+       * @param callback The function to call with the id of the drawable that was removed.
+       */
+      void setRemoveCallback( std::function<void( unsigned )> callback ) ;
+      
+      /** Method to retrieve the host-side transformation of a drawable.
+       * @param id The id of the drawable.
+       * @return Const reference to the transformation of the drawable.
+       */
+      const glm::mat4& transform( unsigned id ) const ;
+      
       void setTransformFlag( nyx::ArrayFlags flag ) ;
       
       void setPostInitCallback( std::function<void()> callback ) ;
       
       bool dirty() ;
       
+      /** Method to force this object to re-record it's draws next frame, e.g. when a derived module's draw state changed.
+       */
+      void setDirty() ;
+      
       void emit() ;
     private:
       using DrawCallback       = std::function<void( unsigned, Drawable&, nyx::Chain<Framework>&, nyx::Pipeline<Framework>& )> ;
       using InitializeCallback = std::function<void()> ;
+      using AddCallback        = std::function<void( unsigned, Drawable& )> ;
+      using RemoveCallback     = std::function<void( unsigned )> ;
+      using SortCallback       = std::function<void( unsigned, Drawable&, nyx::DrawQueue& )> ;
+      using SortedDrawCallback = std::function<void( const nyx::DrawItem*, unsigned, nyx::Chain<Framework>&, nyx::Pipeline<Framework>& )> ;
 
       void addDrawable( unsigned id, const Drawable& drawable ) ;
       void addDrawableTransform( unsigned id, const glm::mat4& transform ) ;
+      void addDrawableTransforms( const nyx::TransformBatch& batch ) ;
       void removeDrawable( unsigned id ) ;
+      void reserveTransforms( unsigned count ) ;
       void setParentPass( const nyx::RenderPass<Framework>& render_pass ) ;
       void setParentChain( const nyx::Chain<Framework>& parent_chain ) ;
       void setDrawableName( const char* name ) ;
@@ -146,9 +204,15 @@ namespace nyx
       nyx::Pipeline<Framework>               render_pipeline       ;
       nyx::Array<Framework, glm::mat4>       d_transforms          ;
       bool                                   transforms_dirty      ;
+      bool                                   transforms_grow       ;
       bool                                   drawables_dirty       ;
       DrawCallback                           per_drawable_function ;
       InitializeCallback                     init_callback         ;
+      AddCallback                            add_function          ;
+      RemoveCallback                         remove_function       ;
+      SortCallback                           sort_function         ;
+      SortedDrawCallback                     sorted_draw_function  ;
+      nyx::DrawQueue                         draw_queue            ;
       std::string                            transform_key         ;
       std::vector<glm::mat4>                 transforms            ;
       std::unordered_map<unsigned ,Drawable> drawables             ;
@@ -166,12 +230,17 @@ namespace nyx
     this->height                = 1024                           ;
     this->initialized           = false                          ;
     this->transforms_dirty      = true                           ;
+    this->transforms_grow       = false                          ;
     this->drawables_dirty       = true                           ;
     this->parent_chain          = nullptr                        ;
     this->parent_pass           = nullptr                        ;
     this->child_bus             = nullptr                        ;
     this->pipeline_bytes        = nullptr                        ;
     this->per_drawable_function = nullptr                        ;
+    this->sort_function         = nullptr                        ;
+    this->add_function          = nullptr                        ;
+    this->remove_function       = nullptr                        ;
+    this->sorted_draw_function  = nullptr                        ;
     this->pipeline_size         = 0                              ;
     this->subpass_id            = UINT_MAX                       ;
   }
@@ -240,6 +309,36 @@ namespace nyx
     this->per_drawable_function = callback ;
   }
   
+  template<typename Drawable>
+  void NyxDrawModule<Drawable>::setSortCallback( std::function<void( unsigned, Drawable&, nyx::DrawQueue& )> callback )
+  {
+    this->sort_function = callback ;
+  }
+  
+  template<typename Drawable>
+  void NyxDrawModule<Drawable>::setSortedDrawCallback( std::function<void( const nyx::DrawItem*, unsigned, nyx::Chain<Framework>&, nyx::Pipeline<Framework>& )> callback )
+  {
+    this->sorted_draw_function = callback ;
+  }
+  
+  template<typename Drawable>
+  void NyxDrawModule<Drawable>::setAddCallback( std::function<void( unsigned, Drawable& )> callback )
+  {
+    this->add_function = callback ;
+  }
+  
+  template<typename Drawable>
+  void NyxDrawModule<Drawable>::setRemoveCallback( std::function<void( unsigned )> callback )
+  {
+    this->remove_function = callback ;
+  }
+  
+  template<typename Drawable>
+  const glm::mat4& NyxDrawModule<Drawable>::transform( unsigned id ) const
+  {
+    return this->transforms[ id < this->transforms.size() ? id : 0 ] ;
+  }
+  
   template<typename Drawable>
   void NyxDrawModule<Drawable>::setPostInitCallback( std::function<void()> callback )
   {
@@ -304,8 +403,12 @@ namespace nyx
     auto iter = this->drawables.find( id ) ;
     if( iter == this->drawables.end() )
     {
-      this->drawables.insert( iter, { id, drawable } ) ;
+      this->reserveTransforms( id + 1 ) ;
+      
+      iter = this->drawables.insert( iter, { id, drawable } ) ;
       this->drawables_dirty = true ;
+      
+      if( this->add_function ) this->add_function( id, iter->second ) ;
     }
     else
     {
@@ -316,6 +419,8 @@ namespace nyx
   template<typename Drawable>
   void NyxDrawModule<Drawable>::addDrawableTransform( unsigned id, const glm::mat4& transform )
   {
+    this->reserveTransforms( id + 1 ) ;
+    
     if( id < this->transforms.size() )
     {
       this->transforms[ id ] = transform ;
@@ -327,12 +432,47 @@ namespace nyx
     }
   }
   
+  template<typename Drawable>
+  void NyxDrawModule<Drawable>::addDrawableTransforms( const nyx::TransformBatch& batch )
+  {
+    this->reserveTransforms( batch.first + batch.count ) ;
+    
+    if( batch.first + batch.count <= this->transforms.size() )
+    {
+      std::copy( batch.transforms, batch.transforms + batch.count, this->transforms.begin() + batch.first ) ;
+      this->transforms_dirty = true ;
+    }
+    else
+    {
+      Log::output( Log::Level::Warning, "Trying to add ", batch.count, " drawable transforms to module ", this->name(), " starting at ID ", batch.first, " which does not fit it's transform buffer." ) ;
+    }
+  }
+  
+  template<typename Drawable>
+  void NyxDrawModule<Drawable>::reserveTransforms( unsigned count )
+  {
+    unsigned size = std::max<unsigned>( this->transforms.size(), 1 ) ;
+    
+    if( !this->transforms_grow || count <= this->transforms.size() ) return ;
+    while( size < count ) size *= 2 ;
+    
+    // Only the host copy grows here, the device buffer follows before the next recording.
+    this->transforms.resize( size ) ;
+    this->transforms_dirty = true ;
+  }
+  
   template<typename Drawable>
   bool NyxDrawModule<Drawable>::dirty()
   {
     return this->drawables_dirty ;
   }
 
+  template<typename Drawable>
+  void NyxDrawModule<Drawable>::setDirty()
+  {
+    this->drawables_dirty = true ;
+  }
+
   template<typename Drawable>
   void NyxDrawModule<Drawable>::emit()
   {
@@ -347,6 +487,8 @@ namespace nyx
     {
       this->drawables.erase( iter ) ;
       this->drawables_dirty = true ;
+      
+      if( this->remove_function ) this->remove_function( id ) ;
     }
     else
     {
@@ -359,12 +501,25 @@ namespace nyx
   {
     return this->drawables.size() ;
   }
+
+  template<typename Drawable>
+  unsigned NyxDrawModule<Drawable>::viewportWidth() const
+  {
+    return this->width ;
+  }
+
+  template<typename Drawable>
+  unsigned NyxDrawModule<Drawable>::viewportHeight() const
+  {
+    return this->height ;
+  }
   
   template<typename Drawable>
   void NyxDrawModule<Drawable>::setDrawableName( const char* name )
   {
-    this->child_bus->enroll( this, &NyxDrawModule::addDrawable         , iris::OPTIONAL, name ) ;
-    this->child_bus->enroll( this, &NyxDrawModule::addDrawableTransform, iris::OPTIONAL, name ) ;
+    this->child_bus->enroll( this, &NyxDrawModule::addDrawable          , iris::OPTIONAL, name ) ;
+    this->child_bus->enroll( this, &NyxDrawModule::addDrawableTransform , iris::OPTIONAL, name ) ;
+    this->child_bus->enroll( this, &NyxDrawModule::addDrawableTransforms, iris::OPTIONAL, name ) ;
   }
   
   template<typename Drawable>
@@ -418,6 +573,16 @@ namespace nyx
     
     if( this->initialized )
     {
+      // Recorded draws reference the old transformation buffer, so growing it means re-recording them.
+      if( this->d_transforms.size() < this->transforms.size() )
+      {
+        Framework::deviceSynchronize( this->gpu() ) ;
+        this->d_transforms.reset() ;
+        this->d_transforms.initialize( this->gpu(), this->transforms.size(), false, this->array_flag ) ;
+        this->render_pipeline.bind( this->transform_key.c_str(), this->d_transforms ) ;
+        this->drawables_dirty = true ;
+      }
+      
       if( this->transforms_dirty && this->copy_chain.initialized() )
       {
         this->copy_chain.copy( this->transforms.data(), this->d_transforms ) ;
@@ -426,7 +591,24 @@ namespace nyx
         this->transforms_dirty = false ;
       }
       
-      if( function && this->drawables_dirty && this->render_chain.initialized() )
+      if( this->sort_function && this->sorted_draw_function && this->drawables_dirty && this->render_chain.initialized() )
+      {
+        // Gather every draw with it's sort key, then record them in key order so that state changes are grouped.
+        this->draw_queue.clear() ;
+        
+        for( auto& drawable : this->drawables )
+        {
+          this->sort_function( drawable.first, drawable.second, this->draw_queue ) ;
+        }
+        
+        this->draw_queue.sort() ;
+        
+        this->render_chain.begin() ;
+        this->sorted_draw_function( this->draw_queue.data(), this->draw_queue.size(), this->render_chain, this->render_pipeline ) ;
+        this->render_chain.end() ;
+        this->emit() ;
+      }
+      else if( function && this->drawables_dirty && this->render_chain.initialized() )
       {
         this->render_chain.begin() ;
         
@@ -466,6 +648,12 @@ namespace nyx
     this->transforms.resize( sz ) ;
   }
   
+  template<typename Drawable>
+  void NyxDrawModule<Drawable>::setTransformGrowth( bool value )
+  {
+    this->transforms_grow = value ;
+  }
+  
   template<typename Drawable>
   nyx::Pipeline<Framework>& NyxDrawModule<Drawable>::pipeline()
   {
@@ -0,0 +1,200 @@
+/*
+ * Copyright (C) 2020 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace nyx
+{
+  /** The amount of bits of a draw key used for each sort criteria, from most to least significant.
+   */
+  constexpr unsigned DRAW_KEY_PIPELINE_BITS = 8  ;
+  constexpr unsigned DRAW_KEY_TEXTURE_BITS  = 16 ;
+  constexpr unsigned DRAW_KEY_MESH_BITS     = 16 ;
+  constexpr unsigned DRAW_KEY_DEPTH_BITS    = 24 ;
+
+  /** The largest value each sort criteria of a draw key can hold.
+   */
+  constexpr unsigned DRAW_KEY_PIPELINE_MAX = ( 1u << DRAW_KEY_PIPELINE_BITS ) - 1 ;
+  constexpr unsigned DRAW_KEY_TEXTURE_MAX  = ( 1u << DRAW_KEY_TEXTURE_BITS  ) - 1 ;
+  constexpr unsigned DRAW_KEY_MESH_MAX     = ( 1u << DRAW_KEY_MESH_BITS     ) - 1 ;
+  constexpr unsigned DRAW_KEY_DEPTH_MAX    = ( 1u << DRAW_KEY_DEPTH_BITS    ) - 1 ;
+
+  /** Structure describing a single draw operation waiting to be recorded.
+   */
+  struct DrawItem
+  {
+    std::uint64_t key  ; ///< The sort key of this draw.
+    unsigned      id   ; ///< The ID of the drawable this draw belongs to.
+    unsigned      data ; ///< Module-specific payload, e.g. an index into a module's own draw records.
+  };
+
+  /** Function to pack draw state into a single 64-bit sort key.
+   * Values wider than their field are clamped to it's largest value, so they still sort after every value that fits instead of wrapping onto smaller ones.
+   * @param pipeline The pipeline ID of the draw.
+   * @param texture The texture ID of the draw.
+   * @param mesh The mesh ID of the draw.
+   * @param depth The quantized depth of the draw. See @quantizeDepth.
+   * @return The packed sort key.
+   */
+  inline std::uint64_t makeDrawKey( unsigned pipeline, unsigned texture, unsigned mesh, unsigned depth ) ;
+
+  /** Function to quantize a view-space distance into the depth field of a draw key.
+   * @param distance The distance from the camera.
+   * @param range The maximum distance to expect. Anything further is clamped.
+   * @return The quantized depth.
+   */
+  inline unsigned quantizeDepth( float distance, float range ) ;
+
+  /** Function to retrieve the state portion of a draw key, that is, everything but depth.
+   * @param key The key to strip.
+   * @return The key without it's depth field.
+   */
+  inline std::uint64_t drawKeyState( std::uint64_t key ) ;
+
+  /** Class to collect draws and order them by their sort keys.
+   */
+  class DrawQueue
+  {
+    public:
+
+      /** Method to clear all draws from this queue. Keeps the allocated memory.
+       */
+      void clear() ;
+
+      /** Method to add a draw to this queue.
+       * @param key The sort key of the draw.
+       * @param id The id of the drawable.
+       * @param data The module-specific payload of the draw.
+       */
+      void push( std::uint64_t key, unsigned id, unsigned data ) ;
+
+      /** Method to sort this object's draws by key using an LSD radix sort.
+       * The sort is stable, so draws with equal keys keep their insertion order.
+       */
+      void sort() ;
+
+      /** Method to retrieve a pointer to this object's draws.
+       * @return Pointer to the start of this object's draws.
+       */
+      const DrawItem* data() const ;
+
+      /** Method to retrieve the amount of draws in this queue.
+       * @return The amount of draws in this queue.
+       */
+      unsigned size() const ;
+
+    private:
+      std::vector<DrawItem> items   ;
+      std::vector<DrawItem> scratch ;
+  };
+
+  std::uint64_t makeDrawKey( unsigned pipeline, unsigned texture, unsigned mesh, unsigned depth )
+  {
+    const std::uint64_t pipeline_field = pipeline < DRAW_KEY_PIPELINE_MAX ? pipeline : DRAW_KEY_PIPELINE_MAX ;
+    const std::uint64_t texture_field  = texture  < DRAW_KEY_TEXTURE_MAX  ? texture  : DRAW_KEY_TEXTURE_MAX  ;
+    const std::uint64_t mesh_field     = mesh     < DRAW_KEY_MESH_MAX     ? mesh     : DRAW_KEY_MESH_MAX     ;
+    const std::uint64_t depth_field    = depth    < DRAW_KEY_DEPTH_MAX    ? depth    : DRAW_KEY_DEPTH_MAX    ;
+
+    return ( pipeline_field << ( DRAW_KEY_TEXTURE_BITS + DRAW_KEY_MESH_BITS + DRAW_KEY_DEPTH_BITS ) ) |
+           ( texture_field  << ( DRAW_KEY_MESH_BITS    + DRAW_KEY_DEPTH_BITS                       ) ) |
+           ( mesh_field     << ( DRAW_KEY_DEPTH_BITS                                               ) ) |
+           ( depth_field                                                                             ) ;
+  }
+
+  unsigned quantizeDepth( float distance, float range )
+  {
+    constexpr float max_depth = static_cast<float>( DRAW_KEY_DEPTH_MAX ) ;
+
+    if( distance <= 0.0f   ) return 0                                  ;
+    if( distance >= range  ) return static_cast<unsigned>( max_depth ) ;
+
+    return static_cast<unsigned>( ( distance / range ) * max_depth ) ;
+  }
+
+  std::uint64_t drawKeyState( std::uint64_t key )
+  {
+    return key >> DRAW_KEY_DEPTH_BITS ;
+  }
+
+  inline void DrawQueue::clear()
+  {
+    this->items.clear() ;
+  }
+
+  inline void DrawQueue::push( std::uint64_t key, unsigned id, unsigned data )
+  {
+    this->items.push_back( { key, id, data } ) ;
+  }
+
+  inline void DrawQueue::sort()
+  {
+    constexpr unsigned RADIX  = 256                     ;
+    constexpr unsigned PASSES = sizeof( std::uint64_t ) ;
+
+    unsigned histogram[ PASSES ][ RADIX ] = {} ;
+
+    if( this->items.size() < 2 ) return ;
+
+    this->scratch.resize( this->items.size() ) ;
+
+    // Build every pass' histogram in a single sweep over the keys.
+    for( const auto& item : this->items )
+    {
+      for( unsigned pass = 0; pass < PASSES; pass++ )
+      {
+        histogram[ pass ][ ( item.key >> ( pass * 8 ) ) & 0xFF ]++ ;
+      }
+    }
+
+    for( unsigned pass = 0; pass < PASSES; pass++ )
+    {
+      auto&    counts = histogram[ pass ] ;
+      unsigned offset = 0                 ;
+      unsigned shift  = pass * 8          ;
+
+      // Skip passes where every key shares the same byte, they wouldn't move anything.
+      if( counts[ ( this->items.front().key >> shift ) & 0xFF ] == this->items.size() ) continue ;
+
+      for( unsigned bucket = 0; bucket < RADIX; bucket++ )
+      {
+        const unsigned count = counts[ bucket ] ;
+        counts[ bucket ] = offset ;
+        offset += count ;
+      }
+
+      for( const auto& item : this->items )
+      {
+        this->scratch[ counts[ ( item.key >> shift ) & 0xFF ]++ ] = item ;
+      }
+
+      this->items.swap( this->scratch ) ;
+    }
+  }
+
+  inline const DrawItem* DrawQueue::data() const
+  {
+    return this->items.data() ;
+  }
+
+  inline unsigned DrawQueue::size() const
+  {
+    return this->items.size() ;
+  }
+}
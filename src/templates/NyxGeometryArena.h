@@ -0,0 +1,400 @@
+/*
+ * Copyright (C) 2020 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <NyxGPU/library/Array.h>
+#include <NyxGPU/library/Chain.h>
+#include <map>
+#include <iterator>
+#include <algorithm>
+#include <climits>
+
+namespace nyx
+{
+  /** Class to suballocate ranges out of a fixed amount of elements, using a first-fit free list.
+   * Neighbouring free ranges are merged when released, so the list stays as short as the fragmentation allows.
+   */
+  class FreeList
+  {
+    public:
+
+      /** Default constructor.
+       */
+      FreeList() ;
+
+      /** Method to initialize this object with a single free range covering the whole capacity.
+       * @param capacity The amount of elements to manage.
+       */
+      void initialize( unsigned capacity ) ;
+
+      /** Method to allocate a range from this object.
+       * @param count The amount of elements to allocate.
+       * @return The offset of the allocated range. UINT_MAX if no free range is big enough.
+       */
+      unsigned allocate( unsigned count ) ;
+
+      /** Method to release a range back to this object.
+       * @param offset The offset of the range, as returned by @allocate.
+       * @param count The amount of elements in the range.
+       */
+      void release( unsigned offset, unsigned count ) ;
+
+      /** Method to grow this object's capacity. The added elements are appended as free.
+       * @param capacity The new capacity. Ignored if not larger than the current one.
+       */
+      void grow( unsigned capacity ) ;
+
+      /** Method to retrieve the amount of elements this object manages.
+       * @return The capacity of this object.
+       */
+      unsigned capacity() const ;
+
+      /** Method to retrieve the amount of elements currently allocated.
+       * @return The amount of allocated elements.
+       */
+      unsigned used() const ;
+
+      /** Method to retrieve the amount of separate free ranges, a measure of fragmentation.
+       * @return The amount of free ranges.
+       */
+      unsigned ranges() const ;
+
+    private:
+      std::map<unsigned, unsigned> free_ranges ; ///< Free ranges, as offset to count.
+      unsigned                     total       ;
+      unsigned                     allocated   ;
+  };
+
+  /** Structure describing where a mesh was placed in a geometry arena.
+   */
+  struct GeometryAllocation
+  {
+    unsigned base_vertex  = 0 ; ///< The first vertex of the mesh. Indices of the mesh are relative to it.
+    unsigned vertex_count = 0 ; ///< The amount of vertices of the mesh.
+    unsigned first_index  = 0 ; ///< The first index of the mesh.
+    unsigned index_count  = 0 ; ///< The amount of indices of the mesh.
+  };
+
+  /** Class to hold the geometry of many meshes in one shared vertex buffer & one shared index buffer.
+   * Meshes are referenced by their placement in the buffers, so a whole module can draw with a single buffer binding.
+   */
+  template<typename Framework, typename Vertex>
+  class GeometryArena
+  {
+    public:
+      using Allocation = GeometryAllocation ;
+
+      /** Method to initialize this arena's device buffers.
+       * @param gpu The device to allocate the buffers on.
+       * @param vertex_capacity The initial amount of vertices the arena can hold.
+       * @param index_capacity The initial amount of indices the arena can hold.
+       */
+      void initialize( unsigned gpu, unsigned vertex_capacity, unsigned index_capacity ) ;
+
+      /** Method to place a mesh's geometry into this arena, growing the buffers if it does not fit.
+       * Records the copies onto the given chain, so it must be submitted before the geometry is drawn.
+       * @param chain The chain to record the copies into.
+       * @param vertices The vertices of the mesh.
+       * @param indices The indices of the mesh.
+       * @return Where the mesh was placed.
+       */
+      Allocation add( nyx::Chain<Framework>& chain, const nyx::Array<Framework, Vertex>& vertices, const nyx::Array<Framework, unsigned>& indices ) ;
+
+      /** Method to place a mesh's geometry into this arena from host vertices, e.g. ones converted at load.
+       * Records the copies onto the given chain, so the vertices must stay alive until it is submitted.
+       * @param chain The chain to record the copies into.
+       * @param vertices Pointer to the host vertices of the mesh.
+       * @param vertex_count The amount of vertices of the mesh.
+       * @param indices The indices of the mesh.
+       * @return Where the mesh was placed.
+       */
+      Allocation add( nyx::Chain<Framework>& chain, const Vertex* vertices, unsigned vertex_count, const nyx::Array<Framework, unsigned>& indices ) ;
+
+      /** Method to overwrite the indices of a placed mesh, e.g. once they are reordered. The mesh keeps it's amount of indices.
+       * Records the copy onto the given chain, so the indices must stay alive until it is submitted.
+       * @param chain The chain to record the copy into.
+       * @param allocation The placement of the mesh, as returned by @add.
+       * @param indices Pointer to the host indices, one for every index of the mesh.
+       */
+      void setIndices( nyx::Chain<Framework>& chain, const Allocation& allocation, const unsigned* indices ) ;
+
+      /** Method to release a mesh's space in this arena.
+       * @param allocation The placement of the mesh, as returned by @add.
+       */
+      void remove( const Allocation& allocation ) ;
+
+      /** Method to retrieve the shared vertex buffer.
+       * @return Reference to the shared vertex buffer.
+       */
+      const nyx::Array<Framework, Vertex>& vertices() const ;
+
+      /** Method to retrieve the shared index buffer.
+       * @return Reference to the shared index buffer.
+       */
+      const nyx::Array<Framework, unsigned>& indices() const ;
+
+      /** Method to release this arena's device buffers.
+       */
+      void reset() ;
+
+    private:
+
+      /** Method to find room for a mesh in this arena, growing the buffers if it does not fit.
+       * @param chain The chain to record the copies of grown buffers into.
+       * @param vertex_count The amount of vertices of the mesh.
+       * @param index_count The amount of indices of the mesh.
+       * @return Where the mesh goes.
+       */
+      Allocation reserve( nyx::Chain<Framework>& chain, unsigned vertex_count, unsigned index_count ) ;
+
+      /** Method to reallocate one of this arena's buffers at a larger size, keeping it's contents.
+       * @param chain The chain to record the copy of the old contents into.
+       * @param array The buffer to grow.
+       * @param list The free list of the buffer.
+       * @param count The amount of elements that has to fit.
+       * @param flags The flags the buffer was allocated with.
+       */
+      template<typename Type>
+      void grow( nyx::Chain<Framework>& chain, nyx::Array<Framework, Type>& array, FreeList& list, unsigned count, nyx::ArrayFlags flags ) ;
+
+      nyx::Array<Framework, Vertex>   d_vertices  ;
+      nyx::Array<Framework, unsigned> d_indices   ;
+      FreeList                        vertex_list ;
+      FreeList                        index_list  ;
+      unsigned                        gpu         ;
+  };
+
+  inline FreeList::FreeList()
+  {
+    this->total     = 0 ;
+    this->allocated = 0 ;
+  }
+
+  inline void FreeList::initialize( unsigned capacity )
+  {
+    this->free_ranges.clear() ;
+    this->total     = capacity ;
+    this->allocated = 0        ;
+
+    if( capacity != 0 ) this->free_ranges[ 0 ] = capacity ;
+  }
+
+  inline unsigned FreeList::allocate( unsigned count )
+  {
+    if( count == 0 ) return 0 ;
+
+    for( auto iter = this->free_ranges.begin(); iter != this->free_ranges.end(); ++iter )
+    {
+      if( iter->second >= count )
+      {
+        const unsigned offset    = iter->first          ;
+        const unsigned remaining = iter->second - count ;
+
+        this->free_ranges.erase( iter ) ;
+        if( remaining != 0 ) this->free_ranges[ offset + count ] = remaining ;
+
+        this->allocated += count ;
+        return offset ;
+      }
+    }
+
+    return UINT_MAX ;
+  }
+
+  inline void FreeList::release( unsigned offset, unsigned count )
+  {
+    const unsigned released = count                                   ;
+    auto           next     = this->free_ranges.lower_bound( offset ) ;
+
+    if( count == 0 ) return ;
+
+    this->allocated -= released ;
+
+    // Merge with the following range if they touch.
+    if( next != this->free_ranges.end() && offset + count == next->first )
+    {
+      count += next->second ;
+      next = this->free_ranges.erase( next ) ;
+    }
+
+    // Merge with the preceding range if they touch.
+    if( next != this->free_ranges.begin() )
+    {
+      auto prev = std::prev( next ) ;
+      if( prev->first + prev->second == offset )
+      {
+        prev->second += count ;
+        return ;
+      }
+    }
+
+    this->free_ranges[ offset ] = count ;
+  }
+
+  inline void FreeList::grow( unsigned capacity )
+  {
+    if( capacity <= this->total ) return ;
+
+    const unsigned added = capacity - this->total ;
+    const unsigned start = this->total            ;
+
+    this->total      = capacity ;
+    this->allocated += added    ;
+    this->release( start, added ) ;
+  }
+
+  inline unsigned FreeList::capacity() const
+  {
+    return this->total ;
+  }
+
+  inline unsigned FreeList::used() const
+  {
+    return this->allocated ;
+  }
+
+  inline unsigned FreeList::ranges() const
+  {
+    return this->free_ranges.size() ;
+  }
+
+  template<typename Framework, typename Vertex>
+  void GeometryArena<Framework, Vertex>::initialize( unsigned gpu, unsigned vertex_capacity, unsigned index_capacity )
+  {
+    this->gpu = gpu ;
+    this->d_vertices.initialize( gpu, vertex_capacity, false, nyx::ArrayFlags::Vertex | nyx::ArrayFlags::StorageBuffer | nyx::ArrayFlags::TransferSrc | nyx::ArrayFlags::TransferDst ) ;
+    this->d_indices .initialize( gpu, index_capacity , false, nyx::ArrayFlags::Index  | nyx::ArrayFlags::StorageBuffer | nyx::ArrayFlags::TransferSrc | nyx::ArrayFlags::TransferDst ) ;
+    this->vertex_list.initialize( vertex_capacity ) ;
+    this->index_list .initialize( index_capacity  ) ;
+  }
+
+  template<typename Framework, typename Vertex>
+  typename GeometryArena<Framework, Vertex>::Allocation GeometryArena<Framework, Vertex>::add( nyx::Chain<Framework>& chain, const nyx::Array<Framework, Vertex>& vertices, const nyx::Array<Framework, unsigned>& indices )
+  {
+    Allocation allocation = this->reserve( chain, vertices.size(), indices.size() ) ;
+
+    chain.copy( vertices, this->d_vertices, allocation.vertex_count, 0, allocation.base_vertex ) ;
+    chain.copy( indices , this->d_indices , allocation.index_count , 0, allocation.first_index ) ;
+
+    return allocation ;
+  }
+
+  template<typename Framework, typename Vertex>
+  void GeometryArena<Framework, Vertex>::setIndices( nyx::Chain<Framework>& chain, const Allocation& allocation, const unsigned* indices )
+  {
+    chain.copy( indices, this->d_indices, allocation.index_count, 0, allocation.first_index ) ;
+  }
+
+  template<typename Framework, typename Vertex>
+  typename GeometryArena<Framework, Vertex>::Allocation GeometryArena<Framework, Vertex>::add( nyx::Chain<Framework>& chain, const Vertex* vertices, unsigned vertex_count, const nyx::Array<Framework, unsigned>& indices )
+  {
+    Allocation allocation = this->reserve( chain, vertex_count, indices.size() ) ;
+
+    chain.copy( vertices, this->d_vertices, allocation.vertex_count, 0, allocation.base_vertex ) ;
+    chain.copy( indices , this->d_indices , allocation.index_count , 0, allocation.first_index ) ;
+
+    return allocation ;
+  }
+
+  template<typename Framework, typename Vertex>
+  typename GeometryArena<Framework, Vertex>::Allocation GeometryArena<Framework, Vertex>::reserve( nyx::Chain<Framework>& chain, unsigned vertex_count, unsigned index_count )
+  {
+    Allocation allocation ;
+
+    allocation.vertex_count = vertex_count ;
+    allocation.index_count  = index_count  ;
+    allocation.base_vertex  = this->vertex_list.allocate( allocation.vertex_count ) ;
+    allocation.first_index  = this->index_list .allocate( allocation.index_count  ) ;
+
+    if( allocation.base_vertex == UINT_MAX )
+    {
+      this->grow( chain, this->d_vertices, this->vertex_list, allocation.vertex_count, nyx::ArrayFlags::Vertex | nyx::ArrayFlags::StorageBuffer | nyx::ArrayFlags::TransferSrc | nyx::ArrayFlags::TransferDst ) ;
+      allocation.base_vertex = this->vertex_list.allocate( allocation.vertex_count ) ;
+    }
+
+    if( allocation.first_index == UINT_MAX )
+    {
+      this->grow( chain, this->d_indices, this->index_list, allocation.index_count, nyx::ArrayFlags::Index | nyx::ArrayFlags::StorageBuffer | nyx::ArrayFlags::TransferSrc | nyx::ArrayFlags::TransferDst ) ;
+      allocation.first_index = this->index_list.allocate( allocation.index_count ) ;
+    }
+
+    return allocation ;
+  }
+
+  template<typename Framework, typename Vertex>
+  void GeometryArena<Framework, Vertex>::remove( const Allocation& allocation )
+  {
+    this->vertex_list.release( allocation.base_vertex, allocation.vertex_count ) ;
+    this->index_list .release( allocation.first_index, allocation.index_count  ) ;
+  }
+
+  template<typename Framework, typename Vertex>
+  const nyx::Array<Framework, Vertex>& GeometryArena<Framework, Vertex>::vertices() const
+  {
+    return this->d_vertices ;
+  }
+
+  template<typename Framework, typename Vertex>
+  const nyx::Array<Framework, unsigned>& GeometryArena<Framework, Vertex>::indices() const
+  {
+    return this->d_indices ;
+  }
+
+  template<typename Framework, typename Vertex>
+  void GeometryArena<Framework, Vertex>::reset()
+  {
+    this->d_vertices.reset() ;
+    this->d_indices .reset() ;
+    this->vertex_list.initialize( 0 ) ;
+    this->index_list .initialize( 0 ) ;
+  }
+
+  template<typename Framework, typename Vertex>
+  template<typename Type>
+  void GeometryArena<Framework, Vertex>::grow( nyx::Chain<Framework>& chain, nyx::Array<Framework, Type>& array, FreeList& list, unsigned count, nyx::ArrayFlags flags )
+  {
+    nyx::Array<Framework, Type> old      ;
+    const unsigned              previous = list.capacity()                             ;
+    const unsigned              capacity = std::max( previous * 2, previous + count ) ;
+
+    // Finish any copies still touching the buffer, then stash it's contents while it is reallocated.
+    chain.submit     () ;
+    chain.synchronize() ;
+
+    if( previous != 0 )
+    {
+      old.initialize   ( this->gpu, previous, false, nyx::ArrayFlags::TransferSrc | nyx::ArrayFlags::TransferDst ) ;
+      chain.copy       ( array, old, previous, 0, 0 ) ;
+      chain.submit     () ;
+      chain.synchronize() ;
+    }
+
+    array.reset     () ;
+    array.initialize( this->gpu, capacity, false, flags ) ;
+
+    if( previous != 0 )
+    {
+      chain.copy       ( old, array, previous, 0, 0 ) ;
+      chain.submit     () ;
+      chain.synchronize() ;
+      old.reset        () ;
+    }
+
+    list.grow( capacity ) ;
+  }
+}
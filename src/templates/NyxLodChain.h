@@ -0,0 +1,168 @@
+/*
+ * Copyright (C) 2020 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <Mars/Model.h>
+#include <Mars/Manager.h>
+#include <unordered_map>
+#include <vector>
+#include <mutex>
+#include <algorithm>
+
+namespace nyx
+{
+  /** The fraction of a level's switch size a drawable has to move past before it's level changes.
+   * Keeps drawables sitting right at a switch distance from popping between levels every frame.
+   */
+  constexpr float LOD_HYSTERESIS = 0.1f ;
+
+  /** Function to select which level of detail to draw something at.
+   * @param sizes The switch sizes of each reduced level, most detailed first. See @LodChain::Level.
+   * @param count The amount of reduced levels.
+   * @param size The current screen size of the drawable, as a fraction of the screen height.
+   * @param current The level the drawable was last drawn at, where 0 is full detail and N is the N-th reduced level.
+   * @return The level to draw at.
+   */
+  inline unsigned selectLod( const float* sizes, unsigned count, float size, unsigned current ) ;
+
+  /** Static class to associate models with the reduced level-of-detail models used to draw them from afar.
+   * Chains are registered by whoever loads models ( e.g. the database ), and read by the modules drawing them.
+   * Registering & reading may happen on different threads, so every access is locked and reads hand out copies.
+   */
+  template<typename Framework>
+  class LodChain
+  {
+    public:
+      using Model = mars::Model<Framework> ;
+
+      /** Structure describing a single reduced level of a model.
+       */
+      struct Level
+      {
+        mars::Reference<Model> model ; ///< The reduced model to draw for this level.
+        float                  size  ; ///< The screen size, as a fraction of the screen height, below which this level is used.
+      };
+
+      /** Static method to set the bounding radius of a model, used to estimate it's size on screen.
+       * @param model The full detail model.
+       * @param radius The radius of the model's bounding sphere, in model space.
+       */
+      static void setRadius( const Model& model, float radius ) ;
+
+      /** Static method to add a reduced level to a model's chain. Levels are kept ordered from most to least detailed.
+       * @param model The full detail model.
+       * @param level The reduced model.
+       * @param size The screen size, as a fraction of the screen height, below which the reduced model is used.
+       */
+      static void add( const Model& model, const mars::Reference<Model>& level, float size ) ;
+
+      /** Static method to retrieve a copy of the reduced levels of a model.
+       * @param model The full detail model.
+       * @return The reduced levels of the model, most detailed first. Empty if the model has no chain.
+       */
+      static std::vector<Level> levels( const Model& model ) ;
+
+      /** Static method to retrieve the bounding radius of a model.
+       * @param model The full detail model.
+       * @return The radius of the model's bounding sphere. 1.0 if none was set.
+       */
+      static float radius( const Model& model ) ;
+
+    private:
+
+      /** Structure containing the level of detail information of a single model.
+       */
+      struct Chain
+      {
+        float              radius = 1.0f ;
+        std::vector<Level> levels        ;
+      };
+
+      /** Static method to retrieve the map of all chains. Function-local so that every module shares the same map.
+       * @return Reference to the map of all chains.
+       */
+      static std::unordered_map<const Model*, Chain>& chains() ;
+
+      /** Static method to retrieve the mutex guarding the map of all chains.
+       * @return Reference to the mutex guarding @chains.
+       */
+      static std::mutex& mutex() ;
+  };
+
+  unsigned selectLod( const float* sizes, unsigned count, float size, unsigned current )
+  {
+    unsigned level = std::min( current, count ) ;
+
+    // Only step coarser once clearly below a switch size, and only step finer once clearly above it.
+    while( level < count && size < sizes[ level     ] * ( 1.0f - LOD_HYSTERESIS ) ) level++ ;
+    while( level > 0     && size > sizes[ level - 1 ] * ( 1.0f + LOD_HYSTERESIS ) ) level-- ;
+
+    return level ;
+  }
+
+  template<typename Framework>
+  void LodChain<Framework>::setRadius( const Model& model, float radius )
+  {
+    std::lock_guard<std::mutex> lock( LodChain::mutex() ) ;
+
+    LodChain::chains()[ &model ].radius = radius ;
+  }
+
+  template<typename Framework>
+  void LodChain<Framework>::add( const Model& model, const mars::Reference<Model>& level, float size )
+  {
+    std::lock_guard<std::mutex> lock( LodChain::mutex() ) ;
+
+    auto& levels = LodChain::chains()[ &model ].levels ;
+
+    levels.push_back( { level, size } ) ;
+    std::stable_sort( levels.begin(), levels.end(), [] ( const Level& a, const Level& b ) { return a.size > b.size ; } ) ;
+  }
+
+  template<typename Framework>
+  std::vector<typename LodChain<Framework>::Level> LodChain<Framework>::levels( const Model& model )
+  {
+    std::lock_guard<std::mutex> lock( LodChain::mutex() ) ;
+
+    auto iter = LodChain::chains().find( &model ) ;
+    return iter != LodChain::chains().end() ? iter->second.levels : std::vector<Level>() ;
+  }
+
+  template<typename Framework>
+  float LodChain<Framework>::radius( const Model& model )
+  {
+    std::lock_guard<std::mutex> lock( LodChain::mutex() ) ;
+
+    auto iter = LodChain::chains().find( &model ) ;
+    return iter != LodChain::chains().end() ? iter->second.radius : 1.0f ;
+  }
+
+  template<typename Framework>
+  std::unordered_map<const typename LodChain<Framework>::Model*, typename LodChain<Framework>::Chain>& LodChain<Framework>::chains()
+  {
+    static std::unordered_map<const Model*, Chain> map ;
+    return map ;
+  }
+
+  template<typename Framework>
+  std::mutex& LodChain<Framework>::mutex()
+  {
+    static std::mutex lock ;
+    return lock ;
+  }
+}
@@ -0,0 +1,232 @@
+/*
+ * Copyright (C) 2020 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+namespace nyx
+{
+  /** The most unique vertices a single meshlet may reference.
+   */
+  constexpr unsigned MESHLET_VERTICES = 64 ;
+
+  /** The most triangles a single meshlet may contain.
+   */
+  constexpr unsigned MESHLET_TRIANGLES = 124 ;
+
+  /** Structure describing a cluster of neighbouring triangles that is culled as a whole.
+   * Matches Meshlet in the shader meshlet_cull.comp.glsl.
+   */
+  struct Meshlet
+  {
+    glm::vec4 sphere        ; ///< The bounding sphere of the meshlet in model space. xyz is the center, w the radius.
+    glm::vec4 cone          ; ///< The cone of the meshlet's normals. xyz is the axis, w the sine of it's spread. 1 means it can never be backface culled.
+    unsigned  first_index   ; ///< The meshlet's first index, relative to the mesh's first index.
+    unsigned  index_count   ; ///< The amount of indices in the meshlet.
+    unsigned  padding[ 2 ]  ;
+  };
+
+  /** Function to split a triangle list into meshlets of neighbouring triangles.
+   * The indices are reordered in place so that every meshlet is a contiguous range of them, keeping each triangle's winding.
+   * @param vertices The vertices of the mesh. Only their position, vertex, is read.
+   * @param vertex_count The amount of vertices.
+   * @param indices The indices of the mesh's triangle list, reordered in place.
+   * @param index_count The amount of indices.
+   * @param meshlets The list to append the built meshlets to.
+   * @return The amount of meshlets built.
+   */
+  template<typename Vertex>
+  unsigned buildMeshlets( const Vertex* vertices, unsigned vertex_count, unsigned* indices, unsigned index_count, std::vector<Meshlet>& meshlets ) ;
+
+  /** Function to check whether a meshlet faces entirely away from a viewer. Mirrors the test in meshlet_cull.comp.glsl.
+   * @param meshlet The meshlet to test, in the same space as the eye.
+   * @param eye The position of the viewer.
+   * @return Whether no triangle of the meshlet can be front facing.
+   */
+  inline bool meshletBackfacing( const Meshlet& meshlet, const glm::vec3& eye ) ;
+
+  /** Function to compute the bounding sphere & normal cone of a range of a triangle list.
+   * @param vertices The vertices of the mesh.
+   * @param indices The first index of the range.
+   * @param index_count The amount of indices in the range.
+   * @param meshlet The meshlet to write the bounds of.
+   */
+  template<typename Vertex>
+  void meshletBounds( const Vertex* vertices, const unsigned* indices, unsigned index_count, Meshlet& meshlet ) ;
+
+  bool meshletBackfacing( const Meshlet& meshlet, const glm::vec3& eye )
+  {
+    const glm::vec3 offset = glm::vec3( meshlet.sphere ) - eye ;
+
+    return glm::dot( offset, glm::vec3( meshlet.cone ) ) >= meshlet.cone.w * glm::length( offset ) + meshlet.sphere.w ;
+  }
+
+  template<typename Vertex>
+  void meshletBounds( const Vertex* vertices, const unsigned* indices, unsigned index_count, Meshlet& meshlet )
+  {
+    glm::vec3 low    = glm::vec3( vertices[ indices[ 0 ] ].vertex ) ;
+    glm::vec3 high   = low                                         ;
+    glm::vec3 axis   = glm::vec3( 0.0f )                           ;
+    float     radius = 0.0f                                        ;
+    float     spread = 1.0f                                        ;
+
+    for( unsigned index = 0; index < index_count; index++ )
+    {
+      low  = glm::min( low , glm::vec3( vertices[ indices[ index ] ].vertex ) ) ;
+      high = glm::max( high, glm::vec3( vertices[ indices[ index ] ].vertex ) ) ;
+    }
+
+    const glm::vec3 center = ( low + high ) * 0.5f ;
+
+    for( unsigned index = 0; index < index_count; index++ )
+    {
+      radius = std::max( radius, glm::length( glm::vec3( vertices[ indices[ index ] ].vertex ) - center ) ) ;
+    }
+
+    // The cone axis is the average of the face normals, and it's spread the normal furthest from it.
+    for( unsigned index = 0; index + 2 < index_count; index += 3 )
+    {
+      const glm::vec3 a      = glm::vec3( vertices[ indices[ index     ] ].vertex ) ;
+      const glm::vec3 b      = glm::vec3( vertices[ indices[ index + 1 ] ].vertex ) ;
+      const glm::vec3 c      = glm::vec3( vertices[ indices[ index + 2 ] ].vertex ) ;
+      const glm::vec3 normal = glm::cross( b - a, c - a )                           ;
+      const float     length = glm::length( normal )                                ;
+
+      if( length > 0.0f ) axis += normal / length ;
+    }
+
+    if( glm::length( axis ) > 0.0f )
+    {
+      float closest = 1.0f ;
+
+      axis = glm::normalize( axis ) ;
+
+      for( unsigned index = 0; index + 2 < index_count; index += 3 )
+      {
+        const glm::vec3 a      = glm::vec3( vertices[ indices[ index     ] ].vertex ) ;
+        const glm::vec3 b      = glm::vec3( vertices[ indices[ index + 1 ] ].vertex ) ;
+        const glm::vec3 c      = glm::vec3( vertices[ indices[ index + 2 ] ].vertex ) ;
+        const glm::vec3 normal = glm::cross( b - a, c - a )                           ;
+        const float     length = glm::length( normal )                                ;
+
+        if( length > 0.0f ) closest = std::min( closest, glm::dot( axis, normal / length ) ) ;
+      }
+
+      // Normals spreading past a hemisphere can always face the viewer somewhere.
+      if( closest > 0.0f ) spread = std::sqrt( 1.0f - closest * closest ) ;
+    }
+
+    meshlet.sphere = glm::vec4( center, radius ) ;
+    meshlet.cone   = glm::vec4( axis  , spread ) ;
+  }
+
+  template<typename Vertex>
+  unsigned buildMeshlets( const Vertex* vertices, unsigned vertex_count, unsigned* indices, unsigned index_count, std::vector<Meshlet>& meshlets )
+  {
+    const unsigned triangle_count = index_count / 3 ;
+    const unsigned first          = meshlets.size() ;
+
+    std::vector<unsigned> offsets   ( vertex_count + 1, 0       ) ;
+    std::vector<unsigned> counts    ( vertex_count    , 0       ) ;
+    std::vector<unsigned> adjacency ( triangle_count * 3        ) ;
+    std::vector<unsigned> owner     ( vertex_count    , UINT_MAX ) ;
+    std::vector<bool>     used      ( triangle_count  , false   ) ;
+    std::vector<unsigned> output                                  ;
+    std::vector<unsigned> candidates                              ;
+    unsigned              cursor = 0                              ;
+
+    for( unsigned index = 0; index < triangle_count * 3; index++ ) counts[ indices[ index ] ]++ ;
+    for( unsigned vertex = 0; vertex < vertex_count; vertex++ ) offsets[ vertex + 1 ] = offsets[ vertex ] + counts[ vertex ] ;
+
+    std::fill( counts.begin(), counts.end(), 0 ) ;
+    for( unsigned index = 0; index < triangle_count * 3; index++ )
+    {
+      adjacency[ offsets[ indices[ index ] ] + counts[ indices[ index ] ]++ ] = index / 3 ;
+    }
+
+    output.reserve( triangle_count * 3 ) ;
+
+    while( cursor < triangle_count )
+    {
+      const unsigned id        = meshlets.size() ;
+      unsigned       unique    = 0               ;
+      unsigned       triangles = 0               ;
+      Meshlet        meshlet                     ;
+
+      while( cursor < triangle_count && used[ cursor ] ) cursor++ ;
+      if( cursor == triangle_count ) break ;
+
+      meshlet.first_index = output.size() ;
+      candidates.assign( 1, cursor ) ;
+
+      // Grow the meshlet from it's seed, always taking the neighbour that adds the fewest new vertices.
+      while( triangles < MESHLET_TRIANGLES && !candidates.empty() )
+      {
+        unsigned best  = UINT_MAX ;
+        unsigned added = 4        ;
+        unsigned kept  = 0        ;
+
+        for( auto tri : candidates )
+        {
+          if( used[ tri ] ) continue ;
+
+          unsigned fresh = 0 ;
+          for( unsigned corner = 0; corner < 3; corner++ ) if( owner[ indices[ tri * 3 + corner ] ] != id ) fresh++ ;
+
+          candidates[ kept++ ] = tri ;
+          if( fresh < added && unique + fresh <= MESHLET_VERTICES ) { best = tri ; added = fresh ; }
+        }
+
+        candidates.resize( kept ) ;
+        if( best == UINT_MAX ) break ;
+
+        used[ best ] = true ;
+        triangles++ ;
+        unique += added ;
+
+        for( unsigned corner = 0; corner < 3; corner++ )
+        {
+          const unsigned vertex = indices[ best * 3 + corner ] ;
+
+          output.push_back( vertex ) ;
+          if( owner[ vertex ] == id ) continue ;
+
+          owner[ vertex ] = id ;
+          for( unsigned adjacent = offsets[ vertex ]; adjacent < offsets[ vertex + 1 ]; adjacent++ )
+          {
+            if( !used[ adjacency[ adjacent ] ] ) candidates.push_back( adjacency[ adjacent ] ) ;
+          }
+        }
+      }
+
+      meshlet.index_count  = output.size() - meshlet.first_index ;
+      meshlet.padding[ 0 ] = 0                                   ;
+      meshlet.padding[ 1 ] = 0                                   ;
+      nyx::meshletBounds( vertices, output.data() + meshlet.first_index, meshlet.index_count, meshlet ) ;
+      meshlets.push_back( meshlet ) ;
+    }
+
+    std::copy( output.begin(), output.end(), indices ) ;
+
+    return meshlets.size() - first ;
+  }
+}
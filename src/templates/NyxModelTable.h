@@ -0,0 +1,187 @@
+/*
+ * Copyright (C) 2020 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <unordered_map>
+#include <algorithm>
+#include <utility>
+#include <vector>
+#include <climits>
+
+namespace nyx
+{
+  /** Class to map drawables to integer handles of the models they draw, so recording never has to look a model up.
+   * Drawables are only queued when added, and resolved later in one go, e.g. once the module drawing them is initialized.
+   * Every model is only resolved the first time it is seen, no matter how many drawables share it.
+   */
+  template<typename Model>
+  class ModelTable
+  {
+    public:
+
+      /** Method to queue a drawable to be resolved on the next call to @resolve.
+       * @param id The id of the drawable.
+       * @param model The model of the drawable. Has to outlive the drawable.
+       */
+      void add( unsigned id, const Model& model ) ;
+
+      /** Method to forget a drawable, whether it was resolved yet or not.
+       * @param id The id of the drawable.
+       */
+      void remove( unsigned id ) ;
+
+      /** Method to resolve every queued drawable, in the order they were added.
+       * @param function The function to call with a model not seen before, returning the handle to use for it.
+       * @return The amount of drawables resolved.
+       */
+      template<typename Resolve>
+      unsigned resolve( Resolve function ) ;
+
+      /** Method to retrieve the handle of a model, resolving it first if it was not seen before.
+       * Usable from within the resolve function, e.g. for the levels of detail of a model.
+       * @param model The model to retrieve the handle of.
+       * @param function The function to call if the model was not seen before, returning the handle to use for it.
+       * @return The handle of the model.
+       */
+      template<typename Resolve>
+      unsigned handle( const Model& model, Resolve function ) ;
+
+      /** Method to retrieve the handle of the model a drawable draws.
+       * @param id The id of the drawable.
+       * @return The handle of the drawable's model. UINT_MAX if the drawable is not resolved.
+       */
+      unsigned model( unsigned id ) const ;
+
+      /** Method to retrieve the level of detail a drawable was last drawn at.
+       * @param id The id of the drawable.
+       * @return The level of the drawable, where 0 is full detail.
+       */
+      unsigned lod( unsigned id ) const ;
+
+      /** Method to set the level of detail a drawable is drawn at.
+       * @param id The id of the drawable. Has to be resolved.
+       * @param level The level of the drawable, where 0 is full detail.
+       */
+      void setLod( unsigned id, unsigned level ) ;
+
+      /** Method to retrieve the amount of drawable ids this table has room for, resolved or not.
+       * @return The amount of drawable ids to iterate over.
+       */
+      unsigned size() const ;
+
+      /** Method to retrieve the amount of drawables waiting to be resolved.
+       * @return The amount of queued drawables.
+       */
+      unsigned pending() const ;
+
+    private:
+      std::unordered_map<const Model*, unsigned>     handles        ;
+      std::vector<std::pair<unsigned, const Model*>> queue          ;
+      std::vector<unsigned>                          drawable_model ;
+      std::vector<unsigned>                          drawable_lod   ;
+  };
+
+  template<typename Model>
+  void ModelTable<Model>::add( unsigned id, const Model& model )
+  {
+    this->queue.push_back( { id, &model } ) ;
+  }
+
+  template<typename Model>
+  void ModelTable<Model>::remove( unsigned id )
+  {
+    auto match = [=] ( const std::pair<unsigned, const Model*>& entry ) { return entry.first == id ; } ;
+
+    this->queue.erase( std::remove_if( this->queue.begin(), this->queue.end(), match ), this->queue.end() ) ;
+
+    if( id < this->drawable_model.size() )
+    {
+      this->drawable_model[ id ] = UINT_MAX ;
+      this->drawable_lod  [ id ] = 0        ;
+    }
+  }
+
+  template<typename Model>
+  template<typename Resolve>
+  unsigned ModelTable<Model>::resolve( Resolve function )
+  {
+    const unsigned count = this->queue.size() ;
+
+    for( const auto& entry : this->queue )
+    {
+      if( entry.first >= this->drawable_model.size() )
+      {
+        this->drawable_model.resize( entry.first + 1, UINT_MAX ) ;
+        this->drawable_lod  .resize( entry.first + 1, 0        ) ;
+      }
+
+      this->drawable_model[ entry.first ] = this->handle( *entry.second, function ) ;
+      this->drawable_lod  [ entry.first ] = 0                                        ;
+    }
+
+    this->queue.clear() ;
+
+    return count ;
+  }
+
+  template<typename Model>
+  template<typename Resolve>
+  unsigned ModelTable<Model>::handle( const Model& model, Resolve function )
+  {
+    auto iter = this->handles.find( &model ) ;
+
+    if( iter == this->handles.end() )
+    {
+      const unsigned value = function( model ) ;
+
+      iter = this->handles.insert( { &model, value } ).first ;
+    }
+
+    return iter->second ;
+  }
+
+  template<typename Model>
+  unsigned ModelTable<Model>::model( unsigned id ) const
+  {
+    return id < this->drawable_model.size() ? this->drawable_model[ id ] : UINT_MAX ;
+  }
+
+  template<typename Model>
+  unsigned ModelTable<Model>::lod( unsigned id ) const
+  {
+    return id < this->drawable_lod.size() ? this->drawable_lod[ id ] : 0 ;
+  }
+
+  template<typename Model>
+  void ModelTable<Model>::setLod( unsigned id, unsigned level )
+  {
+    this->drawable_lod[ id ] = level ;
+  }
+
+  template<typename Model>
+  unsigned ModelTable<Model>::size() const
+  {
+    return this->drawable_model.size() ;
+  }
+
+  template<typename Model>
+  unsigned ModelTable<Model>::pending() const
+  {
+    return this->queue.size() ;
+  }
+}
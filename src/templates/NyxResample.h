@@ -0,0 +1,365 @@
+/*
+ * Copyright (C) 2020 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cmath>
+
+namespace nyx
+{
+  /** The output pixels of a line each workgroup of resample.comp.glsl writes.
+   */
+  constexpr unsigned RESAMPLE_BLOCK = 64 ;
+
+  /** The lines each workgroup of resample.comp.glsl resamples.
+   */
+  constexpr unsigned RESAMPLE_LINES = 2 ;
+
+  /** The most input pixels of a line resample.comp.glsl keeps in shared memory. Wider spans are read from the image directly.
+   */
+  constexpr unsigned RESAMPLE_TILE = 384 ;
+
+  /** The filters an image can be resampled with.
+   */
+  enum class ResampleFilter : unsigned
+  {
+    Bilinear = 0, ///< A single bilinear fetch per pixel, done by a blit. Aliases when shrinking by more than half.
+    Box      = 1, ///< The average of every input pixel the output pixel covers.
+    Bicubic  = 2, ///< Catmull-Rom, sharper than box with little ringing.
+    Lanczos3 = 3, ///< Windowed sinc of three lobes, the sharpest, with some ringing at hard edges.
+  };
+
+  /** Structure describing the input pixels of one output pixel. Matches Span in the shader resample.comp.glsl.
+   */
+  struct ResampleSpan
+  {
+    int first ; ///< The first input pixel along the axis.
+    int count ; ///< The amount of input pixels, each with a weight.
+  };
+
+  /** Structure describing one pass of a resample. Matches the push constant of resample.comp.glsl.
+   */
+  struct ResamplePass
+  {
+    unsigned axis   ; ///< 0 to resample along x, 1 along y.
+    unsigned offset ; ///< The first span of this pass. It's weights start at offset * taps.
+    unsigned taps   ; ///< The weights kept per span.
+    unsigned size   ; ///< The amount of output pixels along the axis.
+  };
+
+  /** Function to retrieve the filter named by a string, bilinear if unknown.
+   * @param name The name of the filter, "bilinear", "box", "bicubic" or "lanczos3".
+   * @return The filter.
+   */
+  inline ResampleFilter resampleFilter( const std::string& name ) ;
+
+  /** Function to retrieve how far from it's center a filter reaches, in output pixels.
+   * @param filter The filter.
+   * @return The radius of the filter.
+   */
+  inline float resampleRadius( ResampleFilter filter ) ;
+
+  /** Function to evaluate a filter.
+   * @param filter The filter.
+   * @param x The distance from the center of the output pixel, in output pixels.
+   * @return The weight of an input pixel at that distance, before normalizing.
+   */
+  inline float resampleWeight( ResampleFilter filter, float x ) ;
+
+  /** Class to build the weights of a separable resample, once per change of size.
+   * Every output pixel keeps the span of input pixels under the filter & their normalized weights, so the shader only multiplies & adds.
+   * Spans of the horizontal pass come first, those of the vertical pass after them.
+   */
+  class ResampleKernel
+  {
+    public:
+
+      /** Default constructor.
+       */
+      ResampleKernel() ;
+
+      /** Method to build the weights of a resample between two sizes.
+       * @param filter The filter to resample with.
+       * @param in_width The width of the input.
+       * @param in_height The height of the input.
+       * @param out_width The width of the output.
+       * @param out_height The height of the output.
+       */
+      void build( ResampleFilter filter, unsigned in_width, unsigned in_height, unsigned out_width, unsigned out_height ) ;
+
+      /** Method to resample an image of floats on the host, exactly as resample.comp.glsl does. Used as a reference.
+       * @param input The input image, @channels floats per pixel.
+       * @param output The output image to write.
+       * @param channels The floats per pixel.
+       */
+      void apply( const float* input, float* output, unsigned channels = 4 ) const ;
+
+      /** Method to retrieve one pass of this kernel.
+       * @param axis 0 for the horizontal pass, 1 for the vertical.
+       * @return The push constant of the pass.
+       */
+      ResamplePass pass( unsigned axis ) const ;
+
+      /** Method to retrieve the spans of both passes.
+       * @return The spans, horizontal then vertical.
+       */
+      const std::vector<ResampleSpan>& spans() const ;
+
+      /** Method to retrieve the weights of both passes, @taps per span.
+       * @return The weights, horizontal then vertical.
+       */
+      const std::vector<float>& weights() const ;
+
+      /** Method to retrieve the most input pixels any output pixel reads.
+       * @return The weights kept per span.
+       */
+      unsigned taps() const ;
+
+      /** Method to retrieve whether a pass's workgroups all fit their input in shared memory.
+       * @param axis 0 for the horizontal pass, 1 for the vertical.
+       * @return Whether every block of the pass is read into shared memory.
+       */
+      bool tiled( unsigned axis ) const ;
+
+    private:
+
+      /** Method to build the spans & weights of one axis.
+       * @param in The input size along the axis.
+       * @param out The output size along the axis.
+       * @param first The first span of the axis.
+       */
+      void buildAxis( unsigned in, unsigned out, unsigned first ) ;
+
+      std::vector<ResampleSpan> span_list   ;
+      std::vector<float>        weight_list ;
+      ResampleFilter            filter      ;
+      unsigned                  in_width    ;
+      unsigned                  in_height   ;
+      unsigned                  out_width   ;
+      unsigned                  out_height  ;
+      unsigned                  tap_count   ;
+  };
+
+  ResampleFilter resampleFilter( const std::string& name )
+  {
+    if( name == "box"      ) return ResampleFilter::Box      ;
+    if( name == "bicubic"  ) return ResampleFilter::Bicubic  ;
+    if( name == "lanczos3" ) return ResampleFilter::Lanczos3 ;
+    return ResampleFilter::Bilinear ;
+  }
+
+  float resampleRadius( ResampleFilter filter )
+  {
+    switch( filter )
+    {
+      case ResampleFilter::Box      : return 0.5f ;
+      case ResampleFilter::Bicubic  : return 2.0f ;
+      case ResampleFilter::Lanczos3 : return 3.0f ;
+      default                       : return 1.0f ;
+    }
+  }
+
+  float resampleWeight( ResampleFilter filter, float x )
+  {
+    const float pi = 3.14159265358979f ;
+
+    x = std::fabs( x ) ;
+
+    switch( filter )
+    {
+      case ResampleFilter::Box :
+        return x < 0.5f ? 1.0f : 0.0f ;
+
+      case ResampleFilter::Bicubic :
+        if( x < 1.0f ) return (  1.5f * x - 2.5f ) * x * x + 1.0f ;
+        if( x < 2.0f ) return ( ( -0.5f * x + 2.5f ) * x - 4.0f ) * x + 2.0f ;
+        return 0.0f ;
+
+      case ResampleFilter::Lanczos3 :
+        if( x < 1e-5f ) return 1.0f ;
+        if( x < 3.0f  ) return 3.0f * std::sin( pi * x ) * std::sin( pi * x / 3.0f ) / ( pi * pi * x * x ) ;
+        return 0.0f ;
+
+      default :
+        return x < 1.0f ? 1.0f - x : 0.0f ;
+    }
+  }
+
+  inline ResampleKernel::ResampleKernel()
+  {
+    this->filter     = ResampleFilter::Bilinear ;
+    this->in_width   = 0                        ;
+    this->in_height  = 0                        ;
+    this->out_width  = 0                        ;
+    this->out_height = 0                        ;
+    this->tap_count  = 0                        ;
+  }
+
+  inline void ResampleKernel::build( ResampleFilter filter, unsigned in_width, unsigned in_height, unsigned out_width, unsigned out_height )
+  {
+    this->filter     = filter     ;
+    this->in_width   = in_width   ;
+    this->in_height  = in_height  ;
+    this->out_width  = out_width  ;
+    this->out_height = out_height ;
+    this->tap_count  = 0          ;
+
+    // Both axes share one stride of weights, the widest span of either.
+    for( unsigned axis = 0; axis < 2; axis++ )
+    {
+      const float scale  = std::max( 1.0f, static_cast<float>( axis == 0 ? in_width : in_height ) / static_cast<float>( axis == 0 ? out_width : out_height ) ) ;
+      const float radius = resampleRadius( filter ) * scale ;
+
+      this->tap_count = std::max( this->tap_count, static_cast<unsigned>( std::ceil( radius * 2.0f ) ) + 1 ) ;
+    }
+
+    this->span_list  .assign( out_width + out_height                    , { 0, 0 } ) ;
+    this->weight_list.assign( ( out_width + out_height ) * this->tap_count, 0.0f     ) ;
+
+    this->buildAxis( in_width , out_width , 0         ) ;
+    this->buildAxis( in_height, out_height, out_width ) ;
+  }
+
+  inline void ResampleKernel::buildAxis( unsigned in, unsigned out, unsigned first )
+  {
+    // Shrinking widens the filter to cover every input pixel under the output one. Growing keeps it at it's own size.
+    const float scale  = static_cast<float>( in ) / static_cast<float>( out ) ;
+    const float widen  = std::max( 1.0f, scale )                             ;
+    const float radius = resampleRadius( this->filter ) * widen              ;
+
+    for( unsigned index = 0; index < out; index++ )
+    {
+      const float center = ( index + 0.5f ) * scale                                                                   ;
+      const int   low    = std::max( 0                      , static_cast<int>( std::floor( center - radius ) )      ) ;
+      const int   high   = std::min( static_cast<int>( in ), static_cast<int>( std::ceil ( center + radius ) )      ) ;
+      float*      weight = this->weight_list.data() + ( first + index ) * this->tap_count                              ;
+      int         start  = -1                                                                                          ;
+      int         end    = -1                                                                                          ;
+      float       total  = 0.0f                                                                                        ;
+
+      // Only the run of input pixels with a weight is kept, so no tap is spent on zeros at the edges of the filter.
+      for( int pixel = low; pixel < high; pixel++ )
+      {
+        if( resampleWeight( this->filter, ( pixel + 0.5f - center ) / widen ) != 0.0f )
+        {
+          if( start < 0 ) start = pixel ;
+          end = pixel + 1 ;
+        }
+      }
+
+      if( start < 0 )
+      {
+        start = std::min( static_cast<int>( center ), static_cast<int>( in ) - 1 ) ;
+        end   = start + 1                                                          ;
+      }
+
+      end = std::min( end, start + static_cast<int>( this->tap_count ) ) ;
+
+      for( int pixel = start; pixel < end; pixel++ )
+      {
+        weight[ pixel - start ] = resampleWeight( this->filter, ( pixel + 0.5f - center ) / widen ) ;
+        total += weight[ pixel - start ] ;
+      }
+
+      if( total == 0.0f )
+      {
+        weight[ 0 ] = 1.0f ;
+        total       = 1.0f ;
+      }
+
+      for( int tap = 0; tap < end - start; tap++ ) weight[ tap ] /= total ;
+
+      this->span_list[ first + index ] = { start, end - start } ;
+    }
+  }
+
+  inline void ResampleKernel::apply( const float* input, float* output, unsigned channels ) const
+  {
+    std::vector<float> between( this->out_width * this->in_height * channels, 0.0f ) ;
+
+    for( unsigned y = 0; y < this->in_height; y++ )
+    {
+      for( unsigned x = 0; x < this->out_width; x++ )
+      {
+        const ResampleSpan& span   = this->span_list[ x ]                                    ;
+        const float*        weight = this->weight_list.data() + x * this->tap_count         ;
+        float*              out    = between.data() + ( y * this->out_width + x ) * channels ;
+
+        for( int tap = 0; tap < span.count; tap++ )
+        {
+          const float* in = input + ( y * this->in_width + span.first + tap ) * channels ;
+
+          for( unsigned channel = 0; channel < channels; channel++ ) out[ channel ] += weight[ tap ] * in[ channel ] ;
+        }
+      }
+    }
+
+    std::fill( output, output + this->out_width * this->out_height * channels, 0.0f ) ;
+
+    for( unsigned y = 0; y < this->out_height; y++ )
+    {
+      const ResampleSpan& span   = this->span_list[ this->out_width + y ]                       ;
+      const float*        weight = this->weight_list.data() + ( this->out_width + y ) * this->tap_count ;
+
+      for( int tap = 0; tap < span.count; tap++ )
+      {
+        const float* in  = between.data() + ( span.first + tap ) * this->out_width * channels ;
+        float*       out = output + y * this->out_width * channels                           ;
+
+        for( unsigned value = 0; value < this->out_width * channels; value++ ) out[ value ] += weight[ tap ] * in[ value ] ;
+      }
+    }
+  }
+
+  inline ResamplePass ResampleKernel::pass( unsigned axis ) const
+  {
+    return { axis, axis == 0 ? 0 : this->out_width, this->tap_count, axis == 0 ? this->out_width : this->out_height } ;
+  }
+
+  inline const std::vector<ResampleSpan>& ResampleKernel::spans() const
+  {
+    return this->span_list ;
+  }
+
+  inline const std::vector<float>& ResampleKernel::weights() const
+  {
+    return this->weight_list ;
+  }
+
+  inline unsigned ResampleKernel::taps() const
+  {
+    return this->tap_count ;
+  }
+
+  inline bool ResampleKernel::tiled( unsigned axis ) const
+  {
+    const ResamplePass pass = this->pass( axis ) ;
+
+    for( unsigned block = 0; block < pass.size; block += RESAMPLE_BLOCK )
+    {
+      const ResampleSpan& low  = this->span_list[ pass.offset + block                                          ] ;
+      const ResampleSpan& high = this->span_list[ pass.offset + std::min( block + RESAMPLE_BLOCK, pass.size ) - 1 ] ;
+
+      if( high.first + high.count - low.first > static_cast<int>( RESAMPLE_TILE ) ) return false ;
+    }
+
+    return true ;
+  }
+}
@@ -0,0 +1,201 @@
+/*
+ * Copyright (C) 2020 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <templates/NyxGeometryArena.h>
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <vector>
+#include <climits>
+
+namespace nyx
+{
+  /** Function to skin a single vertex the same way the skinning pass does.
+   * Vertices without any weight are left where they are.
+   * @param vertex The vertex to skin. Needs the NGG vertex, normals, weights & ids members.
+   * @param bones The bone buffer the vertex's palette lives in.
+   * @param first_bone The first bone of the vertex's palette in the bone buffer. The vertex's bone ids are relative to it.
+   * @return The skinned vertex.
+   */
+  template<typename Vertex>
+  inline Vertex skinVertex( const Vertex& vertex, const glm::mat4* bones, unsigned first_bone ) ;
+
+  /** Class to pack the bone palettes of skinned drawables into one shared bone buffer, giving every drawable it's own range of it.
+   * A drawable only gets a new range when the size of it's palette changes, and released ranges are reused by later palettes.
+   */
+  class BonePalettes
+  {
+    public:
+
+      /** Method to initialize this object's bone buffer.
+       * @param capacity The initial amount of bones the buffer can hold.
+       */
+      void initialize( unsigned capacity ) ;
+
+      /** Method to copy a drawable's bone palette into the bone buffer, giving it a range of the buffer if it's size changed.
+       * The buffer grows when no free range is big enough.
+       * @param id The id of the drawable.
+       * @param palette Pointer to the first bone of the palette.
+       * @param count The amount of bones in the palette.
+       * @return Whether the drawable was given a new range, meaning anything referencing it's old range is stale.
+       */
+      bool set( unsigned id, const glm::mat4* palette, unsigned count ) ;
+
+      /** Method to give a drawable's range of the bone buffer back, so it can be reused by later palettes.
+       * @param id The id of the drawable.
+       * @return Whether the drawable had a palette.
+       */
+      bool remove( unsigned id ) ;
+
+      /** Method to check whether a drawable has a bone palette.
+       * @param id The id of the drawable.
+       * @return Whether the drawable is skinned.
+       */
+      bool skinned( unsigned id ) const ;
+
+      /** Method to retrieve the first bone of a drawable's range of the bone buffer.
+       * @param id The id of the drawable. Has to be skinned.
+       * @return The offset of the drawable's palette in the bone buffer.
+       */
+      unsigned first( unsigned id ) const ;
+
+      /** Method to retrieve the bone buffer every palette is packed into.
+       * @return Pointer to the first bone of the buffer.
+       */
+      const glm::mat4* bones() const ;
+
+      /** Method to retrieve the amount of bones the bone buffer holds, used or not.
+       * @return The capacity of the bone buffer.
+       */
+      unsigned size() const ;
+
+      /** Method to retrieve the amount of bones currently given to palettes.
+       * @return The amount of used bones.
+       */
+      unsigned used() const ;
+
+    private:
+
+      /** Structure describing a drawable's range of the bone buffer.
+       */
+      struct Range
+      {
+        unsigned first_bone ;
+        unsigned count      ;
+      };
+
+      nyx::FreeList          list   ;
+      std::vector<glm::mat4> buffer ;
+      std::vector<Range>     ranges ;
+  };
+
+  template<typename Vertex>
+  Vertex skinVertex( const Vertex& vertex, const glm::mat4* bones, unsigned first_bone )
+  {
+    const float total   = vertex.weights.x + vertex.weights.y + vertex.weights.z + vertex.weights.w ;
+    Vertex      skinned = vertex                                                                    ;
+
+    if( total > 0.0f )
+    {
+      const glm::mat4 skin = vertex.weights.x * bones[ first_bone + vertex.ids.x ] +
+                             vertex.weights.y * bones[ first_bone + vertex.ids.y ] +
+                             vertex.weights.z * bones[ first_bone + vertex.ids.z ] +
+                             vertex.weights.w * bones[ first_bone + vertex.ids.w ] ;
+
+      skinned.vertex  = skin * glm::vec4( glm::vec3( vertex.vertex ), 1.0f )                                          ;
+      skinned.normals = glm::vec4( glm::normalize( glm::mat3( skin ) * glm::vec3( vertex.normals ) ), vertex.normals.w ) ;
+    }
+
+    return skinned ;
+  }
+
+  inline void BonePalettes::initialize( unsigned capacity )
+  {
+    this->list  .initialize( capacity ) ;
+    this->buffer.resize    ( capacity ) ;
+    this->ranges.clear     (          ) ;
+  }
+
+  inline bool BonePalettes::set( unsigned id, const glm::mat4* palette, unsigned count )
+  {
+    bool moved = false ;
+
+    if( id >= this->ranges.size() ) this->ranges.resize( id + 1, { 0, 0 } ) ;
+
+    auto& range = this->ranges[ id ] ;
+
+    if( range.count != count )
+    {
+      if( range.count != 0 ) this->list.release( range.first_bone, range.count ) ;
+
+      range.count      = count                              ;
+      range.first_bone = this->list.allocate( range.count ) ;
+
+      if( range.first_bone == UINT_MAX )
+      {
+        this->list.grow( std::max( this->list.capacity() * 2, this->list.capacity() + range.count ) ) ;
+        range.first_bone = this->list.allocate( range.count ) ;
+      }
+
+      this->buffer.resize( this->list.capacity() ) ;
+      moved = true ;
+    }
+
+    std::copy( palette, palette + count, this->buffer.begin() + range.first_bone ) ;
+
+    return moved ;
+  }
+
+  inline bool BonePalettes::remove( unsigned id )
+  {
+    if( id < this->ranges.size() && this->ranges[ id ].count != 0 )
+    {
+      this->list.release( this->ranges[ id ].first_bone, this->ranges[ id ].count ) ;
+      this->ranges[ id ] = { 0, 0 } ;
+
+      return true ;
+    }
+
+    return false ;
+  }
+
+  inline bool BonePalettes::skinned( unsigned id ) const
+  {
+    return id < this->ranges.size() && this->ranges[ id ].count != 0 ;
+  }
+
+  inline unsigned BonePalettes::first( unsigned id ) const
+  {
+    return this->ranges[ id ].first_bone ;
+  }
+
+  inline const glm::mat4* BonePalettes::bones() const
+  {
+    return this->buffer.data() ;
+  }
+
+  inline unsigned BonePalettes::size() const
+  {
+    return this->buffer.size() ;
+  }
+
+  inline unsigned BonePalettes::used() const
+  {
+    return this->list.used() ;
+  }
+}
@@ -0,0 +1,1086 @@
+/*
+ * Copyright (C) 2020 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "NyxAtlas.h"
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <list>
+#include <cstring>
+#include <cstdint>
+
+namespace nyx
+{
+  /** The default most glyphs drawn in a frame, the size of the glyph instance buffer.
+   */
+  constexpr unsigned TEXT_GLYPHS = 131072 ;
+
+  /** The amount of glyphs the slot of a string in a text batch is rounded up to, leaving room for it to grow without moving any other string.
+   */
+  constexpr unsigned TEXT_SLACK = 8 ;
+
+  /** The width & height of the single page glyphs are packed into.
+   */
+  constexpr unsigned TEXT_ATLAS_SIZE = 1024 ;
+
+  /** The amount of source pixels the distance field reaches out from a glyph's edge, on every side of it.
+   * Text stays sharp scaled up until a single source pixel covers about this many pixels on screen.
+   */
+  constexpr unsigned GLYPH_SPREAD = 4 ;
+
+  /** The amount of distance field pixels every pixel of the built-in font is scaled up to.
+   */
+  constexpr unsigned GLYPH_SCALE = 4 ;
+
+  /** The glyph drawn in place of ones the font doesn't have.
+   */
+  constexpr unsigned GLYPH_MISSING = '?' ;
+
+  /** The default most laid out strings kept around for reuse.
+   */
+  constexpr unsigned TEXT_RUNS = 4096 ;
+
+  /** Structure describing a single glyph as coverage, before it's turned into a distance field.
+   * Every measure is in pixels of the coverage, with y growing down from the top of the line.
+   */
+  struct GlyphBitmap
+  {
+    std::vector<unsigned char> coverage  ; ///< One byte per pixel, row by row. Anything over half is inside the glyph.
+    unsigned                   width     ; ///< The width of the coverage.
+    unsigned                   height    ; ///< The height of the coverage.
+    float                      bearing_x ; ///< The offset from the pen to the left of the coverage.
+    float                      bearing_y ; ///< The offset from the top of the line to the top of the coverage.
+    float                      advance   ; ///< The amount the pen moves after this glyph.
+  };
+
+  /** Interface to whatever rasterizes a font on the host. Only ever asked for the glyphs strings actually use, once each.
+   */
+  class GlyphSource
+  {
+    public:
+
+      /** Virtual deconstructor. Needed for inheritance.
+       */
+      virtual ~GlyphSource() {}
+
+      /** Method to rasterize a glyph.
+       * @param code The unicode code point of the glyph.
+       * @param bitmap The bitmap to write the glyph's coverage & metrics to.
+       * @return Whether the font has the glyph.
+       */
+      virtual bool glyph( unsigned code, GlyphBitmap& bitmap ) const = 0 ;
+
+      /** Method to retrieve the distance between two lines of text.
+       * @return The height of a line, in pixels of the coverage.
+       */
+      virtual float lineHeight() const = 0 ;
+
+      /** Method to retrieve the adjustment of the pen between two glyphs.
+       * @param left The code point of the glyph on the left.
+       * @param right The code point of the glyph on the right.
+       * @return The amount to add to the left glyph's advance, in pixels of the coverage.
+       */
+      virtual float kerning( unsigned left, unsigned right ) const { ( void )left ; ( void )right ; return 0.0f ; }
+  };
+
+  /** The font used when no other is given. Printable ASCII drawn 5 x 7 pixels, scaled up so the distance field keeps it's corners.
+   */
+  class BitmapFont : public GlyphSource
+  {
+    public:
+
+      /** Constructor.
+       * @param scale The amount of coverage pixels each pixel of the font is scaled up to.
+       */
+      BitmapFont( unsigned scale = GLYPH_SCALE ) ;
+
+      bool glyph( unsigned code, GlyphBitmap& bitmap ) const override ;
+
+      float lineHeight() const override ;
+
+    private:
+      unsigned scale ;
+  };
+
+  /** Structure describing a glyph in the atlas. Quads are in pixels of the glyph source, the distance field's spread included.
+   */
+  struct Glyph
+  {
+    glm::vec4 region  ; ///< The glyph's rectangle in normalized coordinates of it's page. Zero size for glyphs with nothing to draw.
+    unsigned  page    ; ///< The page of the atlas the glyph was packed into.
+    float     x       ; ///< The offset from the pen to the left of the glyph's quad.
+    float     y       ; ///< The offset from the top of the line to the top of the glyph's quad.
+    float     width   ; ///< The width of the glyph's quad.
+    float     height  ; ///< The height of the glyph's quad.
+    float     advance ; ///< The amount the pen moves after this glyph.
+  };
+
+  /** What an instance samples, for shaders drawing glyphs & images together. Matches the modes in draw_2d.frag.glsl.
+   */
+  enum class InstanceMode : unsigned
+  {
+    Glyph = 0, ///< A glyph's distance field, on a page of the glyph atlas.
+    Image = 1, ///< An image, on a page of the image atlas.
+  };
+
+  /** Structure describing a single glyph to draw. Matches Glyph in the text shaders.
+   */
+  struct GlyphInstance
+  {
+    glm::vec4    rect      ; ///< The glyph's quad in the space of it's string, xy offset & zw size.
+    glm::vec4    region    ; ///< The glyph's rectangle on it's atlas page, xy offset & zw size.
+    glm::vec4    color     ; ///< The color the glyph is drawn in.
+    unsigned     page      ; ///< The atlas page the glyph is on.
+    unsigned     transform ; ///< The transform of the glyph's string.
+    InstanceMode mode      ; ///< What the instance samples. Always a glyph, unless drawn by NyxDraw2D.
+    unsigned     padding   ;
+  };
+
+  /** Method to turn glyph coverage into a signed distance field, stored in the alpha of white RGBA8 pixels.
+   * An alpha of one half is the glyph's edge, growing inside of it & shrinking outside of it until @spread pixels away.
+   * @param bitmap The glyph to turn into a distance field.
+   * @param spread The distance in pixels the field reaches out from the edge. The field is this much larger on every side.
+   * @param pixels The ( width + 2 * spread ) * ( height + 2 * spread ) pixels to write.
+   */
+  void signedDistance( const GlyphBitmap& bitmap, unsigned spread, std::vector<unsigned char>& pixels ) ;
+
+  /** The glyphs of a font, turned into distance fields the first time a string uses them & packed into an atlas.
+   * Lays strings out into glyph instances, every glyph a quad sampling it's distance field.
+   */
+  class GlyphSet
+  {
+    public:
+
+      /** Default constructor.
+       */
+      GlyphSet() ;
+
+      /** Method to initialize this set, forgetting every glyph loaded so far.
+       * @param source The font to rasterize glyphs from.
+       * @param atlas The atlas to pack glyphs into. Glyphs are added with their code point as id.
+       * @param spread The distance in pixels of the source the distance fields reach out from every glyph's edge.
+       */
+      void initialize( const GlyphSource* source, AtlasPages* atlas, unsigned spread = GLYPH_SPREAD ) ;
+
+      /** Method to look a glyph up, rasterizing it into the atlas if this is the first time it is asked for.
+       * @param code The code point of the glyph.
+       * @return The glyph, or nullptr if neither it nor GLYPH_MISSING are in the font, or the atlas is full.
+       */
+      const Glyph* find( unsigned code ) ;
+
+      /** Method to lay a string out into glyph instances. Whitespace moves the pen without drawing anything.
+       * @param text The UTF-8 string to lay out. Newlines start a new line.
+       * @param size The height of a line in the space of the string.
+       * @param transform The transform of the string, passed along to every glyph.
+       * @param color The color of the string.
+       * @param instances The glyph instances to write.
+       * @param capacity The most glyph instances to write.
+       * @return The amount of glyph instances written.
+       */
+      unsigned layout( const std::string& text, float size, unsigned transform, const glm::vec4& color, GlyphInstance* instances, unsigned capacity ) ;
+
+      /** Method to retrieve the amount of glyphs rasterized so far.
+       * @return The amount of glyphs in the atlas.
+       */
+      unsigned count() const ;
+
+      /** Method to retrieve the font glyphs are rasterized from.
+       * @return The font this set was initialized with.
+       */
+      const GlyphSource* font() const ;
+
+    private:
+
+      /** Method to rasterize a glyph into the atlas.
+       * @param code The code point of the glyph.
+       * @param glyph The glyph to write.
+       * @return Whether the font has the glyph & it fit into the atlas.
+       */
+      bool load( unsigned code, Glyph& glyph ) ;
+
+      using GlyphMap = std::unordered_map<unsigned, Glyph> ;
+
+      std::vector<Glyph>         ascii       ;
+      std::vector<unsigned char> loaded      ;
+      GlyphMap                   glyphs      ;
+      GlyphBitmap                bitmap      ;
+      std::vector<unsigned char> pixels      ;
+      const GlyphSource*         source      ;
+      AtlasPages*                atlas       ;
+      unsigned                   spread      ;
+      unsigned                   glyph_count ;
+  };
+
+  /** Structure describing how well a text run cache is doing.
+   */
+  struct TextRunStats
+  {
+    unsigned long long hits      = 0 ; ///< The strings found already laid out.
+    unsigned long long misses    = 0 ; ///< The strings that had to be laid out.
+    unsigned long long evictions = 0 ; ///< The runs dropped to make room for new ones.
+    unsigned           runs      = 0 ; ///< The runs currently kept.
+
+    /** Method to retrieve the part of strings found already laid out.
+     * @return The hits over every lookup, from 0 to 1.
+     */
+    float rate() const { return this->hits + this->misses != 0 ? static_cast<float>( static_cast<double>( this->hits ) / ( this->hits + this->misses ) ) : 0.0f ; }
+  };
+
+  /** A cache of laid out strings, keyed by font, size & a hash of the string.
+   * Strings drawn again & again, like labels & units, are laid out once and copied from then on. The least recently used runs make room for new ones.
+   */
+  class TextRunCache
+  {
+    public:
+
+      /** Default constructor.
+       */
+      TextRunCache() ;
+
+      /** Method to initialize this cache, dropping every run kept so far.
+       * @param glyphs The glyphs to lay strings out with.
+       * @param capacity The most runs to keep.
+       */
+      void initialize( GlyphSet* glyphs, unsigned capacity = TEXT_RUNS ) ;
+
+      /** Method to retrieve a string laid out, laying it out only if it isn't kept already.
+       * Glyphs of the run are at transform 0 & white. The run stays valid until the next call.
+       * @param text The UTF-8 string to lay out.
+       * @param size The height of a line in the space of the string.
+       * @return The glyph instances of the string.
+       */
+      const std::vector<GlyphInstance>& shape( const std::string& text, float size ) ;
+
+      /** Method to write a string's glyph instances, copied from it's run.
+       * @param text The UTF-8 string to lay out.
+       * @param size The height of a line in the space of the string.
+       * @param transform The transform of the string, passed along to every glyph.
+       * @param color The color of the string.
+       * @param instances The glyph instances to write.
+       * @param capacity The most glyph instances to write.
+       * @return The amount of glyph instances written.
+       */
+      unsigned write( const std::string& text, float size, unsigned transform, const glm::vec4& color, GlyphInstance* instances, unsigned capacity ) ;
+
+      /** Method to copy a run's glyph instances, moved to a string's transform & color.
+       * @param run The run to copy, as retrieved by @shape.
+       * @param transform The transform of the string, passed along to every glyph.
+       * @param color The color of the string.
+       * @param instances The glyph instances to write.
+       * @param capacity The most glyph instances to write.
+       * @return The amount of glyph instances written.
+       */
+      static unsigned copy( const std::vector<GlyphInstance>& run, unsigned transform, const glm::vec4& color, GlyphInstance* instances, unsigned capacity ) ;
+
+      /** Method to drop every run, for when the glyphs they point at are gone. Statistics are kept.
+       */
+      void clear() ;
+
+      /** Method to retrieve how well this cache is doing.
+       * @return The statistics of this cache.
+       */
+      const TextRunStats& stats() const ;
+
+    private:
+
+      /** Structure describing a laid out string.
+       */
+      struct Run
+      {
+        std::string                        text   ;
+        const GlyphSource*                 font   ;
+        float                              size   ;
+        std::vector<GlyphInstance>         glyphs ;
+        std::list<std::uint64_t>::iterator used   ;
+      };
+
+      /** Method to hash the key of a run.
+       * @param text The string.
+       * @param size The height of a line.
+       * @return The hash of the font, size & string.
+       */
+      std::uint64_t key( const std::string& text, float size ) const ;
+
+      using RunMap = std::unordered_map<std::uint64_t, Run> ;
+
+      RunMap                   runs     ;
+      std::list<std::uint64_t> lru      ;
+      TextRunStats             counters ;
+      GlyphSet*                glyphs   ;
+      unsigned                 capacity ;
+  };
+
+  /** Structure describing a range of glyph instances.
+   */
+  struct TextRange
+  {
+    unsigned offset ; ///< The first glyph instance of the range.
+    unsigned count  ; ///< The amount of glyph instances in the range.
+  };
+
+  /** Every string drawn together, packed one after the other into a single buffer of glyph instances.
+   * Every string gets a slot with some slack past it's glyphs, filled with blank instances, so a string changing length is patched where it is
+   * as long as it fits it's slot. Strings that didn't change are never laid out again: when nothing moves they aren't touched at all, otherwise
+   * their glyphs are copied from where they were. Changed strings come out of a run cache.
+   */
+  class TextBatch
+  {
+    public:
+
+      /** Default constructor.
+       */
+      TextBatch() ;
+
+      /** Method to initialize this batch, dropping every string.
+       * @param runs The run cache to lay strings out with.
+       * @param capacity The most glyph instances in the batch.
+       */
+      void initialize( TextRunCache* runs, unsigned capacity = TEXT_GLYPHS ) ;
+
+      /** Method to set the strings drawn & the order they are drawn in. Strings not in the order are kept, but not drawn.
+       * @param ids The ids of the strings to draw, also the transform of each string.
+       * @param count The amount of strings to draw.
+       */
+      void setOrder( const unsigned* ids, unsigned count ) ;
+
+      /** Method to set a string. Setting the string it already is does nothing.
+       * @param id The id of the string.
+       * @param text The UTF-8 string.
+       */
+      void setText( unsigned id, const std::string& text ) ;
+
+      /** Method to set the color of a string.
+       * @param id The id of the string.
+       * @param color The color to draw the string in.
+       */
+      void setColor( unsigned id, const glm::vec4& color ) ;
+
+      /** Method to set the height of a line of every string, laying every string out again.
+       * @param size The height of a line in the space of the strings.
+       */
+      void setSize( float size ) ;
+
+      /** Method to lay every string out again, for when the font changed.
+       */
+      void invalidate() ;
+
+      /** Method to bring the glyph instances up to date with every change since the last update.
+       * @return Whether any glyph instance changed.
+       */
+      bool update() ;
+
+      /** Method to retrieve the ranges of glyph instances the last update changed.
+       * @return The ranges to upload.
+       */
+      const std::vector<TextRange>& uploads() const ;
+
+      /** Method to retrieve the glyph instances of every string.
+       * @return The first of @count glyph instances.
+       */
+      const GlyphInstance* instances() const ;
+
+      /** Method to retrieve the amount of glyph instances of every string's slot, blank ones included.
+       * @return The amount of glyphs to draw.
+       */
+      unsigned count() const ;
+
+      /** Method to retrieve whether the strings didn't fit in the glyph instances, so the glyphs past the last one are dropped.
+       * @return Whether the batch is full.
+       */
+      bool full() const ;
+
+    private:
+
+      /** Structure describing a single string of the batch.
+       */
+      struct Entry
+      {
+        std::string text    = ""                ;
+        glm::vec4   color   = glm::vec4( 1.0f ) ;
+        unsigned    offset  = 0                 ;
+        unsigned    count   = 0                 ;
+        unsigned    slot    = 0                 ; ///< The amount of glyph instances the string has at it's offset, slack included.
+        bool        placed  = false             ; ///< Whether the string's glyphs are at it's offset in the current glyph instances.
+        bool        changed = true              ; ///< Whether the string changed since it's glyphs were written.
+      };
+
+      using EntryMap = std::unordered_map<unsigned, Entry> ;
+
+      EntryMap                   entries  ;
+      std::vector<unsigned>      order    ;
+      std::vector<unsigned>      changed  ;
+      std::vector<GlyphInstance> current  ;
+      std::vector<GlyphInstance> previous ;
+      std::vector<TextRange>     ranges   ;
+      TextRunCache*              runs     ;
+      float                      size     ;
+      unsigned                   glyphs   ;
+      bool                       repack   ;
+      bool                       reshape  ;
+      bool                       dropped  ;
+  };
+
+  /** Method to read the next code point of a UTF-8 string. Malformed bytes are read as themselves.
+   * @param text The string to read.
+   * @param index The byte to read from, moved past the code point.
+   * @return The code point.
+   */
+  inline unsigned decode( const std::string& text, std::size_t& index )
+  {
+    const unsigned char lead = static_cast<unsigned char>( text[ index++ ] ) ;
+    unsigned            code                                                ;
+    unsigned            follow                                              ;
+
+    if     ( lead < 0x80 ) return lead ;
+    else if( ( lead & 0xE0 ) == 0xC0 ) { code = lead & 0x1F ; follow = 1 ; }
+    else if( ( lead & 0xF0 ) == 0xE0 ) { code = lead & 0x0F ; follow = 2 ; }
+    else if( ( lead & 0xF8 ) == 0xF0 ) { code = lead & 0x07 ; follow = 3 ; }
+    else return lead ;
+
+    if( index + follow > text.size() ) return lead ;
+
+    for( unsigned byte = 0; byte < follow; byte++ )
+    {
+      const unsigned char next = static_cast<unsigned char>( text[ index + byte ] ) ;
+
+      if( ( next & 0xC0 ) != 0x80 ) return lead ;
+      code = ( code << 6 ) | ( next & 0x3F ) ;
+    }
+
+    index += follow ;
+    return code ;
+  }
+
+  /** Method to compute the squared distance of every cell of a row or column to the closest seed, in place.
+   * Felzenszwalb & Huttenlocher's lower envelope of parabolas, linear in the amount of cells.
+   * @param cells The cells, zero at seeds & a huge value everywhere else.
+   * @param count The amount of cells.
+   * @param stride The distance between two cells.
+   * @param scratch Room for 3 * count + 1 values.
+   */
+  inline void distanceTransform( float* cells, unsigned count, unsigned stride, std::vector<float>& scratch )
+  {
+    const float infinity = std::numeric_limits<float>::infinity() ;
+    float*      values   = scratch.data()                         ;
+    float*      bounds   = scratch.data() + count                 ;
+    float*      parabola = scratch.data() + 2 * count + 1         ;
+    unsigned    top      = 0                                      ;
+
+    for( unsigned index = 0; index < count; index++ ) values[ index ] = cells[ index * stride ] ;
+
+    parabola[ 0 ] = 0.0f      ;
+    bounds  [ 0 ] = -infinity ;
+    bounds  [ 1 ] =  infinity ;
+
+    // Every cell is a parabola rooted at it's value, keep only the ones forming the lower envelope.
+    for( unsigned cell = 1; cell < count; cell++ )
+    {
+      const float q = static_cast<float>( cell ) ;
+      float       v = parabola[ top ]            ;
+      float       s = ( ( values[ cell ] + q * q ) - ( values[ static_cast<unsigned>( v ) ] + v * v ) ) / ( 2.0f * ( q - v ) ) ;
+
+      while( s <= bounds[ top ] )
+      {
+        top-- ;
+        v = parabola[ top ] ;
+        s = ( ( values[ cell ] + q * q ) - ( values[ static_cast<unsigned>( v ) ] + v * v ) ) / ( 2.0f * ( q - v ) ) ;
+      }
+
+      top++ ;
+      parabola[ top     ] = q        ;
+      bounds  [ top     ] = s        ;
+      bounds  [ top + 1 ] = infinity ;
+    }
+
+    top = 0 ;
+    for( unsigned cell = 0; cell < count; cell++ )
+    {
+      const float q = static_cast<float>( cell ) ;
+
+      while( bounds[ top + 1 ] < q ) top++ ;
+
+      const float v = parabola[ top ] ;
+
+      cells[ cell * stride ] = ( q - v ) * ( q - v ) + values[ static_cast<unsigned>( v ) ] ;
+    }
+  }
+
+  inline void signedDistance( const GlyphBitmap& bitmap, unsigned spread, std::vector<unsigned char>& pixels )
+  {
+    const unsigned     width    = bitmap.width  + 2 * spread                 ;
+    const unsigned     height   = bitmap.height + 2 * spread                 ;
+    std::vector<float> to_glyph ( width * height, 1e20f                    ) ;
+    std::vector<float> to_space ( width * height, 0.0f                     ) ;
+    std::vector<float> scratch  ( 3 * std::max( width, height ) + 1        ) ;
+
+    // Seeds of the distance to the glyph are it's pixels, seeds of the distance out of it every pixel around them.
+    for( unsigned row = 0; row < bitmap.height; row++ )
+    {
+      for( unsigned column = 0; column < bitmap.width; column++ )
+      {
+        if( bitmap.coverage[ row * bitmap.width + column ] < 128 ) continue ;
+
+        const unsigned cell = ( row + spread ) * width + column + spread ;
+
+        to_glyph[ cell ] = 0.0f  ;
+        to_space[ cell ] = 1e20f ;
+      }
+    }
+
+    for( unsigned column = 0; column < width; column++ )
+    {
+      distanceTransform( to_glyph.data() + column, height, width, scratch ) ;
+      distanceTransform( to_space.data() + column, height, width, scratch ) ;
+    }
+
+    for( unsigned row = 0; row < height; row++ )
+    {
+      distanceTransform( to_glyph.data() + row * width, width, 1, scratch ) ;
+      distanceTransform( to_space.data() + row * width, width, 1, scratch ) ;
+    }
+
+    pixels.resize( width * height * 4 ) ;
+
+    for( unsigned cell = 0; cell < width * height; cell++ )
+    {
+      // Half a pixel puts the edge between the last pixel in & the first pixel out, rather than on either of them.
+      const float distance = to_space[ cell ] > 0.0f ? std::sqrt( to_space[ cell ] ) - 0.5f : 0.5f - std::sqrt( to_glyph[ cell ] ) ;
+      const float value    = std::min( std::max( 0.5f + distance / ( 2.0f * spread ), 0.0f ), 1.0f ) ;
+
+      pixels[ cell * 4 + 0 ] = 255 ;
+      pixels[ cell * 4 + 1 ] = 255 ;
+      pixels[ cell * 4 + 2 ] = 255 ;
+      pixels[ cell * 4 + 3 ] = static_cast<unsigned char>( value * 255.0f + 0.5f ) ;
+    }
+  }
+
+  /** The columns of every printable ASCII character in the built-in font, least significant bit at the top.
+   */
+  static const unsigned char BITMAP_FONT[ 95 ][ 5 ] =
+  {
+    { 0x00, 0x00, 0x00, 0x00, 0x00 }, { 0x00, 0x00, 0x5F, 0x00, 0x00 }, { 0x00, 0x07, 0x00, 0x07, 0x00 }, { 0x14, 0x7F, 0x14, 0x7F, 0x14 },
+    { 0x24, 0x2A, 0x7F, 0x2A, 0x12 }, { 0x23, 0x13, 0x08, 0x64, 0x62 }, { 0x36, 0x49, 0x55, 0x22, 0x50 }, { 0x00, 0x05, 0x03, 0x00, 0x00 },
+    { 0x00, 0x1C, 0x22, 0x41, 0x00 }, { 0x00, 0x41, 0x22, 0x1C, 0x00 }, { 0x08, 0x2A, 0x1C, 0x2A, 0x08 }, { 0x08, 0x08, 0x3E, 0x08, 0x08 },
+    { 0x00, 0x50, 0x30, 0x00, 0x00 }, { 0x08, 0x08, 0x08, 0x08, 0x08 }, { 0x00, 0x60, 0x60, 0x00, 0x00 }, { 0x20, 0x10, 0x08, 0x04, 0x02 },
+    { 0x3E, 0x51, 0x49, 0x45, 0x3E }, { 0x00, 0x42, 0x7F, 0x40, 0x00 }, { 0x42, 0x61, 0x51, 0x49, 0x46 }, { 0x21, 0x41, 0x45, 0x4B, 0x31 },
+    { 0x18, 0x14, 0x12, 0x7F, 0x10 }, { 0x27, 0x45, 0x45, 0x45, 0x39 }, { 0x3C, 0x4A, 0x49, 0x49, 0x30 }, { 0x01, 0x71, 0x09, 0x05, 0x03 },
+    { 0x36, 0x49, 0x49, 0x49, 0x36 }, { 0x06, 0x49, 0x49, 0x29, 0x1E }, { 0x00, 0x36, 0x36, 0x00, 0x00 }, { 0x00, 0x56, 0x36, 0x00, 0x00 },
+    { 0x08, 0x14, 0x22, 0x41, 0x00 }, { 0x14, 0x14, 0x14, 0x14, 0x14 }, { 0x00, 0x41, 0x22, 0x14, 0x08 }, { 0x02, 0x01, 0x51, 0x09, 0x06 },
+    { 0x32, 0x49, 0x79, 0x41, 0x3E }, { 0x7E, 0x11, 0x11, 0x11, 0x7E }, { 0x7F, 0x49, 0x49, 0x49, 0x36 }, { 0x3E, 0x41, 0x41, 0x41, 0x22 },
+    { 0x7F, 0x41, 0x41, 0x22, 0x1C }, { 0x7F, 0x49, 0x49, 0x49, 0x41 }, { 0x7F, 0x09, 0x09, 0x01, 0x01 }, { 0x3E, 0x41, 0x41, 0x51, 0x32 },
+    { 0x7F, 0x08, 0x08, 0x08, 0x7F }, { 0x00, 0x41, 0x7F, 0x41, 0x00 }, { 0x20, 0x40, 0x41, 0x3F, 0x01 }, { 0x7F, 0x08, 0x14, 0x22, 0x41 },
+    { 0x7F, 0x40, 0x40, 0x40, 0x40 }, { 0x7F, 0x02, 0x04, 0x02, 0x7F }, { 0x7F, 0x04, 0x08, 0x10, 0x7F }, { 0x3E, 0x41, 0x41, 0x41, 0x3E },
+    { 0x7F, 0x09, 0x09, 0x09, 0x06 }, { 0x3E, 0x41, 0x51, 0x21, 0x5E }, { 0x7F, 0x09, 0x19, 0x29, 0x46 }, { 0x46, 0x49, 0x49, 0x49, 0x31 },
+    { 0x01, 0x01, 0x7F, 0x01, 0x01 }, { 0x3F, 0x40, 0x40, 0x40, 0x3F }, { 0x1F, 0x20, 0x40, 0x20, 0x1F }, { 0x7F, 0x20, 0x18, 0x20, 0x7F },
+    { 0x63, 0x14, 0x08, 0x14, 0x63 }, { 0x03, 0x04, 0x78, 0x04, 0x03 }, { 0x61, 0x51, 0x49, 0x45, 0x43 }, { 0x00, 0x7F, 0x41, 0x41, 0x00 },
+    { 0x02, 0x04, 0x08, 0x10, 0x20 }, { 0x00, 0x41, 0x41, 0x7F, 0x00 }, { 0x04, 0x02, 0x01, 0x02, 0x04 }, { 0x40, 0x40, 0x40, 0x40, 0x40 },
+    { 0x00, 0x01, 0x02, 0x04, 0x00 }, { 0x20, 0x54, 0x54, 0x54, 0x78 }, { 0x7F, 0x48, 0x44, 0x44, 0x38 }, { 0x38, 0x44, 0x44, 0x44, 0x20 },
+    { 0x38, 0x44, 0x44, 0x48, 0x7F }, { 0x38, 0x54, 0x54, 0x54, 0x18 }, { 0x08, 0x7E, 0x09, 0x01, 0x02 }, { 0x0C, 0x52, 0x52, 0x52, 0x3E },
+    { 0x7F, 0x08, 0x04, 0x04, 0x78 }, { 0x00, 0x44, 0x7D, 0x40, 0x00 }, { 0x20, 0x40, 0x44, 0x3D, 0x00 }, { 0x7F, 0x10, 0x28, 0x44, 0x00 },
+    { 0x00, 0x41, 0x7F, 0x40, 0x00 }, { 0x7C, 0x04, 0x18, 0x04, 0x78 }, { 0x7C, 0x08, 0x04, 0x04, 0x78 }, { 0x38, 0x44, 0x44, 0x44, 0x38 },
+    { 0x7C, 0x14, 0x14, 0x14, 0x08 }, { 0x08, 0x14, 0x14, 0x18, 0x7C }, { 0x7C, 0x08, 0x04, 0x04, 0x08 }, { 0x48, 0x54, 0x54, 0x54, 0x20 },
+    { 0x04, 0x3F, 0x44, 0x40, 0x20 }, { 0x3C, 0x40, 0x40, 0x20, 0x7C }, { 0x1C, 0x20, 0x40, 0x20, 0x1C }, { 0x3C, 0x40, 0x30, 0x40, 0x3C },
+    { 0x44, 0x28, 0x10, 0x28, 0x44 }, { 0x0C, 0x50, 0x50, 0x50, 0x3C }, { 0x44, 0x64, 0x54, 0x4C, 0x44 }, { 0x00, 0x08, 0x36, 0x41, 0x00 },
+    { 0x00, 0x00, 0x7F, 0x00, 0x00 }, { 0x00, 0x41, 0x36, 0x08, 0x00 }, { 0x08, 0x04, 0x08, 0x10, 0x08 }
+  };
+
+  inline BitmapFont::BitmapFont( unsigned scale )
+  {
+    this->scale = std::max( scale, 1u ) ;
+  }
+
+  inline bool BitmapFont::glyph( unsigned code, GlyphBitmap& bitmap ) const
+  {
+    if( code < 32 || code > 126 ) return false ;
+
+    const unsigned char* columns = BITMAP_FONT[ code - 32 ] ;
+
+    bitmap.width     = 5 * this->scale       ;
+    bitmap.height    = 7 * this->scale       ;
+    bitmap.bearing_x = 0.0f                  ;
+    bitmap.bearing_y = 1.0f * this->scale    ;
+    bitmap.advance   = 6.0f * this->scale    ;
+
+    bitmap.coverage.assign( bitmap.width * bitmap.height, 0 ) ;
+
+    for( unsigned row = 0; row < bitmap.height; row++ )
+    {
+      for( unsigned column = 0; column < bitmap.width; column++ )
+      {
+        if( columns[ column / this->scale ] & ( 1 << ( row / this->scale ) ) ) bitmap.coverage[ row * bitmap.width + column ] = 255 ;
+      }
+    }
+
+    return true ;
+  }
+
+  inline float BitmapFont::lineHeight() const
+  {
+    return 9.0f * this->scale ;
+  }
+
+  inline GlyphSet::GlyphSet()
+  {
+    this->source      = nullptr ;
+    this->atlas       = nullptr ;
+    this->spread      = 0       ;
+    this->glyph_count = 0       ;
+  }
+
+  inline void GlyphSet::initialize( const GlyphSource* source, AtlasPages* atlas, unsigned spread )
+  {
+    this->source      = source ;
+    this->atlas       = atlas  ;
+    this->spread      = spread ;
+    this->glyph_count = 0      ;
+
+    // ASCII is looked up directly, it is what nearly every string is made of.
+    this->ascii .assign( 128, Glyph() ) ;
+    this->loaded.assign( 128, 0       ) ;
+    this->glyphs.clear() ;
+  }
+
+  inline bool GlyphSet::load( unsigned code, Glyph& glyph )
+  {
+    AtlasRect rect ;
+
+    if( this->source == nullptr || this->atlas == nullptr || !this->source->glyph( code, this->bitmap ) ) return false ;
+
+    glyph.region  = glm::vec4( 0.0f )      ;
+    glyph.page    = 0                      ;
+    glyph.x       = 0.0f                   ;
+    glyph.y       = 0.0f                   ;
+    glyph.width   = 0.0f                   ;
+    glyph.height  = 0.0f                   ;
+    glyph.advance = this->bitmap.advance   ;
+
+    const bool empty = std::none_of( this->bitmap.coverage.begin(), this->bitmap.coverage.end(), [] ( unsigned char value ) { return value >= 128 ; } ) ;
+
+    if( !empty )
+    {
+      signedDistance( this->bitmap, this->spread, this->pixels ) ;
+
+      const AtlasImage image = { code, this->pixels.data(), this->bitmap.width + 2 * this->spread, this->bitmap.height + 2 * this->spread } ;
+
+      if( !this->atlas->add( image ) || !this->atlas->find( code, rect ) ) return false ;
+
+      glyph.region = rect.region                             ;
+      glyph.page   = rect.page                               ;
+      glyph.x      = this->bitmap.bearing_x - this->spread   ;
+      glyph.y      = this->bitmap.bearing_y - this->spread   ;
+      glyph.width  = static_cast<float>( image.width  )      ;
+      glyph.height = static_cast<float>( image.height )      ;
+    }
+
+    this->glyph_count++ ;
+    return true ;
+  }
+
+  inline const Glyph* GlyphSet::find( unsigned code )
+  {
+    if( code < 128 )
+    {
+      // 1 is loaded, 2 is missing from the font.
+      if( this->loaded[ code ] == 0 ) this->loaded[ code ] = this->load( code, this->ascii[ code ] ) ? 1 : 2 ;
+      if( this->loaded[ code ] == 1 ) return &this->ascii[ code ] ;
+    }
+    else
+    {
+      auto iter = this->glyphs.find( code ) ;
+
+      if( iter == this->glyphs.end() )
+      {
+        Glyph glyph ;
+
+        if( this->load( code, glyph ) ) iter = this->glyphs.emplace( code, glyph ).first ;
+      }
+
+      if( iter != this->glyphs.end() ) return &iter->second ;
+    }
+
+    return code != GLYPH_MISSING ? this->find( GLYPH_MISSING ) : nullptr ;
+  }
+
+  inline unsigned GlyphSet::layout( const std::string& text, float size, unsigned transform, const glm::vec4& color, GlyphInstance* instances, unsigned capacity )
+  {
+    unsigned    count    = 0    ;
+    unsigned    previous = 0    ;
+    float       pen_x    = 0.0f ;
+    float       pen_y    = 0.0f ;
+    std::size_t index    = 0    ;
+
+    if( this->source == nullptr ) return 0 ;
+
+    const float line  = this->source->lineHeight() ;
+    const float scale = size / line                ;
+
+    while( index < text.size() && count < capacity )
+    {
+      const unsigned code = decode( text, index ) ;
+
+      if( code == '\n' )
+      {
+        pen_x    = 0.0f ;
+        pen_y   += line ;
+        previous = 0    ;
+        continue ;
+      }
+
+      const Glyph* glyph = this->find( code == '\t' ? ' ' : code ) ;
+
+      if( glyph == nullptr ) continue ;
+      if( previous != 0    ) pen_x += this->source->kerning( previous, code ) ;
+
+      if( glyph->width > 0.0f )
+      {
+        GlyphInstance& instance = instances[ count++ ] ;
+
+        instance.rect      = glm::vec4( pen_x + glyph->x, pen_y + glyph->y, glyph->width, glyph->height ) * scale ;
+        instance.region    = glyph->region       ;
+        instance.color     = color               ;
+        instance.page      = glyph->page         ;
+        instance.transform = transform           ;
+        instance.mode      = InstanceMode::Glyph ;
+        instance.padding   = 0                   ;
+      }
+
+      pen_x   += code == '\t' ? glyph->advance * 4.0f : glyph->advance ;
+      previous = code ;
+    }
+
+    return count ;
+  }
+
+  inline unsigned GlyphSet::count() const
+  {
+    return this->glyph_count ;
+  }
+
+  inline const GlyphSource* GlyphSet::font() const
+  {
+    return this->source ;
+  }
+
+  inline TextRunCache::TextRunCache()
+  {
+    this->glyphs   = nullptr   ;
+    this->capacity = TEXT_RUNS ;
+  }
+
+  inline void TextRunCache::initialize( GlyphSet* glyphs, unsigned capacity )
+  {
+    this->glyphs   = glyphs                   ;
+    this->capacity = std::max( capacity, 1u ) ;
+
+    this->clear() ;
+  }
+
+  inline std::uint64_t TextRunCache::key( const std::string& text, float size ) const
+  {
+    const std::uintptr_t font = reinterpret_cast<std::uintptr_t>( this->glyphs ? this->glyphs->font() : nullptr ) ;
+    std::uint64_t        hash = 14695981039346656037ull                                                           ;
+    std::uint32_t        bits                                                                                      ;
+
+    std::memcpy( &bits, &size, sizeof( bits ) ) ;
+
+    // FNV-1a over the string, then the font & size folded in.
+    for( char byte : text ) hash = ( hash ^ static_cast<unsigned char>( byte ) ) * 1099511628211ull ;
+
+    hash ^= font + 0x9e3779b97f4a7c15ull + ( hash << 6 ) + ( hash >> 2 ) ;
+    hash ^= bits + 0x9e3779b97f4a7c15ull + ( hash << 6 ) + ( hash >> 2 ) ;
+
+    return hash ;
+  }
+
+  inline const std::vector<GlyphInstance>& TextRunCache::shape( const std::string& text, float size )
+  {
+    static const std::vector<GlyphInstance> empty ;
+
+    if( this->glyphs == nullptr ) return empty ;
+
+    const GlyphSource*  font = this->glyphs->font()    ;
+    const std::uint64_t hash = this->key( text, size ) ;
+    auto                iter = this->runs.find( hash ) ;
+
+    if( iter != this->runs.end() && iter->second.font == font && iter->second.size == size && iter->second.text == text )
+    {
+      this->lru.splice( this->lru.begin(), this->lru, iter->second.used ) ;
+      this->counters.hits++ ;
+
+      return iter->second.glyphs ;
+    }
+
+    this->counters.misses++ ;
+
+    // A different string with the same hash is simply replaced.
+    if( iter == this->runs.end() )
+    {
+      while( this->runs.size() >= this->capacity )
+      {
+        this->runs.erase( this->lru.back() ) ;
+        this->lru .pop_back() ;
+        this->counters.evictions++ ;
+      }
+
+      this->lru.push_front( hash ) ;
+      iter = this->runs.emplace( hash, Run() ).first ;
+      iter->second.used = this->lru.begin() ;
+    }
+    else
+    {
+      this->lru.splice( this->lru.begin(), this->lru, iter->second.used ) ;
+    }
+
+    Run& run = iter->second ;
+
+    run.text = text ;
+    run.font = font ;
+    run.size = size ;
+
+    // Every glyph is at least a byte of the string, so the string's length is always enough room.
+    run.glyphs.resize( text.size() ) ;
+    run.glyphs.resize( this->glyphs->layout( text, size, 0, glm::vec4( 1.0f ), run.glyphs.data(), run.glyphs.size() ) ) ;
+
+    this->counters.runs = this->runs.size() ;
+
+    return run.glyphs ;
+  }
+
+  inline unsigned TextRunCache::copy( const std::vector<GlyphInstance>& run, unsigned transform, const glm::vec4& color, GlyphInstance* instances, unsigned capacity )
+  {
+    const unsigned count = std::min<unsigned>( run.size(), capacity ) ;
+
+    std::copy( run.begin(), run.begin() + count, instances ) ;
+
+    for( unsigned index = 0; index < count; index++ )
+    {
+      instances[ index ].transform = transform ;
+      instances[ index ].color     = color     ;
+    }
+
+    return count ;
+  }
+
+  inline unsigned TextRunCache::write( const std::string& text, float size, unsigned transform, const glm::vec4& color, GlyphInstance* instances, unsigned capacity )
+  {
+    return TextRunCache::copy( this->shape( text, size ), transform, color, instances, capacity ) ;
+  }
+
+  inline void TextRunCache::clear()
+  {
+    this->runs.clear() ;
+    this->lru .clear() ;
+    this->counters.runs = 0 ;
+  }
+
+  inline const TextRunStats& TextRunCache::stats() const
+  {
+    return this->counters ;
+  }
+
+  inline TextBatch::TextBatch()
+  {
+    this->runs    = nullptr ;
+    this->size    = 32.0f   ;
+    this->glyphs  = 0       ;
+    this->repack  = true    ;
+    this->reshape = true    ;
+    this->dropped = false   ;
+  }
+
+  inline void TextBatch::initialize( TextRunCache* runs, unsigned capacity )
+  {
+    this->runs    = runs  ;
+    this->glyphs  = 0     ;
+    this->repack  = true  ;
+    this->reshape = true  ;
+    this->dropped = false ;
+
+    this->current .assign( capacity, GlyphInstance() ) ;
+    this->previous.assign( capacity, GlyphInstance() ) ;
+    this->entries .clear() ;
+    this->order   .clear() ;
+    this->changed .clear() ;
+    this->ranges  .clear() ;
+  }
+
+  inline void TextBatch::setOrder( const unsigned* ids, unsigned count )
+  {
+    this->order.assign( ids, ids + count ) ;
+    this->repack = true ;
+  }
+
+  inline void TextBatch::setText( unsigned id, const std::string& text )
+  {
+    Entry& entry = this->entries[ id ] ;
+
+    if( entry.text == text && !entry.changed ) return ;
+
+    entry.text = text ;
+    if( !entry.changed || !entry.placed ) this->changed.push_back( id ) ;
+    entry.changed = true ;
+  }
+
+  inline void TextBatch::setColor( unsigned id, const glm::vec4& color )
+  {
+    Entry& entry = this->entries[ id ] ;
+
+    if( entry.color.x == color.x && entry.color.y == color.y && entry.color.z == color.z && entry.color.w == color.w ) return ;
+
+    entry.color = color ;
+    if( !entry.changed || !entry.placed ) this->changed.push_back( id ) ;
+    entry.changed = true ;
+  }
+
+  inline void TextBatch::setSize( float size )
+  {
+    if( this->size == size ) return ;
+
+    this->size    = size ;
+    this->reshape = true ;
+  }
+
+  inline void TextBatch::invalidate()
+  {
+    this->reshape = true ;
+  }
+
+  inline bool TextBatch::update()
+  {
+    this->ranges.clear() ;
+
+    if( this->runs == nullptr || ( this->changed.empty() && !this->repack && !this->reshape ) ) return false ;
+
+    // Changed strings still fitting their slot are patched where they are, blanking what's left of the old glyphs. Nothing else moves.
+    for( unsigned index = 0; index < this->changed.size() && !this->repack && !this->reshape; index++ )
+    {
+      const unsigned id    = this->changed[ index ] ;
+      Entry&         entry = this->entries[ id ]    ;
+
+      if( !entry.placed ) { this->repack = true ; break ; }
+
+      const std::vector<GlyphInstance>& run = this->runs->shape( entry.text, this->size ) ;
+
+      if( run.size() > entry.slot ) { this->repack = true ; break ; }
+
+      const unsigned count = TextRunCache::copy( run, id, entry.color, this->current.data() + entry.offset, entry.slot ) ;
+      const unsigned range = std::max( count, entry.count )                                                               ;
+
+      for( unsigned glyph = count; glyph < entry.count; glyph++ )
+      {
+        this->current[ entry.offset + glyph ]           = GlyphInstance() ;
+        this->current[ entry.offset + glyph ].transform = id              ;
+      }
+
+      entry.count   = count ;
+      entry.changed = false ;
+      if( range != 0 ) this->ranges.push_back( { entry.offset, range } ) ;
+    }
+
+    // Otherwise strings are packed again. Unchanged ones are copied from where they were, only changed ones come from the run cache.
+    if( this->repack || this->reshape )
+    {
+      const unsigned capacity = this->current.size() ;
+      unsigned       count    = 0                     ;
+
+      this->dropped = false ;
+
+      std::swap( this->current, this->previous ) ;
+      this->ranges.clear() ;
+
+      // Only strings placed before are in the old glyph instances, the rest have to be laid out.
+      for( auto& entry : this->entries )
+      {
+        if( !entry.second.placed ) entry.second.changed = true ;
+        entry.second.placed = false ;
+      }
+
+      for( unsigned id : this->order )
+      {
+        auto iter = this->entries.find( id ) ;
+
+        if( iter == this->entries.end() || iter->second.placed ) continue ;
+
+        Entry&         entry = iter->second ;
+        const unsigned room  = capacity - count ;
+
+        if( !this->reshape && !entry.changed && entry.count <= room )
+        {
+          std::copy( this->previous.begin() + entry.offset, this->previous.begin() + entry.offset + entry.count, this->current.begin() + count ) ;
+        }
+        else
+        {
+          const std::vector<GlyphInstance>& run = this->runs->shape( entry.text, this->size ) ;
+
+          entry.count = TextRunCache::copy( run, id, entry.color, this->current.data() + count, room ) ;
+          if( entry.count < run.size() ) this->dropped = true ;
+        }
+
+        // The slot always has some slack past the glyphs, as much as is left of the buffer.
+        entry.slot = std::min( ( entry.count / TEXT_SLACK + 1 ) * TEXT_SLACK, room ) ;
+
+        for( unsigned glyph = entry.count; glyph < entry.slot; glyph++ )
+        {
+          this->current[ count + glyph ]           = GlyphInstance() ;
+          this->current[ count + glyph ].transform = id              ;
+        }
+
+        entry.offset  = count ;
+        entry.placed  = true  ;
+        entry.changed = false ;
+        count        += entry.slot ;
+      }
+
+      this->glyphs = count ;
+      if( count != 0 ) this->ranges.push_back( { 0, count } ) ;
+    }
+
+    for( unsigned id : this->changed ) this->entries[ id ].changed = !this->entries[ id ].placed ;
+
+    this->changed.clear() ;
+    this->repack  = false ;
+    this->reshape = false ;
+
+    return true ;
+  }
+
+  inline const std::vector<TextRange>& TextBatch::uploads() const
+  {
+    return this->ranges ;
+  }
+
+  inline const GlyphInstance* TextBatch::instances() const
+  {
+    return this->current.data() ;
+  }
+
+  inline unsigned TextBatch::count() const
+  {
+    return this->glyphs ;
+  }
+
+  inline bool TextBatch::full() const
+  {
+    return this->dropped ;
+  }
+}
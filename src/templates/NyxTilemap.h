@@ -0,0 +1,578 @@
+/*
+ * Copyright (C) 2020 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+
+namespace nyx
+{
+  /** The amount of tiles along each side of a chunk, the unit tile maps are streamed & drawn in.
+   */
+  constexpr unsigned TILEMAP_CHUNK = 64 ;
+
+  /** The amount of chunks the device keeps resident at once.
+   */
+  constexpr unsigned TILEMAP_LAYERS = 1024 ;
+
+  /** The most chunks drawn in a frame. Cameras seeing more than this draw the ones around the center of the screen.
+   */
+  constexpr unsigned TILEMAP_VISIBLE = 512 ;
+
+  /** The most chunks streamed in per frame, keeping the cost of a frame the same no matter how large the map is.
+   */
+  constexpr unsigned TILEMAP_UPLOADS = 16 ;
+
+  /** The layer of chunks that aren't resident. Matches NO_CHUNK in the tilemap shaders.
+   */
+  constexpr unsigned NO_CHUNK = UINT_MAX ;
+
+  /** Interface to whatever holds a tile map on the host. Only ever asked for the chunks around the camera,
+   * so a source can generate or page in maps far larger than would fit in memory.
+   * Tile indices are one past the tileset cell they show, zero is an empty tile.
+   */
+  class TileSource
+  {
+    public:
+
+      /** Virtual deconstructor. Needed for inheritance.
+       */
+      virtual ~TileSource() {}
+
+      /** Method to retrieve the width of the map.
+       * @return The amount of tiles along x.
+       */
+      virtual unsigned width() const = 0 ;
+
+      /** Method to retrieve the height of the map.
+       * @return The amount of tiles along y.
+       */
+      virtual unsigned height() const = 0 ;
+
+      /** Method to write the tiles of a chunk, row by row. Tiles past the map's edge are to be written as empty.
+       * @param chunk_x The chunk's column.
+       * @param chunk_y The chunk's row.
+       * @param tiles The TILEMAP_CHUNK * TILEMAP_CHUNK tiles to write.
+       */
+      virtual void chunk( unsigned chunk_x, unsigned chunk_y, unsigned* tiles ) const = 0 ;
+  };
+
+  /** A tile source holding every tile of a map, for maps small enough to keep whole.
+   */
+  class TileGrid : public TileSource
+  {
+    public:
+
+      /** Method to size the map, emptying every tile.
+       * @param width The amount of tiles along x.
+       * @param height The amount of tiles along y.
+       */
+      void initialize( unsigned width, unsigned height ) ;
+
+      /** Method to set a single tile.
+       * @param x The tile's column.
+       * @param y The tile's row.
+       * @param tile The tile index, one past the tileset cell it shows.
+       */
+      void set( unsigned x, unsigned y, unsigned tile ) ;
+
+      unsigned width() const override ;
+      unsigned height() const override ;
+      void chunk( unsigned chunk_x, unsigned chunk_y, unsigned* tiles ) const override ;
+
+    private:
+
+      std::vector<unsigned> tiles      ;
+      unsigned              map_width  = 0 ;
+      unsigned              map_height = 0 ;
+  };
+
+  /** Keeps track of which chunks live in which layer of the device's chunk cache, evicting the least recently used.
+   */
+  class ChunkCache
+  {
+    public:
+
+      /** Method to initialize the cache, forgetting every resident chunk.
+       * @param layers The amount of chunks that can be resident at once.
+       */
+      void initialize( unsigned layers = TILEMAP_LAYERS ) ;
+
+      /** Method to start a new frame. Chunks used during it are never evicted until the next one.
+       */
+      void advance() ;
+
+      /** Method to find the layer of a chunk, making it resident if allowed.
+       * @param chunk_x The chunk's column.
+       * @param chunk_y The chunk's row.
+       * @param load Whether the chunk may be made resident if it isn't.
+       * @param fresh Set to whether the chunk was just made resident & it's layer has to be filled.
+       * @return The layer of the chunk, or NO_CHUNK if it isn't resident.
+       */
+      unsigned acquire( unsigned chunk_x, unsigned chunk_y, bool load, bool& fresh ) ;
+
+      /** Method to find the layer of a chunk without marking it as used.
+       * @param chunk_x The chunk's column.
+       * @param chunk_y The chunk's row.
+       * @return The layer of the chunk, or NO_CHUNK if it isn't resident.
+       */
+      unsigned find( unsigned chunk_x, unsigned chunk_y ) const ;
+
+      /** Method to retrieve the amount of chunks currently resident.
+       * @return The amount of resident chunks.
+       */
+      unsigned resident() const ;
+
+      /** Method to retrieve the amount of layers of this cache.
+       * @return The most chunks resident at once.
+       */
+      unsigned layers() const ;
+
+    private:
+
+      std::unordered_map<std::uint64_t, unsigned> lookup    ;
+      std::vector<std::uint64_t>                  owners    ;
+      std::vector<unsigned>                       last_used ;
+      unsigned                                    frame     = 0 ;
+  };
+
+  /** Structure describing a single chunk drawn this frame. Matches Chunk in the tilemap shaders.
+   */
+  struct TileChunk
+  {
+    glm::vec4 rect         ; ///< xy is the first tile of the chunk, zw the amount of tiles it spans.
+    unsigned  layer        ; ///< The layer of the cache holding the chunk's tiles, NO_CHUNK to skip drawing it.
+    unsigned  padding[ 3 ] ;
+  };
+
+  /** Decides every frame which chunks of a tile source are drawn & which are streamed into the device's cache.
+   * Only the chunks a camera sees are ever looked at, so a frame costs the same on a map of any size.
+   */
+  class TileStreamer
+  {
+    public:
+
+      /** Method to initialize the streamer, forgetting every resident chunk.
+       * @param layers The amount of chunks that can be resident at once. At least twice the visible chunks.
+       * @param visible The most chunks drawn in a frame.
+       * @param uploads The most chunks streamed in per frame.
+       */
+      void initialize( unsigned layers = TILEMAP_LAYERS, unsigned visible = TILEMAP_VISIBLE, unsigned uploads = TILEMAP_UPLOADS ) ;
+
+      /** Method to set the tile source to stream from. Forgets every resident chunk.
+       * @param source The tile source, or nullptr to draw nothing.
+       */
+      void setSource( const TileSource* source ) ;
+
+      /** Method to flag a tile as changed, so the chunk holding it is streamed in again next frame if it is resident.
+       * @param x The tile's column.
+       * @param y The tile's row.
+       */
+      void invalidate( unsigned x, unsigned y ) ;
+
+      /** Method to pick this frame's chunks for a camera & stream in whichever of them are missing, nearest to the center first.
+       * @param viewproj The projection times the view of the camera.
+       * @return The amount of chunks drawn this frame.
+       */
+      unsigned stream( const glm::mat4& viewproj ) ;
+
+      /** Method to retrieve the chunks to draw. Always the size of the visible chunks, the ones past those drawn are skipped.
+       * @return The chunks of this frame.
+       */
+      const std::vector<TileChunk>& chunks() const ;
+
+      /** Method to retrieve how many chunk records changed & have to be uploaded this frame.
+       * @return The amount of records at the front of the chunks to upload.
+       */
+      unsigned dirty() const ;
+
+      /** Method to retrieve the layers filled this frame.
+       * @return The layers of the cache to upload to, in the order of their tiles.
+       */
+      const std::vector<unsigned>& uploads() const ;
+
+      /** Method to retrieve the tiles filled this frame, TILEMAP_CHUNK * TILEMAP_CHUNK per upload.
+       * @return The tiles of every upload, back to back.
+       */
+      const unsigned* tiles() const ;
+
+      /** Method to retrieve the amount of layers of the cache.
+       * @return The most chunks resident at once.
+       */
+      unsigned layers() const ;
+
+      /** Method to retrieve the amount of chunks resident.
+       * @return The amount of resident chunks.
+       */
+      unsigned resident() const ;
+
+    private:
+
+      /** Method to fill a layer with a chunk from the source & queue it for upload.
+       */
+      void fill( unsigned chunk_x, unsigned chunk_y, unsigned layer ) ;
+
+      ChunkCache                 cache   ;
+      std::vector<TileChunk>     records ;
+      std::vector<unsigned>      missing ;
+      std::vector<unsigned>      filled  ;
+      std::vector<unsigned>      scratch ;
+      std::vector<std::uint64_t> stale   ;
+      const TileSource*          source  = nullptr         ;
+      unsigned                   budget  = TILEMAP_UPLOADS ;
+      unsigned                   drawn   = 0               ;
+      unsigned                   changed = 0               ;
+      unsigned                   pending = 0               ;
+  };
+
+  /** Function to find the rectangle of a tile map a camera sees, on the map's plane at z = 0 where one unit is one tile.
+   * Works for orthographic & perspective cameras by casting the corners of the screen onto the plane.
+   * @param viewproj The projection times the view of the camera.
+   * @param low Set to the lowest tile coordinate seen.
+   * @param high Set to the highest tile coordinate seen.
+   * @return Whether the plane is seen at all.
+   */
+  inline bool visibleTiles( const glm::mat4& viewproj, glm::vec2& low, glm::vec2& high )
+  {
+    const glm::mat4 inverse = glm::inverse( viewproj ) ;
+    bool            seen    = false                   ;
+
+    low  = glm::vec2(  INFINITY ) ;
+    high = glm::vec2( -INFINITY ) ;
+
+    for( unsigned corner = 0; corner < 4; corner++ )
+    {
+      const glm::vec2 ndc  = glm::vec2( corner & 1 ? 1.0f : -1.0f, corner & 2 ? 1.0f : -1.0f ) ;
+      const glm::vec4 near = inverse * glm::vec4( ndc, 0.0f, 1.0f )                          ;
+      const glm::vec4 far  = inverse * glm::vec4( ndc, 1.0f, 1.0f )                          ;
+      const glm::vec3 from = glm::vec3( near ) / near.w                                      ;
+      const glm::vec3 to   = glm::vec3( far  ) / far .w                                      ;
+      const float     dz   = to.z - from.z                                                   ;
+      float           t    = 0.0f                                                            ;
+
+      // Orthographic cameras looking straight at the map see it everywhere along the ray, the near point will do.
+      if( std::abs( dz ) > 1e-6f )
+      {
+        t = -from.z / dz ;
+        if( t < 0.0f ) continue ;
+      }
+
+      const glm::vec2 hit = glm::vec2( from + ( to - from ) * t ) ;
+
+      low  = glm::min( low , hit ) ;
+      high = glm::max( high, hit ) ;
+      seen = true ;
+    }
+
+    return seen ;
+  }
+
+  inline void TileGrid::initialize( unsigned width, unsigned height )
+  {
+    this->map_width  = width  ;
+    this->map_height = height ;
+    this->tiles.assign( static_cast<std::size_t>( width ) * height, 0 ) ;
+  }
+
+  inline void TileGrid::set( unsigned x, unsigned y, unsigned tile )
+  {
+    if( x < this->map_width && y < this->map_height ) this->tiles[ static_cast<std::size_t>( y ) * this->map_width + x ] = tile ;
+  }
+
+  inline unsigned TileGrid::width() const
+  {
+    return this->map_width ;
+  }
+
+  inline unsigned TileGrid::height() const
+  {
+    return this->map_height ;
+  }
+
+  inline void TileGrid::chunk( unsigned chunk_x, unsigned chunk_y, unsigned* tiles ) const
+  {
+    for( unsigned row = 0; row < TILEMAP_CHUNK; row++ )
+    {
+      const unsigned y = chunk_y * TILEMAP_CHUNK + row ;
+
+      for( unsigned column = 0; column < TILEMAP_CHUNK; column++ )
+      {
+        const unsigned x = chunk_x * TILEMAP_CHUNK + column ;
+
+        tiles[ row * TILEMAP_CHUNK + column ] = x < this->map_width && y < this->map_height ? this->tiles[ static_cast<std::size_t>( y ) * this->map_width + x ] : 0 ;
+      }
+    }
+  }
+
+  inline void ChunkCache::initialize( unsigned layers )
+  {
+    this->lookup.clear() ;
+    this->owners   .assign( layers, UINT64_MAX ) ;
+    this->last_used.assign( layers, 0          ) ;
+    this->frame = 1 ;
+  }
+
+  inline void ChunkCache::advance()
+  {
+    this->frame++ ;
+  }
+
+  inline unsigned ChunkCache::acquire( unsigned chunk_x, unsigned chunk_y, bool load, bool& fresh )
+  {
+    const std::uint64_t key  = static_cast<std::uint64_t>( chunk_y ) << 32 | chunk_x ;
+    auto                iter = this->lookup.find( key )                              ;
+    unsigned            layer = NO_CHUNK                                             ;
+
+    fresh = false ;
+
+    if( iter != this->lookup.end() )
+    {
+      this->last_used[ iter->second ] = this->frame ;
+      return iter->second ;
+    }
+
+    if( !load ) return NO_CHUNK ;
+
+    // The least recently used layer goes, as long as it isn't needed this frame.
+    for( unsigned index = 0; index < this->owners.size(); index++ )
+    {
+      if( this->last_used[ index ] == this->frame ) continue ;
+      if( layer == NO_CHUNK || this->last_used[ index ] < this->last_used[ layer ] ) layer = index ;
+    }
+
+    if( layer == NO_CHUNK ) return NO_CHUNK ;
+
+    if( this->owners[ layer ] != UINT64_MAX ) this->lookup.erase( this->owners[ layer ] ) ;
+
+    this->owners   [ layer ] = key         ;
+    this->last_used[ layer ] = this->frame ;
+    this->lookup[ key ] = layer ;
+    fresh = true ;
+
+    return layer ;
+  }
+
+  inline unsigned ChunkCache::find( unsigned chunk_x, unsigned chunk_y ) const
+  {
+    auto iter = this->lookup.find( static_cast<std::uint64_t>( chunk_y ) << 32 | chunk_x ) ;
+
+    return iter != this->lookup.end() ? iter->second : NO_CHUNK ;
+  }
+
+  inline unsigned ChunkCache::resident() const
+  {
+    return this->lookup.size() ;
+  }
+
+  inline unsigned ChunkCache::layers() const
+  {
+    return this->owners.size() ;
+  }
+
+  inline void TileStreamer::initialize( unsigned layers, unsigned visible, unsigned uploads )
+  {
+    TileChunk hidden = { glm::vec4( 0.0f ), NO_CHUNK, { 0, 0, 0 } } ;
+
+    this->cache.initialize( std::max( layers, visible * 2 ) ) ;
+    this->records.assign( visible, hidden ) ;
+    this->stale  .clear() ;
+    this->filled .clear() ;
+
+    this->budget  = uploads ;
+    this->drawn   = 0       ;
+    this->changed = visible ;
+    this->pending = visible ;
+  }
+
+  inline void TileStreamer::setSource( const TileSource* source )
+  {
+    this->source = source ;
+    this->initialize( this->cache.layers(), this->records.size(), this->budget ) ;
+  }
+
+  inline void TileStreamer::invalidate( unsigned x, unsigned y )
+  {
+    const std::uint64_t key = static_cast<std::uint64_t>( y / TILEMAP_CHUNK ) << 32 | x / TILEMAP_CHUNK ;
+
+    if( this->cache.find( x / TILEMAP_CHUNK, y / TILEMAP_CHUNK ) != NO_CHUNK && std::find( this->stale.begin(), this->stale.end(), key ) == this->stale.end() ) this->stale.push_back( key ) ;
+  }
+
+  inline unsigned TileStreamer::stream( const glm::mat4& viewproj )
+  {
+    const unsigned previous = this->drawn ;
+    glm::vec2      low                    ;
+    glm::vec2      high                   ;
+    bool           fresh                  ;
+
+    this->cache.advance() ;
+    this->filled.clear() ;
+    this->drawn = 0 ;
+
+    // Edited chunks are filled again in place, so they never blink out while streaming back in.
+    for( auto key : this->stale )
+    {
+      const unsigned chunk_x = static_cast<unsigned>( key & 0xFFFFFFFF ) ;
+      const unsigned chunk_y = static_cast<unsigned>( key >> 32        ) ;
+      const unsigned layer   = this->cache.find( chunk_x, chunk_y )      ;
+
+      if( layer != NO_CHUNK && this->source != nullptr ) this->fill( chunk_x, chunk_y, layer ) ;
+    }
+
+    this->stale.clear() ;
+
+    if( this->source != nullptr && this->source->width() != 0 && this->source->height() != 0 && nyx::visibleTiles( viewproj, low, high ) )
+    {
+      const float    width    = static_cast<float>( this->source->width () ) ;
+      const float    height   = static_cast<float>( this->source->height() ) ;
+      const unsigned capacity = this->records.size()                         ;
+
+      if( high.x >= 0.0f && high.y >= 0.0f && low.x < width && low.y < height )
+      {
+        unsigned first_x = static_cast<unsigned>( std::max( low .x, 0.0f          ) ) / TILEMAP_CHUNK ;
+        unsigned first_y = static_cast<unsigned>( std::max( low .y, 0.0f          ) ) / TILEMAP_CHUNK ;
+        unsigned last_x  = static_cast<unsigned>( std::min( high.x, width  - 1.0f ) ) / TILEMAP_CHUNK ;
+        unsigned last_y  = static_cast<unsigned>( std::min( high.y, height - 1.0f ) ) / TILEMAP_CHUNK ;
+        unsigned columns = last_x - first_x + 1 ;
+        unsigned rows    = last_y - first_y + 1 ;
+
+        // Zoomed out too far, keep the chunks around the center of the screen.
+        if( columns * rows > capacity )
+        {
+          const float    scale       = std::sqrt( static_cast<float>( capacity ) / static_cast<float>( columns * rows ) ) ;
+          const unsigned new_columns = std::max( 1u, std::min( columns, static_cast<unsigned>( columns * scale ) ) )      ;
+          const unsigned new_rows    = std::max( 1u, std::min( rows   , capacity / new_columns ) )                        ;
+
+          first_x += ( columns - new_columns ) / 2 ;
+          first_y += ( rows    - new_rows    ) / 2 ;
+          columns  = new_columns ;
+          rows     = new_rows    ;
+        }
+
+        this->missing.clear() ;
+
+        // Resident chunks are claimed first, so streaming in the missing ones can't evict anything on screen.
+        for( unsigned row = 0; row < rows; row++ )
+        {
+          for( unsigned column = 0; column < columns; column++ )
+          {
+            TileChunk& chunk = this->records[ this->drawn ] ;
+
+            chunk.rect  = glm::vec4( static_cast<float>( ( first_x + column ) * TILEMAP_CHUNK ), static_cast<float>( ( first_y + row ) * TILEMAP_CHUNK ), static_cast<float>( TILEMAP_CHUNK ), static_cast<float>( TILEMAP_CHUNK ) ) ;
+            chunk.layer = this->cache.acquire( first_x + column, first_y + row, false, fresh ) ;
+
+            if( chunk.layer == NO_CHUNK ) this->missing.push_back( this->drawn ) ;
+            this->drawn++ ;
+          }
+        }
+
+        const float center_x = static_cast<float>( columns - 1 ) * 0.5f ;
+        const float center_y = static_cast<float>( rows    - 1 ) * 0.5f ;
+
+        auto distance = [&] ( unsigned index )
+        {
+          const float x = static_cast<float>( index % columns ) - center_x ;
+          const float y = static_cast<float>( index / columns ) - center_y ;
+
+          return x * x + y * y ;
+        };
+
+        std::sort( this->missing.begin(), this->missing.end(), [&] ( unsigned a, unsigned b ) { return distance( a ) < distance( b ) ; } ) ;
+
+        for( unsigned index = 0; index < this->missing.size() && this->filled.size() < this->budget; index++ )
+        {
+          TileChunk&     chunk   = this->records[ this->missing[ index ] ] ;
+          const unsigned chunk_x = first_x + this->missing[ index ] % columns ;
+          const unsigned chunk_y = first_y + this->missing[ index ] / columns ;
+
+          chunk.layer = this->cache.acquire( chunk_x, chunk_y, true, fresh ) ;
+          if( chunk.layer != NO_CHUNK ) this->fill( chunk_x, chunk_y, chunk.layer ) ;
+        }
+
+        // Whatever is left of the budget streams in the ring around the screen, ready for the camera to move onto.
+        const unsigned ring_first_x = first_x > 0 ? first_x - 1 : 0 ;
+        const unsigned ring_first_y = first_y > 0 ? first_y - 1 : 0 ;
+        const unsigned ring_last_x  = std::min( first_x + columns, ( this->source->width () - 1 ) / TILEMAP_CHUNK ) ;
+        const unsigned ring_last_y  = std::min( first_y + rows   , ( this->source->height() - 1 ) / TILEMAP_CHUNK ) ;
+
+        for( unsigned chunk_y = ring_first_y; chunk_y <= ring_last_y && this->filled.size() < this->budget; chunk_y++ )
+        {
+          for( unsigned chunk_x = ring_first_x; chunk_x <= ring_last_x && this->filled.size() < this->budget; chunk_x++ )
+          {
+            const bool inside = chunk_x >= first_x && chunk_x < first_x + columns && chunk_y >= first_y && chunk_y < first_y + rows ;
+
+            if( inside ) continue ;
+
+            const unsigned layer = this->cache.acquire( chunk_x, chunk_y, true, fresh ) ;
+            if( fresh ) this->fill( chunk_x, chunk_y, layer ) ;
+          }
+        }
+      }
+    }
+
+    for( unsigned index = this->drawn; index < previous; index++ ) this->records[ index ].layer = NO_CHUNK ;
+
+    this->changed = std::max( this->pending, std::max( previous, this->drawn ) ) ;
+    this->pending = 0 ;
+
+    return this->drawn ;
+  }
+
+  inline void TileStreamer::fill( unsigned chunk_x, unsigned chunk_y, unsigned layer )
+  {
+    const std::size_t offset = this->filled.size() * TILEMAP_CHUNK * TILEMAP_CHUNK ;
+
+    this->scratch.resize( offset + TILEMAP_CHUNK * TILEMAP_CHUNK ) ;
+    this->source->chunk( chunk_x, chunk_y, this->scratch.data() + offset ) ;
+    this->filled.push_back( layer ) ;
+  }
+
+  inline const std::vector<TileChunk>& TileStreamer::chunks() const
+  {
+    return this->records ;
+  }
+
+  inline unsigned TileStreamer::dirty() const
+  {
+    return this->changed ;
+  }
+
+  inline const std::vector<unsigned>& TileStreamer::uploads() const
+  {
+    return this->filled ;
+  }
+
+  inline const unsigned* TileStreamer::tiles() const
+  {
+    return this->scratch.data() ;
+  }
+
+  inline unsigned TileStreamer::layers() const
+  {
+    return this->cache.layers() ;
+  }
+
+  inline unsigned TileStreamer::resident() const
+  {
+    return this->cache.resident() ;
+  }
+}
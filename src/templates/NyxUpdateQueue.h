@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 2020 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <cstddef>
+
+namespace nyx
+{
+  /** The default amount of updates an update queue holds before producers have to wait for it to be drained.
+   */
+  constexpr unsigned UPDATE_QUEUE_SIZE = 1 << 14 ;
+
+  /** Bounded, lock-free queue of updates pushed from any amount of threads & drained by one.
+   * Every slot carries a sequence number, so producers only ever contend on the single write position.
+   */
+  template<typename Type>
+  class UpdateQueue
+  {
+    public:
+
+      /** Constructor. Allocates the queue.
+       * @param capacity The amount of updates the queue can hold. Rounded up to a power of two.
+       */
+      explicit UpdateQueue( unsigned capacity = UPDATE_QUEUE_SIZE ) ;
+
+      /** Method to push an update onto the queue. Safe to call from any thread.
+       * @param value The update to push.
+       * @return Whether the update was pushed. False when the queue is full.
+       */
+      bool push( const Type& value ) ;
+
+      /** Method to pop every update currently in the queue, in the order they were pushed.
+       * Only one thread may drain at a time.
+       * @param function The function to call with every popped update.
+       * @return The amount of updates popped.
+       */
+      template<typename Function>
+      unsigned drain( Function function ) ;
+
+      /** Method to retrieve the amount of updates this queue can hold.
+       * @return The capacity of this queue.
+       */
+      unsigned capacity() const ;
+
+    private:
+
+      /** Structure describing a single slot of the queue.
+       * A slot is free to write at position N when it's sequence is N, and holds the update of position N when it is N + 1.
+       */
+      struct Slot
+      {
+        std::atomic<std::size_t> sequence ;
+        Type                     value    ;
+      };
+
+      std::unique_ptr<Slot[]>              slots ;
+      std::size_t                          mask  ;
+      alignas( 64 ) std::atomic<std::size_t> tail  ;
+      alignas( 64 ) std::size_t              head  ;
+  };
+
+  template<typename Type>
+  UpdateQueue<Type>::UpdateQueue( unsigned capacity )
+  {
+    std::size_t size = 1 ;
+
+    while( size < capacity ) size *= 2 ;
+
+    this->slots.reset( new Slot[ size ] ) ;
+    this->mask = size - 1 ;
+    this->head = 0        ;
+    this->tail.store( 0, std::memory_order_relaxed ) ;
+
+    for( std::size_t index = 0; index < size; index++ ) this->slots[ index ].sequence.store( index, std::memory_order_relaxed ) ;
+  }
+
+  template<typename Type>
+  bool UpdateQueue<Type>::push( const Type& value )
+  {
+    std::size_t position = this->tail.load( std::memory_order_relaxed ) ;
+    Slot*       slot                                                   ;
+
+    for( ;; )
+    {
+      slot = &this->slots[ position & this->mask ] ;
+
+      const std::size_t    sequence   = slot->sequence.load( std::memory_order_acquire )                                   ;
+      const std::ptrdiff_t difference = static_cast<std::ptrdiff_t>( sequence ) - static_cast<std::ptrdiff_t>( position ) ;
+
+      if( difference == 0 )
+      {
+        if( this->tail.compare_exchange_weak( position, position + 1, std::memory_order_relaxed ) ) break ;
+      }
+      else if( difference < 0 )
+      {
+        // The slot still holds an update from a lap ago, so the queue is full.
+        return false ;
+      }
+      else
+      {
+        position = this->tail.load( std::memory_order_relaxed ) ;
+      }
+    }
+
+    slot->value = value ;
+    slot->sequence.store( position + 1, std::memory_order_release ) ;
+
+    return true ;
+  }
+
+  template<typename Type>
+  template<typename Function>
+  unsigned UpdateQueue<Type>::drain( Function function )
+  {
+    unsigned count = 0 ;
+
+    for( ;; )
+    {
+      Slot& slot = this->slots[ this->head & this->mask ] ;
+
+      // Stops at the first slot still being written, it's update is picked up by the next drain.
+      if( slot.sequence.load( std::memory_order_acquire ) != this->head + 1 ) return count ;
+
+      function( static_cast<const Type&>( slot.value ) ) ;
+      slot.sequence.store( this->head + this->mask + 1, std::memory_order_release ) ;
+
+      this->head++ ;
+      count++ ;
+    }
+  }
+
+  template<typename Type>
+  unsigned UpdateQueue<Type>::capacity() const
+  {
+    return this->mask + 1 ;
+  }
+}
@@ -0,0 +1,163 @@
+/*
+ * Copyright (C) 2020 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+
+namespace nyx
+{
+  /** Structure describing a compressed NGG vertex, 24 bytes instead of the 72 of the full float layout.
+   * Matches NyxQuantizedVertex in the shader include NyxQuantized.h.
+   */
+  struct QuantizedVertex
+  {
+    std::int16_t  position[ 4 ] ; ///< Snorm16 position inside the mesh's bounds. See @Dequantization. The fourth value is padding.
+    std::uint32_t normal        ; ///< Octahedral-encoded normal, as two snorm16 values.
+    std::uint32_t weights       ; ///< Four unorm8 bone weights, summing to exactly 255.
+    std::uint32_t ids           ; ///< Four uint8 bone ids.
+    std::uint32_t tex_coords    ; ///< Two half-float texture coordinates.
+  };
+
+  /** Structure describing how to turn a mesh's quantized positions back into model space: position = offset + scale * snorm.
+   */
+  struct Dequantization
+  {
+    glm::vec4 offset ; ///< The center of the mesh's bounds.
+    glm::vec4 scale  ; ///< The half extent of the mesh's bounds on each axis.
+  };
+
+  /** Function to encode a unit vector onto the octahedron, folded into the [-1, 1] square.
+   * @param normal The unit vector to encode.
+   * @return The two encoded components.
+   */
+  inline glm::vec2 octEncode( const glm::vec3& normal ) ;
+
+  /** Function to decode a unit vector encoded with @octEncode.
+   * @param encoded The two encoded components.
+   * @return The decoded unit vector.
+   */
+  inline glm::vec3 octDecode( const glm::vec2& encoded ) ;
+
+  /** Function to compute the dequantization of a mesh from the bounds of it's positions.
+   * @param vertices The full float vertices of the mesh.
+   * @param count The amount of vertices.
+   * @return The dequantization to quantize the mesh's positions against.
+   */
+  template<typename Vertex>
+  Dequantization computeDequantization( const Vertex* vertices, unsigned count ) ;
+
+  /** Function to quantize a single full float NGG vertex.
+   * @param vertex The vertex to quantize.
+   * @param dequantization The dequantization of the vertex's mesh.
+   * @return The quantized vertex.
+   */
+  template<typename Vertex>
+  QuantizedVertex quantizeVertex( const Vertex& vertex, const Dequantization& dequantization ) ;
+
+  glm::vec2 octEncode( const glm::vec3& normal )
+  {
+    const float     sum    = std::fabs( normal.x ) + std::fabs( normal.y ) + std::fabs( normal.z ) ;
+    const glm::vec3 n      = sum > 0.0f ? normal / sum : glm::vec3( 0.0f, 0.0f, 1.0f )             ;
+    glm::vec2       result = glm::vec2( n.x, n.y )                                                   ;
+
+    // Fold the lower hemisphere over the diagonals.
+    if( n.z < 0.0f )
+    {
+      result.x = ( 1.0f - std::fabs( n.y ) ) * ( n.x >= 0.0f ? 1.0f : -1.0f ) ;
+      result.y = ( 1.0f - std::fabs( n.x ) ) * ( n.y >= 0.0f ? 1.0f : -1.0f ) ;
+    }
+
+    return result ;
+  }
+
+  glm::vec3 octDecode( const glm::vec2& encoded )
+  {
+    glm::vec3   n = glm::vec3( encoded.x, encoded.y, 1.0f - std::fabs( encoded.x ) - std::fabs( encoded.y ) ) ;
+    const float t = std::max( -n.z, 0.0f )                                                                   ;
+
+    n.x += n.x >= 0.0f ? -t : t ;
+    n.y += n.y >= 0.0f ? -t : t ;
+
+    return glm::normalize( n ) ;
+  }
+
+  template<typename Vertex>
+  Dequantization computeDequantization( const Vertex* vertices, unsigned count )
+  {
+    Dequantization result                                                            ;
+    glm::vec3      low  = count ? glm::vec3( vertices[ 0 ].vertex ) : glm::vec3( 0.0f ) ;
+    glm::vec3      high = low                                                          ;
+
+    for( unsigned index = 1; index < count; index++ )
+    {
+      low  = glm::min( low , glm::vec3( vertices[ index ].vertex ) ) ;
+      high = glm::max( high, glm::vec3( vertices[ index ].vertex ) ) ;
+    }
+
+    result.offset = glm::vec4( ( low + high ) * 0.5f, 0.0f ) ;
+    result.scale  = glm::vec4( ( high - low ) * 0.5f, 0.0f ) ;
+
+    // Flat axes would divide by zero, any scale reproduces them exactly.
+    for( unsigned axis = 0; axis < 3; axis++ ) if( result.scale[ axis ] <= 0.0f ) result.scale[ axis ] = 1.0f ;
+
+    return result ;
+  }
+
+  template<typename Vertex>
+  QuantizedVertex quantizeVertex( const Vertex& vertex, const Dequantization& dequantization )
+  {
+    QuantizedVertex result                                                                               ;
+    unsigned        weights  [ 4 ]                                                                       ;
+    unsigned        total    = 0                                                                         ;
+    unsigned        heaviest = 0                                                                         ;
+    const float     sum      = vertex.weights.x + vertex.weights.y + vertex.weights.z + vertex.weights.w ;
+
+    for( unsigned axis = 0; axis < 3; axis++ )
+    {
+      const float normalized = ( vertex.vertex[ axis ] - dequantization.offset[ axis ] ) / dequantization.scale[ axis ] ;
+      result.position[ axis ] = static_cast<std::int16_t>( std::round( glm::clamp( normalized, -1.0f, 1.0f ) * 32767.0f ) ) ;
+    }
+    result.position[ 3 ] = 0 ;
+
+    result.normal     = glm::packSnorm2x16( nyx::octEncode( glm::vec3( vertex.normals ) ) ) ;
+    result.tex_coords = glm::packHalf2x16 ( glm::vec2( vertex.tex_coords )                ) ;
+    result.ids        = 0                                                                     ;
+    result.weights    = 0                                                                     ;
+
+    // Round the weights, then hand the rounding error to the heaviest one so they still sum to one.
+    for( unsigned index = 0; index < 4; index++ )
+    {
+      weights[ index ] = sum > 0.0f ? static_cast<unsigned>( std::round( vertex.weights[ index ] / sum * 255.0f ) ) : 0 ;
+      total           += weights[ index ] ;
+      if( weights[ index ] > weights[ heaviest ] ) heaviest = index ;
+    }
+
+    if( total != 0 ) weights[ heaviest ] = weights[ heaviest ] + 255 - total ;
+
+    for( unsigned index = 0; index < 4; index++ )
+    {
+      result.weights |= ( weights[ index ]                                & 0xFF ) << ( index * 8 ) ;
+      result.ids     |= ( std::min<unsigned>( vertex.ids[ index ], 255 ) & 0xFF ) << ( index * 8 ) ;
+    }
+
+    return result ;
+  }
+}
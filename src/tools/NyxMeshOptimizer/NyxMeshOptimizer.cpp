@@ -0,0 +1,531 @@
+/*
+ * Copyright (C) 2020 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   NyxMeshOptimizer.cpp
+ * Author: Jordan Hendl
+ *
+ * Created on May 6, 2021, 9:40 PM
+ */
+
+#include "NyxMeshOptimizer.h"
+#include <vector>
+#include <string>
+#include <fstream>
+#include <cstdint>
+#include <utility>
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+#include <climits>
+#include <limits>
+
+namespace nyx
+{
+  /** The size of the LRU cache Forsyth's scoring models. Larger than the measured FIFO cache, as the algorithm recommends.
+   */
+  constexpr unsigned FORSYTH_CACHE_SIZE = 32 ;
+
+  /** The resolution of each view overdraw is measured from.
+   */
+  constexpr unsigned OVERDRAW_GRID = 256 ;
+
+  /** The first bytes of every optimized mesh file.
+   */
+  constexpr char MESH_FILE_MAGIC[] = "NYXM" ;
+
+  /** Structure to hold a 3D position while working on a mesh.
+   */
+  struct Position
+  {
+    float x ;
+    float y ;
+    float z ;
+  };
+
+  /** Structure describing a run of triangles that is reordered as a whole by the overdraw pass.
+   */
+  struct Cluster
+  {
+    unsigned first ; ///< The first triangle of the cluster.
+    unsigned count ; ///< The amount of triangles in the cluster.
+    float    key   ; ///< How far the cluster faces out of the mesh. Clusters facing out are drawn first.
+  };
+
+  /** Function to score a vertex by how much emitting one of it's triangles now would help the cache.
+   * @param position The vertex's position in the LRU cache. -1 if it is not cached.
+   * @param remaining The amount of triangles still using the vertex.
+   * @return The score of the vertex.
+   */
+  static float vertexScore( int position, unsigned remaining )
+  {
+    float score = 0.0f ;
+
+    if( remaining == 0 ) return -1.0f ;
+
+    // The last triangle's vertices get a fixed score, so the next triangle doesn't just reuse one of them.
+    if( position >= 0 )
+    {
+      if( position < 3 ) score = 0.75f ;
+      else               score = std::pow( 1.0f - static_cast<float>( position - 3 ) / ( FORSYTH_CACHE_SIZE - 3 ), 1.5f ) ;
+    }
+
+    // Favour finishing vertices with few triangles left, so they can leave the cache for good.
+    return score + 2.0f / std::sqrt( static_cast<float>( remaining ) ) ;
+  }
+
+  /** Function to read the position of a vertex.
+   * @param positions Pointer to the x, y & z of the first vertex.
+   * @param stride The amount of bytes between consecutive positions.
+   * @param index The index of the vertex.
+   * @return The position of the vertex.
+   */
+  static Position position( const float* positions, unsigned stride, unsigned index )
+  {
+    const float* value = reinterpret_cast<const float*>( reinterpret_cast<const unsigned char*>( positions ) + static_cast<std::size_t>( index ) * stride ) ;
+
+    return { value[ 0 ], value[ 1 ], value[ 2 ] } ;
+  }
+
+  void optimizeVertexCache( unsigned* indices, unsigned index_count, unsigned vertex_count )
+  {
+    const unsigned triangle_count = index_count / 3 ;
+
+    std::vector<unsigned> offsets  ( vertex_count + 1, 0 ) ;
+    std::vector<unsigned> remaining( vertex_count    , 0 ) ;
+    std::vector<unsigned> adjacency( index_count         ) ;
+    std::vector<int>      cached   ( vertex_count    , -1 ) ;
+    std::vector<float>    scores   ( vertex_count         ) ;
+    std::vector<float>    triangle ( triangle_count       ) ;
+    std::vector<bool>     emitted  ( triangle_count, false ) ;
+    std::vector<unsigned> output                             ;
+    std::vector<unsigned> cache                              ;
+    std::vector<unsigned> next                               ;
+    unsigned              best   = UINT_MAX                  ;
+    unsigned              cursor = 0                         ;
+    float                 top    = -1.0f                     ;
+
+    if( triangle_count == 0 ) return ;
+
+    // Build each vertex's list of triangles.
+    for( unsigned index = 0; index < triangle_count * 3; index++ ) remaining[ indices[ index ] ]++ ;
+    for( unsigned vertex = 0; vertex < vertex_count; vertex++ ) offsets[ vertex + 1 ] = offsets[ vertex ] + remaining[ vertex ] ;
+
+    std::fill( remaining.begin(), remaining.end(), 0 ) ;
+    for( unsigned index = 0; index < triangle_count * 3; index++ )
+    {
+      const unsigned vertex = indices[ index ] ;
+      adjacency[ offsets[ vertex ] + remaining[ vertex ]++ ] = index / 3 ;
+    }
+
+    for( unsigned vertex = 0; vertex < vertex_count; vertex++ ) scores[ vertex ] = nyx::vertexScore( -1, remaining[ vertex ] ) ;
+
+    for( unsigned tri = 0; tri < triangle_count; tri++ )
+    {
+      triangle[ tri ] = scores[ indices[ tri * 3 ] ] + scores[ indices[ tri * 3 + 1 ] ] + scores[ indices[ tri * 3 + 2 ] ] ;
+      if( triangle[ tri ] > top ) { top = triangle[ tri ] ; best = tri ; }
+    }
+
+    output.reserve( triangle_count * 3 ) ;
+
+    while( best != UINT_MAX )
+    {
+      const unsigned* corners = indices + best * 3 ;
+
+      emitted[ best ] = true ;
+      output.insert( output.end(), corners, corners + 3 ) ;
+
+      // Remove the triangle from it's vertices' lists, so only unemitted triangles are ever scored.
+      for( unsigned corner = 0; corner < 3; corner++ )
+      {
+        const unsigned vertex = corners[ corner ]                     ;
+        unsigned*      begin  = adjacency.data() + offsets[ vertex ] ;
+        unsigned*      end    = begin + remaining[ vertex ]           ;
+
+        std::iter_swap( std::find( begin, end, best ), end - 1 ) ;
+        remaining[ vertex ]-- ;
+      }
+
+      // The triangle's vertices move to the front of the cache.
+      next.assign( corners, corners + 3 ) ;
+      for( auto vertex : cache ) if( vertex != corners[ 0 ] && vertex != corners[ 1 ] && vertex != corners[ 2 ] ) next.push_back( vertex ) ;
+
+      for( unsigned slot = 0; slot < next.size(); slot++ )
+      {
+        cached[ next[ slot ] ] = slot < FORSYTH_CACHE_SIZE ? static_cast<int>( slot ) : -1 ;
+        scores[ next[ slot ] ] = nyx::vertexScore( cached[ next[ slot ] ], remaining[ next[ slot ] ] ) ;
+      }
+
+      for( auto vertex : next )
+      {
+        for( unsigned adjacent = offsets[ vertex ]; adjacent < offsets[ vertex ] + remaining[ vertex ]; adjacent++ )
+        {
+          const unsigned tri = adjacency[ adjacent ] ;
+          triangle[ tri ] = scores[ indices[ tri * 3 ] ] + scores[ indices[ tri * 3 + 1 ] ] + scores[ indices[ tri * 3 + 2 ] ] ;
+        }
+      }
+
+      if( next.size() > FORSYTH_CACHE_SIZE ) next.resize( FORSYTH_CACHE_SIZE ) ;
+      cache.swap( next ) ;
+
+      // The best next triangle almost always touches the cache, so only those are searched.
+      best = UINT_MAX ;
+      top  = -1.0f    ;
+      for( auto vertex : cache )
+      {
+        for( unsigned adjacent = offsets[ vertex ]; adjacent < offsets[ vertex ] + remaining[ vertex ]; adjacent++ )
+        {
+          const unsigned tri = adjacency[ adjacent ] ;
+          if( triangle[ tri ] > top ) { top = triangle[ tri ] ; best = tri ; }
+        }
+      }
+
+      // Nothing left around the cache, continue with the next untouched part of the mesh.
+      if( best == UINT_MAX )
+      {
+        while( cursor < triangle_count && emitted[ cursor ] ) cursor++ ;
+        if( cursor < triangle_count ) best = cursor ;
+      }
+    }
+
+    std::copy( output.begin(), output.end(), indices ) ;
+  }
+
+  void optimizeOverdraw( unsigned* indices, unsigned index_count, const float* positions, unsigned vertex_count, unsigned stride )
+  {
+    const unsigned triangle_count = index_count / 3 ;
+
+    std::vector<unsigned> stamps( vertex_count, 0 )  ;
+    std::vector<Cluster>  clusters                   ;
+    std::vector<unsigned> output                     ;
+    unsigned              time   = MESH_CACHE_SIZE + 1 ;
+    Position              center = { 0.0f, 0.0f, 0.0f } ;
+    float                 area   = 0.0f                 ;
+
+    if( triangle_count == 0 ) return ;
+
+    // Split where a triangle misses the cache with all three vertices, since the cache is cold there anyway.
+    for( unsigned tri = 0; tri < triangle_count; tri++ )
+    {
+      unsigned misses = 0 ;
+
+      for( unsigned corner = 0; corner < 3; corner++ )
+      {
+        const unsigned vertex = indices[ tri * 3 + corner ] ;
+        if( time - stamps[ vertex ] > MESH_CACHE_SIZE ) { stamps[ vertex ] = time++ ; misses++ ; }
+      }
+
+      if( tri == 0 || misses == 3 ) clusters.push_back( { tri, 0, 0.0f } ) ;
+      clusters.back().count++ ;
+    }
+
+    // Area-weighted center of the whole mesh.
+    for( unsigned tri = 0; tri < triangle_count; tri++ )
+    {
+      const Position a = nyx::position( positions, stride, indices[ tri * 3     ] ) ;
+      const Position b = nyx::position( positions, stride, indices[ tri * 3 + 1 ] ) ;
+      const Position c = nyx::position( positions, stride, indices[ tri * 3 + 2 ] ) ;
+      const float    ux = b.x - a.x, uy = b.y - a.y, uz = b.z - a.z ;
+      const float    vx = c.x - a.x, vy = c.y - a.y, vz = c.z - a.z ;
+      const float    nx = uy * vz - uz * vy, ny = uz * vx - ux * vz, nz = ux * vy - uy * vx ;
+      const float    weight = std::sqrt( nx * nx + ny * ny + nz * nz ) ;
+
+      center.x += weight * ( a.x + b.x + c.x ) / 3.0f ;
+      center.y += weight * ( a.y + b.y + c.y ) / 3.0f ;
+      center.z += weight * ( a.z + b.z + c.z ) / 3.0f ;
+      area     += weight ;
+    }
+
+    if( area > 0.0f ) { center.x /= area ; center.y /= area ; center.z /= area ; }
+
+    for( auto& cluster : clusters )
+    {
+      Position centroid = { 0.0f, 0.0f, 0.0f } ;
+      Position normal   = { 0.0f, 0.0f, 0.0f } ;
+      float    weight   = 0.0f                 ;
+
+      for( unsigned tri = cluster.first; tri < cluster.first + cluster.count; tri++ )
+      {
+        const Position a = nyx::position( positions, stride, indices[ tri * 3     ] ) ;
+        const Position b = nyx::position( positions, stride, indices[ tri * 3 + 1 ] ) ;
+        const Position c = nyx::position( positions, stride, indices[ tri * 3 + 2 ] ) ;
+        const float    ux = b.x - a.x, uy = b.y - a.y, uz = b.z - a.z ;
+        const float    vx = c.x - a.x, vy = c.y - a.y, vz = c.z - a.z ;
+        const float    nx = uy * vz - uz * vy, ny = uz * vx - ux * vz, nz = ux * vy - uy * vx ;
+        const float    size = std::sqrt( nx * nx + ny * ny + nz * nz ) ;
+
+        centroid.x += size * ( a.x + b.x + c.x ) / 3.0f ;
+        centroid.y += size * ( a.y + b.y + c.y ) / 3.0f ;
+        centroid.z += size * ( a.z + b.z + c.z ) / 3.0f ;
+        normal.x   += nx ;
+        normal.y   += ny ;
+        normal.z   += nz ;
+        weight     += size ;
+      }
+
+      const float length = std::sqrt( normal.x * normal.x + normal.y * normal.y + normal.z * normal.z ) ;
+
+      if( weight > 0.0f && length > 0.0f )
+      {
+        cluster.key = ( ( centroid.x / weight - center.x ) * normal.x +
+                        ( centroid.y / weight - center.y ) * normal.y +
+                        ( centroid.z / weight - center.z ) * normal.z ) / length ;
+      }
+    }
+
+    std::stable_sort( clusters.begin(), clusters.end(), [] ( const Cluster& a, const Cluster& b ) { return a.key > b.key ; } ) ;
+
+    output.reserve( triangle_count * 3 ) ;
+    for( const auto& cluster : clusters )
+    {
+      output.insert( output.end(), indices + cluster.first * 3, indices + ( cluster.first + cluster.count ) * 3 ) ;
+    }
+
+    std::copy( output.begin(), output.end(), indices ) ;
+  }
+
+  unsigned optimizeVertexFetch( void* vertices, unsigned vertex_count, unsigned stride, unsigned* indices, unsigned index_count )
+  {
+    std::vector<unsigned>      remap( vertex_count, UINT_MAX ) ;
+    std::vector<unsigned char> copy                            ;
+    unsigned char*             bytes = static_cast<unsigned char*>( vertices ) ;
+    unsigned                   next  = 0                                       ;
+
+    for( unsigned index = 0; index < index_count; index++ )
+    {
+      unsigned& target = remap[ indices[ index ] ] ;
+
+      if( target == UINT_MAX ) target = next++ ;
+      indices[ index ] = target ;
+    }
+
+    copy.assign( bytes, bytes + static_cast<std::size_t>( vertex_count ) * stride ) ;
+
+    for( unsigned vertex = 0; vertex < vertex_count; vertex++ )
+    {
+      if( remap[ vertex ] != UINT_MAX ) std::memcpy( bytes + static_cast<std::size_t>( remap[ vertex ] ) * stride, copy.data() + static_cast<std::size_t>( vertex ) * stride, stride ) ;
+    }
+
+    return next ;
+  }
+
+  VertexCacheStatistics analyzeVertexCache( const unsigned* indices, unsigned index_count, unsigned vertex_count, unsigned cache_size )
+  {
+    VertexCacheStatistics result = { 0, 0.0f, 0.0f }         ;
+    std::vector<unsigned> stamps ( vertex_count, 0     )    ;
+    std::vector<bool>     used   ( vertex_count, false )    ;
+    unsigned              time   = cache_size + 1           ;
+    unsigned              unique = 0                        ;
+
+    for( unsigned index = 0; index < index_count; index++ )
+    {
+      const unsigned vertex = indices[ index ] ;
+
+      if( time - stamps[ vertex ] > cache_size ) { stamps[ vertex ] = time++ ; result.misses++ ; }
+      if( !used[ vertex ] ) { used[ vertex ] = true ; unique++ ; }
+    }
+
+    if( index_count >= 3 ) result.acmr = static_cast<float>( result.misses ) / ( index_count / 3 ) ;
+    if( unique      != 0 ) result.atvr = static_cast<float>( result.misses ) / unique            ;
+
+    return result ;
+  }
+
+  OverdrawStatistics analyzeOverdraw( const unsigned* indices, unsigned index_count, const float* positions, unsigned vertex_count, unsigned stride )
+  {
+    const float        far    = std::numeric_limits<float>::max() ;
+    OverdrawStatistics result = { 0, 0, 0.0f }                     ;
+    std::vector<float> depth( OVERDRAW_GRID * OVERDRAW_GRID )      ;
+    Position           low    = { far, far, far }                  ;
+    Position           high   = { -far, -far, -far }               ;
+    float              extent = 0.0f                               ;
+
+    for( unsigned vertex = 0; vertex < vertex_count; vertex++ )
+    {
+      const Position p = nyx::position( positions, stride, vertex ) ;
+
+      low .x = std::min( low .x, p.x ) ; low .y = std::min( low .y, p.y ) ; low .z = std::min( low .z, p.z ) ;
+      high.x = std::max( high.x, p.x ) ; high.y = std::max( high.y, p.y ) ; high.z = std::max( high.z, p.z ) ;
+    }
+
+    extent = std::max( { high.x - low.x, high.y - low.y, high.z - low.z } ) ;
+    if( vertex_count == 0 || extent <= 0.0f ) return result ;
+
+    // Look down each axis from both sides.
+    for( unsigned view = 0; view < 6; view++ )
+    {
+      const unsigned axis      = view / 2                   ;
+      const float    direction = view % 2 ? -1.0f : 1.0f    ;
+      const float    scale     = ( OVERDRAW_GRID - 1 ) / extent ;
+
+      std::fill( depth.begin(), depth.end(), far ) ;
+
+      for( unsigned tri = 0; tri + 2 < index_count; tri += 3 )
+      {
+        float screen[ 3 ][ 3 ] ;
+
+        for( unsigned corner = 0; corner < 3; corner++ )
+        {
+          const Position p      = nyx::position( positions, stride, indices[ tri + corner ] ) ;
+          const float    v[ 3 ] = { p.x - low.x, p.y - low.y, p.z - low.z }                ;
+
+          screen[ corner ][ 0 ] = v[ ( axis + 1 ) % 3 ] * scale  ;
+          screen[ corner ][ 1 ] = v[ ( axis + 2 ) % 3 ] * scale  ;
+          screen[ corner ][ 2 ] = v[ axis ]             * direction ;
+        }
+
+        // Counter-clockwise triangles face the viewer, back faces are culled like the renderer does.
+        const float area = ( screen[ 1 ][ 0 ] - screen[ 0 ][ 0 ] ) * ( screen[ 2 ][ 1 ] - screen[ 0 ][ 1 ] ) -
+                           ( screen[ 1 ][ 1 ] - screen[ 0 ][ 1 ] ) * ( screen[ 2 ][ 0 ] - screen[ 0 ][ 0 ] ) ;
+
+        if( area * direction >= 0.0f ) continue ;
+
+        const int min_x = std::max( 0                                , static_cast<int>( std::floor( std::min( { screen[ 0 ][ 0 ], screen[ 1 ][ 0 ], screen[ 2 ][ 0 ] } ) ) ) ) ;
+        const int max_x = std::min( static_cast<int>( OVERDRAW_GRID ) - 1, static_cast<int>( std::ceil ( std::max( { screen[ 0 ][ 0 ], screen[ 1 ][ 0 ], screen[ 2 ][ 0 ] } ) ) ) ) ;
+        const int min_y = std::max( 0                                , static_cast<int>( std::floor( std::min( { screen[ 0 ][ 1 ], screen[ 1 ][ 1 ], screen[ 2 ][ 1 ] } ) ) ) ) ;
+        const int max_y = std::min( static_cast<int>( OVERDRAW_GRID ) - 1, static_cast<int>( std::ceil ( std::max( { screen[ 0 ][ 1 ], screen[ 1 ][ 1 ], screen[ 2 ][ 1 ] } ) ) ) ) ;
+
+        for( int y = min_y; y <= max_y; y++ )
+        {
+          for( int x = min_x; x <= max_x; x++ )
+          {
+            const float px = x + 0.5f ;
+            const float py = y + 0.5f ;
+            const float w0 = ( ( screen[ 2 ][ 0 ] - screen[ 1 ][ 0 ] ) * ( py - screen[ 1 ][ 1 ] ) - ( screen[ 2 ][ 1 ] - screen[ 1 ][ 1 ] ) * ( px - screen[ 1 ][ 0 ] ) ) / area ;
+            const float w1 = ( ( screen[ 0 ][ 0 ] - screen[ 2 ][ 0 ] ) * ( py - screen[ 2 ][ 1 ] ) - ( screen[ 0 ][ 1 ] - screen[ 2 ][ 1 ] ) * ( px - screen[ 2 ][ 0 ] ) ) / area ;
+            const float w2 = 1.0f - w0 - w1 ;
+
+            if( w0 < 0.0f || w1 < 0.0f || w2 < 0.0f ) continue ;
+
+            const float z     = w0 * screen[ 0 ][ 2 ] + w1 * screen[ 1 ][ 2 ] + w2 * screen[ 2 ][ 2 ] ;
+            float&      value = depth[ y * OVERDRAW_GRID + x ]                                         ;
+
+            if( z < value )
+            {
+              if( value == far ) result.covered++ ;
+              value = z ;
+              result.shaded++ ;
+            }
+          }
+        }
+      }
+    }
+
+    if( result.covered != 0 ) result.overdraw = static_cast<float>( result.shaded ) / result.covered ;
+
+    return result ;
+  }
+
+  /** Function to write a single 32-bit value to an optimized mesh file.
+   */
+  static void writeValue( std::ofstream& stream, std::uint32_t value )
+  {
+    stream.write( reinterpret_cast<const char*>( &value ), sizeof( value ) ) ;
+  }
+
+  /** Function to read a single 32-bit value of an optimized mesh file.
+   */
+  static bool readValue( std::ifstream& stream, std::uint32_t& value )
+  {
+    return static_cast<bool>( stream.read( reinterpret_cast<char*>( &value ), sizeof( value ) ) ) ;
+  }
+
+  bool saveMeshes( const char* path, const std::vector<OptimizedMesh>& meshes )
+  {
+    std::ofstream stream( path, std::ios::binary ) ;
+
+    if( !stream ) return false ;
+
+    stream.write( MESH_FILE_MAGIC, 4 ) ;
+    writeValue( stream, MESH_FILE_VERSION ) ;
+    writeValue( stream, meshes.size()     ) ;
+
+    for( const auto& mesh : meshes )
+    {
+      const std::uint32_t vertex_count = mesh.stride != 0 ? mesh.vertices.size() / mesh.stride : 0 ;
+
+      writeValue( stream, mesh.name.size()     ) ;
+      stream.write( mesh.name.data(), mesh.name.size() ) ;
+      writeValue( stream, vertex_count         ) ;
+      writeValue( stream, mesh.stride          ) ;
+      writeValue( stream, mesh.indices.size()  ) ;
+      stream.write( reinterpret_cast<const char*>( mesh.vertices.data() ), static_cast<std::size_t>( vertex_count ) * mesh.stride ) ;
+      stream.write( reinterpret_cast<const char*>( mesh.indices .data() ), mesh.indices.size() * sizeof( unsigned )             ) ;
+    }
+
+    return static_cast<bool>( stream ) ;
+  }
+
+  bool loadMeshes( const char* path, std::vector<OptimizedMesh>& meshes )
+  {
+    std::ifstream              stream( path, std::ios::binary | std::ios::ate ) ;
+    std::vector<OptimizedMesh> result                                         ;
+    char                       magic[ 4 ]                                     ;
+    std::uint32_t              version = 0                                    ;
+    std::uint32_t              count   = 0                                    ;
+    std::uint64_t              left    = 0                                    ;
+
+    if( !stream ) return false ;
+
+    // Sizes are checked against what's left of the file, so a broken file can't make this allocate more than the file holds.
+    left = static_cast<std::uint64_t>( stream.tellg() ) ;
+    stream.seekg( 0 ) ;
+
+    if( !stream.read( magic, 4 ) || std::memcmp( magic, MESH_FILE_MAGIC, 4 ) != 0 ) return false ;
+    if( !readValue( stream, version ) || version != MESH_FILE_VERSION             ) return false ;
+    if( !readValue( stream, count )                                               ) return false ;
+
+    left -= 12 ;
+
+    for( std::uint32_t index = 0; index < count; index++ )
+    {
+      OptimizedMesh mesh             ;
+      std::uint32_t length       = 0 ;
+      std::uint32_t vertex_count = 0 ;
+      std::uint32_t stride       = 0 ;
+      std::uint32_t index_count  = 0 ;
+
+      if( left < 16 || !readValue( stream, length ) || length > left - 16 ) return false ;
+
+      mesh.name.resize( length ) ;
+      stream.read( &mesh.name[ 0 ], length ) ;
+      left -= 4 + static_cast<std::uint64_t>( length ) ;
+
+      if( !readValue( stream, vertex_count ) || !readValue( stream, stride ) || !readValue( stream, index_count ) ) return false ;
+      left -= 12 ;
+
+      const std::uint64_t vertex_bytes = static_cast<std::uint64_t>( vertex_count ) * stride                 ;
+      const std::uint64_t index_bytes  = static_cast<std::uint64_t>( index_count  ) * sizeof( std::uint32_t ) ;
+
+      if( vertex_bytes + index_bytes > left ) return false ;
+
+      mesh.stride = stride ;
+      mesh.vertices.resize( vertex_bytes ) ;
+      mesh.indices .resize( index_count  ) ;
+      stream.read( reinterpret_cast<char*>( mesh.vertices.data() ), vertex_bytes ) ;
+      stream.read( reinterpret_cast<char*>( mesh.indices .data() ), index_bytes  ) ;
+      left -= vertex_bytes + index_bytes ;
+
+      if( !stream ) return false ;
+      result.push_back( std::move( mesh ) ) ;
+    }
+
+    meshes = std::move( result ) ;
+
+    return true ;
+  }
+}
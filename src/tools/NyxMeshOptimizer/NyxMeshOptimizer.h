@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2020 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   NyxMeshOptimizer.h
+ * Author: Jordan Hendl
+ *
+ * Created on May 6, 2021, 9:40 PM
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace nyx
+{
+  /** The amount of vertices the post-transform cache is modelled with when measuring a mesh.
+   */
+  constexpr unsigned MESH_CACHE_SIZE = 16 ;
+
+  /** The version of the optimized mesh files this library reads & writes.
+   */
+  constexpr unsigned MESH_FILE_VERSION = 1 ;
+
+  /** Structure describing how well a mesh's index order uses the post-transform vertex cache.
+   */
+  struct VertexCacheStatistics
+  {
+    unsigned misses ; ///< The amount of vertices that had to be transformed.
+    float    acmr   ; ///< Average cache miss ratio, transformed vertices per triangle. 0.5 is the best possible, 3.0 the worst.
+    float    atvr   ; ///< Average transform to vertex ratio, transformed vertices per unique vertex. 1.0 is the best possible.
+  };
+
+  /** Structure describing how often pixels of a mesh are shaded more than once.
+   */
+  struct OverdrawStatistics
+  {
+    unsigned covered  ; ///< The amount of pixels the mesh covers.
+    unsigned shaded   ; ///< The amount of fragments that passed the depth test.
+    float    overdraw ; ///< Shaded fragments per covered pixel. 1.0 is the best possible.
+  };
+
+  /** Structure describing a single mesh of an optimized mesh file.
+   */
+  struct OptimizedMesh
+  {
+    std::string                name     ;
+    unsigned                   stride   ; ///< The size of a single vertex, in bytes.
+    std::vector<unsigned char> vertices ; ///< The vertices, in the NGG vertex layout.
+    std::vector<unsigned>      indices  ; ///< The indices of the triangle list.
+  };
+
+  /** Function to reorder a triangle list for the post-transform vertex cache, using Forsyth's linear-speed algorithm.
+   * @param indices The indices of the triangle list, reordered in place.
+   * @param index_count The amount of indices.
+   * @param vertex_count The amount of vertices the indices reference.
+   */
+  void optimizeVertexCache( unsigned* indices, unsigned index_count, unsigned vertex_count ) ;
+
+  /** Function to reorder clusters of a cache-optimized triangle list so that outward-facing clusters are drawn first, reducing overdraw.
+   * Clusters are split where the cache would be cold anyway, so the vertex cache efficiency is kept.
+   * @param indices The indices of the triangle list, reordered in place. Should be optimized with @optimizeVertexCache first.
+   * @param index_count The amount of indices.
+   * @param positions Pointer to the x, y & z of the first vertex.
+   * @param vertex_count The amount of vertices.
+   * @param stride The amount of bytes between the positions of consecutive vertices.
+   */
+  void optimizeOverdraw( unsigned* indices, unsigned index_count, const float* positions, unsigned vertex_count, unsigned stride ) ;
+
+  /** Function to reorder vertices in the order the triangle list first uses them, so vertex fetch walks memory linearly.
+   * Unreferenced vertices are dropped.
+   * @param vertices The vertices, reordered in place.
+   * @param vertex_count The amount of vertices.
+   * @param stride The size of a single vertex, in bytes.
+   * @param indices The indices of the triangle list, rewritten to the new order.
+   * @param index_count The amount of indices.
+   * @return The amount of vertices left.
+   */
+  unsigned optimizeVertexFetch( void* vertices, unsigned vertex_count, unsigned stride, unsigned* indices, unsigned index_count ) ;
+
+  /** Function to measure a triangle list against a FIFO post-transform cache.
+   * @param indices The indices of the triangle list.
+   * @param index_count The amount of indices.
+   * @param vertex_count The amount of vertices the indices reference.
+   * @param cache_size The amount of vertices in the modelled cache.
+   * @return The cache statistics of the triangle list.
+   */
+  VertexCacheStatistics analyzeVertexCache( const unsigned* indices, unsigned index_count, unsigned vertex_count, unsigned cache_size = MESH_CACHE_SIZE ) ;
+
+  /** Function to measure overdraw by rasterizing a triangle list with depth testing & back-face culling from the six axis directions.
+   * @param indices The indices of the triangle list.
+   * @param index_count The amount of indices.
+   * @param positions Pointer to the x, y & z of the first vertex.
+   * @param vertex_count The amount of vertices.
+   * @param stride The amount of bytes between the positions of consecutive vertices.
+   * @return The overdraw statistics of the triangle list, summed over every view.
+   */
+  OverdrawStatistics analyzeOverdraw( const unsigned* indices, unsigned index_count, const float* positions, unsigned vertex_count, unsigned stride ) ;
+
+  /** Function to write meshes to an optimized mesh file. The layout, all values little-endian:
+   *   char[4]  "NYXM"
+   *   uint32   version
+   *   uint32   mesh count
+   *   per mesh:
+   *     uint32   name length, followed by the name's bytes.
+   *     uint32   vertex count
+   *     uint32   vertex stride, in bytes
+   *     uint32   index count
+   *     bytes    vertex count * stride bytes of vertices.
+   *     uint32[] index count indices.
+   * @param path The path of the file to write.
+   * @param meshes The meshes to write.
+   * @return Whether the file was written.
+   */
+  bool saveMeshes( const char* path, const std::vector<OptimizedMesh>& meshes ) ;
+
+  /** Function to read the meshes of an optimized mesh file.
+   * @param path The path of the file to read.
+   * @param meshes The meshes read, replacing whatever it held.
+   * @return Whether the file was a complete optimized mesh file of this version. Nothing is read if it isn't.
+   */
+  bool loadMeshes( const char* path, std::vector<OptimizedMesh>& meshes ) ;
+}
@@ -0,0 +1,273 @@
+/*
+ * Copyright (C) 2020 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   Test.cpp
+ * Author: Jordan Hendl
+ *
+ * Created on May 6, 2021, 9:40 PM
+ */
+
+#include "NyxMeshOptimizer.h"
+#include <iostream>
+#include <random>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <set>
+#include <array>
+#include <fstream>
+#include <iterator>
+#include <cstdio>
+#include <cstring>
+
+/** Structure to hold a test vertex. Padded out like a real vertex, so the stride is exercised.
+ */
+struct Vertex
+{
+  float    position[ 3 ] ;
+  float    normal  [ 3 ] ;
+  unsigned id            ;
+};
+
+static std::vector<Vertex>   vertices ;
+static std::vector<unsigned> indices  ;
+
+/** Function to add a UV sphere to the test mesh.
+ */
+static void buildSphere( unsigned rings, unsigned segments, float radius )
+{
+  constexpr float PI = 3.14159265358979f ;
+
+  const unsigned first = vertices.size() ;
+
+  for( unsigned ring = 0; ring <= rings; ring++ )
+  {
+    for( unsigned segment = 0; segment <= segments; segment++ )
+    {
+      const float theta = PI * ring / rings                 ;
+      const float phi   = 2.0f * PI * segment / segments    ;
+      const float x     = std::sin( theta ) * std::cos( phi ) ;
+      const float y     = std::sin( theta ) * std::sin( phi ) ;
+      const float z     = std::cos( theta )                 ;
+
+      vertices.push_back( { { x * radius, y * radius, z * radius }, { x, y, z }, static_cast<unsigned>( vertices.size() ) } ) ;
+    }
+  }
+
+  for( unsigned ring = 0; ring < rings; ring++ )
+  {
+    for( unsigned segment = 0; segment < segments; segment++ )
+    {
+      const unsigned a = first + ring * ( segments + 1 ) + segment ;
+      const unsigned b = a + segments + 1                          ;
+
+      indices.insert( indices.end(), { a, b, a + 1 } ) ;
+      indices.insert( indices.end(), { a + 1, b, b + 1 } ) ;
+    }
+  }
+}
+
+/** Function to shuffle the triangles of the test mesh, the worst case an exporter can hand over.
+ */
+static void shuffleTriangles()
+{
+  std::mt19937 rng( 1337 ) ;
+  std::vector<std::array<unsigned, 3>> triangles ;
+
+  for( unsigned index = 0; index + 2 < indices.size(); index += 3 ) triangles.push_back( { indices[ index ], indices[ index + 1 ], indices[ index + 2 ] } ) ;
+
+  std::shuffle( triangles.begin(), triangles.end(), rng ) ;
+
+  indices.clear() ;
+  for( const auto& triangle : triangles ) indices.insert( indices.end(), triangle.begin(), triangle.end() ) ;
+}
+
+/** Function to collect the triangles of a triangle list by the ids of their vertices, rotated so the order of triangles & corners doesn't matter.
+ */
+static std::multiset<std::array<unsigned, 3>> triangleSet( const std::vector<Vertex>& verts, const std::vector<unsigned>& list )
+{
+  std::multiset<std::array<unsigned, 3>> result ;
+
+  for( unsigned index = 0; index + 2 < list.size(); index += 3 )
+  {
+    std::array<unsigned, 3> triangle = { verts[ list[ index ] ].id, verts[ list[ index + 1 ] ].id, verts[ list[ index + 2 ] ].id } ;
+
+    std::rotate( triangle.begin(), std::min_element( triangle.begin(), triangle.end() ), triangle.end() ) ;
+    result.insert( triangle ) ;
+  }
+
+  return result ;
+}
+
+static bool testVertexCache()
+{
+  const auto before = nyx::analyzeVertexCache( indices.data(), indices.size(), vertices.size() ) ;
+  const auto set    = triangleSet( vertices, indices )                                           ;
+
+  nyx::optimizeVertexCache( indices.data(), indices.size(), vertices.size() ) ;
+
+  const auto after = nyx::analyzeVertexCache( indices.data(), indices.size(), vertices.size() ) ;
+
+  std::cout << "Vertex cache: " << "\n"
+            << "-- ACMR : " << before.acmr << " -> " << after.acmr << "\n"
+            << "-- ATVR : " << before.atvr << " -> " << after.atvr << std::endl ;
+
+  // Winding has to survive, and the ordering should get well under one transform per triangle.
+  return set == triangleSet( vertices, indices ) && after.acmr < 0.8f && after.acmr < before.acmr ;
+}
+
+static bool testOverdraw()
+{
+  const auto before = nyx::analyzeOverdraw( indices.data(), indices.size(), vertices[ 0 ].position, vertices.size(), sizeof( Vertex ) ) ;
+  const auto cache  = nyx::analyzeVertexCache( indices.data(), indices.size(), vertices.size() )                                     ;
+  const auto set    = triangleSet( vertices, indices )                                                                                ;
+
+  nyx::optimizeOverdraw( indices.data(), indices.size(), vertices[ 0 ].position, vertices.size(), sizeof( Vertex ) ) ;
+
+  const auto after  = nyx::analyzeOverdraw( indices.data(), indices.size(), vertices[ 0 ].position, vertices.size(), sizeof( Vertex ) ) ;
+  const auto kept   = nyx::analyzeVertexCache( indices.data(), indices.size(), vertices.size() )                                     ;
+
+  std::cout << "Overdraw: " << "\n"
+            << "-- Overdraw : " << before.overdraw << " -> " << after.overdraw << "\n"
+            << "-- ACMR     : " << cache.acmr      << " -> " << kept.acmr      << std::endl ;
+
+  // A convex mesh has no overdraw to win back, but reordering must not add any or undo the cache ordering.
+  return set == triangleSet( vertices, indices ) && after.overdraw <= before.overdraw + 0.01f && kept.acmr <= cache.acmr * 1.05f ;
+}
+
+/** Writes the sphere to an optimized mesh file & reads it back, checking a cut off file is refused.
+ */
+static bool testMeshFile()
+{
+  const char*                     path  = "nyx_mesh_optimizer_test.nyxm"                            ;
+  const unsigned char*            bytes = reinterpret_cast<const unsigned char*>( vertices.data() ) ;
+  std::vector<nyx::OptimizedMesh> meshes                                                           ;
+  std::vector<nyx::OptimizedMesh> loaded                                                           ;
+  std::vector<char>               file                                                             ;
+
+  meshes.push_back( { "sphere", sizeof( Vertex ), std::vector<unsigned char>( bytes, bytes + vertices.size() * sizeof( Vertex ) ), indices } ) ;
+  meshes.push_back( { ""      , sizeof( Vertex ), {}, {} } ) ;
+
+  if( !nyx::saveMeshes( path, meshes ) || !nyx::loadMeshes( path, loaded ) ) return false ;
+
+  const bool same = loaded.size() == 2 && loaded[ 0 ].name == "sphere" && loaded[ 0 ].stride == sizeof( Vertex ) &&
+                    loaded[ 0 ].vertices == meshes[ 0 ].vertices && loaded[ 0 ].indices == indices && loaded[ 1 ].name.empty() && loaded[ 1 ].indices.empty() ;
+
+  // Cut the end of the file off, it has to be refused & nothing read.
+  {
+    std::ifstream input( path, std::ios::binary ) ;
+    file.assign( std::istreambuf_iterator<char>( input ), std::istreambuf_iterator<char>() ) ;
+  }
+  {
+    std::ofstream output( path, std::ios::binary | std::ios::trunc ) ;
+    output.write( file.data(), file.size() - 4 ) ;
+  }
+
+  const bool refused = !nyx::loadMeshes( path, loaded ) && loaded.size() == 2 ;
+
+  std::remove( path ) ;
+
+  return same && refused ;
+}
+
+/** Checks overdraw on a mesh that isn't convex: a shell with a smaller one inside it, which only ever shows when drawn before the outer one.
+ */
+static bool testNestedOverdraw()
+{
+  vertices.clear() ;
+  indices .clear() ;
+  buildSphere( 32, 64, 1.0f ) ;
+  buildSphere( 32, 64, 0.6f ) ;
+  shuffleTriangles() ;
+
+  nyx::optimizeVertexCache( indices.data(), indices.size(), vertices.size() ) ;
+
+  const auto before = nyx::analyzeOverdraw( indices.data(), indices.size(), vertices[ 0 ].position, vertices.size(), sizeof( Vertex ) ) ;
+  const auto set    = triangleSet( vertices, indices )                                                                                ;
+
+  nyx::optimizeOverdraw( indices.data(), indices.size(), vertices[ 0 ].position, vertices.size(), sizeof( Vertex ) ) ;
+
+  const auto after  = nyx::analyzeOverdraw( indices.data(), indices.size(), vertices[ 0 ].position, vertices.size(), sizeof( Vertex ) ) ;
+
+  std::cout << "Nested shell overdraw: " << "\n"
+            << "-- Overdraw : " << before.overdraw << " -> " << after.overdraw << std::endl ;
+
+  // Drawing the outer shell first hides the inner one behind it, so there has to be a real drop.
+  return set == triangleSet( vertices, indices ) && after.overdraw < before.overdraw - 0.05f ;
+}
+
+static bool testVertexFetch()
+{
+  const auto             set   = triangleSet( vertices, indices ) ;
+  std::vector<Vertex>    moved = vertices                         ;
+  std::vector<unsigned>  list  = indices                          ;
+  unsigned               last  = 0                                ;
+
+  // Add a vertex nothing uses, it should get dropped.
+  moved.push_back( { { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f }, 0xFFFFFFFF } ) ;
+
+  const unsigned count = nyx::optimizeVertexFetch( moved.data(), moved.size(), sizeof( Vertex ), list.data(), list.size() ) ;
+  moved.resize( count ) ;
+
+  // Every index may at most be one past the largest seen so far.
+  for( auto index : list )
+  {
+    if( index > last + 1 ) return false ;
+    last = std::max( last, index ) ;
+  }
+
+  return count == vertices.size() && set == triangleSet( moved, list ) ;
+}
+
+int main()
+{
+  buildSphere( 48, 96, 1.0f ) ;
+  shuffleTriangles() ;
+
+  if( !testVertexCache() )
+  {
+    std::cout << "Vertex cache optimization test failed." << std::endl ;
+    return 1 ;
+  }
+
+  if( !testOverdraw() )
+  {
+    std::cout << "Overdraw optimization test failed." << std::endl ;
+    return 1 ;
+  }
+
+  if( !testVertexFetch() )
+  {
+    std::cout << "Vertex fetch optimization test failed." << std::endl ;
+    return 1 ;
+  }
+
+  if( !testMeshFile() )
+  {
+    std::cout << "Optimized mesh file test failed." << std::endl ;
+    return 1 ;
+  }
+
+  if( !testNestedOverdraw() )
+  {
+    std::cout << "Nested overdraw optimization test failed." << std::endl ;
+    return 1 ;
+  }
+
+  return 0 ;
+}
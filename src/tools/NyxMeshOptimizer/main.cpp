@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2020 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   main.cpp
+ * Author: Jordan Hendl
+ *
+ * Created on May 6, 2021, 9:40 PM
+ */
+
+/* Offline pass over an .ngg model: every mesh's triangles are reordered for the vertex cache, then for overdraw, and it's
+ * vertices for fetch order. Statistics are printed before & after each mesh, and the meshes are written as an optimized mesh file,
+ * read back with nyx::loadMeshes.
+ */
+
+#include "NyxMeshOptimizer.h"
+#include <NyxGPU/library/Array.h>
+#include <NyxGPU/library/Chain.h>
+#include <NyxGPU/vkg/Vulkan.h>
+#include <Mars/Manager.h>
+#include <Mars/Model.h>
+#include <iostream>
+#include <vector>
+#include <type_traits>
+#include <utility>
+
+namespace nyx
+{
+  using Framework    = nyx::vkg::Vulkan                                ;
+  using Model        = mars::Model<Framework>                          ;
+  using ModelManager = mars::Manager<unsigned, Model>                  ;
+  using MeshRef      = std::decay<decltype( *std::declval<Model&>().meshes().begin() )>::type ;
+
+  template<typename Array>
+  struct ArrayElement ;
+
+  template<typename Impl, typename Type>
+  struct ArrayElement<nyx::Array<Impl, Type>> { using Value = Type ; } ;
+
+  using Vertex = ArrayElement<std::decay<decltype( std::declval<MeshRef&>()->vertices )>::type>::Value ;
+}
+
+/** Function to print the statistics of a mesh.
+ */
+static void report( const char* label, const nyx::VertexCacheStatistics& cache, const nyx::OverdrawStatistics& overdraw )
+{
+  std::cout << "-- " << label << " ACMR: " << cache.acmr << ", ATVR: " << cache.atvr << ", Overdraw: " << overdraw.overdraw << "\n" ;
+}
+
+int main( int argc, char** argv )
+{
+  constexpr unsigned DEVICE = 0 ;
+
+  std::vector<nyx::Vertex>        vertices ;
+  std::vector<unsigned>           indices  ;
+  std::vector<nyx::OptimizedMesh> output   ;
+  nyx::Chain<nyx::Framework>      chain    ;
+
+  if( argc != 3 )
+  {
+    std::cout << "Usage: " << argv[ 0 ] << " <input.ngg> <output>" << std::endl ;
+    return 1 ;
+  }
+
+  nyx::Framework::initialize() ;
+  chain.initialize( DEVICE, nyx::ChainType::Compute ) ;
+
+  auto model = nyx::ModelManager::create( 0, argv[ 1 ], DEVICE ) ;
+  if( !model->initialized() )
+  {
+    std::cout << "Failed to load model " << argv[ 1 ] << "." << std::endl ;
+    return 1 ;
+  }
+
+  for( auto mesh : model->meshes() )
+  {
+    vertices.resize( mesh->vertices.size() ) ;
+    indices .resize( mesh->indices .size() ) ;
+
+    // Meshes only live on the device once loaded, so read them back.
+    chain.copy       ( mesh->vertices, vertices.data() ) ;
+    chain.copy       ( mesh->indices , indices .data() ) ;
+    chain.submit     () ;
+    chain.synchronize() ;
+
+    const float*   positions = vertices.empty() ? nullptr : &vertices[ 0 ].vertex.x ;
+    const unsigned stride    = sizeof( nyx::Vertex )                                ;
+
+    std::cout << "Mesh \"" << mesh->name << "\", " << vertices.size() << " vertices, " << indices.size() / 3 << " triangles:" << "\n" ;
+    report( "Before:", nyx::analyzeVertexCache( indices.data(), indices.size(), vertices.size() ), nyx::analyzeOverdraw( indices.data(), indices.size(), positions, vertices.size(), stride ) ) ;
+
+    nyx::optimizeVertexCache( indices.data(), indices.size(), vertices.size()                    ) ;
+    nyx::optimizeOverdraw   ( indices.data(), indices.size(), positions, vertices.size(), stride ) ;
+    vertices.resize( nyx::optimizeVertexFetch( vertices.data(), vertices.size(), stride, indices.data(), indices.size() ) ) ;
+
+    report( "After: ", nyx::analyzeVertexCache( indices.data(), indices.size(), vertices.size() ), nyx::analyzeOverdraw( indices.data(), indices.size(), positions, vertices.size(), stride ) ) ;
+
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>( vertices.data() ) ;
+
+    output.push_back( { mesh->name, stride, std::vector<unsigned char>( bytes, bytes + vertices.size() * stride ), indices } ) ;
+  }
+
+  if( !nyx::saveMeshes( argv[ 2 ], output ) )
+  {
+    std::cout << "Failed to write " << argv[ 2 ] << "." << std::endl ;
+    return 1 ;
+  }
+
+  std::cout << "Wrote " << output.size() << " meshes to " << argv[ 2 ] << "." << std::endl ;
+
+  return 0 ;
+}
@@ -0,0 +1,666 @@
+/*
+ * Copyright (C) 2020 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define GLM_FORCE_RADIANS
+
+#include "NyxAnimator.h"
+#include <templates/NyxAnimation.h>
+#include <Iris/data/Bus.h>
+#include <Iris/log/Log.h>
+#include <Iris/config/Configuration.h>
+#include <Iris/config/Parser.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+
+static const unsigned VERSION = 1 ;
+namespace nyx
+{
+  using Log   = iris::log::Log            ;
+  using Token = iris::config::json::Token ;
+
+  /** The amount of instances a single worker job evaluates.
+   */
+  constexpr unsigned ANIMATOR_CHUNK = 64 ;
+
+  /** Class to run jobs across a fixed set of worker threads. The calling thread works alongside them.
+   */
+  class WorkerPool
+  {
+    public:
+      WorkerPool() ;
+      ~WorkerPool() ;
+
+      /** Method to start the worker threads.
+       * @param count The amount of worker threads to start, not counting the calling thread.
+       */
+      void start( unsigned count ) ;
+
+      /** Method to stop & join the worker threads.
+       */
+      void stop() ;
+
+      /** Method to run a function once for every job index, blocking until every job finished.
+       * @param jobs The amount of jobs to run.
+       * @param function The function to call with each job index.
+       */
+      void run( unsigned jobs, const std::function<void( unsigned )>& function ) ;
+
+    private:
+
+      /** Method to pull & run jobs until there are none left.
+       */
+      void work() ;
+
+      /** Method run by each worker thread.
+       */
+      void loop() ;
+
+      std::vector<std::thread>                  threads    ;
+      std::mutex                                lock       ;
+      std::condition_variable                   wake       ;
+      std::condition_variable                   finished   ;
+      const std::function<void( unsigned )>*    function   ;
+      std::atomic<unsigned>                     next       ;
+      std::atomic<unsigned>                     remaining  ;
+      unsigned                                  jobs       ;
+      unsigned                                  active     ;
+      unsigned                                  generation ;
+      bool                                      running    ;
+  };
+
+  /** Structure containing the keyframes of a single node of a clip.
+   */
+  struct Track
+  {
+    int                    parent       ; ///< The track this track is relative to. -1 if it is a root.
+    glm::mat4              inverse_bind ; ///< The inverse of the node's bind pose, applied after sampling for bone palettes.
+    std::vector<float>     times        ; ///< The time of each key, ascending.
+    std::vector<glm::vec3> translations ;
+    std::vector<glm::quat> rotations    ;
+    std::vector<glm::vec3> scales       ;
+  };
+
+  /** Structure containing a single keyframe clip.
+   */
+  struct Clip
+  {
+    float              duration ; ///< The length of the clip, after which it loops.
+    bool               skeletal ; ///< Whether the clip animates bone palettes instead of whole drawables.
+    std::vector<Track> tracks   ; ///< The tracks of the clip. Parents always come before their children.
+  };
+
+  /** Structure describing a range of consecutive drawables playing the same clip.
+   */
+  struct Group
+  {
+    unsigned first   ; ///< The id of the first drawable of the group.
+    unsigned count   ; ///< The amount of drawables in the group.
+    unsigned clip    ; ///< The clip the group plays.
+    float    stagger ; ///< The time offset between consecutive drawables, so they don't move in lockstep.
+    float    speed   ; ///< The playback speed of the group.
+    unsigned offset  ; ///< Where the group's results start in the output buffer.
+  };
+
+  struct AnimatorData
+  {
+    using Clock = std::chrono::steady_clock ;
+
+    iris::Bus              bus              ;
+    std::string            name             ;
+    std::string            transform_output ;
+    std::string            bones_output     ;
+    std::vector<Clip>      clips            ;
+    std::vector<Group>     groups           ;
+    std::vector<glm::mat4> transforms       ;
+    std::vector<glm::mat4> palettes         ;
+    WorkerPool             pool             ;
+    unsigned               threads          ;
+    float                  time             ;
+    Clock::time_point      last             ;
+    bool                   dirty            ;
+
+    /** Default constructor.
+     */
+    AnimatorData() ;
+
+    /** Method to set the clips this module can play.
+     * @param token The JSON token containing the clips.
+     */
+    void setClips( const Token& token ) ;
+
+    /** Method to set the groups of drawables this module animates.
+     * @param token The JSON token containing the groups.
+     */
+    void setInstances( const Token& token ) ;
+
+    /** Method to set the amount of worker threads used to evaluate clips.
+     * @param count The amount of worker threads.
+     */
+    void setThreads( unsigned count ) ;
+
+    /** Method to set the name of the output whole-drawable transforms are sent to. Usually a draw module's drawable input.
+     * @param name The name of the output.
+     */
+    void setTransformOutput( const char* name ) ;
+
+    /** Method to set the name of the output bone palettes are sent to. Usually a draw module's bone input.
+     * @param name The name of the output.
+     */
+    void setBonesOutput( const char* name ) ;
+
+    /** Method to place every group's results in the output buffers.
+     */
+    void layout() ;
+
+    /** Method to evaluate a range of a group's drawables at the current time.
+     * @param group The group to evaluate.
+     * @param begin The first drawable of the group to evaluate, relative to the group.
+     * @param end One past the last drawable of the group to evaluate, relative to the group.
+     */
+    void evaluate( const Group& group, unsigned begin, unsigned end ) ;
+  };
+
+  /** Function to find the keys surrounding a time in a track.
+   * @param times The key times of the track.
+   * @param time The time to sample at.
+   * @param first Reference to the key before the time.
+   * @param second Reference to the key after the time.
+   * @return The interpolation factor between the two keys.
+   */
+  static inline float findKeys( const std::vector<float>& times, float time, unsigned& first, unsigned& second )
+  {
+    const auto     iter  = std::upper_bound( times.begin(), times.end(), time ) ;
+    const unsigned upper = iter - times.begin()                                  ;
+
+    if( upper == 0            ) { first = second = 0                ; return 0.0f ; }
+    if( upper == times.size() ) { first = second = times.size() - 1 ; return 0.0f ; }
+
+    first  = upper - 1 ;
+    second = upper     ;
+
+    return ( time - times[ first ] ) / ( times[ second ] - times[ first ] ) ;
+  }
+
+  WorkerPool::WorkerPool()
+  {
+    this->function   = nullptr ;
+    this->next       = 0       ;
+    this->remaining  = 0       ;
+    this->jobs       = 0       ;
+    this->active     = 0       ;
+    this->generation = 0       ;
+    this->running    = false   ;
+  }
+
+  WorkerPool::~WorkerPool()
+  {
+    this->stop() ;
+  }
+
+  void WorkerPool::start( unsigned count )
+  {
+    this->stop() ;
+    this->running = true ;
+
+    for( unsigned index = 0; index < count; index++ )
+    {
+      this->threads.emplace_back( &WorkerPool::loop, this ) ;
+    }
+  }
+
+  void WorkerPool::stop()
+  {
+    {
+      std::lock_guard<std::mutex> guard( this->lock ) ;
+      this->running = false ;
+    }
+
+    this->wake.notify_all() ;
+    for( auto& thread : this->threads ) thread.join() ;
+    this->threads.clear() ;
+  }
+
+  void WorkerPool::run( unsigned jobs, const std::function<void( unsigned )>& function )
+  {
+    if( jobs == 0 ) return ;
+
+    {
+      std::lock_guard<std::mutex> guard( this->lock ) ;
+      this->function  = &function ;
+      this->jobs      = jobs      ;
+      this->next      = 0         ;
+      this->remaining = jobs      ;
+      this->generation++ ;
+    }
+
+    this->wake.notify_all() ;
+    this->work() ;
+
+    // Wait for the workers to leave this run too, so none of them can touch the next one's counters early.
+    std::unique_lock<std::mutex> guard( this->lock ) ;
+    this->finished.wait( guard, [ this ] { return this->remaining == 0 && this->active == 0 ; } ) ;
+    this->function = nullptr ;
+  }
+
+  void WorkerPool::work()
+  {
+    unsigned job ;
+
+    while( ( job = this->next++ ) < this->jobs )
+    {
+      ( *this->function )( job ) ;
+
+      if( --this->remaining == 0 )
+      {
+        std::lock_guard<std::mutex> guard( this->lock ) ;
+        this->finished.notify_all() ;
+      }
+    }
+  }
+
+  void WorkerPool::loop()
+  {
+    unsigned seen = 0 ;
+
+    while( true )
+    {
+      {
+        std::unique_lock<std::mutex> guard( this->lock ) ;
+        this->wake.wait( guard, [ this, seen ] { return !this->running || ( this->generation != seen && this->function ) ; } ) ;
+
+        if( !this->running ) return ;
+        seen = this->generation ;
+        this->active++ ;
+      }
+
+      this->work() ;
+
+      {
+        std::lock_guard<std::mutex> guard( this->lock ) ;
+        this->active-- ;
+      }
+
+      this->finished.notify_all() ;
+    }
+  }
+
+  AnimatorData::AnimatorData()
+  {
+    this->threads = std::max( 1u, std::thread::hardware_concurrency() ) - 1 ;
+    this->time    = 0.0f                                                   ;
+    this->dirty   = false                                                  ;
+  }
+
+  void AnimatorData::setClips( const Token& token )
+  {
+    this->clips.clear() ;
+
+    for( unsigned clip_index = 0; clip_index < token.size(); clip_index++ )
+    {
+      auto clip_token = token.token( clip_index ) ;
+      auto duration   = clip_token[ "duration" ] ;
+      auto skeletal   = clip_token[ "skeletal" ] ;
+      auto tracks     = clip_token[ "tracks"   ] ;
+      Clip clip                                  ;
+
+      clip.duration = duration ? duration.decimal() : 1.0f  ;
+      clip.skeletal = skeletal ? skeletal.boolean() : false ;
+
+      for( unsigned track_index = 0; tracks && track_index < tracks.size(); track_index++ )
+      {
+        auto  track_token  = tracks.token( track_index ) ;
+        auto  parent       = track_token[ "parent"       ] ;
+        auto  inverse_bind = track_token[ "inverse_bind" ] ;
+        auto  keys         = track_token[ "keys"         ] ;
+        Track track                                        ;
+
+        track.parent       = parent ? static_cast<int>( parent.number() ) : -1 ;
+        track.inverse_bind = glm::mat4( 1.0f )                                ;
+
+        if( track.parent >= static_cast<int>( track_index ) )
+        {
+          Log::output( Log::Level::Warning, "Module ", this->name.c_str(), " clip ", clip_index, " track ", track_index, " has parent ", track.parent, " which does not come before it. Treating it as a root." ) ;
+          track.parent = -1 ;
+        }
+
+        if( inverse_bind && inverse_bind.size() == 16 )
+        {
+          for( unsigned index = 0; index < 16; index++ ) track.inverse_bind[ index / 4 ][ index % 4 ] = inverse_bind.decimal( index ) ;
+        }
+
+        for( unsigned key_index = 0; keys && key_index < keys.size(); key_index++ )
+        {
+          auto key_token   = keys.token( key_index ) ;
+          auto time        = key_token[ "time" ]     ;
+          auto translation = key_token[ "t"    ]     ;
+          auto rotation    = key_token[ "r"    ]     ;
+          auto scale       = key_token[ "s"    ]     ;
+
+          track.times       .push_back( time        ? time.decimal()                                                                                  : 0.0f                          ) ;
+          track.translations.push_back( translation ? glm::vec3( translation.decimal( 0 ), translation.decimal( 1 ), translation.decimal( 2 ) )      : glm::vec3( 0.0f )             ) ;
+          track.rotations   .push_back( rotation    ? glm::normalize( glm::quat( rotation.decimal( 3 ), rotation.decimal( 0 ), rotation.decimal( 1 ), rotation.decimal( 2 ) ) ) : glm::quat( 1.0f, 0.0f, 0.0f, 0.0f ) ) ;
+          track.scales      .push_back( scale       ? glm::vec3( scale.decimal( 0 ), scale.decimal( 1 ), scale.decimal( 2 ) )                        : glm::vec3( 1.0f )             ) ;
+        }
+
+        if( track.times.empty() )
+        {
+          track.times       .push_back( 0.0f                                ) ;
+          track.translations.push_back( glm::vec3( 0.0f )                   ) ;
+          track.rotations   .push_back( glm::quat( 1.0f, 0.0f, 0.0f, 0.0f ) ) ;
+          track.scales      .push_back( glm::vec3( 1.0f )                   ) ;
+        }
+
+        clip.tracks.push_back( track ) ;
+      }
+
+      Log::output( "Module ", this->name.c_str(), " added clip ", clip_index, " with ", clip.tracks.size(), " tracks lasting ", clip.duration, " seconds" ) ;
+      this->clips.push_back( clip ) ;
+    }
+
+    this->dirty = true ;
+  }
+
+  void AnimatorData::setInstances( const Token& token )
+  {
+    this->groups.clear() ;
+
+    for( unsigned index = 0; index < token.size(); index++ )
+    {
+      auto  group_token = token.token( index )   ;
+      auto  first       = group_token[ "first"   ] ;
+      auto  count       = group_token[ "count"   ] ;
+      auto  clip        = group_token[ "clip"    ] ;
+      auto  stagger     = group_token[ "stagger" ] ;
+      auto  speed       = group_token[ "speed"   ] ;
+      Group group                                  ;
+
+      group.first   = first   ? first  .number () : 0    ;
+      group.count   = count   ? count  .number () : 1    ;
+      group.clip    = clip    ? clip   .number () : 0    ;
+      group.stagger = stagger ? stagger.decimal() : 0.0f ;
+      group.speed   = speed   ? speed  .decimal() : 1.0f ;
+      group.offset  = 0                                  ;
+
+      Log::output( "Module ", this->name.c_str(), " animating ", group.count, " drawables starting at ID ", group.first, " with clip ", group.clip ) ;
+      this->groups.push_back( group ) ;
+    }
+
+    this->dirty = true ;
+  }
+
+  void AnimatorData::setThreads( unsigned count )
+  {
+    Log::output( "Module ", this->name.c_str(), " set worker thread count as ", count ) ;
+    this->threads = count ;
+  }
+
+  void AnimatorData::setTransformOutput( const char* name )
+  {
+    Log::output( "Module ", this->name.c_str(), " set output transformations as \"", name, "\"" ) ;
+    this->transform_output = name ;
+  }
+
+  void AnimatorData::setBonesOutput( const char* name )
+  {
+    Log::output( "Module ", this->name.c_str(), " set output bone palettes as \"", name, "\"" ) ;
+    this->bones_output = name ;
+  }
+
+  void AnimatorData::layout()
+  {
+    unsigned transform_count = 0 ;
+    unsigned palette_count   = 0 ;
+
+    // Drop groups playing clips that don't exist, so evaluation never has to check.
+    this->groups.erase( std::remove_if( this->groups.begin(), this->groups.end(), [ this ] ( const Group& group )
+    {
+      if( group.clip < this->clips.size() && !this->clips[ group.clip ].tracks.empty() ) return false ;
+
+      Log::output( Log::Level::Warning, "Module ", this->name.c_str(), " has no clip ", group.clip, ", ignoring the drawables starting at ID ", group.first ) ;
+      return true ;
+    } ), this->groups.end() ) ;
+
+    for( auto& group : this->groups )
+    {
+      const Clip& clip = this->clips[ group.clip ] ;
+
+      if( clip.skeletal )
+      {
+        group.offset   = palette_count                      ;
+        palette_count += group.count * clip.tracks.size()   ;
+      }
+      else
+      {
+        group.offset     = transform_count ;
+        transform_count += group.count     ;
+      }
+    }
+
+    this->transforms.resize( transform_count ) ;
+    this->palettes  .resize( palette_count   ) ;
+    this->dirty = false ;
+  }
+
+  void AnimatorData::evaluate( const Group& group, unsigned begin, unsigned end )
+  {
+    const Clip&            clip  = this->clips[ group.clip ]               ;
+    const unsigned         nodes = clip.skeletal ? clip.tracks.size() : 1 ;
+    std::vector<glm::mat4> globals( nodes * 4 )                            ;
+    QuaternionLanes        from                                            ;
+    QuaternionLanes        to                                              ;
+    QuaternionLanes        rotation                                        ;
+    float                  times       [ 4 ]                               ;
+    float                  factors     [ 4 ]                               ;
+    glm::vec3              translations[ 4 ]                               ;
+    glm::vec3              scales      [ 4 ]                               ;
+
+    for( unsigned base = begin; base < end; base += 4 )
+    {
+      const unsigned lanes = std::min( 4u, end - base ) ;
+
+      for( unsigned lane = 0; lane < 4; lane++ )
+      {
+        const float local = this->time * group.speed + ( base + std::min( lane, lanes - 1 ) ) * group.stagger ;
+        times[ lane ] = std::fmod( std::fmod( local, clip.duration ) + clip.duration, clip.duration ) ;
+      }
+
+      for( unsigned node = 0; node < nodes; node++ )
+      {
+        const Track& track = clip.tracks[ node ] ;
+
+        // Gather each lane's surrounding keys so all four rotations interpolate together.
+        for( unsigned lane = 0; lane < 4; lane++ )
+        {
+          unsigned   first  ;
+          unsigned   second ;
+          const float factor = findKeys( track.times, times[ lane ], first, second ) ;
+
+          const glm::quat& a = track.rotations[ first  ] ;
+          const glm::quat& b = track.rotations[ second ] ;
+
+          from.x[ lane ] = a.x ; from.y[ lane ] = a.y ; from.z[ lane ] = a.z ; from.w[ lane ] = a.w ;
+          to  .x[ lane ] = b.x ; to  .y[ lane ] = b.y ; to  .z[ lane ] = b.z ; to  .w[ lane ] = b.w ;
+
+          factors     [ lane ] = factor                                                                     ;
+          translations[ lane ] = glm::mix( track.translations[ first ], track.translations[ second ], factor ) ;
+          scales      [ lane ] = glm::mix( track.scales      [ first ], track.scales      [ second ], factor ) ;
+        }
+
+        nyx::fastSlerp4( from, to, factors, rotation ) ;
+
+        for( unsigned lane = 0; lane < lanes; lane++ )
+        {
+          const glm::quat q     = glm::quat( rotation.w[ lane ], rotation.x[ lane ], rotation.y[ lane ], rotation.z[ lane ] ) ;
+          const glm::mat4 local = glm::scale( glm::translate( glm::mat4( 1.0f ), translations[ lane ] ) * glm::mat4_cast( q ), scales[ lane ] ) ;
+          glm::mat4&      out   = globals[ lane * nodes + node ] ;
+
+          out = track.parent >= 0 && clip.skeletal ? globals[ lane * nodes + track.parent ] * local : local ;
+        }
+      }
+
+      for( unsigned lane = 0; lane < lanes; lane++ )
+      {
+        const unsigned instance = base + lane ;
+
+        if( clip.skeletal )
+        {
+          glm::mat4* palette = this->palettes.data() + group.offset + instance * nodes ;
+          for( unsigned node = 0; node < nodes; node++ ) palette[ node ] = globals[ lane * nodes + node ] * clip.tracks[ node ].inverse_bind ;
+        }
+        else
+        {
+          this->transforms[ group.offset + instance ] = globals[ lane * nodes ] ;
+        }
+      }
+    }
+  }
+
+  Animator::Animator()
+  {
+    this->module_data = new AnimatorData() ;
+  }
+
+  Animator::~Animator()
+  {
+    delete this->module_data ;
+  }
+
+  void Animator::initialize()
+  {
+    Log::output( "Module ", this->name(), " evaluating clips on ", data().threads + 1, " threads" ) ;
+    data().pool.start( data().threads ) ;
+    data().layout() ;
+    data().last = AnimatorData::Clock::now() ;
+  }
+
+  void Animator::subscribe( unsigned id )
+  {
+    data().bus.setChannel( id ) ;
+    data().name = this->name() ;
+    data().bus.enroll( this->module_data, &AnimatorData::setClips          , iris::OPTIONAL, this->name(), "::clips"     ) ;
+    data().bus.enroll( this->module_data, &AnimatorData::setInstances      , iris::OPTIONAL, this->name(), "::instances" ) ;
+    data().bus.enroll( this->module_data, &AnimatorData::setThreads        , iris::OPTIONAL, this->name(), "::threads"   ) ;
+    data().bus.enroll( this->module_data, &AnimatorData::setTransformOutput, iris::OPTIONAL, this->name(), "::drawer"    ) ;
+    data().bus.enroll( this->module_data, &AnimatorData::setBonesOutput    , iris::OPTIONAL, this->name(), "::bones"     ) ;
+  }
+
+  void Animator::shutdown()
+  {
+    data().pool.stop() ;
+  }
+
+  void Animator::execute()
+  {
+    const auto  now     = AnimatorData::Clock::now()                                ;
+    const float elapsed = std::chrono::duration<float>( now - data().last ).count() ;
+
+    std::vector<std::pair<unsigned, unsigned>> chunks ;
+
+    data().last  = now     ;
+    data().time += elapsed ;
+
+    if( data().dirty ) data().layout() ;
+
+    // Split every group into fixed size chunks, so large & small groups balance across the pool.
+    for( unsigned index = 0; index < data().groups.size(); index++ )
+    {
+      for( unsigned begin = 0; begin < data().groups[ index ].count; begin += ANIMATOR_CHUNK )
+      {
+        chunks.push_back( { index, begin } ) ;
+      }
+    }
+
+    data().pool.run( chunks.size(), [ this, &chunks ] ( unsigned job )
+    {
+      const Group&   group = data().groups[ chunks[ job ].first ] ;
+      const unsigned begin = chunks[ job ].second                ;
+
+      data().evaluate( group, begin, std::min( group.count, begin + ANIMATOR_CHUNK ) ) ;
+    } ) ;
+
+    // One bulk update per group instead of one event per drawable.
+    for( const auto& group : data().groups )
+    {
+      const Clip& clip = data().clips[ group.clip ] ;
+
+      if( clip.skeletal && !data().bones_output.empty() )
+      {
+        data().bus.emit( nyx::PaletteBatch{ group.first, group.count, static_cast<unsigned>( clip.tracks.size() ), data().palettes.data() + group.offset }, data().bones_output.c_str() ) ;
+      }
+      else if( !clip.skeletal && !data().transform_output.empty() )
+      {
+        data().bus.emit( nyx::TransformBatch{ group.first, group.count, data().transforms.data() + group.offset }, data().transform_output.c_str() ) ;
+      }
+    }
+  }
+
+  AnimatorData& Animator::data()
+  {
+    return *this->module_data ;
+  }
+
+  const AnimatorData& Animator::data() const
+  {
+    return *this->module_data ;
+  }
+}
+
+/** Exported function to retrive the name of this module type.
+ * @return The name of this object's type.
+ */
+exported_function const char* name()
+{
+  return "NyxAnimator" ;
+}
+
+/** Exported function to retrieve the version of this module.
+ * @return The version of this module.
+ */
+exported_function unsigned version()
+{
+  return VERSION ;
+}
+
+/** Exported function to make one instance of this module.
+ * @return A single instance of this module.
+ */
+exported_function ::iris::Module* make()
+{
+  return new ::nyx::Animator() ;
+}
+
+/** Exported function to destroy an instance of this module.
+ * @param module A Pointer to a Module object that is of this type.
+ */
+exported_function void destroy( ::iris::Module* module )
+{
+  ::nyx::Animator* mod ;
+
+  mod = dynamic_cast<::nyx::Animator*>( module ) ;
+  delete mod ;
+}
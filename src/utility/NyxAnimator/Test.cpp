@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2020 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   Test.cpp
+ * Author: Jordan Hendl
+ *
+ * Created on May 2, 2021, 3:12 PM
+ */
+
+#define GLM_FORCE_RADIANS
+
+#include "NyxAnimator.h"
+#include <templates/NyxAnimation.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+#include <cmath>
+
+static bool testFastSlerp()
+{
+  constexpr unsigned PAIRS  = 4096 ;
+  constexpr unsigned ROUNDS = 256  ;
+
+  std::mt19937                          rng( 1337 )        ;
+  std::uniform_real_distribution<float> value( -1.0f, 1.0f ) ;
+  std::vector<glm::quat>                from( PAIRS )       ;
+  std::vector<glm::quat>                to  ( PAIRS )       ;
+  std::vector<float>                    t   ( PAIRS )       ;
+  std::vector<glm::quat>                exact( PAIRS )      ;
+  nyx::QuaternionLanes                  a                   ;
+  nyx::QuaternionLanes                  b                   ;
+  nyx::QuaternionLanes                  out                 ;
+  float                                 error = 0.0f        ;
+  volatile float                        sink  = 0.0f        ;
+
+  for( unsigned index = 0; index < PAIRS; index++ )
+  {
+    from[ index ] = glm::normalize( glm::quat( value( rng ), value( rng ), value( rng ), value( rng ) ) ) ;
+    to  [ index ] = glm::normalize( glm::quat( value( rng ), value( rng ), value( rng ), value( rng ) ) ) ;
+    t   [ index ] = ( value( rng ) + 1.0f ) * 0.5f ;
+  }
+
+  auto start = std::chrono::high_resolution_clock::now() ;
+  for( unsigned round = 0; round < ROUNDS; round++ )
+  {
+    for( unsigned index = 0; index < PAIRS; index++ )
+    {
+      exact[ index ] = glm::slerp( from[ index ], to[ index ] * ( glm::dot( from[ index ], to[ index ] ) < 0.0f ? -1.0f : 1.0f ), t[ index ] ) ;
+    }
+    sink = sink + exact[ round ].w ;
+  }
+  auto slerp_time = std::chrono::duration<double, std::milli>( std::chrono::high_resolution_clock::now() - start ).count() ;
+
+  start = std::chrono::high_resolution_clock::now() ;
+  for( unsigned round = 0; round < ROUNDS; round++ )
+  {
+    for( unsigned base = 0; base < PAIRS; base += 4 )
+    {
+      for( unsigned lane = 0; lane < 4; lane++ )
+      {
+        a.x[ lane ] = from[ base + lane ].x ; a.y[ lane ] = from[ base + lane ].y ; a.z[ lane ] = from[ base + lane ].z ; a.w[ lane ] = from[ base + lane ].w ;
+        b.x[ lane ] = to  [ base + lane ].x ; b.y[ lane ] = to  [ base + lane ].y ; b.z[ lane ] = to  [ base + lane ].z ; b.w[ lane ] = to  [ base + lane ].w ;
+      }
+
+      nyx::fastSlerp4( a, b, t.data() + base, out ) ;
+
+      // Only measure the error once, the timing rounds just repeat the same work.
+      for( unsigned lane = 0; round == 0 && lane < 4; lane++ )
+      {
+        const glm::quat approx = glm::quat( out.w[ lane ], out.x[ lane ], out.y[ lane ], out.z[ lane ] ) ;
+        error = std::max( error, 1.0f - std::fabs( glm::dot( approx, exact[ base + lane ] ) ) ) ;
+      }
+    }
+    sink = sink + out.w[ 0 ] ;
+  }
+  auto fast_time = std::chrono::duration<double, std::milli>( std::chrono::high_resolution_clock::now() - start ).count() ;
+
+  std::cout << "Rotation interpolation of " << PAIRS * ROUNDS << " pairs: " << "\n"
+            << "-- glm::slerp      : " << slerp_time << "ms" << "\n"
+            << "-- nyx::fastSlerp4 : " << fast_time  << "ms" << "\n"
+            << "-- Largest error   : " << error      << std::endl ;
+
+  // An error of 1 - |dot| below 1e-6 is well under a thousandth of a radian.
+  return error < 1e-6f ;
+}
+
+int main()
+{
+  if( !testFastSlerp() )
+  {
+    std::cout << "Fast slerp test failed." << std::endl ;
+    return 1 ;
+  }
+
+  return 0 ;
+}